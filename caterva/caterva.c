@@ -10,9 +10,19 @@
  */
 
 #include <caterva.h>
+#include <math.h>
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif !defined(_WIN32)
+#include <unistd.h>
+#endif
 
 #include "caterva_blosc.h"
 #include "caterva_plainbuffer.h"
+#include "caterva_reduce.h"
+#include "caterva_sharded.h"
+#include "caterva_stream.h"
+#include "caterva_verify.h"
 
 int caterva_ctx_new(caterva_config_t *cfg, caterva_ctx_t **ctx) {
     CATERVA_ERROR_NULL(cfg);
@@ -53,10 +63,23 @@ int caterva_empty(caterva_ctx_t *ctx, caterva_params_t *params,
     CATERVA_ERROR_NULL(storage);
     CATERVA_ERROR_NULL(array);
 
-    if (storage->backend == CATERVA_STORAGE_BLOSC) {
-        CATERVA_ERROR(caterva_blosc_array_empty(ctx, params, storage, array));
-    } else {
-        CATERVA_ERROR(caterva_plainbuffer_array_empty(ctx, params, storage, array));
+    if (storage->io != NULL && storage->backend != CATERVA_STORAGE_BLOSC) {
+        DEBUG_PRINT("Only arrays backed by a Blosc super-chunk can be stored in an I/O backend");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    switch (storage->backend) {
+        case CATERVA_STORAGE_BLOSC:
+            CATERVA_ERROR(caterva_blosc_array_empty(ctx, params, storage, array));
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            CATERVA_ERROR(caterva_plainbuffer_array_empty(ctx, params, storage, array));
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_empty(ctx, params, storage, array));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
 
     if ((*array)->nitems != 0) {
@@ -97,12 +120,115 @@ int caterva_from_serial_schunk(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64
     return CATERVA_SUCCEED;
 }
 
+int caterva_from_serial_schunk_view(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64_t len,
+                                    caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(serial_schunk);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(caterva_blosc_from_serial_schunk_view(ctx, serial_schunk, len, array));
+
+    return CATERVA_SUCCEED;
+}
+
+// Open a plain buffer or a sharded array, which are recognized by the magic string of their
+// header. It is only called when the file can not be opened as a frame (whose error is rc).
+static int open_header(caterva_ctx_t *ctx, const char *urlpath,
+                       int (*open_shard)(caterva_ctx_t *, const char *, caterva_array_t **),
+                       int rc, caterva_array_t **array) {
+    if (caterva_plainbuffer_is_file(urlpath)) {
+        CATERVA_ERROR(caterva_plainbuffer_open(ctx, urlpath, array));
+    } else if (caterva_sharded_is_file(urlpath)) {
+        CATERVA_ERROR(caterva_sharded_open(ctx, urlpath, open_shard, array));
+    } else {
+        return rc;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
 int caterva_open(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(urlpath);
     CATERVA_ERROR_NULL(array);
 
-    CATERVA_ERROR(caterva_blosc_open(ctx, urlpath, array));
+    int rc = caterva_blosc_open(ctx, urlpath, array);
+    if (rc != CATERVA_SUCCEED) {
+        CATERVA_ERROR(open_header(ctx, urlpath, caterva_open, rc, array));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_open_lazy(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(urlpath);
+    CATERVA_ERROR_NULL(array);
+
+    // Plain buffers are mapped without reading their data, so they are already lazy
+    int rc = caterva_blosc_open_lazy(ctx, urlpath, array);
+    if (rc != CATERVA_SUCCEED) {
+        CATERVA_ERROR(open_header(ctx, urlpath, caterva_open, rc, array));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Load the super-chunk of an array opened lazily before accessing its data
+static int load_array(caterva_ctx_t *ctx, caterva_array_t *array) {
+    if (array->storage == CATERVA_STORAGE_BLOSC) {
+        CATERVA_ERROR(caterva_blosc_array_load(ctx, array));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_open_mmap(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(urlpath);
+    CATERVA_ERROR_NULL(array);
+
+    int rc = caterva_blosc_open_mmap(ctx, urlpath, array);
+    if (rc != CATERVA_SUCCEED) {
+        CATERVA_ERROR(open_header(ctx, urlpath, caterva_open_mmap, rc, array));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_open_io(caterva_ctx_t *ctx, const caterva_io_t *io, const char *urlpath,
+                    caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(io);
+    CATERVA_ERROR_NULL(urlpath);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(caterva_blosc_open_io(ctx, io, urlpath, array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_serialize_stream(caterva_ctx_t *ctx, caterva_array_t *array,
+                             caterva_write_cb_t write_cb, void *userdata) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(write_cb);
+
+    CATERVA_ERROR(load_array(ctx, array));
+    CATERVA_ERROR(caterva_stream_serialize(ctx, array, write_cb, userdata));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_deserialize_stream(caterva_ctx_t *ctx, caterva_read_cb_t read_cb,
+                               caterva_chunk_cb_t chunk_cb, void *userdata,
+                               caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(read_cb);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(caterva_stream_deserialize(ctx, read_cb, chunk_cb, userdata, storage, array));
 
     return CATERVA_SUCCEED;
 }
@@ -112,6 +238,9 @@ int caterva_free(caterva_ctx_t *ctx, caterva_array_t **array) {
     CATERVA_ERROR_NULL(array);
 
     if (*array) {
+        if ((*array)->access_stats != NULL) {
+            ctx->cfg->free((*array)->access_stats);
+        }
         switch ((*array)->storage) {
             case CATERVA_STORAGE_BLOSC:
                 caterva_blosc_array_free(ctx, array);
@@ -119,6 +248,9 @@ int caterva_free(caterva_ctx_t *ctx, caterva_array_t **array) {
             case CATERVA_STORAGE_PLAINBUFFER:
                 caterva_plainbuffer_array_free(ctx, array);
                 break;
+            case CATERVA_STORAGE_SHARDED:
+                caterva_sharded_array_free(ctx, array);
+                break;
         }
         ctx->cfg->free(*array);
     }
@@ -130,8 +262,12 @@ int caterva_append(caterva_ctx_t *ctx, caterva_array_t *array, void *chunk,
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
     CATERVA_ERROR_NULL(chunk);
+    CATERVA_ERROR(load_array(ctx, array));
 
-    if (array->filled) {
+    if (array->readonly) {
+        CATERVA_ERROR(CATERVA_ERR_READ_ONLY);
+    }
+    if (array->filled && !array->extendable) {
         CATERVA_ERROR(CATERVA_ERR_CONTAINER_FILLED);
     }
     switch (array->storage) {
@@ -139,6 +275,7 @@ int caterva_append(caterva_ctx_t *ctx, caterva_array_t *array, void *chunk,
             if (chunksize != array->next_chunknitems * array->itemsize) {
                 CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
             }
+            CATERVA_ERROR(caterva_verify_drop_checksums(array));
             CATERVA_ERROR(caterva_blosc_array_append(ctx, array, chunk, (int32_t) chunksize));
             break;
         case CATERVA_STORAGE_PLAINBUFFER:
@@ -147,6 +284,10 @@ int caterva_append(caterva_ctx_t *ctx, caterva_array_t *array, void *chunk,
             }
             CATERVA_ERROR(caterva_plainbuffer_array_append(ctx, array, chunk, chunksize));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            // The size of the chunk is checked by the shard where it is appended
+            CATERVA_ERROR(caterva_sharded_array_append(ctx, array, chunk, chunksize));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
@@ -186,6 +327,70 @@ int caterva_from_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersize,
         case CATERVA_STORAGE_PLAINBUFFER:
             CATERVA_ERROR(caterva_plainbuffer_array_from_buffer(ctx, *array, buffer, buffersize));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_from_buffer(ctx, *array, buffer, buffersize));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_zeros(caterva_ctx_t *ctx, caterva_params_t *params, caterva_storage_t *storage,
+                  caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(caterva_empty(ctx, params, storage, array));
+
+    if ((*array)->nitems == 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    switch ((*array)->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            CATERVA_ERROR(caterva_blosc_array_full(ctx, *array, NULL));
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            CATERVA_ERROR(caterva_plainbuffer_array_full(ctx, *array, NULL));
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_full(ctx, *array, NULL));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_full(caterva_ctx_t *ctx, caterva_params_t *params, caterva_storage_t *storage,
+                 void *fill_value, caterva_array_t **array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(fill_value);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(caterva_empty(ctx, params, storage, array));
+
+    if ((*array)->nitems == 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    switch ((*array)->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            CATERVA_ERROR(caterva_blosc_array_full(ctx, *array, fill_value));
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            CATERVA_ERROR(caterva_plainbuffer_array_full(ctx, *array, fill_value));
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_full(ctx, *array, fill_value));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
@@ -198,6 +403,7 @@ int caterva_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer,
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
     CATERVA_ERROR_NULL(buffer);
+    CATERVA_ERROR(load_array(ctx, array));
 
     if (buffersize < (int64_t) array->nitems * array->itemsize) {
         CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
@@ -214,6 +420,9 @@ int caterva_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer,
         case CATERVA_STORAGE_PLAINBUFFER:
             CATERVA_ERROR(caterva_plainbuffer_array_to_buffer(ctx, array, buffer));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_to_buffer(ctx, array, buffer));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
@@ -221,6 +430,75 @@ int caterva_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer,
     return CATERVA_SUCCEED;
 }
 
+// The cost (in bytes decompressed) estimated for every chunk and block touched by a slice
+#define CATERVA_ACCESS_CHUNK_COST (16 * 1024)
+#define CATERVA_ACCESS_BLOCK_COST 512
+
+// Count the chunks and blocks touched by a slice and estimate its cost
+static double get_slice_cost(int8_t ndim, const int64_t *start, const int64_t *stop,
+                             const int32_t *chunkshape, const int32_t *blockshape,
+                             int8_t itemsize, int64_t *nchunks, int64_t *nblocks) {
+    *nchunks = 1;
+    *nblocks = 1;
+    int64_t blocknitems = 1;
+    for (int i = 0; i < ndim; ++i) {
+        if (stop[i] <= start[i] || chunkshape[i] == 0) {
+            *nchunks = 0;
+            *nblocks = 0;
+            return 0;
+        }
+        int64_t c = chunkshape[i];
+        int64_t b = blockshape[i];
+        int64_t first = start[i] / c;
+        int64_t last = (stop[i] - 1) / c;
+        int64_t blocks;
+        if (first == last) {
+            blocks = ((stop[i] - 1) % c) / b - (start[i] % c) / b + 1;
+        } else {
+            int64_t chunkblocks = (c + b - 1) / b;
+            blocks = chunkblocks - (start[i] % c) / b + ((stop[i] - 1) % c) / b + 1 +
+                     (last - first - 1) * chunkblocks;
+        }
+        *nchunks *= last - first + 1;
+        *nblocks *= blocks;
+        blocknitems *= b;
+    }
+
+    return (double) *nblocks * (double) (blocknitems * itemsize + CATERVA_ACCESS_BLOCK_COST) +
+           (double) *nchunks * CATERVA_ACCESS_CHUNK_COST;
+}
+
+// Add a slice to the statistics of an array
+static void record_access(caterva_array_t *array, const int64_t *start, const int64_t *stop) {
+    caterva_access_stats_t *stats = array->access_stats;
+    int64_t nbytes = array->itemsize;
+    for (int i = 0; i < array->ndim; ++i) {
+        int64_t extent = stop[i] - start[i];
+        int bin = 0;
+        while (bin < CATERVA_ACCESS_NBINS - 1 && (extent >> (bin + 1)) > 0) {
+            bin++;
+        }
+        stats->extents[i][bin]++;
+        nbytes *= extent;
+    }
+
+    int64_t nchunks;
+    int64_t nblocks;
+    get_slice_cost(array->ndim, start, stop, array->chunkshape, array->blockshape,
+                   array->itemsize, &nchunks, &nblocks);
+    stats->nchunks += nchunks;
+    stats->nblocks += nblocks;
+    stats->nbytes_used += nbytes;
+    stats->nbytes_touched += nblocks * array->blocknitems * array->itemsize;
+
+    int sample = (int) (stats->naccesses % CATERVA_ACCESS_NSAMPLES);
+    for (int i = 0; i < array->ndim; ++i) {
+        stats->sample_start[sample][i] = start[i];
+        stats->sample_stop[sample][i] = stop[i];
+    }
+    stats->naccesses++;
+}
+
 int caterva_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *start,
                              int64_t *stop, int64_t *shape, void *buffer,
                              int64_t buffersize) {
@@ -230,7 +508,7 @@ int caterva_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *
     CATERVA_ERROR_NULL(stop);
     CATERVA_ERROR_NULL(shape);
     CATERVA_ERROR_NULL(buffer);
-
+    CATERVA_ERROR(load_array(ctx, src));
 
     int64_t size = 1;
     for (int i = 0; i < src->ndim; ++i) {
@@ -259,10 +537,18 @@ int caterva_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *
             CATERVA_ERROR(
                 caterva_plainbuffer_array_get_slice_buffer(ctx, src, start, stop, shape, buffer));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(
+                caterva_sharded_array_get_slice_buffer(ctx, src, start, stop, shape, buffer));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
 
+    if (src->access_stats != NULL) {
+        record_access(src, start, stop);
+    }
+
     return CATERVA_SUCCEED;
 }
 
@@ -273,6 +559,10 @@ int caterva_set_slice_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersiz
     CATERVA_ERROR_NULL(start);
     CATERVA_ERROR_NULL(stop);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR(load_array(ctx, array));
+    if (array->readonly) {
+        CATERVA_ERROR(CATERVA_ERR_READ_ONLY);
+    }
 
     int64_t size = 1;
     for (int i = 0; i < array->ndim; ++i) {
@@ -289,12 +579,18 @@ int caterva_set_slice_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersiz
 
     switch (array->storage) {
         case CATERVA_STORAGE_BLOSC:
-            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+            CATERVA_ERROR(caterva_verify_drop_checksums(array));
+            CATERVA_ERROR(caterva_blosc_array_set_slice_buffer(
+                ctx, buffer, size * array->itemsize, start, stop, array));
             break;
         case CATERVA_STORAGE_PLAINBUFFER:
             CATERVA_ERROR(caterva_plainbuffer_array_set_slice_buffer(
                 ctx, buffer, size * array->itemsize, start, stop, array));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_set_slice_buffer(
+                ctx, buffer, size * array->itemsize, start, stop, array));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
@@ -310,6 +606,7 @@ int caterva_get_slice(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *start,
     CATERVA_ERROR_NULL(start);
     CATERVA_ERROR_NULL(stop);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR(load_array(ctx, src));
 
     caterva_params_t params;
     params.ndim = src->ndim;
@@ -331,6 +628,9 @@ int caterva_get_slice(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *start,
         case CATERVA_STORAGE_PLAINBUFFER:
             CATERVA_ERROR(caterva_plainbuffer_array_get_slice(ctx, src, start, stop, *array));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_get_slice(ctx, src, start, stop, *array));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
@@ -343,6 +643,10 @@ int caterva_get_slice(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *start,
 int caterva_squeeze(caterva_ctx_t *ctx, caterva_array_t *array) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR(load_array(ctx, array));
+    if (array->readonly) {
+        CATERVA_ERROR(CATERVA_ERR_READ_ONLY);
+    }
 
     switch (array->storage) {
         case CATERVA_STORAGE_BLOSC:
@@ -351,6 +655,9 @@ int caterva_squeeze(caterva_ctx_t *ctx, caterva_array_t *array) {
         case CATERVA_STORAGE_PLAINBUFFER:
             CATERVA_ERROR(caterva_plainbuffer_array_squeeze(ctx, array));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_squeeze(ctx, array));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
@@ -361,6 +668,10 @@ int caterva_squeeze(caterva_ctx_t *ctx, caterva_array_t *array) {
 int caterva_squeeze_index(caterva_ctx_t *ctx, caterva_array_t *array, bool *index) {
     CATERVA_ERROR_NULL(ctx);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR(load_array(ctx, array));
+    if (array->readonly) {
+        CATERVA_ERROR(CATERVA_ERR_READ_ONLY);
+    }
 
     switch (array->storage) {
         case CATERVA_STORAGE_BLOSC:
@@ -369,6 +680,9 @@ int caterva_squeeze_index(caterva_ctx_t *ctx, caterva_array_t *array, bool *inde
         case CATERVA_STORAGE_PLAINBUFFER:
             CATERVA_ERROR(caterva_plainbuffer_array_squeeze_index(ctx, array, index));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_squeeze_index(ctx, array, index));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
@@ -382,6 +696,7 @@ int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *st
     CATERVA_ERROR_NULL(src);
     CATERVA_ERROR_NULL(storage);
     CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR(load_array(ctx, src));
 
 
     caterva_params_t params;
@@ -398,6 +713,9 @@ int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *st
         case CATERVA_STORAGE_PLAINBUFFER:
             CATERVA_ERROR(caterva_plainbuffer_array_copy(ctx, &params, storage, src, array));
             break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_copy(ctx, &params, storage, src, array));
+            break;
         default:
             CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
     }
@@ -406,3 +724,478 @@ int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *st
 
     return CATERVA_SUCCEED;
 }
+
+int caterva_resize(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *new_shape) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(new_shape);
+    CATERVA_ERROR(load_array(ctx, array));
+    if (array->readonly) {
+        CATERVA_ERROR(CATERVA_ERR_READ_ONLY);
+    }
+
+    for (int i = 0; i < array->ndim; ++i) {
+        if (new_shape[i] < 0) {
+            DEBUG_PRINT("The new shape can not have negative dimensions");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    }
+
+    switch (array->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            CATERVA_ERROR(caterva_verify_drop_checksums(array));
+            CATERVA_ERROR(caterva_blosc_array_resize(ctx, array, new_shape));
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            CATERVA_ERROR(caterva_plainbuffer_array_resize(ctx, array, new_shape));
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_resize(ctx, array, new_shape));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_flush(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    switch (array->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            CATERVA_ERROR(caterva_blosc_array_flush(ctx, array));
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            CATERVA_ERROR(caterva_plainbuffer_array_flush(ctx, array));
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_flush(ctx, array));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_compact(caterva_ctx_t *ctx, caterva_array_t *array, bool recompress) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    CATERVA_ERROR(load_array(ctx, array));
+    if (array->readonly) {
+        CATERVA_ERROR(CATERVA_ERR_READ_ONLY);
+    }
+
+    switch (array->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            CATERVA_ERROR(caterva_blosc_array_compact(ctx, array, recompress));
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            CATERVA_ERROR(caterva_sharded_array_compact(ctx, array, recompress));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_verify(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads,
+                   caterva_verify_report_t *report) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(report);
+
+    CATERVA_ERROR(load_array(ctx, array));
+    CATERVA_ERROR(caterva_verify_array(ctx, array, nthreads, report));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_verify_report_free(caterva_ctx_t *ctx, caterva_verify_report_t *report) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(report);
+
+    if (report->bad_coords != NULL) {
+        ctx->cfg->free(report->bad_coords);
+        report->bad_coords = NULL;
+    }
+    report->nbad = 0;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_store_checksums(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR(load_array(ctx, array));
+    if (array->readonly) {
+        CATERVA_ERROR(CATERVA_ERR_READ_ONLY);
+    }
+
+    CATERVA_ERROR(caterva_verify_store_checksums(ctx, array, nthreads));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_advise(caterva_ctx_t *ctx, caterva_array_t *array, caterva_advice_t advice) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+
+    switch (array->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            array->advice = advice;
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            for (int64_t i = 0; i < array->nshards; ++i) {
+                CATERVA_ERROR(caterva_advise(ctx, array->shards[i], advice));
+            }
+            array->advice = advice;
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            CATERVA_ERROR(caterva_plainbuffer_array_advise(ctx, array, advice));
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Get the sizes (in bytes) of the L1, L2 and L3 data caches (common ones if they are unknown)
+static void get_cache_sizes(int64_t *sizes) {
+    sizes[0] = 32 * 1024;
+    sizes[1] = 256 * 1024;
+    sizes[2] = 8 * 1024 * 1024;
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && \
+    defined(_SC_LEVEL3_CACHE_SIZE)
+    long detected[3] = {sysconf(_SC_LEVEL1_DCACHE_SIZE), sysconf(_SC_LEVEL2_CACHE_SIZE),
+                        sysconf(_SC_LEVEL3_CACHE_SIZE)};
+    for (int i = 0; i < 3; ++i) {
+        if (detected[i] > 0) {
+            sizes[i] = detected[i];
+        }
+    }
+#elif defined(__APPLE__)
+    const char *names[3] = {"hw.l1dcachesize", "hw.l2cachesize", "hw.l3cachesize"};
+    for (int i = 0; i < 3; ++i) {
+        int64_t detected = 0;
+        size_t len = sizeof(detected);
+        if (sysctlbyname(names[i], &detected, &len, NULL, 0) == 0 && detected > 0) {
+            sizes[i] = detected;
+        }
+    }
+#endif
+    // Some CPUs lack an L3 cache (or report it per core)
+    if (sizes[2] < sizes[1]) {
+        sizes[2] = sizes[1];
+    }
+}
+
+// Fit up to nitems items in a shape bounded by bound, either giving them to the dimensions
+// from the last one to the first one (or from the first one if reversed) or spreading them
+// evenly among the dimensions
+static void fit_shape(int8_t ndim, const int64_t *bound, int64_t nitems,
+                      caterva_access_hint_t access_hint, int32_t *shape) {
+    bool fitted[CATERVA_MAX_DIM];
+    int nfree = 0;
+    for (int i = 0; i < ndim; ++i) {
+        fitted[i] = (bound[i] == 0);
+        shape[i] = (bound[i] == 0) ? 0 : 1;
+        nfree += !fitted[i];
+    }
+    if (nitems < 1) {
+        nitems = 1;
+    }
+
+    if (access_hint == CATERVA_ACCESS_RANDOM) {
+        // The dimensions shorter than the side of a hypercube are fitted first
+        double remaining = (double) nitems;
+        while (nfree > 0) {
+            double side = pow(remaining, 1. / nfree);
+            bool changed = false;
+            for (int i = 0; i < ndim; ++i) {
+                if (!fitted[i] && bound[i] <= side) {
+                    shape[i] = (int32_t) bound[i];
+                    remaining /= (double) bound[i];
+                    fitted[i] = true;
+                    nfree--;
+                    changed = true;
+                }
+            }
+            if (!changed) {
+                for (int i = 0; i < ndim; ++i) {
+                    if (!fitted[i]) {
+                        shape[i] = side < 1 ? 1 : (int32_t) side;
+                    }
+                }
+                break;
+            }
+        }
+        return;
+    }
+
+    int64_t remaining = nitems;
+    for (int j = 0; j < ndim; ++j) {
+        int i = (access_hint == CATERVA_ACCESS_COLUMNS) ? j : ndim - 1 - j;
+        if (fitted[i]) {
+            continue;
+        }
+        int64_t len = bound[i] < remaining ? bound[i] : remaining;
+        shape[i] = (int32_t) (len < 1 ? 1 : len);
+        remaining /= shape[i];
+    }
+}
+
+int caterva_suggest_shapes(caterva_ctx_t *ctx, caterva_params_t *params,
+                           caterva_access_hint_t access_hint, int32_t *chunkshape,
+                           int32_t *blockshape) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(params);
+    CATERVA_ERROR_NULL(chunkshape);
+    CATERVA_ERROR_NULL(blockshape);
+    if (params->itemsize <= 0) {
+        DEBUG_PRINT("The itemsize must be positive");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    int64_t caches[3];
+    get_cache_sizes(caches);
+    int64_t chunk_nbytes;
+    int64_t block_nbytes;
+    switch (access_hint) {
+        case CATERVA_ACCESS_WHOLE:
+            // Leave room in the caches for the destination and the compressed data (the L3
+            // cache reported is usually shared by all the cores)
+            chunk_nbytes = caches[2] / 2 < 8 * caches[1] ? caches[2] / 2 : 8 * caches[1];
+            block_nbytes = caches[1] / 2;
+            break;
+        case CATERVA_ACCESS_ROWS:
+        case CATERVA_ACCESS_COLUMNS:
+        case CATERVA_ACCESS_RANDOM:
+            // Only the blocks touched by a slice are decompressed, so they are kept small
+            chunk_nbytes = caches[1];
+            block_nbytes = caches[0] / 2;
+            break;
+        default:
+            DEBUG_PRINT("Unknown access hint");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    fit_shape(params->ndim, params->shape, chunk_nbytes / params->itemsize, access_hint,
+              chunkshape);
+    int64_t chunkshape_[CATERVA_MAX_DIM];
+    for (int i = 0; i < params->ndim; ++i) {
+        chunkshape_[i] = chunkshape[i];
+    }
+    fit_shape(params->ndim, chunkshape_, block_nbytes / params->itemsize, access_hint,
+              blockshape);
+
+    // Avoid padding blocks inside the chunks that do not span a whole dimension
+    for (int i = 0; i < params->ndim; ++i) {
+        if (chunkshape[i] < params->shape[i] && chunkshape[i] % blockshape[i] != 0) {
+            chunkshape[i] -= chunkshape[i] % blockshape[i];
+        }
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_record_accesses(caterva_ctx_t *ctx, caterva_array_t *array, bool record) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    if (array->storage != CATERVA_STORAGE_BLOSC) {
+        DEBUG_PRINT("Only the slices of arrays backed by a Blosc super-chunk can be recorded");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    if (!record) {
+        if (array->access_stats != NULL) {
+            ctx->cfg->free(array->access_stats);
+            array->access_stats = NULL;
+        }
+        return CATERVA_SUCCEED;
+    }
+    if (array->access_stats == NULL) {
+        array->access_stats = ctx->cfg->alloc(sizeof(caterva_access_stats_t));
+        CATERVA_ERROR_NULL(array->access_stats);
+        memset(array->access_stats, 0, sizeof(caterva_access_stats_t));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Estimate the cost of the slices sampled with some shapes
+static double get_sampled_cost(caterva_array_t *array, const int32_t *chunkshape,
+                               const int32_t *blockshape) {
+    caterva_access_stats_t *stats = array->access_stats;
+    int64_t nsamples = stats->naccesses < CATERVA_ACCESS_NSAMPLES ? stats->naccesses
+                                                                   : CATERVA_ACCESS_NSAMPLES;
+    double cost = 0;
+    for (int i = 0; i < nsamples; ++i) {
+        int64_t nchunks;
+        int64_t nblocks;
+        cost += get_slice_cost(array->ndim, stats->sample_start[i], stats->sample_stop[i],
+                               chunkshape, blockshape, array->itemsize, &nchunks, &nblocks);
+    }
+
+    return cost;
+}
+
+int caterva_recommend_shapes(caterva_ctx_t *ctx, caterva_array_t *array, int32_t *chunkshape,
+                             int32_t *blockshape, double *speedup) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(chunkshape);
+    CATERVA_ERROR_NULL(blockshape);
+    CATERVA_ERROR_NULL(speedup);
+    if (array->access_stats == NULL) {
+        DEBUG_PRINT("The slices of the array are not recorded");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    for (int i = 0; i < array->ndim; ++i) {
+        chunkshape[i] = array->chunkshape[i];
+        blockshape[i] = array->blockshape[i];
+    }
+    double current_cost = get_sampled_cost(array, array->chunkshape, array->blockshape);
+    double best_cost = current_cost;
+
+    caterva_params_t params;
+    params.itemsize = array->itemsize;
+    params.ndim = array->ndim;
+    for (int i = 0; i < array->ndim; ++i) {
+        params.shape[i] = array->shape[i];
+    }
+    caterva_access_hint_t hints[] = {CATERVA_ACCESS_WHOLE, CATERVA_ACCESS_ROWS,
+                                     CATERVA_ACCESS_COLUMNS, CATERVA_ACCESS_RANDOM};
+    for (int h = 0; h < 4; ++h) {
+        int32_t chunkshape_[CATERVA_MAX_DIM];
+        int32_t blockshape_[CATERVA_MAX_DIM];
+        CATERVA_ERROR(caterva_suggest_shapes(ctx, &params, hints[h], chunkshape_, blockshape_));
+        double cost = get_sampled_cost(array, chunkshape_, blockshape_);
+        if (cost < best_cost) {
+            best_cost = cost;
+            for (int i = 0; i < array->ndim; ++i) {
+                chunkshape[i] = chunkshape_[i];
+                blockshape[i] = blockshape_[i];
+            }
+        }
+    }
+    *speedup = best_cost > 0 ? current_cost / best_cost : 1;
+
+    return CATERVA_SUCCEED;
+}
+
+static void print_shape(FILE *stream, int8_t ndim, const int32_t *shape) {
+    fprintf(stream, "(");
+    for (int i = 0; i < ndim; ++i) {
+        fprintf(stream, i == 0 ? "%d" : ", %d", shape[i]);
+    }
+    fprintf(stream, ")");
+}
+
+int caterva_access_report(caterva_ctx_t *ctx, caterva_array_t *array, FILE *stream) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(stream);
+    caterva_access_stats_t *stats = array->access_stats;
+    if (stats == NULL) {
+        DEBUG_PRINT("The slices of the array are not recorded");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    fprintf(stream, "Slices read: %lld\n", (long long) stats->naccesses);
+    if (stats->naccesses == 0) {
+        return CATERVA_SUCCEED;
+    }
+    for (int i = 0; i < array->ndim; ++i) {
+        fprintf(stream, "Extents of dimension %d:", i);
+        for (int bin = 0; bin < CATERVA_ACCESS_NBINS; ++bin) {
+            if (stats->extents[i][bin] != 0) {
+                fprintf(stream, " [%lld, %lld): %lld", bin == 0 ? 0LL : 1LL << bin,
+                        1LL << (bin + 1), (long long) stats->extents[i][bin]);
+            }
+        }
+        fprintf(stream, "\n");
+    }
+    fprintf(stream, "Chunks touched per slice: %.2f\n",
+            (double) stats->nchunks / (double) stats->naccesses);
+    fprintf(stream, "Blocks touched per slice: %.2f\n",
+            (double) stats->nblocks / (double) stats->naccesses);
+    fprintf(stream, "Bytes used: %lld of %lld touched (%.1f%%)\n",
+            (long long) stats->nbytes_used, (long long) stats->nbytes_touched,
+            stats->nbytes_touched > 0 ? 100. * (double) stats->nbytes_used /
+                                        (double) stats->nbytes_touched : 100.);
+    caterva_ccache_stats_t *ccache_stats = &array->ccache_stats;
+    if (ccache_stats->nhits + ccache_stats->nmisses > 0) {
+        fprintf(stream, "Compressed chunk cache: %lld hits, %lld misses (%.1f%% hit rate)\n",
+                (long long) ccache_stats->nhits, (long long) ccache_stats->nmisses,
+                100. * (double) ccache_stats->nhits /
+                (double) (ccache_stats->nhits + ccache_stats->nmisses));
+    }
+
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    double speedup;
+    CATERVA_ERROR(caterva_recommend_shapes(ctx, array, chunkshape, blockshape, &speedup));
+    fprintf(stream, "Current chunkshape: ");
+    print_shape(stream, array->ndim, array->chunkshape);
+    fprintf(stream, ", blockshape: ");
+    print_shape(stream, array->ndim, array->blockshape);
+    fprintf(stream, "\nRecommended chunkshape: ");
+    print_shape(stream, array->ndim, chunkshape);
+    fprintf(stream, ", blockshape: ");
+    print_shape(stream, array->ndim, blockshape);
+    fprintf(stream, " (estimated speedup: %.2fx)\n", speedup);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_ccache_stats(caterva_ctx_t *ctx, caterva_array_t *array,
+                         caterva_ccache_stats_t *stats) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(stats);
+
+    memset(stats, 0, sizeof(caterva_ccache_stats_t));
+    switch (array->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            *stats = array->ccache_stats;
+            break;
+        case CATERVA_STORAGE_PLAINBUFFER:
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            for (int64_t i = 0; i < array->nshards; ++i) {
+                caterva_ccache_stats_t shard_stats;
+                CATERVA_ERROR(caterva_ccache_stats(ctx, array->shards[i], &shard_stats));
+                stats->nhits += shard_stats.nhits;
+                stats->nmisses += shard_stats.nmisses;
+                stats->nevictions += shard_stats.nevictions;
+                stats->nchunks += shard_stats.nchunks;
+                stats->nbytes += shard_stats.nbytes;
+            }
+            break;
+        default:
+            CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_reduce(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                   caterva_reduce_op_t op, bool *axes, caterva_storage_t *storage,
+                   caterva_array_t **out) {
+    CATERVA_ERROR_NULL(ctx);
+    CATERVA_ERROR_NULL(array);
+    CATERVA_ERROR_NULL(storage);
+    CATERVA_ERROR_NULL(out);
+
+    CATERVA_ERROR(load_array(ctx, array));
+    CATERVA_ERROR(caterva_reduce_array(ctx, array, dtype, op, axes, storage, out));
+
+    return CATERVA_SUCCEED;
+}
@@ -39,6 +39,7 @@
 #define CATERVA_ERR_INVALID_STORAGE 4
 #define CATERVA_ERR_NULL_POINTER 5
 #define CATERVA_ERR_INVALID_INDEX  5
+#define CATERVA_ERR_READ_ONLY 6
 
 #ifdef NDEBUG
 #define DEBUG_PRINT(...) \
@@ -82,13 +83,15 @@ static char *print_error(int rc) {
             return "Pointer is null";
         case CATERVA_ERR_BLOSC_FAILED:
             return "Blosc failed";
+        case CATERVA_ERR_READ_ONLY:
+            return "Array is read-only";
         default:
             return "Unknown error";
     }
 }
 
 /* The version for metalayer format; starts from 0 and it must not exceed 127 */
-#define CATERVA_METALAYER_VERSION 0
+#define CATERVA_METALAYER_VERSION 2
 
 /* The maximum number of dimensions for caterva arrays */
 #define CATERVA_MAX_DIM 8
@@ -96,6 +99,41 @@ static char *print_error(int rc) {
 /* The maximum number of metalayers for caterva arrays */
 #define CATERVA_MAX_METALAYERS BLOSC2_MAX_METALAYERS - 1
 
+/* The number of chunks that can be kept decompressed in the write-back cache of an array */
+#define CATERVA_WRITE_CACHE_NCHUNKS 8
+
+/* The maximum number of codec candidates for the adaptive codec selection */
+#define CATERVA_MAX_CODEC_CANDIDATES 8
+
+/* The number of bins of the histograms of the slice extents (powers of 2) */
+#define CATERVA_ACCESS_NBINS 32
+
+/* The number of recent slices kept to estimate the cost of other shapes */
+#define CATERVA_ACCESS_NSAMPLES 64
+
+/**
+ * @brief A compression setting that the adaptive codec selection can choose for a chunk.
+ */
+typedef struct {
+    uint8_t compcodec;
+    //!< The codec used in compression.
+    uint8_t complevel;
+    //!< The compression level used in Blosc.
+    uint8_t shuffle;
+    //!< The shuffle filter (@p BLOSC_NOSHUFFLE, @p BLOSC_SHUFFLE or @p BLOSC_BITSHUFFLE). It
+    //!< replaces the last filter of the configuration.
+} caterva_codec_candidate_t;
+
+/**
+ * @brief The targets of the adaptive codec selection.
+ */
+typedef enum {
+    CATERVA_CODEC_TARGET_RATIO,
+    //!< Choose the fastest candidate reaching @p target_ratio (or the one with the best ratio).
+    CATERVA_CODEC_TARGET_SPEED,
+    //!< Choose the candidate with the best ratio reaching @p target_speed (or the fastest one).
+} caterva_codec_target_t;
+
 /**
  * @brief Configuration parameters used to create a caterva context.
  */
@@ -120,6 +158,25 @@ typedef struct {
     //!< Defines the function that is applied to the data before compressing it.
     blosc2_prefilter_params *pparams;
     //!< Indicates the parameters of the prefilter function.
+    int ncandidates;
+    //!< Number of codec candidates for the adaptive codec selection. If it is 0, all the chunks
+    //!< are compressed with @p compcodec, @p complevel and @p filters.
+    caterva_codec_candidate_t candidates[CATERVA_MAX_CODEC_CANDIDATES];
+    //!< The codec candidates. A few blocks of each chunk are compressed with each one of them
+    //!< before choosing the one used for the chunk.
+    caterva_codec_target_t codec_target;
+    //!< The target of the adaptive codec selection.
+    double target_ratio;
+    //!< The compression ratio to reach with @p CATERVA_CODEC_TARGET_RATIO.
+    double target_speed;
+    //!< The compression speed (in MB/s) to reach with @p CATERVA_CODEC_TARGET_SPEED.
+    int io_depth;
+    //!< Number of chunks of an array stored on disk read concurrently (ahead of their
+    //!< decompression) when a slice is read. If it is lower than 2, the chunks are read one by one.
+    int64_t ccache_size;
+    //!< The budget (in bytes) of the cache of compressed chunks of each array stored on disk. The
+    //!< chunks read from the disk are kept in this cache, so that reading them again does not
+    //!< require any I/O. If it is 0, the cache is not used.
 } caterva_config_t;
 
 /**
@@ -153,8 +210,111 @@ typedef enum {
     //!< Indicates that the data is stored using a Blosc super-chunk.
     CATERVA_STORAGE_PLAINBUFFER,
     //!< Indicates that the data is stored using a plain buffer.
+    CATERVA_STORAGE_SHARDED,
+    //!< Indicates that the data is stored using several Blosc super-chunks (shards), each one
+    //!< holding a slab of chunks along the first dimension. The shards are independent arrays,
+    //!< so the whole-array operations and the slices spanning several shards are spread over
+    //!< the threads of the context (each shard handled by a single thread).
 } caterva_storage_backend_t;
 
+/**
+ * @brief The orders in which the chunks of an array are stored in its Blosc super-chunk.
+ */
+typedef enum {
+    CATERVA_CHUNK_ORDER_ROW_MAJOR,
+    //!< The chunks are stored in row-major order of the chunk grid.
+    CATERVA_CHUNK_ORDER_MORTON,
+    //!< The chunks are stored along a Z-order (Morton) curve over the chunk grid.
+    CATERVA_CHUNK_ORDER_HILBERT,
+    //!< The chunks are stored along a Hilbert curve over the chunk grid.
+} caterva_chunk_order_t;
+
+/**
+ * @brief The orders in which the blocks of a chunk are placed in it.
+ */
+typedef enum {
+    CATERVA_BLOCK_ORDER_ROW_MAJOR,
+    //!< The blocks are placed in row-major order of the block grid of the chunk.
+    CATERVA_BLOCK_ORDER_MORTON,
+    //!< The blocks are placed along a Z-order (Morton) curve over the block grid of the chunk.
+} caterva_block_order_t;
+
+/**
+ * @brief The access patterns used to suggest the chunk and block shapes of an array.
+ */
+typedef enum {
+    CATERVA_ACCESS_WHOLE,
+    //!< The whole array is read at once.
+    CATERVA_ACCESS_ROWS,
+    //!< Slices spanning the last dimension are read (rows in a 2-dim array).
+    CATERVA_ACCESS_COLUMNS,
+    //!< Slices spanning the first dimension are read (columns in a 2-dim array).
+    CATERVA_ACCESS_RANDOM,
+    //!< Small regions of interest are read in random positions.
+} caterva_access_hint_t;
+
+/**
+ * @brief The access patterns advised to the kernel for the arrays mapped from a file (or to
+ * caterva for the arrays stored in a sequential frame on disk).
+ */
+typedef enum {
+    CATERVA_ADVICE_NORMAL,
+    //!< No special treatment (the default read-ahead of the system is used).
+    CATERVA_ADVICE_SEQUENTIAL,
+    //!< The array is read in increasing order (aggressive read-ahead).
+    CATERVA_ADVICE_RANDOM,
+    //!< The array is read in random order (no read-ahead).
+    CATERVA_ADVICE_WILLNEED,
+    //!< The whole array will be read soon (it is loaded into the page cache in the background).
+    CATERVA_ADVICE_DIRECT,
+    //!< The array is scanned whole without going through the page cache. caterva_to_buffer()
+    //!< streams the chunks of the sequential frame with direct I/O, in aligned extents located
+    //!< with the offsets index of the frame and reading ahead up to @p io_depth regions at once,
+    //!< so only the extent being decompressed is kept in memory. The mapped plain buffers are
+    //!< read sequentially.
+} caterva_advice_t;
+
+/**
+ * @brief The data types of the items of an array that can be reduced.
+ */
+typedef enum {
+    CATERVA_DTYPE_INT8,
+    //!< 8-bit signed integers.
+    CATERVA_DTYPE_INT16,
+    //!< 16-bit signed integers.
+    CATERVA_DTYPE_INT32,
+    //!< 32-bit signed integers.
+    CATERVA_DTYPE_INT64,
+    //!< 64-bit signed integers.
+    CATERVA_DTYPE_UINT8,
+    //!< 8-bit unsigned integers.
+    CATERVA_DTYPE_UINT16,
+    //!< 16-bit unsigned integers.
+    CATERVA_DTYPE_UINT32,
+    //!< 32-bit unsigned integers.
+    CATERVA_DTYPE_UINT64,
+    //!< 64-bit unsigned integers.
+    CATERVA_DTYPE_FLOAT32,
+    //!< Single precision floats.
+    CATERVA_DTYPE_FLOAT64,
+    //!< Double precision floats.
+} caterva_dtype_t;
+
+/**
+ * @brief The reductions computed along the axes of an array.
+ */
+typedef enum {
+    CATERVA_REDUCE_SUM,
+    //!< The sum of the items (the integers are added up as 64-bit integers and the floats as
+    //!< doubles).
+    CATERVA_REDUCE_MIN,
+    //!< The minimum of the items (NaN if any of them is NaN).
+    CATERVA_REDUCE_MAX,
+    //!< The maximum of the items (NaN if any of them is NaN).
+    CATERVA_REDUCE_MEAN,
+    //!< The mean of the items, as a double.
+} caterva_reduce_op_t;
+
 /**
  * @brief The metalayer data needed to store it on an array
  */
@@ -184,6 +344,22 @@ typedef struct {
     //!< List with the metalayers desired.
     int32_t nmetalayers;
     //!< The number of metalayers.
+    bool extendable;
+    //!< Flag to indicate if the array can grow indefinitely along @p extendable_axis.
+    int8_t extendable_axis;
+    //!< The axis along which chunks can be appended once the array is filled.
+    bool sparse;
+    //!< Flag to indicate if the chunks filled with @p fill_value are not stored.
+    void *fill_value;
+    //!< The value (of @p itemsize bytes) of the items in the chunks not stored. If it is @p NULL,
+    //!< zeros are used.
+    caterva_chunk_order_t chunk_order;
+    //!< The order in which the chunks are stored. Curve orders keep the chunks of compact
+    //!< regions close in the super-chunk, but the arrays can not be extendable, resized or
+    //!< committed in groups.
+    caterva_block_order_t block_order;
+    //!< The order in which the blocks are placed in each chunk. The Z-order keeps the blocks of
+    //!< compact regions close in the decompressed chunks.
 } caterva_storage_properties_blosc_t;
 
 /**
@@ -191,10 +367,30 @@ typedef struct {
  */
 typedef struct {
     char *urlpath;
-    //!< The plain buffer name. If @p urlpath is not @p NULL, the plain buffer will be stored on
-    //!< disk. (Not implemented yet).
+    //!< The plain buffer name. If @p urlpath is not @p NULL, the plain buffer is stored on disk
+    //!< (after a small header with the shape and the itemsize) and mapped into memory.
+    caterva_advice_t advice;
+    //!< The access pattern advised for the plain buffer mapped from @p urlpath.
 } caterva_storage_properties_plainbuffer_t;
 
+/**
+ * @brief The storage properties for an array backed by several Blosc super-chunks (shards).
+ */
+typedef struct {
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    //!< The shape of each chunk of Blosc.
+    int32_t blockshape[CATERVA_MAX_DIM];
+    //!< The shape of each block of Blosc.
+    int32_t shard_nchunks;
+    //!< The number of chunks along the first dimension stored in each shard.
+    bool sequencial;
+    //!< Flag to indicate if the super-chunks of the shards are stored sequentially or sparsely.
+    char *urlpath;
+    //!< The name of the manifest of the shards. If @p urlpath is not @p NULL, the manifest is
+    //!< stored on disk and every shard is stored next to it, in a frame named after the manifest
+    //!< followed by a dot and the shard number.
+} caterva_storage_properties_sharded_t;
+
 /**
  * @brief The storage properties for an array.
  */
@@ -203,8 +399,69 @@ typedef union {
     //!< The storage properties when the array is backed by a Blosc super-chunk.
     caterva_storage_properties_plainbuffer_t plainbuffer;
     //!< The storage properties when the array is backed by a plain buffer.
+    caterva_storage_properties_sharded_t sharded;
+    //!< The storage properties when the array is backed by several Blosc super-chunks.
 } caterva_storage_properties_t;
 
+/**
+ * @brief A region of a stream read at once by an I/O backend.
+ */
+typedef struct {
+    void *data;
+    //!< The buffer where the bytes are read.
+    int64_t size;
+    //!< Number of bytes.
+    int64_t offset;
+    //!< The offset of the region in the stream.
+} caterva_io_vec_t;
+
+/**
+ * @brief The function called by an I/O backend when a region read asynchronously is completed.
+ *
+ * The first argument is the number of bytes read (negative on failure), and the second one is
+ * the pointer passed to @p pread_async.
+ */
+typedef void (*caterva_io_done_cb_t)(int64_t nbytes, void *userdata);
+
+/**
+ * @brief An I/O backend storing the chunks of arrays (see caterva_storage_t and caterva_open_io()).
+ *
+ * The streams are opened with a mode like fopen() ("rb" for reading them, "r+b" for reading and
+ * writing them and "w+b" for truncating them too). Only @p preadv and @p pread_async are
+ * optional.
+ *
+ * Every chunk is read and written on its own. The chunks are appended to the stream when the
+ * array is flushed, followed by a tail with the metadata of the array and the index of the
+ * chunks. The superblock at the start of the stream is only replaced once they are synced, so
+ * that a failed flush keeps the previous tail. The space of the chunks that are replaced is not
+ * reclaimed, but the array can be copied to another stream (see caterva_copy()).
+ */
+typedef struct {
+    void *(*open)(const char *urlpath, const char *mode, void *params);
+    //!< Open a stream (it returns NULL on failure).
+    int (*close)(void *stream);
+    //!< Close a stream (it returns 0 on success).
+    int64_t (*pread)(void *stream, void *data, int64_t size, int64_t offset);
+    //!< Read up to @p size bytes at an offset (it returns the number of bytes read).
+    int64_t (*pwrite)(void *stream, const void *data, int64_t size, int64_t offset);
+    //!< Write up to @p size bytes at an offset (it returns the number of bytes written).
+    int64_t (*size)(void *stream);
+    //!< Get the size of a stream (negative on failure).
+    int (*sync)(void *stream);
+    //!< Make the bytes written durable (it returns 0 on success).
+    int64_t (*preadv)(void *stream, caterva_io_vec_t *vecs, int nvecs);
+    //!< Read several regions at once (it returns the total number of bytes read). If it is
+    //!< NULL, the regions are read one by one with @p pread.
+    int (*pread_async)(void *stream, caterva_io_vec_t *vecs, int nvecs,
+                       caterva_io_done_cb_t done_cb, void *userdata);
+    //!< Start reading several regions, calling @p done_cb (maybe from another thread) once for
+    //!< every region completed. It returns the number of regions started, which must be the
+    //!< first ones (the rest are read with @p pread once the ones started are completed). If it
+    //!< is NULL, the regions are read synchronously.
+    void *params;
+    //!< The pointer passed to @p open.
+} caterva_io_t;
+
 /**
  * @brief Storage parameters needed for the creation of a caterva array.
  */
@@ -213,6 +470,11 @@ typedef struct {
     //!< The backend storage.
     caterva_storage_properties_t properties;
     //!< The specific properties for the selected @p backend.
+    const caterva_io_t *io;
+    //!< The I/O backend storing the chunks at the urlpath of the @p properties (NULL for the
+    //!< local files handled by Blosc). It is only supported by arrays backed by a Blosc
+    //!< super-chunk stored in a sequential frame. The chunks are read from the backend when they
+    //!< are needed, and written to it when the array is flushed.
 } caterva_storage_t;
 
 /**
@@ -238,12 +500,69 @@ struct chunk_cache_s {
     //!< Pointer to the chunk data.
     int32_t nchunk;
     //!< The chunk number in cache. If @p nchunk equals to -1, it means that the cache is empty.
+    bool dirty;
+    //!< Indicate if the chunk in cache has been modified and has not been stored yet.
+    int64_t access;
+    //!< The last access to the chunk in cache. It is used to choose the chunk to be evicted.
 };
 
 /**
- * @brief A multidimensional array of data that can be compressed data.
+ * @brief A compressed chunk kept in the cache of compressed chunks of an array.
+ */
+struct ccache_entry_s {
+    uint8_t *cchunk;
+    //!< Pointer to the compressed chunk (NULL if the entry is empty).
+    int32_t cbytes;
+    //!< The size (in bytes) of the compressed chunk.
+    int64_t index;
+    //!< The index of the chunk in the super-chunk (the next empty entry if the entry is empty).
+    bool referenced;
+    //!< Indicate if the chunk has been read since the last time it was considered for eviction.
+};
+
+/**
+ * @brief The statistics of the cache of compressed chunks of an array.
  */
 typedef struct {
+    int64_t nhits;
+    //!< Number of chunks found in the cache.
+    int64_t nmisses;
+    //!< Number of chunks read from the disk.
+    int64_t nevictions;
+    //!< Number of chunks evicted to stay within the budget.
+    int64_t nchunks;
+    //!< Number of chunks in the cache.
+    int64_t nbytes;
+    //!< Number of bytes of the chunks in the cache.
+} caterva_ccache_stats_t;
+
+/**
+ * @brief The statistics of the slices read from an array with caterva_get_slice_buffer().
+ */
+typedef struct {
+    int64_t naccesses;
+    //!< Number of slices read.
+    int64_t extents[CATERVA_MAX_DIM][CATERVA_ACCESS_NBINS];
+    //!< Histograms of the slice extents in each dimension. The bin @p k counts the extents
+    //!< between 2^k and 2^(k+1) - 1 (the bin 0 also counts the empty extents).
+    int64_t nchunks;
+    //!< Number of chunks touched by the slices.
+    int64_t nblocks;
+    //!< Number of blocks touched by the slices.
+    int64_t nbytes_used;
+    //!< Number of bytes returned by the slices.
+    int64_t nbytes_touched;
+    //!< Number of bytes of the blocks touched by the slices.
+    int64_t sample_start[CATERVA_ACCESS_NSAMPLES][CATERVA_MAX_DIM];
+    //!< The start of the last slices read.
+    int64_t sample_stop[CATERVA_ACCESS_NSAMPLES][CATERVA_MAX_DIM];
+    //!< The stop of the last slices read.
+} caterva_access_stats_t;
+
+/**
+ * @brief A multidimensional array of data that can be compressed data.
+ */
+typedef struct caterva_array_s {
     caterva_storage_backend_t storage;
     //!< Storage type.
     blosc2_schunk *sc;
@@ -252,6 +571,18 @@ typedef struct {
     uint8_t *buf;
     //!< Pointer to a plain buffer where data is stored.
     //!< Only is used if \p storage equals to @p CATERVA_STORAGE_PLAINBUFFER.
+    uint8_t *map;
+    //!< Pointer to the mapping of the file where the array is stored (NULL if it is not mapped).
+    //!< The plain buffer follows the header of the file, and the frame of a Blosc super-chunk
+    //!< takes the whole file.
+    int64_t map_len;
+    //!< The length (in bytes) of the mapping.
+    char *map_urlpath;
+    //!< The name of the file where the plain buffer is stored.
+    caterva_advice_t advice;
+    //!< The access pattern advised for the mapping.
+    int64_t ndirect_scans;
+    //!< Number of times caterva_to_buffer() has read the frame with direct I/O.
     int64_t shape[CATERVA_MAX_DIM];
     //!< Shape of original data.
     int32_t chunkshape[CATERVA_MAX_DIM];
@@ -283,12 +614,108 @@ typedef struct {
     //!< Size of each item.
     bool empty;
     //!< Indicate if an array is empty or is filled with data.
+    bool readonly;
+    //!< Indicate if an array can not be modified (its frame is mapped read-only, it references a
+    //!< serialized super-chunk owned by the caller or it has chunks not committed yet).
+    char *lazy_urlpath;
+    //!< The file whose super-chunk is loaded on the first access to the data of an array opened
+    //!< lazily (NULL once it is loaded).
     bool filled;
     //!< Indicate if an array is completely filled or not.
     int64_t nchunks;
     //!< Number of chunks in the array.
+    bool extendable;
+    //!< Indicate if the array can grow indefinitely along @p extendable_axis.
+    int8_t extendable_axis;
+    //!< The axis along which the array grows when it is extendable.
+    int32_t pending_slabs;
+    //!< Number of slabs appended along @p extendable_axis not stored in the metalayer yet.
+    bool sparse;
+    //!< Indicate if the chunks filled with @p fill_value are not stored.
+    uint8_t *fill_value;
+    //!< The value of the items in the chunks not stored. It is only used if @p sparse is true.
+    uint8_t *chunk_presence;
+    //!< A bitmap indicating which chunks are stored. It is only used if @p sparse is true.
+    int64_t *chunk_ranks;
+    //!< A Fenwick tree with the number of chunks stored in each byte of @p chunk_presence.
+    bool chunk_presence_dirty;
+    //!< Indicate if @p chunk_presence has been modified and has not been stored yet.
+    blosc2_context *codec_cctx[CATERVA_MAX_CODEC_CANDIDATES];
+    //!< The compression contexts of the codec candidates (created when they are first used).
+    caterva_codec_candidate_t codec_candidates[CATERVA_MAX_CODEC_CANDIDATES];
+    //!< The codec candidates @p codec_cctx were created for.
+    int codec_ncandidates;
+    //!< Number of compression contexts in @p codec_cctx.
+    int64_t codec_nchunks[CATERVA_MAX_CODEC_CANDIDATES];
+    //!< Number of chunks compressed with each codec candidate (since they were last changed).
+    caterva_chunk_order_t chunk_order;
+    //!< The order in which the chunks are stored in the super-chunk.
+    int64_t *chunk_positions;
+    //!< The position along the chunk order of each chunk of the grid (NULL for row-major order).
+    caterva_block_order_t block_order;
+    //!< The order in which the blocks are placed in each chunk.
+    int64_t *block_positions;
+    //!< The position along the block order of each block of a chunk (NULL for row-major order).
     struct chunk_cache_s chunk_cache;
     //!< A partition cache.
+    struct chunk_cache_s write_cache[CATERVA_WRITE_CACHE_NCHUNKS];
+    //!< A write-back cache with the chunks modified by caterva_set_slice_buffer().
+    int64_t write_cache_access;
+    //!< Number of accesses to the write-back cache.
+    struct ccache_entry_s *ccache;
+    //!< The cache of compressed chunks (NULL if it is not used).
+    int64_t ccache_len;
+    //!< Number of entries of @p ccache.
+    int64_t ccache_free;
+    //!< The first empty entry of @p ccache (-1 if there is none).
+    int64_t *ccache_slots;
+    //!< The entry of @p ccache keeping every chunk index (-1 if the chunk is not kept).
+    int64_t ccache_nslots;
+    //!< Number of chunk indexes in @p ccache_slots.
+    int64_t ccache_hand;
+    //!< The next entry of @p ccache considered for eviction (CLOCK).
+    caterva_ccache_stats_t ccache_stats;
+    //!< The statistics of @p ccache.
+    blosc2_schunk **reader_scs;
+    //!< The handles of the frame opened by the threads reading ahead the chunks of a slice (kept
+    //!< for the next slices until the chunks on disk change).
+    int reader_nscs;
+    //!< Number of handles in @p reader_scs.
+    caterva_access_stats_t *access_stats;
+    //!< The statistics of the slices read (NULL if they are not recorded).
+    bool checksums_dropped;
+    //!< Whether the checksums of the chunks are known to be dropped (or not stored), so that they
+    //!< do not have to be dropped again when the array is modified.
+    const caterva_io_t *io;
+    //!< The I/O backend where the chunks of the super-chunk are written (NULL if it is not used).
+    char *io_urlpath;
+    //!< The urlpath of the stream in @p io.
+    void *io_stream;
+    //!< The stream of the array in @p io.
+    int64_t *io_offsets;
+    //!< The offsets in the stream of the chunks of the super-chunk (negative for the chunks
+    //!< held by the super-chunk, which are written when the array is flushed).
+    int32_t *io_cbytes;
+    //!< The compressed sizes of the chunks in the stream.
+    int64_t io_nslots;
+    //!< Number of slots of @p io_offsets and @p io_cbytes.
+    int64_t io_end;
+    //!< The end of the bytes written in the stream, where the next chunks are appended.
+    uint8_t *io_tail;
+    //!< The last tail written in the stream (it is not written again if it does not change).
+    int64_t io_tail_len;
+    //!< The length of @p io_tail.
+    struct caterva_array_s **shards;
+    //!< The arrays backed by a Blosc super-chunk storing the slabs of chunks along the first
+    //!< dimension. Only is used if @p storage equals to @p CATERVA_STORAGE_SHARDED.
+    int64_t nshards;
+    //!< Number of shards.
+    int32_t shard_nchunks;
+    //!< Number of chunks along the first dimension stored in each shard.
+    bool shard_sequencial;
+    //!< Indicate if the super-chunks of the shards are stored sequentially or sparsely.
+    char *shard_urlpath;
+    //!< The name of the manifest of the shards (NULL if they are stored in memory).
 } caterva_array_t;
 
 /**
@@ -336,6 +763,10 @@ int caterva_free(caterva_ctx_t *ctx, caterva_array_t **array);
 /**
  * Append a chunk to a caterva array (until it is completely filled).
  *
+ * If the array is extendable, once it is filled the chunks are appended along its extendable
+ * axis, one slab (a layer of chunks with the chunkshape size in that axis) at a time. The array
+ * shape grows each time a slab is completed.
+ *
  * @param ctx Pointer to the caterva context to be used.
  * @param array Pointer to the caterva array.
  * @param chunk Pointer to the buffer where the chunk data is stored.
@@ -373,9 +804,116 @@ caterva_from_schunk(caterva_ctx_t *ctx, blosc2_schunk *schunk, caterva_array_t *
 int caterva_from_serial_schunk(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64_t len,
                                caterva_array_t **array);
 
+/**
+ * @brief Create a read-only caterva array referencing a serialized super-chunk without copying it.
+ *
+ * The chunks are decompressed straight from @p serial_schunk, so only the metadata is read when
+ * the array is created. The buffer is owned by the caller: it must stay valid and unmodified until
+ * the array is freed, and it is not released by caterva_free(). The array can not be modified (use
+ * caterva_copy() to get an independent array).
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param serial_schunk The serialized super-chunk where the caterva array is stored.
+ * @param len The size (in bytes) of the serialized super-chunk.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_from_serial_schunk_view(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64_t len,
+                                    caterva_array_t **array);
+
+/**
+ * @brief The function receiving the bytes of an array serialized with caterva_serialize_stream().
+ *
+ * @param data The bytes to write.
+ * @param size The number of bytes to write.
+ * @param userdata The pointer passed to caterva_serialize_stream().
+ *
+ * @return The number of bytes written (any value different from @p size stops the serialization).
+ */
+typedef int64_t (*caterva_write_cb_t)(const void *data, int64_t size, void *userdata);
+
+/**
+ * @brief Serialize a caterva array progressively, passing its bytes to a function.
+ *
+ * The stream starts with a header with the geometry of the array, followed by the metalayers and
+ * the variable-length metalayers set by the user (the ones of the first shard for sharded
+ * arrays), the compressed chunks of the grid in row-major order (as stored by Blosc), an index
+ * with the offset of every chunk in the stream and a trailer with the offset of the index. Only
+ * one chunk is kept in memory at a time, so the array can be sent to a socket or a file without
+ * building the whole serialization in memory. It can only be used if the array is backed by Blosc
+ * super-chunks (@p CATERVA_STORAGE_BLOSC or @p CATERVA_STORAGE_SHARDED) and it is filled.
+ *
+ * The stream is not a Blosc frame, so it can only be read with caterva_deserialize_stream() (and
+ * not with caterva_open() or caterva_from_serial_schunk()).
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array The caterva array to serialize.
+ * @param write_cb The function called with every piece of the stream (in order).
+ * @param userdata A pointer passed to @p write_cb.
+ *
+ * @return An error code.
+ */
+int caterva_serialize_stream(caterva_ctx_t *ctx, caterva_array_t *array,
+                             caterva_write_cb_t write_cb, void *userdata);
+
+/**
+ * @brief The function providing the bytes of an array read with caterva_deserialize_stream().
+ *
+ * @param data The buffer where the bytes are read.
+ * @param size The number of bytes requested.
+ * @param userdata The pointer passed to caterva_deserialize_stream().
+ *
+ * @return The number of bytes read (between 1 and @p size). Any other value stops the
+ * deserialization.
+ */
+typedef int64_t (*caterva_read_cb_t)(void *data, int64_t size, void *userdata);
+
+/**
+ * @brief The function called with every chunk of an array read with caterva_deserialize_stream().
+ *
+ * @param array The array being read. The items in the region of the chunk can already be read
+ * (e.g. with caterva_get_slice_buffer()).
+ * @param start The coordinates of the first item of the chunk.
+ * @param stop The coordinates following the last item of the chunk.
+ * @param userdata The pointer passed to caterva_deserialize_stream().
+ *
+ * @return An error code (any value different from @p CATERVA_SUCCEED stops the deserialization).
+ */
+typedef int (*caterva_chunk_cb_t)(caterva_array_t *array, int64_t *start, int64_t *stop,
+                                  void *userdata);
+
+/**
+ * @brief Read a caterva array serialized with caterva_serialize_stream() progressively.
+ *
+ * The bytes are requested to @p read_cb in order, and every chunk is appended to the array (and
+ * passed to @p chunk_cb) as soon as it is read, so receiving, decompressing and processing the
+ * array can be pipelined. Only one compressed chunk is kept in memory at a time. The index and the
+ * trailer of the stream are checked once all the chunks are read.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param read_cb The function providing the bytes of the stream.
+ * @param chunk_cb The function called with every chunk read (it can be @p NULL).
+ * @param userdata A pointer passed to @p read_cb and @p chunk_cb.
+ * @param storage The storage of the array. It must be @p CATERVA_STORAGE_BLOSC, and the shapes
+ * and the block order are taken from the stream (the array is neither sparse nor extendable and
+ * its chunks are stored in row-major order).
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_deserialize_stream(caterva_ctx_t *ctx, caterva_read_cb_t read_cb,
+                               caterva_chunk_cb_t chunk_cb, void *userdata,
+                               caterva_storage_t *storage, caterva_array_t **array);
+
 /**
  * @brief Read a caterva array from disk.
  *
+ * Plain buffers stored on disk are mapped into memory without reading their data (read-only, and
+ * the array marked as readonly, when the file can not be written), while arrays backed by a Blosc
+ * super-chunk are read from their frame. For sharded arrays, @p urlpath is the manifest and every
+ * shard is read from its own frame.
+ *
  * @param ctx Pointer to the caterva context to be used.
  * @param urlpath The urlpath of the caterva array on disk.
  * @param array Pointer to the memory pointer where the array will be created.
@@ -384,6 +922,103 @@ int caterva_from_serial_schunk(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64
  */
 int caterva_open(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array);
 
+/**
+ * @brief Read the geometry of a caterva array from disk, deferring the load of its data.
+ *
+ * Only the header of a sequential frame is read, and the shapes, the itemsize and the chunk and
+ * block orders are taken from the caterva metalayer in it. The super-chunk (with the index of
+ * the chunks and the variable-length metalayers) is loaded on the first access to the data.
+ * Frames holding more chunks than the ones in that shape (extendable arrays with slabs appended
+ * since their metalayer was updated), frames that are not sequential and frames whose header is
+ * not understood are read as in caterva_open().
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param urlpath The urlpath of the caterva array on disk.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_open_lazy(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array);
+
+/**
+ * @brief Read a caterva array from disk by mapping it into memory.
+ *
+ * The frame of an array backed by a Blosc super-chunk must be sequential. It is mapped read-only
+ * and shared by every process mapping it, and the chunks are decompressed straight from the
+ * mapping, without any read or copy. The array is read-only, so it can not be modified. The
+ * frames of the shards of a sharded array are mapped one by one. Plain buffers are opened as in
+ * caterva_open().
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param urlpath The urlpath of the caterva array on disk.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_open_mmap(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array);
+
+/**
+ * @brief Open a caterva array stored in an I/O backend.
+ *
+ * Only the tail with the metadata and the index of the chunks is read, in regions of 1 MB that
+ * are read at once (with @p pread_async or @p preadv if the backend provides them). The chunks
+ * are read when they are needed, up to @p io_depth at once. The array can be modified if the
+ * stream can be opened for writing, and it is read-only otherwise.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param io The I/O backend.
+ * @param urlpath The urlpath of the stream in the I/O backend.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_open_io(caterva_ctx_t *ctx, const caterva_io_t *io, const char *urlpath,
+                    caterva_array_t **array);
+
+/**
+ * @brief Get the I/O backend storing the frames in local files.
+ *
+ * It is the reference implementation of an I/O backend, using positional reads and writes.
+ *
+ * @return The I/O backend.
+ */
+const caterva_io_t *caterva_io_file(void);
+
+/**
+ * @brief Create a caterva array filled with zeros.
+ *
+ * If the array is backed by a Blosc super-chunk, its chunks are created as special zero chunks,
+ * so no data is compressed and the array takes almost no space.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param params Pointer to the general params of the array desired.
+ * @param storage Pointer to the storage params of the array desired.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_zeros(caterva_ctx_t *ctx, caterva_params_t *params, caterva_storage_t *storage,
+                  caterva_array_t **array);
+
+/**
+ * @brief Create a caterva array filled with a value.
+ *
+ * If the array is backed by a Blosc super-chunk, its chunks are created as special run-length
+ * chunks, so no data is compressed. Only the chunks in the edges of the array (the ones with
+ * padding) are compressed as regular chunks. Sparse arrays do not store any chunk, the value
+ * becomes their fill value.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param params Pointer to the general params of the array desired.
+ * @param storage Pointer to the storage params of the array desired.
+ * @param fill_value Pointer to the value (of @p itemsize bytes) used to fill the array.
+ * @param array Pointer to the memory pointer where the array will be created.
+ *
+ * @return An error code.
+ */
+int caterva_full(caterva_ctx_t *ctx, caterva_params_t *params, caterva_storage_t *storage,
+                 void *fill_value, caterva_array_t **array);
+
 /**
  * @brief Create a caterva array from the data stored in a buffer.
  *
@@ -472,8 +1107,11 @@ int caterva_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *
                              int64_t *stop, int64_t *shape, void *buffer, int64_t buffersize);
 
 /**
- * @brief Set a slice into a caterva array from a C buffer. It can only be used if the array
- * is backed by a plainbuffer.
+ * @brief Set a slice into a caterva array from a C buffer.
+ *
+ * If the array is backed by a Blosc super-chunk, it must be completely filled. The modified
+ * chunks are kept decompressed in a write-back cache and they are only compressed and stored
+ * when they are evicted from it, or when caterva_flush() or caterva_free() are called.
  *
  * @param ctx Pointer to the caterva context to be used.
  * @param buffer Pointer to the buffer where the slice data is.
@@ -500,4 +1138,249 @@ int caterva_set_slice_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersiz
 int caterva_copy(caterva_ctx_t *ctx, caterva_array_t *src, caterva_storage_t *storage,
                  caterva_array_t **array);
 
+/**
+ * @brief Resize the shape of an array.
+ *
+ * Growing the leading dimension only adds new chunks at the end of the array, while growing any
+ * other dimension inserts the new chunks without rewriting the existing ones. Shrinking drops the
+ * chunks that fall outside of the new shape and only re-pads the new edge chunks. The new
+ * positions of the array are filled with zeros.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array to be resized. It must be either empty or
+ * completely filled.
+ * @param new_shape The new shape of the array.
+ *
+ * @return An error code
+ */
+int caterva_resize(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *new_shape);
+
+/**
+ * @brief Store the pending changes of an array.
+ *
+ * The chunks modified in the write-back cache are compressed and stored in the super-chunk, and
+ * the caterva metalayer is updated with the current shape (and the chunk presence bitmap for
+ * sparse arrays). It must be called before using the super-chunk of the array directly.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ *
+ * @return An error code
+ */
+int caterva_flush(caterva_ctx_t *ctx, caterva_array_t *array);
+
+/**
+ * @brief Rewrite the frame of an array to reclaim the space left by its updated chunks.
+ *
+ * The chunks updated in a sequential frame are appended to it, leaving their previous data
+ * unused. This rewrites the frame with just the chunks in use, stored in the chunk order of
+ * the array (see @p chunk_order), one chunk at a time. The new frame is written in a temporary
+ * file (with the `.compact` suffix) that replaces the current one when it is complete, so the
+ * arrays mapped with caterva_open_mmap() before keep reading the previous frame (on POSIX
+ * systems), while the ones opened with caterva_open() must be opened again.
+ *
+ * Only the arrays backed by a Blosc super-chunk stored in a sequential frame on disk (or sharded
+ * arrays with such shards) can be compacted, and not the ones stored through an I/O backend.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ * @param recompress Whether the chunks are recompressed with the compression parameters of
+ * @p ctx (the special chunks are kept as they are). Otherwise, they are copied compressed.
+ *
+ * @return An error code
+ */
+int caterva_compact(caterva_ctx_t *ctx, caterva_array_t *array, bool recompress);
+
+/**
+ * @brief The result of the verification of an array (see caterva_verify()).
+ */
+typedef struct {
+    int64_t nchunks;
+    //!< Number of chunks verified.
+    int64_t nchecked;
+    //!< Number of chunks whose checksum has been checked (see caterva_store_checksums()).
+    int64_t nbad;
+    //!< Number of chunks that can not be decompressed or do not match their checksum.
+    int64_t *bad_coords;
+    //!< The coordinates of the bad chunks in the chunk grid (@p ndim for each one), in row-major
+    //!< order.
+} caterva_verify_report_t;
+
+/**
+ * @brief Check that every chunk of an array can be decompressed.
+ *
+ * The chunks are read one at a time and decompressed in parallel by @p nthreads threads, each
+ * one into its own scratch buffer, so the memory used does not depend on the size of the array.
+ * If the checksums of the chunks have been stored with caterva_store_checksums() (and the array
+ * has not been modified since then), the decompressed chunks are also checked against them.
+ *
+ * The pending changes of the array are stored (see caterva_flush()) before verifying it. It must
+ * be backed by Blosc super-chunks and completely filled.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ * @param nthreads Number of threads used.
+ * @param report Pointer to the report of the verification. It must be released with
+ * caterva_verify_report_free().
+ *
+ * @return An error code (the bad chunks do not make it fail).
+ */
+int caterva_verify(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads,
+                   caterva_verify_report_t *report);
+
+/**
+ * @brief Release the coordinates held by a verification report.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param report Pointer to the report.
+ *
+ * @return An error code
+ */
+int caterva_verify_report_free(caterva_ctx_t *ctx, caterva_verify_report_t *report);
+
+/**
+ * @brief Store the checksums of the chunks of an array, so that caterva_verify() checks them.
+ *
+ * The CRC-32 of every decompressed chunk is stored in the `caterva_checksums` variable-length
+ * metalayer. They are dropped when the array is modified (by caterva_set_slice_buffer(),
+ * caterva_append() or caterva_resize()). It fails if any chunk can not be decompressed.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array. It must be backed by Blosc super-chunks and
+ * completely filled.
+ * @param nthreads Number of threads used.
+ *
+ * @return An error code
+ */
+int caterva_store_checksums(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads);
+
+/**
+ * @brief Advise the access pattern of an array to the kernel.
+ *
+ * It has effect on the plain buffers mapped from a file, whose pages are read from the page
+ * cache without any decompression, and @p CATERVA_ADVICE_DIRECT also on the arrays stored in a
+ * sequential frame on disk (including their shards). It is ignored by the rest of arrays.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ * @param advice The access pattern expected for the array.
+ *
+ * @return An error code
+ */
+int caterva_advise(caterva_ctx_t *ctx, caterva_array_t *array, caterva_advice_t advice);
+
+/**
+ * @brief Suggest the chunk and block shapes of an array backed by a Blosc super-chunk.
+ *
+ * The chunks are sized after the L3 cache and the blocks after the L2 cache when the whole array
+ * is read, or after the L2 and L1 caches for slices. The detected cache sizes are used, or common
+ * ones if they can not be detected. The items are given to the dimensions spanned by the
+ * accesses first, or spread evenly among the dimensions for random accesses.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param params Pointer to the general params of the array.
+ * @param access_hint The access pattern expected for the array.
+ * @param chunkshape Pointer to the chunk shape suggested (of @p ndim dimensions).
+ * @param blockshape Pointer to the block shape suggested (of @p ndim dimensions).
+ *
+ * @return An error code
+ */
+int caterva_suggest_shapes(caterva_ctx_t *ctx, caterva_params_t *params,
+                           caterva_access_hint_t access_hint, int32_t *chunkshape,
+                           int32_t *blockshape);
+
+/**
+ * @brief Start or stop recording the slices read from a caterva array.
+ *
+ * The extents of the slices, the chunks and blocks that they touch and the bytes that they use
+ * are recorded by caterva_get_slice_buffer(). Stopping the recording discards the statistics.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array (it must be backed by a Blosc super-chunk).
+ * @param record Whether the slices are recorded or not.
+ *
+ * @return An error code
+ */
+int caterva_record_accesses(caterva_ctx_t *ctx, caterva_array_t *array, bool record);
+
+/**
+ * @brief Recommend the chunk and block shapes for the slices recorded from a caterva array.
+ *
+ * The shapes suggested by caterva_suggest_shapes() for every access hint and the current ones
+ * are evaluated on the last slices read, estimating their cost by the chunks and the bytes of
+ * the blocks that they touch. The cheapest ones are recommended.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array whose slices are recorded.
+ * @param chunkshape Pointer to the chunk shape recommended.
+ * @param blockshape Pointer to the block shape recommended.
+ * @param speedup Pointer to the speedup estimated for the recommended shapes (1 if they are
+ * the current ones).
+ *
+ * @return An error code
+ */
+int caterva_recommend_shapes(caterva_ctx_t *ctx, caterva_array_t *array, int32_t *chunkshape,
+                             int32_t *blockshape, double *speedup);
+
+/**
+ * @brief Print a report of the slices recorded from a caterva array.
+ *
+ * The report includes the histograms of the slice extents, the chunks and blocks touched per
+ * slice, the fraction of the bytes touched that are used, the hit rate of the cache of
+ * compressed chunks (if it is used) and the recommended shapes. A copy of
+ * the array with them (see caterva_copy()) pays off when the slices are read many times.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array whose slices are recorded.
+ * @param stream The stream where the report is printed.
+ *
+ * @return An error code
+ */
+int caterva_access_report(caterva_ctx_t *ctx, caterva_array_t *array, FILE *stream);
+
+/**
+ * @brief Get the statistics of the cache of compressed chunks of a caterva array.
+ *
+ * The chunks of the arrays stored on disk (and not mapped) are kept compressed in a cache when
+ * the @p ccache_size of the configuration is not 0. The chunks read again are taken from it
+ * without any I/O. The statistics of the shards of an array are added up.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ * @param stats Pointer to the statistics of the cache.
+ *
+ * @return An error code
+ */
+int caterva_ccache_stats(caterva_ctx_t *ctx, caterva_array_t *array,
+                         caterva_ccache_stats_t *stats);
+
+/**
+ * @brief Reduce a caterva array along some of its axes.
+ *
+ * The array is read one chunk at a time, and each chunk is reduced into the output chunk it
+ * contributes to, splitting its rows between the threads of @p ctx (each one reducing them into
+ * its own partial results, which are combined afterwards). The output chunks are appended to
+ * the new array as soon as they are complete, so the memory used is bounded by the size of an
+ * input chunk and an output chunk, not by the size of the array. To get the result in a C buffer,
+ * use a plain buffer for @p storage.
+ *
+ * The reduced axes are removed from the new array (reducing all of them gives a 0-dim array).
+ * The sums of integers are 64-bit integers and the sums of floats and the means are doubles,
+ * while the minimums and maximums keep the data type of the array. The array must be completely
+ * filled, and the minimum, maximum and mean can not be computed along an empty axis.
+ *
+ * @param ctx Pointer to the caterva context to be used.
+ * @param array Pointer to the caterva array.
+ * @param dtype The data type of the items of the array (it must match its itemsize).
+ * @param op The reduction computed.
+ * @param axes The axes reduced (the ones set to true). If it is NULL, all of them are reduced.
+ * @param storage Pointer to the storage params of the new array.
+ * @param out Pointer to the memory pointer where the new array will be created.
+ *
+ * @return An error code
+ */
+int caterva_reduce(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                   caterva_reduce_op_t op, bool *axes, caterva_storage_t *storage,
+                   caterva_array_t **out);
+
 #endif  // CATERVA_CATERVA_H_
@@ -10,7 +10,52 @@
  */
 
 #include <assert.h>
+#include <math.h>
 #include <caterva.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+#include <direct.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "caterva_blosc.h"
+#include "caterva_io.h"
+
+// The name of the variable-length metalayer storing the extendable axis
+#define CATERVA_EXTENDABLE_VLMETA "caterva_extendable"
+
+// The number of completed slabs after which the caterva metalayer of an extendable array is
+// updated (it is always updated when the array is freed)
+#define CATERVA_SLABS_PER_META_UPDATE 16
+
+// The name of the variable-length metalayer storing the fill value and the chunk presence
+// bitmap of sparse arrays
+#define CATERVA_SPARSE_VLMETA "caterva_sparse"
+
+// The number of blocks of each chunk compressed with every codec candidate to choose its codec
+#define CATERVA_CODEC_SAMPLE_NBLOCKS 3
+
+// The offsets of the fields read from the header of a frame (see the format of frames in
+// C-Blosc2) for opening arrays lazily, the only frame format version with this layout and the
+// maximum header length accepted
+#define CATERVA_FRAME_HEADER_MAGIC 2
+#define CATERVA_FRAME_HEADER_LEN 11
+#define CATERVA_FRAME_FLAGS 25
+#define CATERVA_FRAME_VERSION 2
+#define CATERVA_FRAME_NBYTES 30
+#define CATERVA_FRAME_TYPESIZE 48
+#define CATERVA_FRAME_METALAYERS 82
+#define CATERVA_FRAME_MAX_HEADER_LEN (1024 * 1024)
+
+// The suffix of the file where the frame of an array is rewritten while it is compacted
+#define CATERVA_COMPACT_SUFFIX ".compact"
 
 static void index_unidim_to_multidim(int8_t ndim, int64_t *shape, int64_t i, int64_t *index) {
     int64_t strides[CATERVA_MAX_DIM];
@@ -67,19 +112,32 @@ static void swap_store(void *dest, const void *pa, int size) {
 }
 
 static int32_t serialize_meta(int8_t ndim, int64_t *shape, const int32_t *chunkshape,
-                              const int32_t *blockshape, uint8_t **smeta) {
+                              const int32_t *blockshape, caterva_chunk_order_t chunk_order,
+                              caterva_block_order_t block_order, uint8_t **smeta) {
     // Allocate space for Caterva metalayer
     int32_t max_smeta_len = 1 + 1 + 1 + (1 + ndim * (1 + sizeof(int64_t))) +
-                            (1 + ndim * (1 + sizeof(int32_t))) + (1 + ndim * (1 + sizeof(int32_t)));
+                            (1 + ndim * (1 + sizeof(int32_t))) +
+                            (1 + ndim * (1 + sizeof(int32_t))) + 1 + 1;
     *smeta = malloc((size_t) max_smeta_len);
     CATERVA_ERROR_NULL(smeta);
     uint8_t *pmeta = *smeta;
 
-    // Build an array with 5 entries (version, ndim, shape, chunkshape, blockshape)
-    *pmeta++ = 0x90 + 5;
+    // Build an array with 5 entries (version, ndim, shape, chunkshape, blockshape), 6 entries
+    // when the chunks are not in row-major order (the chunk order is added in version 1) or 7
+    // entries when the blocks are not in row-major order (the block order is added in version 2).
+    // Arrays in row-major order keep the version 0 format, so that they can still be read by
+    // previous versions.
+    int version = 0;
+    if (block_order != CATERVA_BLOCK_ORDER_ROW_MAJOR) {
+        version = 2;
+    } else if (chunk_order != CATERVA_CHUNK_ORDER_ROW_MAJOR) {
+        version = 1;
+    }
+    assert(version <= CATERVA_METALAYER_VERSION);
+    *pmeta++ = (uint8_t) (0x90 + 5 + version);
 
     // version entry
-    *pmeta++ = CATERVA_METALAYER_VERSION;  // positive fixnum (7-bit positive integer)
+    *pmeta++ = (uint8_t) version;  // positive fixnum (7-bit positive integer)
     assert(pmeta - *smeta < max_smeta_len);
 
     // ndim entry
@@ -112,18 +170,32 @@ static int32_t serialize_meta(int8_t ndim, int64_t *shape, const int32_t *chunks
         pmeta += sizeof(int32_t);
     }
     assert(pmeta - *smeta <= max_smeta_len);
+
+    // chunk order entry
+    if (version >= 1) {
+        *pmeta++ = (uint8_t) chunk_order;  // positive fixnum (7-bit positive integer)
+    }
+    // block order entry
+    if (version >= 2) {
+        *pmeta++ = (uint8_t) block_order;  // positive fixnum (7-bit positive integer)
+    }
+    assert(pmeta - *smeta <= max_smeta_len);
     int32_t slen = (int32_t)(pmeta - *smeta);
 
     return slen;
 }
 
 static int32_t deserialize_meta(uint8_t *smeta, uint32_t smeta_len, int8_t *ndim, int64_t *shape,
-                                int32_t *chunkshape, int32_t *blockshape) {
+                                int32_t *chunkshape, int32_t *blockshape,
+                                caterva_chunk_order_t *chunk_order,
+                                caterva_block_order_t *block_order) {
     uint8_t *pmeta = smeta;
     CATERVA_UNUSED_PARAM(smeta_len);
 
-    // Check that we have an array with 5 entries (version, ndim, shape, chunkshape, blockshape)
-    assert(*pmeta == 0x90 + 5);
+    // Check that we have an array with 5 entries (version, ndim, shape, chunkshape, blockshape),
+    // 6 entries (plus the chunk order) or 7 entries (plus the block order)
+    int nentries = *pmeta - 0x90;
+    assert(nentries >= 5 && nentries <= 7);
     pmeta += 1;
     assert((uint32_t)(pmeta - smeta) < smeta_len);
 
@@ -179,178 +251,2330 @@ static int32_t deserialize_meta(uint8_t *smeta, uint32_t smeta_len, int8_t *ndim
         pmeta += sizeof(int32_t);
     }
     assert((uint32_t)(pmeta - smeta) <= smeta_len);
+
+    // chunk order entry
+    *chunk_order = CATERVA_CHUNK_ORDER_ROW_MAJOR;
+    if (nentries >= 6) {
+        *chunk_order = (caterva_chunk_order_t) pmeta[0];  // positive fixnum
+        pmeta += 1;
+    }
+
+    // block order entry
+    *block_order = CATERVA_BLOCK_ORDER_ROW_MAJOR;
+    if (nentries >= 7) {
+        *block_order = (caterva_block_order_t) pmeta[0];  // positive fixnum
+        pmeta += 1;
+    }
+    assert((uint32_t)(pmeta - smeta) <= smeta_len);
     uint32_t slen = (uint32_t)(pmeta - smeta);
     CATERVA_UNUSED_PARAM(slen);
     assert(slen == smeta_len);
     return 0;
 }
 
-int caterva_blosc_from_schunk(caterva_ctx_t *ctx, blosc2_schunk *schunk, caterva_array_t **array) {
-    if (ctx == NULL) {
-        DEBUG_PRINT("Context is null");
-        return CATERVA_ERR_NULL_POINTER;
-    }
-    if (schunk == NULL) {
-        DEBUG_PRINT("Schunk is null");
-        return CATERVA_ERR_NULL_POINTER;
+// Update the geometry of an array (in memory only)
+static void update_geometry(caterva_array_t *array, int8_t ndim, int64_t *shape,
+                            int32_t *chunkshape, int32_t *blockshape) {
+    array->ndim = ndim;
+    array->nitems = 1;
+    array->extnitems = 1;
+    array->extchunknitems = 1;
+    array->chunknitems = 1;
+    array->blocknitems = 1;
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        if (i < ndim) {
+            array->shape[i] = shape[i];
+            array->chunkshape[i] = chunkshape[i];
+            array->blockshape[i] = blockshape[i];
+            if (shape[i] != 0) {
+                if (shape[i] % array->chunkshape[i] == 0) {
+                    array->extshape[i] = shape[i];
+                } else {
+                    array->extshape[i] = shape[i] + chunkshape[i] - shape[i] % chunkshape[i];
+                }
+            } else {
+                array->extshape[i] = 0;
+            }
+            if (chunkshape[i] != 0 && blockshape[i] != 0) {
+                if (chunkshape[i] % blockshape[i] == 0) {
+                    array->extchunkshape[i] = chunkshape[i];
+                } else {
+                    array->extchunkshape[i] =
+                            chunkshape[i] + blockshape[i] - chunkshape[i] % blockshape[i];
+                }
+            } else {
+                array->extchunkshape[i] = 0;
+            }
+        } else {
+            array->blockshape[i] = 1;
+            array->chunkshape[i] = 1;
+            array->extshape[i] = 1;
+            array->extchunkshape[i] = 1;
+            array->shape[i] = 1;
+        }
+        array->nitems *= array->shape[i];
+        array->extnitems *= array->extshape[i];
+        array->extchunknitems *= array->extchunkshape[i];
+        array->chunknitems *= array->chunkshape[i];
+        array->blocknitems *= array->blockshape[i];
     }
-    /* Create a caterva_array_t buffer */
-    *array = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
-    CATERVA_ERROR_NULL(array);
+}
 
-    if (schunk == NULL) {
-        DEBUG_PRINT("Schunk is null");
-        return CATERVA_ERR_NULL_POINTER;
+// Store the current geometry of an array in its caterva metalayer
+static int update_meta(caterva_array_t *array) {
+    uint8_t *smeta = NULL;
+    // Serialize the dimension info ...
+    int32_t smeta_len =
+        serialize_meta(array->ndim, array->shape, array->chunkshape, array->blockshape,
+                       array->chunk_order, array->block_order, &smeta);
+    if (smeta_len < 0) {
+        fprintf(stderr, "error during serializing dims info for Caterva");
+        return -1;
     }
-    (*array)->sc = schunk;
-    (*array)->storage = CATERVA_STORAGE_BLOSC;
-
-    blosc2_cparams *cparams;
-    if (blosc2_schunk_get_cparams(schunk, &cparams) < 0) {
-        DEBUG_PRINT("Blosc error");
-        return CATERVA_ERR_NULL_POINTER;
+    // ... and update it in its metalayer
+    if (blosc2_meta_exists(array->sc, "caterva") < 0) {
+        if (blosc2_meta_add(array->sc, "caterva", smeta, (uint32_t) smeta_len) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+    } else {
+        if (blosc2_meta_update(array->sc, "caterva", smeta, (uint32_t) smeta_len) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
     }
+    free(smeta);
 
-    (*array)->itemsize = (int8_t) cparams->typesize;
+    return CATERVA_SUCCEED;
+}
 
-    free(cparams);
+// Compute the number of chunks in each dimension of the chunk grid for a given shape
+static void get_chunk_grid(caterva_array_t *array, const int64_t *shape, int64_t *grid) {
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        if (i >= array->ndim) {
+            grid[i] = 1;
+        } else if (shape[i] == 0 || array->chunkshape[i] == 0) {
+            grid[i] = 0;
+        } else {
+            grid[i] = (shape[i] + array->chunkshape[i] - 1) / array->chunkshape[i];
+        }
+    }
+}
 
-    // Deserialize the caterva metalayer
-    uint8_t *smeta;
-    uint32_t smeta_len;
-    if (blosc2_meta_get(schunk, "caterva", &smeta, &smeta_len) < 0) {
-        DEBUG_PRINT("Blosc error");
-        return CATERVA_ERR_BLOSC_FAILED;
+// Compute the number of chunks in the chunk grid of the current array shape
+static int64_t get_grid_nchunks(caterva_array_t *array) {
+    int64_t grid[CATERVA_MAX_DIM];
+    get_chunk_grid(array, array->shape, grid);
+    int64_t nchunks = 1;
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        nchunks *= grid[i];
     }
-    deserialize_meta(smeta, smeta_len, &(*array)->ndim, (*array)->shape, (*array)->chunkshape,
-                     (*array)->blockshape);
-    free(smeta);
+    return nchunks;
+}
 
-    int64_t *shape = (*array)->shape;
-    int32_t *chunkshape = (*array)->chunkshape;
-    int32_t *blockshape = (*array)->blockshape;
+// Compute the number of chunks in a slab (the chunk grid with one chunk in the extendable axis)
+static int64_t get_slab_nchunks(caterva_array_t *array) {
+    int64_t grid[CATERVA_MAX_DIM];
+    get_chunk_grid(array, array->shape, grid);
+    grid[array->extendable_axis] = 1;
+    int64_t nchunks = 1;
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        nchunks *= grid[i];
+    }
+    return nchunks;
+}
 
-    (*array)->nitems = 1;
-    (*array)->chunknitems = 1;
-    (*array)->blocknitems = 1;
-    (*array)->extnitems = 1;
-    (*array)->extchunknitems = 1;
+// Compute the chunk coordinates (and the chunk grid) for the nchunk-th appended chunk
+static void get_append_coords(caterva_array_t *array, int64_t nchunk, int64_t *grid,
+                              int64_t *coords) {
+    get_chunk_grid(array, array->shape, grid);
+    int64_t nchunks = get_grid_nchunks(array);
+    if (array->extendable && nchunk >= nchunks) {
+        // The chunk belongs to the slab that is being appended after the last one
+        int8_t axis = array->extendable_axis;
+        int64_t naxis = grid[axis];
+        grid[axis] = 1;
+        index_unidim_to_multidim(CATERVA_MAX_DIM, grid, nchunk - nchunks, coords);
+        coords[axis] = naxis;
+        grid[axis] = naxis + 1;
+    } else if (nchunks == 0) {
+        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+            coords[i] = 0;
+        }
+    } else {
+        index_unidim_to_multidim(CATERVA_MAX_DIM, grid, nchunk % nchunks, coords);
+    }
+}
 
-    for (int i = 0; i < (*array)->ndim; ++i) {
-        if (shape[i] != 0) {
-            if (shape[i] % chunkshape[i] == 0) {
-                (*array)->extshape[i] = shape[i];
-            } else {
-                (*array)->extshape[i] = shape[i] + chunkshape[i] - shape[i] % chunkshape[i];
-            }
-            if (chunkshape[i] % blockshape[i] == 0) {
-                (*array)->extchunkshape[i] = chunkshape[i];
-            } else {
-                (*array)->extchunkshape[i] =
-                        chunkshape[i] + blockshape[i] - chunkshape[i] % blockshape[i];
+// Update the shape of the next chunk to be appended (the nchunk-th one)
+static void update_next_chunkshape(caterva_array_t *array, int64_t nchunk) {
+    int64_t grid[CATERVA_MAX_DIM];
+    int64_t coords[CATERVA_MAX_DIM];
+    get_append_coords(array, nchunk, grid, coords);
+    array->next_chunknitems = 1;
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        int64_t next_chunkshape = array->chunkshape[i];
+        if (!array->extendable || i != array->extendable_axis) {
+            int64_t remaining = array->shape[i] - coords[i] * array->chunkshape[i];
+            if (remaining < next_chunkshape) {
+                next_chunkshape = remaining > 0 ? remaining : 0;
             }
-        } else {
-            (*array)->extshape[i] = 0;
-            (*array)->extchunkshape[i] = 0;
         }
-        (*array)->nitems *= shape[i];
-        (*array)->chunknitems *= chunkshape[i];
-        (*array)->blocknitems *= blockshape[i];
-        (*array)->extnitems *= (*array)->extshape[i];
-        (*array)->extchunknitems *= (*array)->extchunkshape[i];
+        array->next_chunkshape[i] = (int32_t) next_chunkshape;
+        array->next_chunknitems *= next_chunkshape;
     }
+}
 
-    for (int i = (*array)->ndim; i < CATERVA_MAX_DIM; ++i) {
-        (*array)->shape[i] = 1;
-        (*array)->chunkshape[i] = 1;
-        (*array)->blockshape[i] = 1;
-        (*array)->extshape[i] = 1;
-        (*array)->extchunkshape[i] = 1;
+// Get the position of a chunk along the chunk order of an array
+static int64_t get_chunk_position(caterva_array_t *array, int64_t nchunk) {
+    if (array->chunk_positions == NULL) {
+        return nchunk;
     }
+    return array->chunk_positions[nchunk];
+}
 
-    // The partition cache (empty initially)
-    (*array)->chunk_cache.data = NULL;
-    (*array)->chunk_cache.nchunk = -1;  // means no valid cache yet
+// Check if a chunk is stored in the super-chunk (always true for non-sparse arrays)
+static bool chunk_is_present(caterva_array_t *array, int64_t nchunk) {
+    if (!array->sparse) {
+        return true;
+    }
+    int64_t position = get_chunk_position(array, nchunk);
+    return (array->chunk_presence[position / 8] >> (position % 8)) & 1;
+}
 
-    (*array)->buf = NULL;
+// Count the bits set in a byte
+static int count_bits(uint8_t byte) {
+    int nbits = 0;
+    for (; byte != 0; byte &= (uint8_t) (byte - 1)) {
+        nbits++;
+    }
+    return nbits;
+}
 
-    if ((*array)->nitems == 0) {
-        (*array)->filled = true;
-        (*array)->empty = false;
-    } else {
-        if (schunk->nchunks == (*array)->extnitems / (*array)->chunknitems) {
-            (*array)->filled = true;
-        } else {
-            (*array)->filled = false;
+// Get the index of a chunk in the super-chunk (the number of stored chunks before it along
+// the chunk order for sparse arrays and for arrays not filled in row-major order yet)
+static int64_t get_chunk_index(caterva_array_t *array, int64_t nchunk) {
+    int64_t position = get_chunk_position(array, nchunk);
+    if (!array->sparse && (array->chunk_positions == NULL || array->filled)) {
+        return position;
+    }
+    uint8_t byte = array->chunk_presence[position / 8];
+    byte &= (uint8_t) ((1 << (position % 8)) - 1);
+    // The chunks stored before the byte are summed up along the Fenwick tree
+    int64_t rank = 0;
+    for (int64_t i = position / 8; i > 0; i -= i & -i) {
+        rank += array->chunk_ranks[i - 1];
+    }
+    return rank + count_bits(byte);
+}
+
+// Get the length of the chunk presence bitmap of an array
+static int64_t get_chunk_presence_len(caterva_array_t *array) {
+    int64_t bitmap_len = (get_grid_nchunks(array) + 7) / 8;
+    return bitmap_len > 0 ? bitmap_len : 1;
+}
+
+// Create a Fenwick tree with the number of chunks stored in each byte of the chunk presence
+// bitmap, so that the chunks stored before a byte are counted (and a chunk is marked) in
+// O(log(bitmap_len)) steps. The tree is built in a single pass.
+static int create_chunk_ranks(caterva_ctx_t *ctx, caterva_array_t *array) {
+    int64_t bitmap_len = get_chunk_presence_len(array);
+    array->chunk_ranks = ctx->cfg->alloc((size_t) bitmap_len * sizeof(int64_t));
+    CATERVA_ERROR_NULL(array->chunk_ranks);
+    for (int64_t i = 0; i < bitmap_len; ++i) {
+        array->chunk_ranks[i] = count_bits(array->chunk_presence[i]);
+    }
+    for (int64_t i = 1; i <= bitmap_len; ++i) {
+        int64_t parent = i + (i & -i);
+        if (parent <= bitmap_len) {
+            array->chunk_ranks[parent - 1] += array->chunk_ranks[i - 1];
         }
     }
 
     return CATERVA_SUCCEED;
 }
 
-int caterva_blosc_from_serial_schunk(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64_t len,
-                                     caterva_array_t **array) {
-    blosc2_schunk *sc = blosc2_schunk_from_buffer(serial_schunk, len, true);
-    if (sc == NULL) {
-        DEBUG_PRINT("Blosc error");
-        return CATERVA_ERR_BLOSC_FAILED;
+// Mark a chunk as stored in the super-chunk
+static void set_chunk_present(caterva_array_t *array, int64_t nchunk) {
+    int64_t position = get_chunk_position(array, nchunk);
+    uint8_t mask = (uint8_t) (1 << (position % 8));
+    if ((array->chunk_presence[position / 8] & mask) == 0) {
+        array->chunk_presence[position / 8] |= mask;
+        int64_t bitmap_len = get_chunk_presence_len(array);
+        for (int64_t i = position / 8 + 1; i <= bitmap_len; i += i & -i) {
+            array->chunk_ranks[i - 1]++;
+        }
     }
-    // ...and create a caterva array out of it
-    CATERVA_ERROR(caterva_from_schunk(ctx, sc, array));
+    array->chunk_presence_dirty = true;
+}
 
-    return CATERVA_SUCCEED;
+// Compute the key of some coordinates (of nbits bits) along a Z-order curve, interleaving
+// their bits (from the most significant ones)
+static uint64_t get_morton_key(const uint64_t *coords, int8_t ndim, int nbits) {
+    uint64_t key = 0;
+    for (int b = nbits - 1; b >= 0; --b) {
+        for (int i = 0; i < ndim; ++i) {
+            key = (key << 1) | ((coords[i] >> b) & 1);
+        }
+    }
+    return key;
 }
 
-int caterva_blosc_open(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array) {
-    blosc2_schunk *sc = blosc2_schunk_open(urlpath);
+// Compute the key of some coordinates (of nbits bits) along a Hilbert curve. The coordinates
+// are transposed as in J. Skilling, "Programming the Hilbert curve" (2004) and then interleaved.
+static uint64_t get_hilbert_key(const uint64_t *coords, int8_t ndim, int nbits) {
+    if (nbits == 0) {
+        return 0;
+    }
+    uint64_t x[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; ++i) {
+        x[i] = coords[i];
+    }
+    // Inverse undo
+    for (uint64_t q = (uint64_t) 1 << (nbits - 1); q > 1; q >>= 1) {
+        uint64_t p = q - 1;
+        for (int i = 0; i < ndim; ++i) {
+            if (x[i] & q) {
+                x[0] ^= p;
+            } else {
+                uint64_t t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+    // Gray encode
+    for (int i = 1; i < ndim; ++i) {
+        x[i] ^= x[i - 1];
+    }
+    uint64_t t = 0;
+    for (uint64_t q = (uint64_t) 1 << (nbits - 1); q > 1; q >>= 1) {
+        if (x[ndim - 1] & q) {
+            t ^= q - 1;
+        }
+    }
+    for (int i = 0; i < ndim; ++i) {
+        x[i] ^= t;
+    }
+    return get_morton_key(x, ndim, nbits);
+}
 
-    // ...and create a caterva array out of it
-    CATERVA_ERROR(caterva_from_schunk(ctx, sc, array));
+typedef struct {
+    uint64_t key;
+    int64_t index;
+} curve_key_t;
 
-    return CATERVA_SUCCEED;
+static int compare_curve_keys(const void *a, const void *b) {
+    const curve_key_t *ka = a;
+    const curve_key_t *kb = b;
+    if (ka->key != kb->key) {
+        return ka->key < kb->key ? -1 : 1;
+    }
+    return ka->index < kb->index ? -1 : ka->index > kb->index;
 }
 
-int caterva_blosc_array_free(caterva_ctx_t *ctx, caterva_array_t **array) {
-    CATERVA_UNUSED_PARAM(ctx);
+// Compute the position along a Z-order (or Hilbert) curve of every element of a grid, given
+// in row-major order. The elements are sorted by their keys along the curve, so that the
+// positions are consecutive even if the grid is not a power of 2.
+static int get_curve_positions(caterva_ctx_t *ctx, int8_t ndim, const int64_t *grid,
+                               bool hilbert, int64_t **positions) {
+    int nbits = 0;
+    int64_t n = 1;
+    for (int i = 0; i < ndim; ++i) {
+        while (((int64_t) 1 << nbits) < grid[i]) {
+            nbits++;
+        }
+        n *= grid[i];
+    }
+    if (nbits * ndim > 64) {
+        DEBUG_PRINT("The grid is too large for a curve order");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
 
-    if ((*array)->sc != NULL) {
-        blosc2_schunk_free((*array)->sc);
+    curve_key_t *keys = ctx->cfg->alloc((size_t) (n > 0 ? n : 1) * sizeof(curve_key_t));
+    CATERVA_ERROR_NULL(keys);
+    for (int64_t index = 0; index < n; ++index) {
+        int64_t coords[CATERVA_MAX_DIM];
+        uint64_t ucoords[CATERVA_MAX_DIM];
+        index_unidim_to_multidim(ndim > 0 ? ndim : 1, (int64_t *) grid, index, coords);
+        for (int i = 0; i < ndim; ++i) {
+            ucoords[i] = (uint64_t) coords[i];
+        }
+        keys[index].index = index;
+        if (hilbert) {
+            keys[index].key = get_hilbert_key(ucoords, ndim, nbits);
+        } else {
+            keys[index].key = get_morton_key(ucoords, ndim, nbits);
+        }
     }
+    qsort(keys, (size_t) n, sizeof(curve_key_t), compare_curve_keys);
+
+    *positions = ctx->cfg->alloc((size_t) (n > 0 ? n : 1) * sizeof(int64_t));
+    CATERVA_ERROR_NULL(*positions);
+    for (int64_t position = 0; position < n; ++position) {
+        (*positions)[keys[position].index] = position;
+    }
+    ctx->cfg->free(keys);
+
     return CATERVA_SUCCEED;
 }
 
-int caterva_blosc_array_repart_chunk(int8_t *rchunk, int64_t rchunksize, void *chunk,
-                                     int64_t chunksize, caterva_array_t *array) {
-    if (rchunksize != array->extchunknitems * array->itemsize) {
-        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+// Compute the position along the chunk order of every chunk in the grid of an array
+static int create_chunk_positions(caterva_ctx_t *ctx, caterva_array_t *array) {
+    array->chunk_positions = NULL;
+    if (array->chunk_order == CATERVA_CHUNK_ORDER_ROW_MAJOR) {
+        return CATERVA_SUCCEED;
     }
-    if (chunksize != array->chunknitems * array->itemsize) {
-        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    if (array->chunk_order != CATERVA_CHUNK_ORDER_MORTON &&
+        array->chunk_order != CATERVA_CHUNK_ORDER_HILBERT) {
+        DEBUG_PRINT("Unknown chunk order");
+        return CATERVA_ERR_INVALID_ARGUMENT;
     }
+    int64_t grid[CATERVA_MAX_DIM];
+    get_chunk_grid(array, array->shape, grid);
+    CATERVA_ERROR(get_curve_positions(ctx, array->ndim, grid,
+                                      array->chunk_order == CATERVA_CHUNK_ORDER_HILBERT,
+                                      &array->chunk_positions));
 
-    const int8_t *src_b = (int8_t *) chunk;
-    memset(rchunk, 0, (size_t) rchunksize);
-    int32_t d_pshape[CATERVA_MAX_DIM];
-    int64_t d_epshape[CATERVA_MAX_DIM];
-    int32_t d_spshape[CATERVA_MAX_DIM];
-    int8_t d_ndim = array->ndim;
+    return CATERVA_SUCCEED;
+}
 
+// Compute the position along the block order of every block in the chunks of an array
+static int create_block_positions(caterva_ctx_t *ctx, caterva_array_t *array) {
+    array->block_positions = NULL;
+    if (array->block_order == CATERVA_BLOCK_ORDER_ROW_MAJOR) {
+        return CATERVA_SUCCEED;
+    }
+    if (array->block_order != CATERVA_BLOCK_ORDER_MORTON) {
+        DEBUG_PRINT("Unknown block order");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    int64_t grid[CATERVA_MAX_DIM];
     for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-        d_pshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->chunkshape[i];
-        d_epshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->extchunkshape[i];
-        d_spshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->blockshape[i];
+        grid[i] = array->blockshape[i] == 0 ? 0 : array->extchunkshape[i] / array->blockshape[i];
     }
+    CATERVA_ERROR(get_curve_positions(ctx, array->ndim, grid, false, &array->block_positions));
 
-    int64_t aux[CATERVA_MAX_DIM];
-    aux[7] = d_epshape[7] / d_spshape[7];
-    for (int i = CATERVA_MAX_DIM - 2; i >= 0; i--) {
-        aux[i] = d_epshape[i] / d_spshape[i] * aux[i + 1];
+    return CATERVA_SUCCEED;
+}
+
+// Get the position of a block (in row-major order in the chunk) along the block order
+static int64_t get_block_position(caterva_array_t *array, int64_t nblock) {
+    if (array->block_positions == NULL) {
+        return nblock;
     }
+    return array->block_positions[nblock];
+}
 
-    /* Fill each block buffer */
-    int32_t orig[CATERVA_MAX_DIM];
-    int64_t actual_spsize[CATERVA_MAX_DIM];
-    for (int32_t sci = 0; sci < array->extchunknitems / array->blocknitems; sci++) {
+// Create the bitmap with the chunks appended to a non-sparse array whose chunks are not in
+// row-major order (they are appended in row-major order, but inserted along the chunk order)
+static int create_chunk_presence(caterva_ctx_t *ctx, caterva_array_t *array) {
+    int64_t bitmap_len = (get_grid_nchunks(array) + 7) / 8;
+    if (bitmap_len == 0) {
+        bitmap_len = 1;
+    }
+    array->chunk_presence = ctx->cfg->alloc((size_t) bitmap_len);
+    CATERVA_ERROR_NULL(array->chunk_presence);
+    memset(array->chunk_presence, 0, (size_t) bitmap_len);
+    // The bits are set first and the ranks are counted once
+    for (int64_t nchunk = 0; nchunk < array->nchunks; ++nchunk) {
+        int64_t position = get_chunk_position(array, nchunk);
+        array->chunk_presence[position / 8] |= (uint8_t) (1 << (position % 8));
+    }
+    CATERVA_ERROR(create_chunk_ranks(ctx, array));
+    array->chunk_presence_dirty = false;
+
+    return CATERVA_SUCCEED;
+}
+
+// Check if all the items of a buffer are equal to the fill value of a sparse array
+static bool buffer_is_fill(caterva_array_t *array, const uint8_t *buffer, int64_t nitems) {
+    for (int64_t i = 0; i < nitems; ++i) {
+        if (memcmp(&buffer[i * array->itemsize], array->fill_value, array->itemsize) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Store the fill value and the chunk presence bitmap of a sparse array in its vlmetalayer
+static int update_sparse_meta(caterva_array_t *array) {
+    int64_t nchunks = get_grid_nchunks(array);
+    uint32_t bitmap_len = (uint32_t) ((nchunks + 7) / 8);
+    uint32_t smeta_len = 1 + 2 + array->itemsize + 1 + sizeof(int64_t) + 1 + sizeof(int32_t) +
+                         bitmap_len;
+    uint8_t *smeta = malloc(smeta_len);
+    CATERVA_ERROR_NULL(smeta);
+    uint8_t *pmeta = smeta;
+
+    // Build an array with 3 entries (fill value, nchunks, bitmap)
+    *pmeta++ = 0x90 + 3;
+    // fill value entry as a bin8
+    *pmeta++ = 0xc4;
+    *pmeta++ = (uint8_t) array->itemsize;
+    memcpy(pmeta, array->fill_value, array->itemsize);
+    pmeta += array->itemsize;
+    // nchunks entry as an int64
+    *pmeta++ = 0xd3;
+    swap_store(pmeta, &array->nchunks, sizeof(int64_t));
+    pmeta += sizeof(int64_t);
+    // bitmap entry as a bin32
+    *pmeta++ = 0xc6;
+    swap_store(pmeta, &bitmap_len, sizeof(int32_t));
+    pmeta += sizeof(int32_t);
+    memcpy(pmeta, array->chunk_presence, bitmap_len);
+    pmeta += bitmap_len;
+    assert((uint32_t) (pmeta - smeta) == smeta_len);
+
+    int rc;
+    if (blosc2_vlmeta_exists(array->sc, CATERVA_SPARSE_VLMETA) < 0) {
+        rc = blosc2_vlmeta_add(array->sc, CATERVA_SPARSE_VLMETA, smeta, smeta_len, NULL);
+    } else {
+        rc = blosc2_vlmeta_update(array->sc, CATERVA_SPARSE_VLMETA, smeta, smeta_len, NULL);
+    }
+    free(smeta);
+    if (rc < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    array->chunk_presence_dirty = false;
+
+    return CATERVA_SUCCEED;
+}
+
+// Read the fill value and the chunk presence bitmap of a sparse array from its vlmetalayer
+static int get_sparse_meta(caterva_ctx_t *ctx, caterva_array_t *array) {
+    uint8_t *smeta;
+    uint32_t smeta_len;
+    if (blosc2_vlmeta_get(array->sc, CATERVA_SPARSE_VLMETA, &smeta, &smeta_len) < 0) {
+        DEBUG_PRINT("Blosc error");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    uint8_t *pmeta = smeta;
+    assert(*pmeta == 0x90 + 3);
+    pmeta += 1;
+    // fill value
+    assert(*pmeta == 0xc4);
+    pmeta += 1;
+    assert(*pmeta == (uint8_t) array->itemsize);
+    pmeta += 1;
+    array->fill_value = ctx->cfg->alloc((size_t) array->itemsize);
+    CATERVA_ERROR_NULL(array->fill_value);
+    memcpy(array->fill_value, pmeta, array->itemsize);
+    pmeta += array->itemsize;
+    // nchunks
+    assert(*pmeta == 0xd3);
+    pmeta += 1;
+    swap_store(&array->nchunks, pmeta, sizeof(int64_t));
+    pmeta += sizeof(int64_t);
+    // bitmap
+    assert(*pmeta == 0xc6);
+    pmeta += 1;
+    uint32_t bitmap_len;
+    swap_store(&bitmap_len, pmeta, sizeof(int32_t));
+    pmeta += sizeof(int32_t);
+    int64_t presence_len = get_chunk_presence_len(array);
+    if (presence_len < bitmap_len) {
+        presence_len = bitmap_len;
+    }
+    array->chunk_presence = ctx->cfg->alloc((size_t) presence_len);
+    CATERVA_ERROR_NULL(array->chunk_presence);
+    memset(array->chunk_presence, 0, (size_t) presence_len);
+    memcpy(array->chunk_presence, pmeta, bitmap_len);
+    pmeta += bitmap_len;
+    assert((uint32_t) (pmeta - smeta) == smeta_len);
+    free(smeta);
+    array->chunk_presence_dirty = false;
+    CATERVA_ERROR(create_chunk_ranks(ctx, array));
+
+    return CATERVA_SUCCEED;
+}
+
+// Free the compression contexts of the codec candidates
+static void free_codec_cctxs(caterva_array_t *array) {
+    for (int i = 0; i < CATERVA_MAX_CODEC_CANDIDATES; ++i) {
+        if (array->codec_cctx[i] != NULL) {
+            blosc2_free_ctx(array->codec_cctx[i]);
+            array->codec_cctx[i] = NULL;
+        }
+    }
+    array->codec_ncandidates = 0;
+}
+
+// Check whether the compression contexts of the array were created out of the codec
+// candidates of a context
+static bool codec_cctxs_match(caterva_ctx_t *ctx, caterva_array_t *array, int ncandidates) {
+    if (array->codec_ncandidates != ncandidates) {
+        return false;
+    }
+    for (int i = 0; i < ncandidates; ++i) {
+        caterva_codec_candidate_t *used = &array->codec_candidates[i];
+        caterva_codec_candidate_t *wanted = &ctx->cfg->candidates[i];
+        if (used->compcodec != wanted->compcodec || used->complevel != wanted->complevel ||
+            used->shuffle != wanted->shuffle) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Create the compression contexts of the codec candidates (out of the super-chunk cparams),
+// replacing the ones created for a different list of candidates
+static int create_codec_cctxs(caterva_ctx_t *ctx, caterva_array_t *array, int ncandidates) {
+    free_codec_cctxs(array);
+    for (int i = 0; i < CATERVA_MAX_CODEC_CANDIDATES; ++i) {
+        array->codec_nchunks[i] = 0;
+    }
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    int rc = CATERVA_SUCCEED;
+    for (int i = 0; i < ncandidates; ++i) {
+        blosc2_cparams candidate_cparams = *cparams;
+        candidate_cparams.compcode = ctx->cfg->candidates[i].compcodec;
+        candidate_cparams.clevel = ctx->cfg->candidates[i].complevel;
+        candidate_cparams.filters[BLOSC2_MAX_FILTERS - 1] = ctx->cfg->candidates[i].shuffle;
+        candidate_cparams.schunk = array->sc;
+        array->codec_cctx[i] = blosc2_create_cctx(candidate_cparams);
+        if (array->codec_cctx[i] == NULL) {
+            DEBUG_PRINT(print_error(CATERVA_ERR_NULL_POINTER));
+            rc = CATERVA_ERR_NULL_POINTER;
+            break;
+        }
+        array->codec_candidates[i] = ctx->cfg->candidates[i];
+    }
+    free(cparams);
+    if (rc != CATERVA_SUCCEED) {
+        free_codec_cctxs(array);
+        return rc;
+    }
+    array->codec_ncandidates = ncandidates;
+
+    return CATERVA_SUCCEED;
+}
+
+// Choose the codec candidate for a repartitioned chunk by compressing a few of its blocks with
+// each one of them
+static int choose_codec(caterva_ctx_t *ctx, caterva_array_t *array, uint8_t *rchunk,
+                        int32_t nbytes, uint8_t *cchunk, int *candidate) {
+    int ncandidates = array->codec_ncandidates;
+    int32_t blocksize = array->blocknitems * array->itemsize;
+    int32_t nblocks = blocksize > 0 ? nbytes / blocksize : 0;
+    int32_t nsamples = nblocks < CATERVA_CODEC_SAMPLE_NBLOCKS ? nblocks
+                                                              : CATERVA_CODEC_SAMPLE_NBLOCKS;
+    *candidate = 0;
+    if (nsamples == 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    int best_target = -1;
+    int best_fallback = 0;
+    double best_target_value = 0;
+    double best_fallback_value = 0;
+    for (int i = 0; i < ncandidates; ++i) {
+        int64_t csize = 0;
+        blosc_timestamp_t start;
+        blosc_timestamp_t end;
+        blosc_set_timestamp(&start);
+        for (int32_t j = 0; j < nsamples; ++j) {
+            // Spread the sampled blocks over the chunk
+            int32_t nblock = (int32_t) ((int64_t) j * nblocks / nsamples);
+            int size = blosc2_compress_ctx(array->codec_cctx[i], &rchunk[nblock * blocksize],
+                                           blocksize, cchunk, nbytes + BLOSC_MAX_OVERHEAD);
+            if (size < 0) {
+                CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+            }
+            csize += size;
+        }
+        blosc_set_timestamp(&end);
+        double secs = blosc_elapsed_secs(start, end);
+        double ratio = (double) nsamples * blocksize / (double) csize;
+        double speed = secs > 0 ? (double) nsamples * blocksize / secs / 1e6 : INFINITY;
+
+        // The value to maximize among the candidates reaching the target, and the one to
+        // maximize if none of them reaches it
+        bool reached;
+        double target_value;
+        double fallback_value;
+        if (ctx->cfg->codec_target == CATERVA_CODEC_TARGET_SPEED) {
+            reached = speed >= ctx->cfg->target_speed;
+            target_value = ratio;
+            fallback_value = speed;
+        } else {
+            reached = ratio >= ctx->cfg->target_ratio;
+            target_value = speed;
+            fallback_value = ratio;
+        }
+        if (reached && (best_target < 0 || target_value > best_target_value)) {
+            best_target = i;
+            best_target_value = target_value;
+        }
+        if (i == 0 || fallback_value > best_fallback_value) {
+            best_fallback = i;
+            best_fallback_value = fallback_value;
+        }
+    }
+    *candidate = best_target >= 0 ? best_target : best_fallback;
+
+    return CATERVA_SUCCEED;
+}
+
+// Compress a repartitioned chunk (into a buffer of nbytes + BLOSC_MAX_OVERHEAD bytes) with the
+// super-chunk codec or, if there are codec candidates, with the one chosen for it
+static int compress_chunk(caterva_ctx_t *ctx, caterva_array_t *array, uint8_t *rchunk,
+                          int32_t nbytes, uint8_t *cchunk) {
+    blosc2_context *cctx = array->sc->cctx;
+    if (ctx->cfg->ncandidates > 0) {
+        int ncandidates = ctx->cfg->ncandidates;
+        if (ncandidates > CATERVA_MAX_CODEC_CANDIDATES) {
+            ncandidates = CATERVA_MAX_CODEC_CANDIDATES;
+        }
+        // The contexts follow the candidates of the context used for each write
+        if (!codec_cctxs_match(ctx, array, ncandidates)) {
+            CATERVA_ERROR(create_codec_cctxs(ctx, array, ncandidates));
+        }
+        int candidate;
+        CATERVA_ERROR(choose_codec(ctx, array, rchunk, nbytes, cchunk, &candidate));
+        cctx = array->codec_cctx[candidate];
+        array->codec_nchunks[candidate]++;
+    }
+    if (blosc2_compress_ctx(cctx, rchunk, nbytes, cchunk, nbytes + BLOSC_MAX_OVERHEAD) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Close the handles of the frame kept for the threads reading ahead the chunks (needed when the
+// chunks on disk change)
+static void reader_scs_clear(caterva_ctx_t *ctx, caterva_array_t *array) {
+    for (int i = 0; i < array->reader_nscs; ++i) {
+        blosc2_schunk_free(array->reader_scs[i]);
+    }
+    if (array->reader_scs != NULL) {
+        ctx->cfg->free(array->reader_scs);
+    }
+    array->reader_scs = NULL;
+    array->reader_nscs = 0;
+}
+
+// The chunks of the arrays stored in an I/O backend are written in its stream when the array is
+// flushed, and the super-chunk keeps a header-only chunk in their place. Their offsets and sizes
+// in the stream are kept in slots that follow the chunks inserted in (and deleted from) the
+// super-chunk, with a negative offset for the chunks that are held by the super-chunk.
+static int io_slots_reserve(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nslots) {
+    if (array->io == NULL || nslots <= array->io_nslots) {
+        return CATERVA_SUCCEED;
+    }
+    nslots = nslots > 2 * array->io_nslots ? nslots : 2 * array->io_nslots;
+    int64_t *offsets = ctx->cfg->alloc(nslots * sizeof(int64_t));
+    int32_t *cbytes = ctx->cfg->alloc(nslots * sizeof(int32_t));
+    if (offsets == NULL || cbytes == NULL) {
+        if (offsets != NULL) {
+            ctx->cfg->free(offsets);
+        }
+        if (cbytes != NULL) {
+            ctx->cfg->free(cbytes);
+        }
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    if (array->io_offsets != NULL) {
+        memcpy(offsets, array->io_offsets, array->sc->nchunks * sizeof(int64_t));
+        memcpy(cbytes, array->io_cbytes, array->sc->nchunks * sizeof(int32_t));
+        ctx->cfg->free(array->io_offsets);
+        ctx->cfg->free(array->io_cbytes);
+    }
+    array->io_offsets = offsets;
+    array->io_cbytes = cbytes;
+    array->io_nslots = nslots;
+
+    return CATERVA_SUCCEED;
+}
+
+// Open a slot for a chunk inserted in the super-chunk (the slots have to be reserved before)
+static void io_slots_insert(caterva_array_t *array, int64_t index) {
+    if (array->io == NULL) {
+        return;
+    }
+    int64_t nmoved = array->sc->nchunks - 1 - index;
+    memmove(&array->io_offsets[index + 1], &array->io_offsets[index], nmoved * sizeof(int64_t));
+    memmove(&array->io_cbytes[index + 1], &array->io_cbytes[index], nmoved * sizeof(int32_t));
+    array->io_offsets[index] = -1;
+    array->io_cbytes[index] = 0;
+}
+
+// Close the slot of a chunk deleted from the super-chunk
+static void io_slots_delete(caterva_array_t *array, int64_t index) {
+    if (array->io == NULL) {
+        return;
+    }
+    int64_t nmoved = array->sc->nchunks - index;
+    memmove(&array->io_offsets[index], &array->io_offsets[index + 1], nmoved * sizeof(int64_t));
+    memmove(&array->io_cbytes[index], &array->io_cbytes[index + 1], nmoved * sizeof(int32_t));
+}
+
+// Insert a compressed chunk in the super-chunk (it is appended if it goes after the last one)
+static int sc_insert_chunk(caterva_ctx_t *ctx, caterva_array_t *array, int64_t index,
+                           uint8_t *cchunk) {
+    CATERVA_ERROR(io_slots_reserve(ctx, array, array->sc->nchunks + 1));
+    int rc;
+    if (index == array->sc->nchunks) {
+        rc = blosc2_schunk_append_chunk(array->sc, cchunk, true);
+    } else {
+        rc = blosc2_schunk_insert_chunk(array->sc, (int) index, cchunk, true);
+    }
+    if (rc < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    io_slots_insert(array, index);
+
+    return CATERVA_SUCCEED;
+}
+
+// Replace a compressed chunk of the super-chunk (the one in the stream of an I/O backend is
+// replaced when the array is flushed)
+static int sc_update_chunk(caterva_array_t *array, int64_t index, uint8_t *cchunk) {
+    if (blosc2_schunk_update_chunk(array->sc, (int) index, cchunk, true) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    if (array->io != NULL) {
+        array->io_offsets[index] = -1;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Delete a compressed chunk from the super-chunk
+static int sc_delete_chunk(caterva_array_t *array, int64_t index) {
+    if (blosc2_schunk_delete_chunk(array->sc, (int) index) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    io_slots_delete(array, index);
+
+    return CATERVA_SUCCEED;
+}
+
+// Check whether a chunk is read from the stream of an I/O backend
+static bool sc_chunk_in_io(caterva_array_t *array, int64_t index) {
+    return array->io != NULL && array->io_offsets[index] >= 0;
+}
+
+// Get a compressed chunk of the super-chunk (it must be released with free() if needs_free is
+// true), reading it from the stream of an I/O backend if it is there
+static int sc_get_chunk(caterva_array_t *array, int64_t index, uint8_t **cchunk,
+                        int32_t *cbytes, bool *needs_free) {
+    if (sc_chunk_in_io(array, index)) {
+        CATERVA_ERROR(caterva_io_read_chunk(array->io, array->io_stream,
+                                            array->io_offsets[index], array->io_cbytes[index],
+                                            cchunk));
+        *cbytes = array->io_cbytes[index];
+        *needs_free = true;
+        return CATERVA_SUCCEED;
+    }
+    *cbytes = blosc2_schunk_get_chunk(array->sc, (int) index, cchunk, needs_free);
+    if (*cbytes < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Decompress a chunk of the super-chunk
+static int sc_decompress_chunk(caterva_array_t *array, int64_t index, void *dest,
+                               int32_t nbytes) {
+    if (!sc_chunk_in_io(array, index)) {
+        if (blosc2_schunk_decompress_chunk(array->sc, (int) index, dest, nbytes) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *cchunk;
+    int32_t cbytes;
+    bool needs_free;
+    CATERVA_ERROR(sc_get_chunk(array, index, &cchunk, &cbytes, &needs_free));
+    int dsize = blosc2_decompress_ctx(array->sc->dctx, cchunk, cbytes, dest, nbytes);
+    if (needs_free) {
+        free(cchunk);
+    }
+    if (dsize < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Check whether the chunks read from the disk (or an I/O backend) are kept in the cache of
+// compressed chunks
+static bool ccache_enabled(caterva_ctx_t *ctx, caterva_array_t *array) {
+    return ctx->cfg->ccache_size > 0 && array->map == NULL &&
+           (array->sc->storage->urlpath != NULL || array->io != NULL);
+}
+
+// Look for a chunk in the cache of compressed chunks (-1 if it is not there)
+static int64_t ccache_lookup(caterva_array_t *array, int64_t index) {
+    if (index < 0 || index >= array->ccache_nslots) {
+        return -1;
+    }
+    return array->ccache_slots[index];
+}
+
+// Release an entry of the cache of compressed chunks, leaving it first in the empty entries
+static void ccache_release(caterva_ctx_t *ctx, caterva_array_t *array, int64_t slot) {
+    struct ccache_entry_s *entry = &array->ccache[slot];
+    array->ccache_slots[entry->index] = -1;
+    ctx->cfg->free(entry->cchunk);
+    entry->cchunk = NULL;
+    entry->index = array->ccache_free;
+    array->ccache_free = slot;
+    array->ccache_stats.nchunks--;
+    array->ccache_stats.nbytes -= entry->cbytes;
+}
+
+// Evict a chunk from the cache of compressed chunks (it must not be empty). The chunks read
+// since the last time the clock hand passed over them get a second chance.
+static void ccache_evict(caterva_ctx_t *ctx, caterva_array_t *array) {
+    while (true) {
+        int64_t slot = array->ccache_hand;
+        struct ccache_entry_s *entry = &array->ccache[slot];
+        array->ccache_hand = (array->ccache_hand + 1) % array->ccache_len;
+        if (entry->cchunk == NULL) {
+            continue;
+        }
+        if (entry->referenced) {
+            entry->referenced = false;
+            continue;
+        }
+        ccache_release(ctx, array, slot);
+        array->ccache_stats.nevictions++;
+        return;
+    }
+}
+
+// Drop a chunk from the cache of compressed chunks (needed when it is updated in place)
+static void ccache_invalidate(caterva_ctx_t *ctx, caterva_array_t *array, int64_t index) {
+    reader_scs_clear(ctx, array);
+    int64_t slot = ccache_lookup(array, index);
+    if (slot >= 0) {
+        ccache_release(ctx, array, slot);
+    }
+}
+
+// Keep a copy of a compressed chunk in the cache, evicting chunks to stay within the budget
+// (the chunks larger than the budget are not kept)
+static int ccache_put(caterva_ctx_t *ctx, caterva_array_t *array, int64_t index,
+                      const uint8_t *cchunk, int32_t cbytes) {
+    if (cbytes > ctx->cfg->ccache_size || ccache_lookup(array, index) >= 0) {
+        return CATERVA_SUCCEED;
+    }
+    // The entries are found by chunk index in the slots, which cover the chunks of the frame
+    if (index >= array->ccache_nslots) {
+        int64_t nslots = 2 * array->ccache_nslots;
+        nslots = nslots > array->sc->nchunks ? nslots : array->sc->nchunks;
+        nslots = nslots > index ? nslots : index + 1;
+        int64_t *slots = ctx->cfg->alloc(nslots * sizeof(int64_t));
+        CATERVA_ERROR_NULL(slots);
+        for (int64_t i = 0; i < nslots; ++i) {
+            slots[i] = i < array->ccache_nslots ? array->ccache_slots[i] : -1;
+        }
+        if (array->ccache_slots != NULL) {
+            ctx->cfg->free(array->ccache_slots);
+        }
+        array->ccache_slots = slots;
+        array->ccache_nslots = nslots;
+    }
+    while (array->ccache_stats.nbytes + cbytes > ctx->cfg->ccache_size) {
+        ccache_evict(ctx, array);
+    }
+    if (array->ccache_free < 0) {
+        int64_t len = array->ccache_len == 0 ? 16 : 2 * array->ccache_len;
+        struct ccache_entry_s *ccache = ctx->cfg->alloc(len * sizeof(struct ccache_entry_s));
+        CATERVA_ERROR_NULL(ccache);
+        memset(ccache, 0, len * sizeof(struct ccache_entry_s));
+        if (array->ccache != NULL) {
+            memcpy(ccache, array->ccache, array->ccache_len * sizeof(struct ccache_entry_s));
+            ctx->cfg->free(array->ccache);
+        }
+        // The new entries are chained as empty entries
+        for (int64_t i = array->ccache_len; i < len; ++i) {
+            ccache[i].index = i + 1 < len ? i + 1 : -1;
+        }
+        array->ccache_free = array->ccache_len;
+        array->ccache = ccache;
+        array->ccache_len = len;
+    }
+    int64_t slot = array->ccache_free;
+    struct ccache_entry_s *entry = &array->ccache[slot];
+    entry->cchunk = ctx->cfg->alloc((size_t) cbytes);
+    CATERVA_ERROR_NULL(entry->cchunk);
+    array->ccache_free = entry->index;
+    memcpy(entry->cchunk, cchunk, (size_t) cbytes);
+    entry->cbytes = cbytes;
+    entry->index = index;
+    entry->referenced = false;
+    array->ccache_slots[index] = slot;
+    array->ccache_stats.nchunks++;
+    array->ccache_stats.nbytes += cbytes;
+
+    return CATERVA_SUCCEED;
+}
+
+// Get a compressed chunk through the cache of compressed chunks. It is owned by the cache (and
+// valid until the cache is modified) unless `needs_free` is set.
+static int ccache_get(caterva_ctx_t *ctx, caterva_array_t *array, int64_t index,
+                      uint8_t **cchunk, int32_t *cbytes, bool *needs_free) {
+    int64_t slot = ccache_lookup(array, index);
+    if (slot < 0) {
+        array->ccache_stats.nmisses++;
+        uint8_t *chunk;
+        bool chunk_needs_free;
+        int32_t chunk_cbytes;
+        CATERVA_ERROR(sc_get_chunk(array, index, &chunk, &chunk_cbytes, &chunk_needs_free));
+        int rc = ccache_put(ctx, array, index, chunk, chunk_cbytes);
+        slot = ccache_lookup(array, index);
+        if (rc != CATERVA_SUCCEED || slot < 0) {
+            *cchunk = chunk;
+            *cbytes = chunk_cbytes;
+            *needs_free = chunk_needs_free;
+            return CATERVA_SUCCEED;
+        }
+        if (chunk_needs_free) {
+            free(chunk);
+        }
+    } else {
+        array->ccache_stats.nhits++;
+        array->ccache[slot].referenced = true;
+    }
+    *cchunk = array->ccache[slot].cchunk;
+    *cbytes = array->ccache[slot].cbytes;
+    *needs_free = false;
+
+    return CATERVA_SUCCEED;
+}
+
+// Release the cache of compressed chunks (needed when the indexes of the chunks change)
+static void ccache_clear(caterva_ctx_t *ctx, caterva_array_t *array) {
+    reader_scs_clear(ctx, array);
+    for (int64_t i = 0; i < array->ccache_len; ++i) {
+        if (array->ccache[i].cchunk != NULL) {
+            ctx->cfg->free(array->ccache[i].cchunk);
+        }
+    }
+    if (array->ccache != NULL) {
+        ctx->cfg->free(array->ccache);
+    }
+    if (array->ccache_slots != NULL) {
+        ctx->cfg->free(array->ccache_slots);
+    }
+    array->ccache = NULL;
+    array->ccache_len = 0;
+    array->ccache_free = -1;
+    array->ccache_slots = NULL;
+    array->ccache_nslots = 0;
+    array->ccache_hand = 0;
+    array->ccache_stats.nchunks = 0;
+    array->ccache_stats.nbytes = 0;
+}
+
+// Compress a repartitioned chunk and insert it in the nchunk-th position of the super-chunk
+static int store_chunk(caterva_ctx_t *ctx, caterva_array_t *array, uint8_t *rchunk,
+                       int32_t nbytes, int64_t nchunk) {
+    // The chunks after an inserted one are shifted
+    if (nchunk < array->sc->nchunks) {
+        ccache_clear(ctx, array);
+    }
+    if (nchunk == array->sc->nchunks && ctx->cfg->ncandidates == 0) {
+        CATERVA_ERROR(io_slots_reserve(ctx, array, array->sc->nchunks + 1));
+        if (blosc2_schunk_append_buffer(array->sc, rchunk, (size_t) nbytes) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        io_slots_insert(array, nchunk);
+        return CATERVA_SUCCEED;
+    }
+    uint8_t *cchunk = ctx->cfg->alloc((size_t) nbytes + BLOSC_MAX_OVERHEAD);
+    CATERVA_ERROR_NULL(cchunk);
+    // The chunk is copied by Blosc, which would release it with its own free otherwise
+    int rc = compress_chunk(ctx, array, rchunk, nbytes, cchunk);
+    if (rc == CATERVA_SUCCEED) {
+        rc = sc_insert_chunk(ctx, array, nchunk, cchunk);
+    }
+    ctx->cfg->free(cchunk);
+    CATERVA_ERROR(rc);
+
+    return CATERVA_SUCCEED;
+}
+
+// Look for a chunk in the write-back cache (-1 if it is not there)
+static int write_cache_lookup(caterva_array_t *array, int64_t nchunk) {
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        if (array->write_cache[i].data != NULL && array->write_cache[i].nchunk == nchunk) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Compress a modified chunk of the write-back cache and store it in the super-chunk
+static int write_cache_store(caterva_ctx_t *ctx, caterva_array_t *array,
+                             struct chunk_cache_s *cache) {
+    int32_t nbytes = (int32_t) array->extchunknitems * array->itemsize;
+    uint8_t *cchunk = ctx->cfg->alloc((size_t) nbytes + BLOSC_MAX_OVERHEAD);
+    CATERVA_ERROR_NULL(cchunk);
+    int rc = compress_chunk(ctx, array, cache->data, nbytes, cchunk);
+    if (rc != CATERVA_SUCCEED) {
+        ctx->cfg->free(cchunk);
+        CATERVA_ERROR(rc);
+    }
+    // The chunks not stored in a sparse array are materialized when they are modified
+    int64_t index = get_chunk_index(array, cache->nchunk);
+    if (!chunk_is_present(array, cache->nchunk)) {
+        // The chunks after the inserted one are shifted
+        if (index < array->sc->nchunks) {
+            ccache_clear(ctx, array);
+        }
+        rc = sc_insert_chunk(ctx, array, index, cchunk);
+        if (rc == CATERVA_SUCCEED) {
+            set_chunk_present(array, cache->nchunk);
+        }
+    } else {
+        ccache_invalidate(ctx, array, index);
+        rc = sc_update_chunk(array, index, cchunk);
+    }
+    ctx->cfg->free(cchunk);
+    CATERVA_ERROR(rc);
+    cache->dirty = false;
+
+    return CATERVA_SUCCEED;
+}
+
+// Get a chunk from the write-back cache, loading it (and evicting the least recently used one)
+// if it is not there
+static int write_cache_get(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nchunk,
+                           struct chunk_cache_s **cache) {
+    int slot = write_cache_lookup(array, nchunk);
+    if (slot < 0) {
+        slot = 0;
+        for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+            if (array->write_cache[i].nchunk == -1) {
+                slot = i;
+                break;
+            }
+            if (array->write_cache[i].access < array->write_cache[slot].access) {
+                slot = i;
+            }
+        }
+        struct chunk_cache_s *victim = &array->write_cache[slot];
+        if (victim->dirty) {
+            CATERVA_ERROR(write_cache_store(ctx, array, victim));
+        }
+        int32_t nbytes = (int32_t) array->extchunknitems * array->itemsize;
+        if (victim->data == NULL) {
+            victim->data = ctx->cfg->alloc((size_t) nbytes);
+            CATERVA_ERROR_NULL(victim->data);
+        }
+        victim->nchunk = -1;
+        if (!chunk_is_present(array, nchunk)) {
+            for (int64_t i = 0; i < array->extchunknitems; ++i) {
+                memcpy(&victim->data[i * array->itemsize], array->fill_value, array->itemsize);
+            }
+        } else {
+            CATERVA_ERROR(sc_decompress_chunk(array, get_chunk_index(array, nchunk),
+                                              victim->data, nbytes));
+        }
+        victim->nchunk = (int32_t) nchunk;
+    }
+    *cache = &array->write_cache[slot];
+    (*cache)->access = ++array->write_cache_access;
+
+    return CATERVA_SUCCEED;
+}
+
+// Store the modified chunks and release the write-back cache (needed when the chunks are moved)
+static int write_cache_clear(caterva_ctx_t *ctx, caterva_array_t *array) {
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        struct chunk_cache_s *cache = &array->write_cache[i];
+        if (cache->dirty) {
+            CATERVA_ERROR(write_cache_store(ctx, array, cache));
+        }
+        if (cache->data != NULL) {
+            ctx->cfg->free(cache->data);
+            cache->data = NULL;
+        }
+        cache->nchunk = -1;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Zero the items of a repartitioned chunk that lie outside of `valid_shape` (in chunk coords)
+static void chunk_zero_outside(caterva_array_t *array, uint8_t *rchunk,
+                               const int64_t *valid_shape) {
+    int64_t d_epshape[CATERVA_MAX_DIM];
+    int64_t d_spshape[CATERVA_MAX_DIM];
+    int64_t d_valid[CATERVA_MAX_DIM];
+    int8_t d_ndim = array->ndim;
+
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        d_epshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->extchunkshape[i];
+        d_spshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->blockshape[i];
+        d_valid[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] =
+            (i < d_ndim) ? valid_shape[i] : 1;
+    }
+
+    int64_t aux[CATERVA_MAX_DIM];
+    aux[7] = d_epshape[7] / d_spshape[7];
+    for (int i = CATERVA_MAX_DIM - 2; i >= 0; i--) {
+        aux[i] = d_epshape[i] / d_spshape[i] * aux[i + 1];
+    }
+
+    int64_t orig[CATERVA_MAX_DIM];
+    int64_t ii[CATERVA_MAX_DIM];
+    int64_t nlines = array->blocknitems / d_spshape[7];
+    for (int64_t sci = 0; sci < array->extchunknitems / array->blocknitems; sci++) {
+        /* Calculate the coord. of the block first element */
+        orig[7] = sci % (d_epshape[7] / d_spshape[7]) * d_spshape[7];
+        for (int i = CATERVA_MAX_DIM - 2; i >= 0; i--) {
+            orig[i] = sci % (aux[i]) / (aux[i + 1]) * d_spshape[i];
+        }
+        for (int64_t nline = 0; nline < nlines; ++nline) {
+            index_unidim_to_multidim(CATERVA_MAX_DIM - 1, d_spshape, nline, ii);
+            uint8_t *line = rchunk + (get_block_position(array, sci) * array->blocknitems +
+                                      nline * d_spshape[7]) * array->itemsize;
+            bool blank = false;
+            for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
+                if (orig[i] + ii[i] >= d_valid[i]) {
+                    blank = true;
+                    break;
+                }
+            }
+            int64_t nvalid = blank ? 0 : d_valid[7] - orig[7];
+            if (nvalid < 0) {
+                nvalid = 0;
+            }
+            if (nvalid < d_spshape[7]) {
+                memset(line + nvalid * array->itemsize, 0,
+                       (size_t) (d_spshape[7] - nvalid) * array->itemsize);
+            }
+        }
+    }
+}
+
+// Get the kind of special chunk (0 if it is a regular one) and its value from its header
+static void get_special(caterva_array_t *array, const uint8_t *chunk, int *special,
+                        uint8_t *value) {
+    *special = (chunk[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK;
+    switch (*special) {
+        case BLOSC2_SPECIAL_VALUE:
+            memcpy(value, chunk + BLOSC_EXTENDED_HEADER_LENGTH, array->itemsize);
+            break;
+        case BLOSC2_SPECIAL_NAN:
+            if (array->itemsize == sizeof(float)) {
+                float nan = NAN;
+                memcpy(value, &nan, sizeof(float));
+            } else if (array->itemsize == sizeof(double)) {
+                double nan = NAN;
+                memcpy(value, &nan, sizeof(double));
+            } else {
+                // NaNs are only defined for floats and doubles
+                *special = 0;
+            }
+            break;
+        case BLOSC2_SPECIAL_ZERO:
+        case BLOSC2_SPECIAL_UNINIT:
+            memset(value, 0, array->itemsize);
+            break;
+        default:
+            *special = 0;
+    }
+}
+
+// Get a lazy chunk (it must be released with free() if needs_free is true), with the kind of
+// special chunk (0 if it is a regular one) and its value
+static int get_chunk_special(caterva_array_t *array, int64_t nchunk, int *special,
+                             uint8_t *value, uint8_t **cchunk, int32_t *cbytes,
+                             bool *needs_free) {
+    // The chunks in the stream of an I/O backend are read whole
+    if (sc_chunk_in_io(array, nchunk)) {
+        CATERVA_ERROR(sc_get_chunk(array, nchunk, cchunk, cbytes, needs_free));
+    } else {
+        *cbytes = blosc2_schunk_get_lazychunk(array->sc, (int) nchunk, cchunk, needs_free);
+        if (*cbytes < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+    }
+    get_special(array, *cchunk, special, value);
+
+    return CATERVA_SUCCEED;
+}
+
+// A scan of the chunks of an array streamed from its frame with direct I/O, in aligned extents
+// located with the offsets index of the frame
+typedef struct {
+    caterva_io_direct_t *file;
+    int64_t *offsets;  // the offsets of the chunks from the end of the header (or special values)
+    int64_t noffsets;
+    int64_t header_len;
+} direct_scan_t;
+
+static void direct_scan_stop(caterva_ctx_t *ctx, direct_scan_t *scan) {
+    if (scan->offsets != NULL) {
+        free(scan->offsets);
+        scan->offsets = NULL;
+    }
+    caterva_io_direct_close(ctx, &scan->file);
+}
+
+static int direct_scan_start(caterva_ctx_t *ctx, caterva_array_t *array, direct_scan_t *scan) {
+    memset(scan, 0, sizeof(direct_scan_t));
+    scan->noffsets = array->sc->nchunks;
+    if (scan->noffsets > 0) {
+        scan->offsets = blosc2_frame_get_offsets(array->sc);
+        if (scan->offsets == NULL) {
+            DEBUG_PRINT("Can not get the offsets of the chunks in the frame");
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+    }
+    int rc = caterva_io_direct_open(ctx, array->sc->storage->urlpath, ctx->cfg->io_depth,
+                                    &scan->file);
+    uint8_t *prefix = NULL;
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_io_direct_read(ctx, scan->file, 0, CATERVA_FRAME_HEADER_LEN + sizeof(int32_t),
+                                    &prefix);
+    }
+    if (rc == CATERVA_SUCCEED && prefix[CATERVA_FRAME_HEADER_LEN - 1] != 0xd2) {
+        DEBUG_PRINT("The header of the frame is not supported");
+        rc = CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (rc != CATERVA_SUCCEED) {
+        direct_scan_stop(ctx, scan);
+        CATERVA_ERROR(rc);
+    }
+    int32_t header_len;
+    swap_store(&header_len, &prefix[CATERVA_FRAME_HEADER_LEN], sizeof(int32_t));
+    scan->header_len = header_len;
+
+    return CATERVA_SUCCEED;
+}
+
+// Get a chunk of a direct scan (it points to the window of the scan, so it is valid until the
+// next one is got), with the kind of special chunk (0 if it is a regular one) and its value
+static int direct_scan_get(caterva_ctx_t *ctx, caterva_array_t *array, direct_scan_t *scan,
+                           int64_t index, int *special, uint8_t *value, uint8_t **cchunk,
+                           int32_t *cbytes, bool *needs_free) {
+    if (index >= scan->noffsets) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
+    }
+    if (scan->offsets[index] < 0) {
+        // Special chunks are encoded in the offsets index, so there is nothing to read
+        CATERVA_ERROR(get_chunk_special(array, index, special, value, cchunk, cbytes,
+                                        needs_free));
+        return CATERVA_SUCCEED;
+    }
+    // The header of the chunk is read first for its length, and then the whole chunk (both are
+    // usually served from the same extent)
+    int64_t offset = scan->header_len + scan->offsets[index];
+    uint8_t *header;
+    CATERVA_ERROR(caterva_io_direct_read(ctx, scan->file, offset, BLOSC_EXTENDED_HEADER_LENGTH,
+                                         &header));
+    int32_t nbytes;
+    int32_t blocksize;
+    if (blosc2_cbuffer_sizes(header, &nbytes, cbytes, &blocksize) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    CATERVA_ERROR(caterva_io_direct_read(ctx, scan->file, offset, *cbytes, cchunk));
+    *needs_free = false;
+    get_special(array, *cchunk, special, value);
+
+    return CATERVA_SUCCEED;
+}
+
+#if !defined(_WIN32)
+typedef struct chunk_reader_s chunk_reader_t;
+
+// A thread of a chunk reader, with its own handle of the frame (super-chunks can not be shared by
+// threads), which is kept on the array
+typedef struct {
+    chunk_reader_t *reader;
+    blosc2_schunk *sc;
+    pthread_t thread;
+} chunk_reader_thread_t;
+
+// A pool of threads reading ahead the compressed chunks needed by a slice of a disk-backed
+// array, so that up to `depth` reads are in flight while the previous chunks are decompressed.
+// The chunks of the arrays stored in an I/O backend are read by the backend instead, `depth` at
+// once.
+struct chunk_reader_s {
+    blosc2_schunk *sc;  // the super-chunk of the array (only used when no thread is running)
+    caterva_array_t *io_array;  // the array, if it is stored in an I/O backend
+    caterva_io_vec_t *vecs;     // the regions of a batch read by the I/O backend
+    int64_t *indexes;  // the indexes of the chunks to read (in the order they are consumed)
+    int64_t nreads;
+    int64_t depth;
+    uint8_t **cchunks;
+    int32_t *cbytes;
+    bool *needs_free;
+    bool *done;
+    int64_t next;      // the next chunk to read
+    int64_t consumed;  // the number of chunks already consumed
+    int nthreads;
+    chunk_reader_thread_t *threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+// Read a chunk from a super-chunk (with the mutex of the reader locked)
+static void chunk_reader_read(chunk_reader_t *reader, blosc2_schunk *sc, int64_t i) {
+    pthread_mutex_unlock(&reader->mutex);
+    uint8_t *cchunk;
+    bool needs_free = false;
+    int32_t cbytes = blosc2_schunk_get_chunk(sc, (int) reader->indexes[i], &cchunk, &needs_free);
+    pthread_mutex_lock(&reader->mutex);
+    reader->cchunks[i] = cbytes < 0 ? NULL : cchunk;
+    reader->cbytes[i] = cbytes;
+    reader->needs_free[i] = cbytes < 0 ? false : needs_free;
+    reader->done[i] = true;
+    pthread_cond_broadcast(&reader->cond);
+}
+
+// Read a batch of up to `depth` chunks through the I/O backend of the array (with the mutex of
+// the reader locked)
+static void chunk_reader_read_io(chunk_reader_t *reader, int64_t i) {
+    caterva_array_t *array = reader->io_array;
+    int nvecs = 0;
+    for (int64_t j = i; j < reader->nreads && nvecs < reader->depth; ++j) {
+        caterva_io_vec_t *vec = &reader->vecs[nvecs];
+        vec->offset = array->io_offsets[reader->indexes[j]];
+        vec->size = array->io_cbytes[reader->indexes[j]];
+        vec->data = malloc((size_t) vec->size);
+        if (vec->data == NULL) {
+            break;
+        }
+        nvecs++;
+    }
+    bool read = nvecs > 0 && caterva_io_read_regions(array->io, array->io_stream, reader->vecs,
+                                                     nvecs) == CATERVA_SUCCEED;
+    for (int k = 0; k < nvecs; ++k) {
+        if (!read) {
+            free(reader->vecs[k].data);
+        }
+        reader->cchunks[i + k] = read ? reader->vecs[k].data : NULL;
+        reader->cbytes[i + k] = read ? (int32_t) reader->vecs[k].size : -1;
+        reader->needs_free[i + k] = read;
+        reader->done[i + k] = true;
+    }
+    if (nvecs == 0) {
+        reader->cchunks[i] = NULL;
+        reader->cbytes[i] = -1;
+        reader->needs_free[i] = false;
+        reader->done[i] = true;
+    }
+    reader->next = i + (nvecs > 0 ? nvecs : 1);
+}
+
+static void *chunk_reader_run(void *arg) {
+    chunk_reader_thread_t *thread = arg;
+    chunk_reader_t *reader = thread->reader;
+    pthread_mutex_lock(&reader->mutex);
+    while (reader->next < reader->nreads) {
+        if (reader->next >= reader->consumed + reader->depth) {
+            pthread_cond_wait(&reader->cond, &reader->mutex);
+            continue;
+        }
+        chunk_reader_read(reader, thread->sc, reader->next++);
+    }
+    pthread_mutex_unlock(&reader->mutex);
+    return NULL;
+}
+
+// Open the handles of the frame for the threads reading ahead the chunks that are not opened
+// yet. They are kept on the array for the next slices, but the ones that do not know about the
+// chunks appended since they were opened are opened again.
+static int reader_scs_open(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads) {
+    if (array->reader_nscs > 0 && array->reader_scs[0]->nchunks != array->sc->nchunks) {
+        reader_scs_clear(ctx, array);
+    }
+    if (array->reader_nscs >= nthreads) {
+        return CATERVA_SUCCEED;
+    }
+    blosc2_schunk **scs = ctx->cfg->alloc(nthreads * sizeof(blosc2_schunk *));
+    CATERVA_ERROR_NULL(scs);
+    for (int i = 0; i < array->reader_nscs; ++i) {
+        scs[i] = array->reader_scs[i];
+    }
+    if (array->reader_scs != NULL) {
+        ctx->cfg->free(array->reader_scs);
+    }
+    array->reader_scs = scs;
+    while (array->reader_nscs < nthreads) {
+        blosc2_schunk *sc = blosc2_schunk_open(array->sc->storage->urlpath);
+        if (sc == NULL) {
+            break;
+        }
+        array->reader_scs[array->reader_nscs++] = sc;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Release the buffers of a chunk reader that has no thread running
+static void chunk_reader_free(caterva_ctx_t *ctx, chunk_reader_t *reader) {
+    void *buffers[] = {reader->threads, reader->done, reader->needs_free, reader->cbytes,
+                       reader->cchunks, reader->indexes, reader->vecs};
+    for (size_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); ++i) {
+        if (buffers[i] != NULL) {
+            ctx->cfg->free(buffers[i]);
+        }
+    }
+    reader->indexes = NULL;
+}
+
+// Start reading the chunks (the reader takes the ownership of the indexes, also on failure)
+static int chunk_reader_start(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *indexes,
+                              int64_t nreads, chunk_reader_t *reader) {
+    memset(reader, 0, sizeof(chunk_reader_t));
+    reader->sc = array->sc;
+    reader->indexes = indexes;
+    reader->nreads = nreads;
+    reader->depth = ctx->cfg->io_depth;
+    int nthreads = (int) (nreads < reader->depth ? nreads : reader->depth);
+    reader->cchunks = ctx->cfg->alloc(nreads * sizeof(uint8_t *));
+    reader->cbytes = ctx->cfg->alloc(nreads * sizeof(int32_t));
+    reader->needs_free = ctx->cfg->alloc(nreads * sizeof(bool));
+    reader->done = ctx->cfg->alloc(nreads * sizeof(bool));
+    reader->threads = ctx->cfg->alloc(nthreads * sizeof(chunk_reader_thread_t));
+    if (array->io != NULL) {
+        reader->io_array = array;
+        reader->vecs = ctx->cfg->alloc(reader->depth * sizeof(caterva_io_vec_t));
+    }
+    if (reader->cchunks == NULL || reader->cbytes == NULL || reader->needs_free == NULL ||
+        reader->done == NULL || reader->threads == NULL ||
+        (array->io != NULL && reader->vecs == NULL)) {
+        chunk_reader_free(ctx, reader);
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    int rc = array->io != NULL ? CATERVA_SUCCEED : reader_scs_open(ctx, array, nthreads);
+    if (rc != CATERVA_SUCCEED) {
+        chunk_reader_free(ctx, reader);
+        CATERVA_ERROR(rc);
+    }
+    memset(reader->done, 0, nreads * sizeof(bool));
+    pthread_mutex_init(&reader->mutex, NULL);
+    pthread_cond_init(&reader->cond, NULL);
+
+    // Every thread reads from its own handle of the frame, so that its reads do not share any
+    // state
+    for (int i = 0; array->io == NULL && i < nthreads && i < array->reader_nscs; ++i) {
+        chunk_reader_thread_t *thread = &reader->threads[reader->nthreads];
+        thread->reader = reader;
+        thread->sc = array->reader_scs[i];
+        if (pthread_create(&thread->thread, NULL, chunk_reader_run, thread) != 0) {
+            break;
+        }
+        reader->nthreads++;
+    }
+    // If no thread can be started, the chunks are read one by one when they are consumed
+    return CATERVA_SUCCEED;
+}
+
+// Wait for a chunk to be read
+static int chunk_reader_get(chunk_reader_t *reader, int64_t i, uint8_t **cchunk,
+                            int32_t *cbytes) {
+    pthread_mutex_lock(&reader->mutex);
+    if (reader->io_array != NULL && !reader->done[i]) {
+        chunk_reader_read_io(reader, i);
+    } else if (reader->nthreads == 0 && !reader->done[i]) {
+        reader->next++;
+        chunk_reader_read(reader, reader->sc, i);
+    }
+    while (!reader->done[i]) {
+        pthread_cond_wait(&reader->cond, &reader->mutex);
+    }
+    *cchunk = reader->cchunks[i];
+    *cbytes = reader->cbytes[i];
+    pthread_mutex_unlock(&reader->mutex);
+    if (*cbytes < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Release a chunk once it has been consumed, making room for the next read
+static void chunk_reader_release(chunk_reader_t *reader, int64_t i) {
+    pthread_mutex_lock(&reader->mutex);
+    if (reader->needs_free[i]) {
+        free(reader->cchunks[i]);
+    }
+    reader->cchunks[i] = NULL;
+    reader->consumed++;
+    pthread_cond_broadcast(&reader->cond);
+    pthread_mutex_unlock(&reader->mutex);
+}
+
+// Stop reading chunks (the ones not consumed yet are discarded)
+static void chunk_reader_stop(caterva_ctx_t *ctx, chunk_reader_t *reader) {
+    if (reader->indexes == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&reader->mutex);
+    reader->nreads = reader->next;
+    pthread_cond_broadcast(&reader->cond);
+    pthread_mutex_unlock(&reader->mutex);
+    for (int i = 0; i < reader->nthreads; ++i) {
+        pthread_join(reader->threads[i].thread, NULL);
+    }
+    for (int64_t i = 0; i < reader->nreads; ++i) {
+        if (reader->cchunks[i] != NULL && reader->needs_free[i]) {
+            free(reader->cchunks[i]);
+        }
+    }
+    pthread_mutex_destroy(&reader->mutex);
+    pthread_cond_destroy(&reader->cond);
+    chunk_reader_free(ctx, reader);
+}
+#else
+// Chunks are read one by one when they are consumed
+typedef struct {
+    int64_t *indexes;
+    int64_t nreads;
+} chunk_reader_t;
+
+static int chunk_reader_start(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *indexes,
+                              int64_t nreads, chunk_reader_t *reader) {
+    (void) array;
+    (void) nreads;
+    ctx->cfg->free(indexes);
+    reader->indexes = NULL;
+    reader->nreads = 0;
+    return CATERVA_SUCCEED;
+}
+
+static int chunk_reader_get(chunk_reader_t *reader, int64_t i, uint8_t **cchunk,
+                            int32_t *cbytes) {
+    (void) reader;
+    (void) i;
+    (void) cchunk;
+    (void) cbytes;
+    return CATERVA_ERR_INVALID_ARGUMENT;
+}
+
+static void chunk_reader_release(chunk_reader_t *reader, int64_t i) {
+    (void) reader;
+    (void) i;
+}
+
+static void chunk_reader_stop(caterva_ctx_t *ctx, chunk_reader_t *reader) {
+    (void) ctx;
+    (void) reader;
+}
+#endif
+
+// Check whether a slice covers the whole chunk with coordinates ii (every coordinate is padded
+// to CATERVA_MAX_DIM dimensions)
+static bool slice_covers_chunk(caterva_array_t *array, const int64_t *ii, const int64_t *start_,
+                               const int64_t *stop_, const int64_t *s_pshape) {
+    for (int i = 0; i < array->ndim; ++i) {
+        int j = CATERVA_MAX_DIM - array->ndim + i;
+        int64_t offset = ii[j] * s_pshape[j];
+        int64_t end = offset + s_pshape[j] < array->shape[i] ? offset + s_pshape[j]
+                                                            : array->shape[i];
+        if (start_[j] > offset || stop_[j] < end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Get the index of the chunk of the grid of a slice (and its coordinates along each dimension)
+static int64_t get_slice_nchunk(int64_t chunk_ind, int64_t *i_shape, const int64_t *i_start,
+                                const int64_t *s_eshape, const int64_t *s_pshape, int64_t *ii) {
+    index_unidim_to_multidim(CATERVA_MAX_DIM, i_shape, chunk_ind, ii);
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        ii[i] += i_start[i];
+    }
+    int64_t nchunk = 0;
+    int64_t inc = 1;
+    for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
+        nchunk += ii[i] * inc;
+        inc *= s_eshape[i] / s_pshape[i];
+    }
+    return nchunk;
+}
+
+// Fill the region [start, stop) of a buffer (all of them with CATERVA_MAX_DIM dims) with a value
+static void fill_buffer(uint8_t *buffer, const int64_t *shape, const int64_t *start,
+                        const int64_t *stop, const uint8_t *value, int8_t itemsize) {
+    int64_t rows_shape[CATERVA_MAX_DIM];
+    int64_t nrows = 1;
+    for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
+        rows_shape[i] = stop[i] - start[i];
+        nrows *= rows_shape[i];
+    }
+    int64_t rowlen = stop[CATERVA_MAX_DIM - 1] - start[CATERVA_MAX_DIM - 1];
+    bool zeros = true;
+    for (int i = 0; i < itemsize; ++i) {
+        if (value[i] != 0) {
+            zeros = false;
+            break;
+        }
+    }
+    for (int64_t row = 0; row < nrows; ++row) {
+        int64_t kk[CATERVA_MAX_DIM];
+        index_unidim_to_multidim(CATERVA_MAX_DIM - 1, rows_shape, row, kk);
+        kk[CATERVA_MAX_DIM - 1] = 0;
+        int64_t pointer = 0;
+        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+            pointer = pointer * shape[i] + start[i] + kk[i];
+        }
+        uint8_t *dest = &buffer[pointer * itemsize];
+        if (zeros) {
+            memset(dest, 0, (size_t) rowlen * itemsize);
+        } else {
+            for (int64_t j = 0; j < rowlen; ++j) {
+                memcpy(&dest[j * itemsize], value, itemsize);
+            }
+        }
+    }
+}
+
+// Create an array out of a super-chunk. Read-only arrays never modify the super-chunk (it can be
+// backed by a frame mapped from a file).
+static int from_schunk(caterva_ctx_t *ctx, blosc2_schunk *schunk, bool readonly,
+                       caterva_array_t **array) {
+    if (ctx == NULL) {
+        DEBUG_PRINT("Context is null");
+        return CATERVA_ERR_NULL_POINTER;
+    }
+    if (schunk == NULL) {
+        DEBUG_PRINT("Schunk is null");
+        return CATERVA_ERR_NULL_POINTER;
+    }
+    /* Create a caterva_array_t buffer */
+    *array = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
+    CATERVA_ERROR_NULL(array);
+
+    if (schunk == NULL) {
+        DEBUG_PRINT("Schunk is null");
+        return CATERVA_ERR_NULL_POINTER;
+    }
+    (*array)->sc = schunk;
+    (*array)->storage = CATERVA_STORAGE_BLOSC;
+    (*array)->readonly = readonly;
+    (*array)->lazy_urlpath = NULL;
+    (*array)->shards = NULL;
+    (*array)->nshards = 0;
+    (*array)->shard_urlpath = NULL;
+
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(schunk, &cparams) < 0) {
+        DEBUG_PRINT("Blosc error");
+        return CATERVA_ERR_NULL_POINTER;
+    }
+
+    (*array)->itemsize = (int8_t) cparams->typesize;
+
+    free(cparams);
+
+    // Deserialize the caterva metalayer
+    uint8_t *smeta;
+    uint32_t smeta_len;
+    if (blosc2_meta_get(schunk, "caterva", &smeta, &smeta_len) < 0) {
+        DEBUG_PRINT("Blosc error");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    deserialize_meta(smeta, smeta_len, &(*array)->ndim, (*array)->shape, (*array)->chunkshape,
+                     (*array)->blockshape, &(*array)->chunk_order, &(*array)->block_order);
+    free(smeta);
+
+    int64_t *shape = (*array)->shape;
+    int32_t *chunkshape = (*array)->chunkshape;
+    int32_t *blockshape = (*array)->blockshape;
+
+    (*array)->nitems = 1;
+    (*array)->chunknitems = 1;
+    (*array)->blocknitems = 1;
+    (*array)->extnitems = 1;
+    (*array)->extchunknitems = 1;
+
+    for (int i = 0; i < (*array)->ndim; ++i) {
+        if (shape[i] != 0) {
+            if (shape[i] % chunkshape[i] == 0) {
+                (*array)->extshape[i] = shape[i];
+            } else {
+                (*array)->extshape[i] = shape[i] + chunkshape[i] - shape[i] % chunkshape[i];
+            }
+        } else {
+            (*array)->extshape[i] = 0;
+        }
+        if (chunkshape[i] != 0 && blockshape[i] != 0) {
+            if (chunkshape[i] % blockshape[i] == 0) {
+                (*array)->extchunkshape[i] = chunkshape[i];
+            } else {
+                (*array)->extchunkshape[i] =
+                        chunkshape[i] + blockshape[i] - chunkshape[i] % blockshape[i];
+            }
+        } else {
+            (*array)->extchunkshape[i] = 0;
+        }
+        (*array)->nitems *= shape[i];
+        (*array)->chunknitems *= chunkshape[i];
+        (*array)->blocknitems *= blockshape[i];
+        (*array)->extnitems *= (*array)->extshape[i];
+        (*array)->extchunknitems *= (*array)->extchunkshape[i];
+    }
+
+    for (int i = (*array)->ndim; i < CATERVA_MAX_DIM; ++i) {
+        (*array)->shape[i] = 1;
+        (*array)->chunkshape[i] = 1;
+        (*array)->blockshape[i] = 1;
+        (*array)->extshape[i] = 1;
+        (*array)->extchunkshape[i] = 1;
+    }
+
+    // The partition cache (empty initially)
+    (*array)->chunk_cache.data = NULL;
+    (*array)->chunk_cache.nchunk = -1;  // means no valid cache yet
+
+    // The write-back cache (empty initially)
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        (*array)->write_cache[i].data = NULL;
+        (*array)->write_cache[i].nchunk = -1;
+        (*array)->write_cache[i].dirty = false;
+        (*array)->write_cache[i].access = 0;
+    }
+    (*array)->write_cache_access = 0;
+    (*array)->access_stats = NULL;
+    (*array)->ccache = NULL;
+    (*array)->ccache_len = 0;
+    (*array)->ccache_free = -1;
+    (*array)->ccache_slots = NULL;
+    (*array)->ccache_nslots = 0;
+    (*array)->ccache_hand = 0;
+    (*array)->reader_scs = NULL;
+    (*array)->reader_nscs = 0;
+    memset(&(*array)->ccache_stats, 0, sizeof(caterva_ccache_stats_t));
+    (*array)->checksums_dropped = false;
+    (*array)->io = NULL;
+    (*array)->io_urlpath = NULL;
+    (*array)->io_stream = NULL;
+    (*array)->io_offsets = NULL;
+    (*array)->io_cbytes = NULL;
+    (*array)->io_nslots = 0;
+    (*array)->io_end = 0;
+    (*array)->io_tail = NULL;
+    (*array)->io_tail_len = 0;
+
+    (*array)->buf = NULL;
+    (*array)->map = NULL;
+    (*array)->map_len = 0;
+    (*array)->map_urlpath = NULL;
+    (*array)->advice = CATERVA_ADVICE_NORMAL;
+    (*array)->ndirect_scans = 0;
+
+    for (int i = 0; i < CATERVA_MAX_CODEC_CANDIDATES; ++i) {
+        (*array)->codec_cctx[i] = NULL;
+        (*array)->codec_nchunks[i] = 0;
+    }
+    (*array)->codec_ncandidates = 0;
+    (*array)->nchunks = schunk->nchunks;
+
+    // Get the extendable axis (if any)
+    (*array)->extendable = false;
+    (*array)->extendable_axis = 0;
+    (*array)->pending_slabs = 0;
+    if (blosc2_vlmeta_exists(schunk, CATERVA_EXTENDABLE_VLMETA) >= 0) {
+        uint8_t *saxis;
+        uint32_t saxis_len;
+        if (blosc2_vlmeta_get(schunk, CATERVA_EXTENDABLE_VLMETA, &saxis, &saxis_len) < 0) {
+            DEBUG_PRINT("Blosc error");
+            return CATERVA_ERR_BLOSC_FAILED;
+        }
+        (*array)->extendable = true;
+        (*array)->extendable_axis = (int8_t) saxis[0];  // positive fixnum
+        free(saxis);
+
+        // The metalayer is only updated every few slabs, so the slabs appended since then
+        // have to be recovered from the number of chunks (they are not pending, so opening
+        // an array does not rewrite its metalayers; they are recovered again on every open)
+        int64_t nslabs = ((*array)->nchunks - get_grid_nchunks(*array)) /
+                         get_slab_nchunks(*array);
+        if (nslabs > 0) {
+            int64_t new_shape[CATERVA_MAX_DIM];
+            for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                new_shape[i] = shape[i];
+            }
+            new_shape[(*array)->extendable_axis] +=
+                    nslabs * chunkshape[(*array)->extendable_axis];
+            update_geometry(*array, (*array)->ndim, new_shape, chunkshape, blockshape);
+        }
+    }
+
+    // Get the fill value and the chunk presence bitmap of sparse arrays (where the number
+    // of chunks is not the one in the super-chunk)
+    (*array)->sparse = false;
+    (*array)->fill_value = NULL;
+    (*array)->chunk_presence = NULL;
+    (*array)->chunk_ranks = NULL;
+    (*array)->chunk_presence_dirty = false;
+    if (blosc2_vlmeta_exists(schunk, CATERVA_SPARSE_VLMETA) >= 0) {
+        (*array)->sparse = true;
+        CATERVA_ERROR(get_sparse_meta(ctx, *array));
+    }
+
+    // Compute the positions of the chunks along the chunk order (and of the blocks along the
+    // block order)
+    CATERVA_ERROR(create_chunk_positions(ctx, *array));
+    if ((*array)->chunk_positions != NULL && !(*array)->sparse) {
+        CATERVA_ERROR(create_chunk_presence(ctx, *array));
+    }
+    CATERVA_ERROR(create_block_positions(ctx, *array));
+
+    if ((*array)->nitems == 0 && (*array)->nchunks == 0) {
+        (*array)->filled = true;
+        (*array)->empty = false;
+    } else {
+        if ((*array)->nchunks == get_grid_nchunks(*array)) {
+            (*array)->filled = true;
+        } else {
+            (*array)->filled = false;
+        }
+    }
+    update_next_chunkshape(*array, (*array)->nchunks);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_from_schunk(caterva_ctx_t *ctx, blosc2_schunk *schunk, caterva_array_t **array) {
+    CATERVA_ERROR(from_schunk(ctx, schunk, false, array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_from_serial_schunk(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64_t len,
+                                     caterva_array_t **array) {
+    blosc2_schunk *sc = blosc2_schunk_from_buffer(serial_schunk, len, true);
+    if (sc == NULL) {
+        DEBUG_PRINT("Blosc error");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    // ...and create a caterva array out of it
+    CATERVA_ERROR(caterva_from_schunk(ctx, sc, array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_from_serial_schunk_view(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64_t len,
+                                          caterva_array_t **array) {
+    // The chunks are decompressed straight from the buffer of the caller (it is not copied)
+    blosc2_schunk *sc = blosc2_schunk_from_buffer(serial_schunk, len, false);
+    if (sc == NULL) {
+        DEBUG_PRINT("Blosc error");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    int rc = from_schunk(ctx, sc, true, array);
+    if (rc != CATERVA_SUCCEED) {
+        blosc2_schunk_free(sc);
+        return rc;
+    }
+    (*array)->empty = false;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_open(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array) {
+    blosc2_schunk *sc = blosc2_schunk_open(urlpath);
+
+    // ...and create a caterva array out of it
+    CATERVA_ERROR(caterva_from_schunk(ctx, sc, array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_open_io(caterva_ctx_t *ctx, const caterva_io_t *io, const char *urlpath,
+                          caterva_array_t **array) {
+    // The stream is opened for writing if the backend allows it (the array is read-only if not)
+    bool readonly = false;
+    void *stream = io->open(urlpath, "r+b", io->params);
+    if (stream == NULL) {
+        readonly = true;
+        stream = io->open(urlpath, "rb", io->params);
+    }
+    if (stream == NULL) {
+        DEBUG_PRINT("Can not open the stream in the I/O backend");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    // Only the tail is read. Its super-chunk holds the chunks apart in memory, so that the ones
+    // written in the stream are released when the array is flushed.
+    uint8_t *tail = NULL;
+    int64_t tail_len;
+    int64_t end;
+    uint8_t *frame;
+    int64_t frame_len;
+    int64_t *offsets = NULL;
+    int32_t *cbytes = NULL;
+    int64_t nchunks;
+    blosc2_schunk *sc = NULL;
+    int rc = caterva_io_read_tail(ctx, io, stream, &tail, &tail_len, &end);
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_io_decode_tail(ctx, tail, tail_len, &frame, &frame_len, &offsets, &cbytes,
+                                    &nchunks);
+    }
+    if (rc == CATERVA_SUCCEED) {
+        blosc2_schunk *frame_sc = blosc2_schunk_from_buffer(frame, frame_len, true);
+        blosc2_cparams *cparams = NULL;
+        blosc2_dparams *dparams = NULL;
+        if (frame_sc != NULL && blosc2_schunk_get_cparams(frame_sc, &cparams) >= 0 &&
+            blosc2_schunk_get_dparams(frame_sc, &dparams) >= 0) {
+            cparams->schunk = NULL;
+            dparams->schunk = NULL;
+            blosc2_storage b_storage = BLOSC2_STORAGE_DEFAULTS;
+            b_storage.cparams = cparams;
+            b_storage.dparams = dparams;
+            sc = blosc2_schunk_copy(frame_sc, &b_storage);
+        }
+        if (cparams != NULL) {
+            free(cparams);
+        }
+        if (dparams != NULL) {
+            free(dparams);
+        }
+        if (frame_sc != NULL) {
+            blosc2_schunk_free(frame_sc);
+        }
+        if (sc == NULL) {
+            DEBUG_PRINT("Blosc error");
+            rc = CATERVA_ERR_BLOSC_FAILED;
+        } else if (sc->nchunks != nchunks) {
+            DEBUG_PRINT("The index of the stream does not match its frame");
+            rc = CATERVA_ERR_INVALID_STORAGE;
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = from_schunk(ctx, sc, readonly, array);
+    }
+    char *io_urlpath = NULL;
+    if (rc == CATERVA_SUCCEED) {
+        io_urlpath = ctx->cfg->alloc(strlen(urlpath) + 1);
+        if (io_urlpath == NULL) {
+            caterva_blosc_array_free(ctx, array);
+            sc = NULL;
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+    }
+    if (rc != CATERVA_SUCCEED) {
+        void *buffers[] = {tail, offsets, cbytes};
+        for (size_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); ++i) {
+            if (buffers[i] != NULL) {
+                ctx->cfg->free(buffers[i]);
+            }
+        }
+        if (sc != NULL) {
+            blosc2_schunk_free(sc);
+        }
+        io->close(stream);
+        CATERVA_ERROR(rc);
+    }
+    strcpy(io_urlpath, urlpath);
+    (*array)->io = io;
+    (*array)->io_urlpath = io_urlpath;
+    (*array)->io_stream = stream;
+    (*array)->io_offsets = offsets;
+    (*array)->io_cbytes = cbytes;
+    (*array)->io_nslots = nchunks > 0 ? nchunks : 1;
+    (*array)->io_end = end;
+    (*array)->io_tail = tail;
+    (*array)->io_tail_len = tail_len;
+
+    return CATERVA_SUCCEED;
+}
+
+// Read the header of a sequential frame and find the content of the caterva metalayer in it.
+// Every field is checked, and false is returned if the header does not have the expected format.
+static bool read_frame_header(caterva_ctx_t *ctx, const char *urlpath, uint8_t **header,
+                              int32_t *typesize, int64_t *nbytes, uint8_t **smeta,
+                              uint32_t *smeta_len) {
+    *header = NULL;
+    FILE *fp = fopen(urlpath, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    uint8_t prefix[CATERVA_FRAME_HEADER_LEN + sizeof(int32_t)];
+    int32_t header_len = 0;
+    if (fread(prefix, 1, sizeof(prefix), fp) == sizeof(prefix) && (prefix[0] & 0xf0) == 0x90 &&
+        prefix[1] == 0xa8 && memcmp(&prefix[CATERVA_FRAME_HEADER_MAGIC], "b2frame", 8) == 0 &&
+        prefix[CATERVA_FRAME_HEADER_LEN - 1] == 0xd2) {
+        swap_store(&header_len, &prefix[CATERVA_FRAME_HEADER_LEN], sizeof(int32_t));
+    }
+    if (header_len < CATERVA_FRAME_METALAYERS + 7 || header_len > CATERVA_FRAME_MAX_HEADER_LEN) {
+        fclose(fp);
+        return false;
+    }
+    *header = ctx->cfg->alloc((size_t) header_len);
+    if (*header == NULL) {
+        fclose(fp);
+        return false;
+    }
+    memcpy(*header, prefix, sizeof(prefix));
+    size_t rbytes = fread(*header + sizeof(prefix), 1, (size_t) header_len - sizeof(prefix), fp);
+    fclose(fp);
+    if (rbytes != (size_t) header_len - sizeof(prefix)) {
+        return false;
+    }
+    uint8_t *h = *header;
+    // The version is kept in the low bits of the general flags, and other versions of the format
+    // may place the fields elsewhere
+    if (h[CATERVA_FRAME_FLAGS - 1] != 0xa4 ||
+        (h[CATERVA_FRAME_FLAGS] & 0x0f) != CATERVA_FRAME_VERSION ||
+        h[CATERVA_FRAME_NBYTES - 1] != 0xd3 || h[CATERVA_FRAME_TYPESIZE - 1] != 0xd2) {
+        return false;
+    }
+    swap_store(nbytes, &h[CATERVA_FRAME_NBYTES], sizeof(int64_t));
+    swap_store(typesize, &h[CATERVA_FRAME_TYPESIZE], sizeof(int32_t));
+
+    // The metalayers are a fixarray with the index size, a map of names to offsets and an array
+    // with the contents (each one a bin32 at its offset)
+    uint8_t *pmeta = &h[CATERVA_FRAME_METALAYERS];
+    if (pmeta[0] != 0x93 || pmeta[1] != 0xcd || pmeta[4] != 0xde) {
+        return false;
+    }
+    uint16_t nmetalayers;
+    swap_store(&nmetalayers, &pmeta[5], sizeof(uint16_t));
+    pmeta += 7;
+    for (int i = 0; i < nmetalayers; ++i) {
+        if (pmeta + 1 > h + header_len || (pmeta[0] & 0xe0) != 0xa0) {
+            return false;
+        }
+        int name_len = pmeta[0] & 0x1f;
+        if (pmeta + 1 + name_len + 1 + sizeof(int32_t) > h + header_len) {
+            return false;
+        }
+        bool found = name_len == 7 && memcmp(&pmeta[1], "caterva", 7) == 0;
+        pmeta += 1 + name_len;
+        if (pmeta[0] != 0xd2) {
+            return false;
+        }
+        int32_t offset;
+        swap_store(&offset, &pmeta[1], sizeof(int32_t));
+        pmeta += 1 + sizeof(int32_t);
+        if (!found) {
+            continue;
+        }
+        if (offset < CATERVA_FRAME_METALAYERS || offset + 5 > header_len || h[offset] != 0xc6) {
+            return false;
+        }
+        int32_t content_len;
+        swap_store(&content_len, &h[offset + 1], sizeof(int32_t));
+        if (content_len < 1 || offset + 5 + content_len > header_len) {
+            return false;
+        }
+        *smeta = &h[offset + 5];
+        *smeta_len = (uint32_t) content_len;
+        // Only the formats known by this version can be deserialized
+        return (*smeta)[0] >= 0x95 && (*smeta)[0] <= 0x97 &&
+               (*smeta)[1] <= CATERVA_METALAYER_VERSION;
+    }
+
+    return false;
+}
+
+int caterva_blosc_open_lazy(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array) {
+    uint8_t *header;
+    int32_t typesize;
+    int64_t nbytes;
+    uint8_t *smeta;
+    uint32_t smeta_len;
+    if (!read_frame_header(ctx, urlpath, &header, &typesize, &nbytes, &smeta, &smeta_len)) {
+        // Frames that are not sequential (or whose header is not understood) are read eagerly
+        if (header != NULL) {
+            ctx->cfg->free(header);
+        }
+        CATERVA_ERROR(caterva_blosc_open(ctx, urlpath, array));
+        return CATERVA_SUCCEED;
+    }
+
+    *array = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
+    CATERVA_ERROR_NULL(*array);
+    memset(*array, 0, sizeof(caterva_array_t));
+    (*array)->storage = CATERVA_STORAGE_BLOSC;
+    (*array)->itemsize = (int8_t) typesize;
+
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    deserialize_meta(smeta, smeta_len, &ndim, shape, chunkshape, blockshape,
+                     &(*array)->chunk_order, &(*array)->block_order);
+    ctx->cfg->free(header);
+    update_geometry(*array, ndim, shape, chunkshape, blockshape);
+
+    // The caterva metalayer of extendable arrays is only updated every few slabs, so the frames
+    // with more chunks than the ones in the grid are read eagerly (recovering the slabs appended
+    // since then out of the number of chunks, which needs the extendable axis of the trailer)
+    int64_t chunk_nbytes = (*array)->extchunknitems * (*array)->itemsize;
+    if (chunk_nbytes > 0 && nbytes / chunk_nbytes > get_grid_nchunks(*array)) {
+        ctx->cfg->free(*array);
+        CATERVA_ERROR(caterva_blosc_open(ctx, urlpath, array));
+        return CATERVA_SUCCEED;
+    }
+
+    (*array)->chunk_cache.nchunk = -1;
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        (*array)->write_cache[i].nchunk = -1;
+    }
+
+    // The super-chunk is loaded on the first access to the data
+    (*array)->lazy_urlpath = ctx->cfg->alloc(strlen(urlpath) + 1);
+    CATERVA_ERROR_NULL((*array)->lazy_urlpath);
+    strcpy((*array)->lazy_urlpath, urlpath);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_load(caterva_ctx_t *ctx, caterva_array_t *array) {
+    if (array->lazy_urlpath == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    caterva_array_t *loaded;
+    CATERVA_ERROR(caterva_blosc_open(ctx, array->lazy_urlpath, &loaded));
+
+    // The loaded array replaces the lazy one (keeping the accesses recorded so far and the
+    // access pattern advised)
+    caterva_access_stats_t *access_stats = array->access_stats;
+    caterva_advice_t advice = array->advice;
+    ctx->cfg->free(array->lazy_urlpath);
+    *array = *loaded;
+    array->access_stats = access_stats;
+    array->advice = advice;
+    ctx->cfg->free(loaded);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_open_mmap(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array) {
+#if defined(_WIN32)
+    CATERVA_UNUSED_PARAM(ctx);
+    CATERVA_UNUSED_PARAM(urlpath);
+    CATERVA_UNUSED_PARAM(array);
+    DEBUG_PRINT("Mapping frames is not supported on Windows");
+    return CATERVA_ERR_INVALID_STORAGE;
+#else
+    int fd = open(urlpath, O_RDONLY);
+    if (fd < 0) {
+        DEBUG_PRINT("Can not open the frame file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        DEBUG_PRINT("Only sequential frames can be mapped");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    // The pages of the frame are shared by every process mapping it
+    int64_t len = (int64_t) st.st_size;
+    void *map = mmap(NULL, (size_t) len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        DEBUG_PRINT("Can not map the frame file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    // The chunks are decompressed straight from the mapping (the frame is not copied)
+    blosc2_schunk *sc = blosc2_schunk_from_buffer(map, len, false);
+    if (sc == NULL) {
+        munmap(map, (size_t) len);
+        DEBUG_PRINT("Blosc error");
+        return CATERVA_ERR_BLOSC_FAILED;
+    }
+    int rc = from_schunk(ctx, sc, true, array);
+    if (rc != CATERVA_SUCCEED) {
+        blosc2_schunk_free(sc);
+        munmap(map, (size_t) len);
+        return rc;
+    }
+    (*array)->map = map;
+    (*array)->map_len = len;
+    (*array)->empty = false;
+
+    return CATERVA_SUCCEED;
+#endif
+}
+
+int caterva_blosc_array_free(caterva_ctx_t *ctx, caterva_array_t **array) {
+    if ((*array)->sc != NULL) {
+        CATERVA_ERROR(caterva_blosc_array_flush(ctx, *array));
+        CATERVA_ERROR(write_cache_clear(ctx, *array));
+        blosc2_schunk_free((*array)->sc);
+    }
+    ccache_clear(ctx, *array);
+    if ((*array)->lazy_urlpath != NULL) {
+        ctx->cfg->free((*array)->lazy_urlpath);
+    }
+    if ((*array)->io_urlpath != NULL) {
+        ctx->cfg->free((*array)->io_urlpath);
+    }
+    if ((*array)->io_stream != NULL && (*array)->io->close((*array)->io_stream) != 0) {
+        DEBUG_PRINT("Error closing the stream in the I/O backend");
+    }
+    void *io_buffers[] = {(*array)->io_offsets, (*array)->io_cbytes, (*array)->io_tail};
+    for (size_t i = 0; i < sizeof(io_buffers) / sizeof(io_buffers[0]); ++i) {
+        if (io_buffers[i] != NULL) {
+            ctx->cfg->free(io_buffers[i]);
+        }
+    }
+#if !defined(_WIN32)
+    // The frame mapped from a file is released after the super-chunk using it
+    if ((*array)->map != NULL) {
+        munmap((*array)->map, (size_t) (*array)->map_len);
+    }
+#endif
+    free_codec_cctxs(*array);
+    if ((*array)->sparse) {
+        ctx->cfg->free((*array)->fill_value);
+    }
+    if ((*array)->chunk_presence != NULL) {
+        ctx->cfg->free((*array)->chunk_presence);
+    }
+    if ((*array)->chunk_ranks != NULL) {
+        ctx->cfg->free((*array)->chunk_ranks);
+    }
+    if ((*array)->chunk_positions != NULL) {
+        ctx->cfg->free((*array)->chunk_positions);
+    }
+    if ((*array)->block_positions != NULL) {
+        ctx->cfg->free((*array)->block_positions);
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_repart_chunk(int8_t *rchunk, int64_t rchunksize, void *chunk,
+                                     int64_t chunksize, caterva_array_t *array) {
+    if (rchunksize != array->extchunknitems * array->itemsize) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    if (chunksize != array->chunknitems * array->itemsize) {
+        CATERVA_ERROR(CATERVA_ERR_INVALID_ARGUMENT);
+    }
+
+    const int8_t *src_b = (int8_t *) chunk;
+    memset(rchunk, 0, (size_t) rchunksize);
+    int32_t d_pshape[CATERVA_MAX_DIM];
+    int64_t d_epshape[CATERVA_MAX_DIM];
+    int32_t d_spshape[CATERVA_MAX_DIM];
+    int8_t d_ndim = array->ndim;
+
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        d_pshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->chunkshape[i];
+        d_epshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->extchunkshape[i];
+        d_spshape[(CATERVA_MAX_DIM - d_ndim + i) % CATERVA_MAX_DIM] = array->blockshape[i];
+    }
+
+    int64_t aux[CATERVA_MAX_DIM];
+    aux[7] = d_epshape[7] / d_spshape[7];
+    for (int i = CATERVA_MAX_DIM - 2; i >= 0; i--) {
+        aux[i] = d_epshape[i] / d_spshape[i] * aux[i + 1];
+    }
+
+    /* Fill each block buffer */
+    int32_t orig[CATERVA_MAX_DIM];
+    int64_t actual_spsize[CATERVA_MAX_DIM];
+    for (int32_t sci = 0; sci < array->extchunknitems / array->blocknitems; sci++) {
         /*Calculate the coord. of the block first element */
         orig[7] = sci % (d_epshape[7] / d_spshape[7]) * d_spshape[7];
         for (int i = CATERVA_MAX_DIM - 2; i >= 0; i--) {
@@ -375,7 +2599,7 @@ int caterva_blosc_array_repart_chunk(int8_t *rchunk, int64_t rchunksize, void *c
             index_unidim_to_multidim(CATERVA_MAX_DIM - 1, actual_spsize, ncopy, ii);
 
             int64_t d_a = d_spshape[7];
-            int64_t d_coord_f = sci * array->blocknitems;
+            int64_t d_coord_f = get_block_position(array, sci) * array->blocknitems;
             for (int i = CATERVA_MAX_DIM - 2; i >= 0; i--) {
                 d_coord_f += ii[i] * d_a;
                 d_a *= d_spshape[i];
@@ -397,7 +2621,20 @@ int caterva_blosc_array_repart_chunk(int8_t *rchunk, int64_t rchunksize, void *c
 
 int caterva_blosc_array_append(caterva_ctx_t *ctx, caterva_array_t *array, void *chunk,
                                int32_t chunksize) {
-    CATERVA_UNUSED_PARAM(ctx);
+    // Appending a slab moves the chunks after it
+    CATERVA_ERROR(write_cache_clear(ctx, array));
+
+    // The chunks filled with the fill value are not stored in sparse arrays
+    if (array->sparse) {
+        array->chunk_presence_dirty = true;
+        if (buffer_is_fill(array, chunk, chunksize / array->itemsize)) {
+            update_next_chunkshape(array, array->nchunks + 1);
+            return CATERVA_SUCCEED;
+        }
+        set_chunk_present(array, array->nchunks);
+    } else if (array->chunk_positions != NULL) {
+        set_chunk_present(array, array->nchunks);
+    }
 
     uint8_t *bchunk = (uint8_t *) chunk;
     int64_t typesize = array->itemsize;
@@ -455,44 +2692,42 @@ int caterva_blosc_array_append(caterva_ctx_t *ctx, caterva_array_t *array, void
     } else {
         CATERVA_ERROR (caterva_blosc_array_repart_chunk(rchunk, size_rep, bchunk, chunksize, array));
     }
-    if (blosc2_schunk_append_buffer(array->sc, rchunk, (size_t) size_rep) < 0) {
-        return CATERVA_ERR_BLOSC_FAILED;
-    }
-    ctx->cfg->free(rchunk);
-    // Calculate chunk position in each dimension
-    int64_t c_shape[CATERVA_MAX_DIM];
-    int64_t c_eshape[CATERVA_MAX_DIM];
-    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-        c_shape[(CATERVA_MAX_DIM - c_ndim + i) % CATERVA_MAX_DIM] = array->shape[i];
-        c_eshape[(CATERVA_MAX_DIM - c_ndim + i) % CATERVA_MAX_DIM] = array->extshape[i];
-        c_pshape[(CATERVA_MAX_DIM - c_ndim + i) % CATERVA_MAX_DIM] = array->chunkshape[i];
-    }
 
-    int64_t aux[CATERVA_MAX_DIM];
-    int64_t poschunk[CATERVA_MAX_DIM];
-    aux[7] = c_eshape[7] / c_pshape[7];
-    for (int i = CATERVA_MAX_DIM - 2; i >= 0; i--) {
-        aux[i] = c_eshape[i] / c_pshape[i] * aux[i + 1];
+    // Chunks of a slab are inserted in the position that they have in the grid of the new shape
+    int64_t nchunks = get_grid_nchunks(array);
+    bool slab = array->extendable && array->nchunks >= nchunks;
+    int64_t nchunk = get_chunk_index(array, array->nchunks);
+    if (slab) {
+        int64_t grid[CATERVA_MAX_DIM];
+        int64_t coords[CATERVA_MAX_DIM];
+        get_append_coords(array, array->nchunks, grid, coords);
+        nchunk = coords[0];
+        for (int i = 1; i < CATERVA_MAX_DIM; ++i) {
+            nchunk = nchunk * grid[i] + coords[i];
+        }
     }
-    poschunk[7] = (array->nchunks + 1) % aux[7];
-    for (int i = CATERVA_MAX_DIM - 2; i >= 0; i--) {
-        poschunk[i] = ((array->nchunks + 1) % aux[i]) / aux[i + 1];
+    CATERVA_ERROR(store_chunk(ctx, array, (uint8_t *) rchunk, size_rep, nchunk));
+    ctx->cfg->free(rchunk);
+    // Update the geometry when a slab along the extendable axis has been completed
+    if (slab && array->nchunks + 1 - nchunks == get_slab_nchunks(array)) {
+        int64_t shape[CATERVA_MAX_DIM];
+        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+            shape[i] = array->shape[i];
+        }
+        shape[array->extendable_axis] += array->chunkshape[array->extendable_axis];
+        update_geometry(array, array->ndim, shape, array->chunkshape, array->blockshape);
+        array->pending_slabs++;
+        if (array->pending_slabs >= CATERVA_SLABS_PER_META_UPDATE) {
+            CATERVA_ERROR(update_meta(array));
+            array->pending_slabs = 0;
+        }
+    } else if (slab) {
+        // The array is not completely filled until the slab is
+        array->filled = false;
     }
 
     // Update next_chunkshape, next_chunknitems
-    array->next_chunknitems = 1;
-    int64_t n_pshape[CATERVA_MAX_DIM];
-    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-        n_pshape[i] = c_pshape[i];
-        if ((poschunk[i] >= (c_eshape[i] / c_pshape[i]) - 1) && (c_eshape[i] > c_shape[i])) {
-            n_pshape[i] -= c_eshape[i] - c_shape[i];
-        }
-        array->next_chunknitems *= n_pshape[i];
-    }
-    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-        array->next_chunkshape[i] =
-            (int32_t) n_pshape[(CATERVA_MAX_DIM - c_ndim + i) % CATERVA_MAX_DIM];
-    }
+    update_next_chunkshape(array, array->nchunks + 1);
 
     return CATERVA_SUCCEED;
 }
@@ -554,6 +2789,7 @@ int caterva_blosc_array_from_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
             for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
                 ncopies *= actual_psize[i];
             }
+            bool fill = array->sparse;
             for (int ncopy = 0; ncopy < ncopies; ++ncopy) {
                 index_unidim_to_multidim(CATERVA_MAX_DIM - 1, actual_psize, ncopy, ii);
 
@@ -570,14 +2806,28 @@ int caterva_blosc_array_from_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
                     s_a *= d_shape[i];
                 }
                 memcpy(chunk + d_coord_f * typesize, bbuffer + s_coord_f * typesize, seq_copylen);
+                if (fill) {
+                    fill = buffer_is_fill(array, (uint8_t *) bbuffer + s_coord_f * typesize,
+                                          actual_psize[7]);
+                }
             }
-            // Copy each chunk from rchunk to dest
-            CATERVA_ERROR (caterva_blosc_array_repart_chunk(rchunk, (int32_t) array->extchunknitems * typesize,
-                                                 chunk, array->chunknitems * typesize, array));
-
-            if (blosc2_schunk_append_buffer(array->sc, rchunk,
-                                        (size_t) array->extchunknitems * typesize) < 0) {
-                return CATERVA_ERR_BLOSC_FAILED;
+            // The chunks filled with the fill value are not stored in sparse arrays
+            if (array->sparse) {
+                array->chunk_presence_dirty = true;
+                if (!fill) {
+                    set_chunk_present(array, array->nchunks);
+                }
+            } else if (array->chunk_positions != NULL) {
+                set_chunk_present(array, array->nchunks);
+            }
+            if (!fill) {
+                // Copy each chunk from rchunk to dest
+                CATERVA_ERROR(caterva_blosc_array_repart_chunk(
+                        rchunk, (int32_t) array->extchunknitems * typesize, chunk,
+                        array->chunknitems * typesize, array));
+                CATERVA_ERROR(store_chunk(ctx, array, (uint8_t *) rchunk,
+                                          (int32_t) array->extchunknitems * typesize,
+                                          get_chunk_index(array, array->nchunks)));
             }
             array->empty = false;
             array->nchunks++;
@@ -592,9 +2842,131 @@ int caterva_blosc_array_from_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
     return CATERVA_SUCCEED;
 }
 
-int caterva_blosc_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
-                                         int64_t *start, int64_t *stop, const int64_t *shape,
-                                         void *buffer) {
+int caterva_blosc_array_full(caterva_ctx_t *ctx, caterva_array_t *array, void *fill_value) {
+    uint8_t *value = fill_value;
+    ccache_clear(ctx, array);
+
+    // Sparse arrays do not store any chunk, the value becomes their fill value
+    if (array->sparse) {
+        if (value != NULL) {
+            memcpy(array->fill_value, value, array->itemsize);
+        } else {
+            memset(array->fill_value, 0, array->itemsize);
+        }
+        array->nchunks = get_grid_nchunks(array);
+        array->chunk_presence_dirty = true;
+        array->filled = true;
+        array->empty = false;
+        return CATERVA_SUCCEED;
+    }
+
+    bool zeros = true;
+    for (int i = 0; value != NULL && i < array->itemsize; ++i) {
+        if (value[i] != 0) {
+            zeros = false;
+            break;
+        }
+    }
+
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    int32_t nbytes = (int32_t) array->extchunknitems * array->itemsize;
+    int32_t special_size = BLOSC_EXTENDED_HEADER_LENGTH + array->itemsize;
+    uint8_t *special = ctx->cfg->alloc((size_t) special_size);
+    CATERVA_ERROR_NULL(special);
+    int csize;
+    if (zeros) {
+        csize = blosc2_chunk_zeros(*cparams, nbytes, special, special_size);
+    } else {
+        csize = blosc2_chunk_repeatval(*cparams, nbytes, special, special_size, value);
+    }
+    free(cparams);
+    if (csize < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+
+    // The padding of the chunks in the edges is kept as zeros, so they are compressed
+    // (only once for each different shape)
+    uint8_t *rchunk = NULL;
+    uint8_t *edge = NULL;
+    int64_t edge_shape[CATERVA_MAX_DIM] = {0};
+    if (!zeros) {
+        rchunk = ctx->cfg->alloc((size_t) nbytes);
+        CATERVA_ERROR_NULL(rchunk);
+        edge = ctx->cfg->alloc((size_t) nbytes + BLOSC_MAX_OVERHEAD);
+        CATERVA_ERROR_NULL(edge);
+    }
+
+    int64_t grid[CATERVA_MAX_DIM];
+    get_chunk_grid(array, array->shape, grid);
+    int64_t nchunks = get_grid_nchunks(array);
+    for (int64_t nchunk = 0; nchunk < nchunks; ++nchunk) {
+        uint8_t *chunk = special;
+        if (!zeros) {
+            int64_t coords[CATERVA_MAX_DIM];
+            index_unidim_to_multidim(CATERVA_MAX_DIM, grid, nchunk, coords);
+            int64_t valid_shape[CATERVA_MAX_DIM];
+            bool padded = false;
+            bool same = true;
+            for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                valid_shape[i] = array->shape[i] - coords[i] * array->chunkshape[i];
+                if (valid_shape[i] >= array->extchunkshape[i]) {
+                    valid_shape[i] = array->extchunkshape[i];
+                } else {
+                    padded = true;
+                }
+                if (valid_shape[i] != edge_shape[i]) {
+                    same = false;
+                }
+            }
+            if (padded && !same) {
+                for (int64_t i = 0; i < array->extchunknitems; ++i) {
+                    memcpy(&rchunk[i * array->itemsize], value, array->itemsize);
+                }
+                chunk_zero_outside(array, rchunk, valid_shape);
+                if (blosc2_compress_ctx(array->sc->cctx, rchunk, nbytes, edge,
+                                        nbytes + BLOSC_MAX_OVERHEAD) < 0) {
+                    CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+                }
+                for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                    edge_shape[i] = valid_shape[i];
+                }
+            }
+            if (padded) {
+                chunk = edge;
+            }
+        }
+        // The chunks are inserted along the chunk order
+        int64_t index = array->sc->nchunks;
+        if (array->chunk_positions != NULL) {
+            set_chunk_present(array, nchunk);
+            index = get_chunk_index(array, nchunk);
+        }
+        CATERVA_ERROR(sc_insert_chunk(ctx, array, index, chunk));
+    }
+    ctx->cfg->free(special);
+    if (!zeros) {
+        ctx->cfg->free(rchunk);
+        ctx->cfg->free(edge);
+    }
+
+    array->nchunks = nchunks;
+    array->filled = true;
+    array->empty = false;
+
+    return CATERVA_SUCCEED;
+}
+
+// Get a slice in a buffer, reading the chunks from a direct scan of the frame if it is not NULL
+static int get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *start,
+                            int64_t *stop, const int64_t *shape, void *buffer,
+                            direct_scan_t *scan) {
+    if (array->extendable && !array->filled) {
+        DEBUG_PRINT("Extendable arrays can not be read while a slab is being appended");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
     uint8_t *bbuffer = buffer;  // for allowing pointer arithmetic
     int64_t start__[CATERVA_MAX_DIM];
     int64_t stop__[CATERVA_MAX_DIM];
@@ -634,15 +3006,37 @@ int caterva_blosc_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *ar
     }
 
     // Acceleration path for the case where we are doing (1-dim) aligned chunk reads
-    if ((s_ndim == 1) && (array->chunkshape[0] == shape[0]) &&
+    if (scan == NULL && (s_ndim == 1) && (array->chunkshape[0] == shape[0]) &&
         (array->chunkshape[0] == array->blockshape[0]) && (start[0] % array->chunkshape[0] == 0) &&
         (stop[0] % array->chunkshape[0] == 0)) {
         int nchunk = (int) (start[0] / array->chunkshape[0]);
+        int slot = write_cache_lookup(array, nchunk);
+        if (slot >= 0) {
+            memcpy(bbuffer, array->write_cache[slot].data,
+                   (size_t) array->chunknitems * array->itemsize);
+            return CATERVA_SUCCEED;
+        }
+        if (!chunk_is_present(array, nchunk)) {
+            for (int64_t i = 0; i < array->chunknitems; ++i) {
+                memcpy(&bbuffer[i * array->itemsize], array->fill_value, array->itemsize);
+            }
+            return CATERVA_SUCCEED;
+        }
         // In case of an aligned read, decompress directly in destination
-        if (blosc2_schunk_decompress_chunk(array->sc, nchunk, bbuffer,
-                                           (size_t) array->chunknitems * array->sc->typesize) < 0) {
-            return CATERVA_ERR_BLOSC_FAILED;
+        int index = (int) get_chunk_index(array, nchunk);
+        int32_t nbytes = (int32_t) array->chunknitems * array->sc->typesize;
+        if (ccache_enabled(ctx, array)) {
+            uint8_t *cchunk;
+            int32_t cbytes;
+            bool needs_free;
+            CATERVA_ERROR(ccache_get(ctx, array, index, &cchunk, &cbytes, &needs_free));
+            int dsize = blosc2_decompress_ctx(array->sc->dctx, cchunk, cbytes, bbuffer, nbytes);
+            if (needs_free) {
+                free(cchunk);
+            }
+            return dsize < 0 ? CATERVA_ERR_BLOSC_FAILED : CATERVA_SUCCEED;
         }
+        CATERVA_ERROR(sc_decompress_chunk(array, index, bbuffer, nbytes));
         return CATERVA_SUCCEED;
     }
 
@@ -659,7 +3053,10 @@ int caterva_blosc_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *ar
     bool local_cache;
     if (array->chunk_cache.data == NULL) {
         chunk = (uint8_t *) ctx->cfg->alloc((size_t) array->extchunknitems * typesize);
-        CATERVA_ERROR_NULL(chunk);
+        if (chunk == NULL) {
+            ctx->cfg->free(block_maskout);
+            CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+        }
         local_cache = true;
     } else {
         chunk = array->chunk_cache.data;
@@ -681,22 +3078,52 @@ int caterva_blosc_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *ar
     for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
         nchunks *= i_shape[i];
     }
-    for (int chunk_ind = 0; chunk_ind < nchunks; ++chunk_ind) {
-        index_unidim_to_multidim(CATERVA_MAX_DIM, i_shape, chunk_ind, ii);
-        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-            ii[i] += i_start[i];
+
+    /* Read ahead the stored chunks of disk-backed arrays and of the arrays stored in an I/O
+     * backend (but the ones in the compressed cache). Only the chunks covered by the slice are
+     * read whole, the blocks needed from the others are read from their lazy chunks. */
+    bool use_ccache = scan == NULL && ccache_enabled(ctx, array);
+    chunk_reader_t reader = {0};
+    int64_t nread = 0;
+    int rc = CATERVA_SUCCEED;
+    if (scan == NULL && ctx->cfg->io_depth > 1 && nchunks > 1 && array->map == NULL &&
+        (array->sc->storage->urlpath != NULL || array->io != NULL)) {
+        int64_t *indexes = ctx->cfg->alloc(nchunks * sizeof(int64_t));
+        if (indexes == NULL) {
+            DEBUG_PRINT(print_error(CATERVA_ERR_NULL_POINTER));
+            rc = CATERVA_ERR_NULL_POINTER;
+        }
+        int64_t nreads = 0;
+        for (int chunk_ind = 0; chunk_ind < nchunks && indexes != NULL; ++chunk_ind) {
+            int64_t nchunk = get_slice_nchunk(chunk_ind, i_shape, i_start, s_eshape, s_pshape, ii);
+            int64_t index = get_chunk_index(array, nchunk);
+            if (write_cache_lookup(array, nchunk) < 0 && chunk_is_present(array, nchunk) &&
+                (!use_ccache || ccache_lookup(array, index) < 0) &&
+                (array->io == NULL || sc_chunk_in_io(array, index)) &&
+                slice_covers_chunk(array, ii, start_, stop_, s_pshape)) {
+                indexes[nreads++] = index;
+            }
+        }
+        if (nreads > 1) {
+            rc = chunk_reader_start(ctx, array, indexes, nreads, &reader);
+        } else if (indexes != NULL) {
+            ctx->cfg->free(indexes);
+        }
+    }
+    if (rc != CATERVA_SUCCEED) {
+        ctx->cfg->free(block_maskout);
+        if (local_cache) {
+            ctx->cfg->free(chunk);
         }
+        return rc;
+    }
 
+    for (int chunk_ind = 0; chunk_ind < nchunks; ++chunk_ind) {
         /* Get the chunk ii */
         memset(block_maskout, true, nblocks);
-        int nchunk = 0;
-        int inc = 1;
-        for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
-            nchunk += (int) (ii[i] * inc);
-            inc *= (int) (s_eshape[i] / s_pshape[i]);
-        }
+        int64_t nchunk = get_slice_nchunk(chunk_ind, i_shape, i_start, s_eshape, s_pshape, ii);
         if (array->chunk_cache.data != NULL) {
-            array->chunk_cache.nchunk = nchunk;
+            array->chunk_cache.nchunk = (int32_t) nchunk;
         }
         /* Calculate the used blocks */
         for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
@@ -730,106 +3157,696 @@ int caterva_blosc_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *ar
                 nblock += (int) (jj[i] * sinc);
                 sinc *= (int) (s_epshape[i] / s_spshape[i]);
             }
-            block_maskout[nblock] = false;
+            block_maskout[get_block_position(array, nblock)] = false;
+        }
+
+        // The chunks modified in the write-back cache are read from there
+        uint8_t *data = chunk;
+        int slot = write_cache_lookup(array, nchunk);
+        if (slot >= 0) {
+            data = array->write_cache[slot].data;
+        } else {
+            // Special chunks (and the ones not stored in sparse arrays) are not decompressed,
+            // their value is filled in the destination
+            int special = 0;
+            uint8_t value[UINT8_MAX];
+            int64_t index = get_chunk_index(array, nchunk);
+            uint8_t *cchunk = NULL;
+            int32_t cbytes = 0;
+            bool from_reader = false;
+            bool needs_free = false;
+            if (!chunk_is_present(array, nchunk)) {
+                special = BLOSC2_SPECIAL_VALUE;
+                memcpy(value, array->fill_value, array->itemsize);
+            } else if (nread < reader.nreads && reader.indexes[nread] == index) {
+                rc = chunk_reader_get(&reader, nread, &cchunk, &cbytes);
+                if (rc != CATERVA_SUCCEED) {
+                    break;
+                }
+                from_reader = true;
+                if (use_ccache) {
+                    rc = ccache_put(ctx, array, index, cchunk, cbytes);
+                    if (rc != CATERVA_SUCCEED) {
+                        chunk_reader_release(&reader, nread++);
+                        break;
+                    }
+                    array->ccache_stats.nmisses++;
+                }
+                get_special(array, cchunk, &special, value);
+            } else if (scan != NULL) {
+                rc = direct_scan_get(ctx, array, scan, index, &special, value, &cchunk, &cbytes,
+                                     &needs_free);
+                if (rc != CATERVA_SUCCEED) {
+                    break;
+                }
+            } else if (use_ccache) {
+                rc = ccache_get(ctx, array, index, &cchunk, &cbytes, &needs_free);
+                if (rc != CATERVA_SUCCEED) {
+                    break;
+                }
+                get_special(array, cchunk, &special, value);
+            } else {
+                // The lazy chunk is decompressed as it is (so it is fetched only once)
+                rc = get_chunk_special(array, index, &special, value, &cchunk, &cbytes,
+                                       &needs_free);
+                if (rc != CATERVA_SUCCEED) {
+                    break;
+                }
+            }
+            if (special != 0) {
+                if (from_reader) {
+                    chunk_reader_release(&reader, nread++);
+                }
+                if (needs_free) {
+                    free(cchunk);
+                }
+                int64_t fill_start[CATERVA_MAX_DIM];
+                int64_t fill_stop[CATERVA_MAX_DIM];
+                for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                    int64_t offset = ii[i] * s_pshape[i];
+                    fill_start[i] = (start_[i] > offset ? start_[i] : offset) - start_[i];
+                    fill_stop[i] = (stop_[i] < offset + s_pshape[i] ? stop_[i]
+                                                                    : offset + s_pshape[i]) -
+                                   start_[i];
+                }
+                fill_buffer(bbuffer, d_pshape_, fill_start, fill_stop, value, array->itemsize);
+                continue;
+            }
+            blosc2_set_maskout(array->sc->dctx, block_maskout, nblocks);
+            int32_t nbytes = (int32_t) array->extchunknitems * typesize;
+            int dsize = blosc2_decompress_ctx(array->sc->dctx, cchunk, cbytes, chunk, nbytes);
+            if (from_reader) {
+                chunk_reader_release(&reader, nread++);
+            }
+            if (needs_free) {
+                free(cchunk);
+            }
+            if (dsize < 0) {
+                DEBUG_PRINT("Error decompressing a chunk");
+                rc = CATERVA_ERR_BLOSC_FAILED;
+                break;
+            }
+        }
+
+        num_blocks = 1;
+        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+            num_blocks *= j_shape[i];
+        }
+        for (int block_ind = 0; block_ind < num_blocks; ++block_ind) {
+            index_unidim_to_multidim(CATERVA_MAX_DIM, j_shape, block_ind, jj);
+            for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                jj[i] += j_start[i];
+            }
+            /* Decompress block jj */
+            int s_start = 0;
+            int sinc = 1;
+            int nblock = 0;
+            for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
+                nblock += (int) (jj[i] * sinc);
+                sinc *= (int) (s_epshape[i] / s_spshape[i]);
+            }
+
+            s_start = (int) get_block_position(array, nblock) * array->blocknitems;
+            /* memcpy */
+            for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                if (jj[i] == j_start[i] && ii[i] == i_start[i]) {
+                    sp_start[i] = (start_[i] % s_pshape[i]) % s_spshape[i];
+                } else {
+                    sp_start[i] = 0;
+                }
+                if (jj[i] == j_stop[i] && ii[i] == i_stop[i]) {
+                    sp_stop[i] = (((stop_[i] - 1) % s_pshape[i]) % s_spshape[i]) + 1;
+                } else {
+                    sp_stop[i] = s_spshape[i];
+                }
+                if ((jj[i] + 1) * s_spshape[i] > s_pshape[i]) {  // case padding
+                    int64_t lastn = s_pshape[i] % s_spshape[i];
+                    if (lastn < sp_stop[i]) {
+                        sp_stop[i] = lastn;
+                    }
+                }
+                sp_shape[i] = sp_stop[i] - sp_start[i];
+            }
+            int64_t kk[CATERVA_MAX_DIM];
+            kk[CATERVA_MAX_DIM - 1] = sp_start[CATERVA_MAX_DIM - 1];
+            int64_t ncopies = 1;
+            for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
+                ncopies *= sp_shape[i];
+            }
+            for (int ncopy = 0; ncopy < ncopies; ++ncopy) {
+                index_unidim_to_multidim(CATERVA_MAX_DIM - 1, sp_shape, ncopy, kk);
+                for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
+                    kk[i] += sp_start[i];
+                }
+
+                // Copy each line of data from block to bdest
+                int64_t sp_pointer = 0;
+                int64_t sp_pointer_inc = 1;
+                for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
+                    sp_pointer += kk[i] * sp_pointer_inc;
+                    sp_pointer_inc *= s_spshape[i];
+                }
+                int64_t buf_pointer = 0;
+                int64_t buf_pointer_inc = 1;
+                for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
+                    buf_pointer +=
+                        (kk[i] + s_spshape[i] * jj[i] + s_pshape[i] * ii[i] - start_[i]) *
+                        buf_pointer_inc;
+                    buf_pointer_inc *= d_pshape_[i];
+                }
+
+                memcpy(&bbuffer[buf_pointer * typesize], &data[(s_start + sp_pointer) * typesize],
+                       (size_t)(sp_stop[7] - sp_start[7]) * typesize);
+            }
+        }
+    }
+
+    chunk_reader_stop(ctx, &reader);
+    ctx->cfg->free(block_maskout);
+    if (local_cache) {
+        ctx->cfg->free(chunk);
+    }
+    return rc;
+}
+
+int caterva_blosc_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
+                                         int64_t *start, int64_t *stop, const int64_t *shape,
+                                         void *buffer) {
+    CATERVA_ERROR(get_slice_buffer(ctx, array, start, stop, shape, buffer, NULL));
+
+    return CATERVA_SUCCEED;
+}
+
+// Check whether an array can be scanned reading its frame with direct I/O (it must be a
+// sequential frame on disk whose chunks are all stored in it)
+static bool direct_scan_enabled(caterva_array_t *array) {
+    if (array->advice != CATERVA_ADVICE_DIRECT || array->map != NULL ||
+        array->sc->storage->urlpath == NULL || !array->sc->storage->contiguous) {
+        return false;
+    }
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        if (array->write_cache[i].dirty) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int caterva_blosc_array_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer) {
+    int8_t *bbuffer = (int8_t *) buffer;
+    int8_t ndim = array->ndim;
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    for (int i = 0; i < ndim; i++) {
+        start[i] = 0;
+        stop[i] = array->shape[i];
+    }
+
+    if (!direct_scan_enabled(array)) {
+        CATERVA_ERROR(caterva_blosc_array_get_slice_buffer(ctx, array, start, stop, array->shape,
+                                                           bbuffer));
+        return CATERVA_SUCCEED;
+    }
+
+    // The chunks are streamed from the frame bypassing the page cache, so only the extents of
+    // the frame being decompressed are kept in memory
+    direct_scan_t scan;
+    CATERVA_ERROR(direct_scan_start(ctx, array, &scan));
+    int rc = get_slice_buffer(ctx, array, start, stop, array->shape, bbuffer, &scan);
+    direct_scan_stop(ctx, &scan);
+    CATERVA_ERROR(rc);
+    array->ndirect_scans++;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_set_slice_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersize,
+                                         int64_t *start, int64_t *stop, caterva_array_t *array) {
+    CATERVA_UNUSED_PARAM(buffersize);
+    uint8_t *bbuffer = buffer;  // for allowing pointer arithmetic
+
+    if (!array->filled) {
+        DEBUG_PRINT("Slices can only be set in completely filled arrays");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    int8_t ndim = array->ndim;
+    int64_t start_[CATERVA_MAX_DIM];
+    int64_t stop_[CATERVA_MAX_DIM];
+    int64_t shape_[CATERVA_MAX_DIM];
+    int64_t grid_[CATERVA_MAX_DIM];
+    int64_t chunkshape_[CATERVA_MAX_DIM];
+    int64_t blockshape_[CATERVA_MAX_DIM];
+    int64_t blocksgrid_[CATERVA_MAX_DIM];
+    int64_t grid[CATERVA_MAX_DIM];
+    get_chunk_grid(array, array->shape, grid);
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        int j = (CATERVA_MAX_DIM - ndim + i) % CATERVA_MAX_DIM;
+        start_[j] = (i < ndim) ? start[i] : 0;
+        stop_[j] = (i < ndim) ? stop[i] : 1;
+        shape_[j] = stop_[j] - start_[j];
+        grid_[j] = grid[i];
+        chunkshape_[j] = array->chunkshape[i];
+        blockshape_[j] = array->blockshape[i];
+        blocksgrid_[j] = array->extchunkshape[i] / array->blockshape[i];
+    }
+
+    // Chunks touched by the slice
+    int64_t i_start[CATERVA_MAX_DIM];
+    int64_t i_shape[CATERVA_MAX_DIM];
+    int64_t nchunks = 1;
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        i_start[i] = start_[i] / chunkshape_[i];
+        i_shape[i] = (stop_[i] - 1) / chunkshape_[i] - i_start[i] + 1;
+        nchunks *= i_shape[i];
+    }
+
+    for (int64_t chunk_ind = 0; chunk_ind < nchunks; ++chunk_ind) {
+        int64_t ii[CATERVA_MAX_DIM];
+        index_unidim_to_multidim(CATERVA_MAX_DIM, i_shape, chunk_ind, ii);
+        int64_t nchunk = 0;
+        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+            ii[i] += i_start[i];
+            nchunk = nchunk * grid_[i] + ii[i];
+        }
+        struct chunk_cache_s *cache;
+        CATERVA_ERROR(write_cache_get(ctx, array, nchunk, &cache));
+
+        // Part of the slice that lies in this chunk (in chunk coordinates)
+        int64_t lo[CATERVA_MAX_DIM];
+        int64_t hi[CATERVA_MAX_DIM];
+        int64_t rows_shape[CATERVA_MAX_DIM];
+        int64_t nrows = 1;
+        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+            int64_t offset = ii[i] * chunkshape_[i];
+            lo[i] = (start_[i] > offset ? start_[i] : offset) - offset;
+            hi[i] = (stop_[i] < offset + chunkshape_[i] ? stop_[i] : offset + chunkshape_[i]) -
+                    offset;
+            rows_shape[i] = hi[i] - lo[i];
+            if (i < CATERVA_MAX_DIM - 1) {
+                nrows *= rows_shape[i];
+            }
+        }
+
+        // Copy each row of the slice, split by the blocks that it crosses
+        for (int64_t row = 0; row < nrows; ++row) {
+            int64_t kk[CATERVA_MAX_DIM];
+            index_unidim_to_multidim(CATERVA_MAX_DIM - 1, rows_shape, row, kk);
+            for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
+                kk[i] += lo[i];
+            }
+            kk[CATERVA_MAX_DIM - 1] = lo[CATERVA_MAX_DIM - 1];
+            while (kk[CATERVA_MAX_DIM - 1] < hi[CATERVA_MAX_DIM - 1]) {
+                int64_t bs = blockshape_[CATERVA_MAX_DIM - 1];
+                int64_t end = (kk[CATERVA_MAX_DIM - 1] / bs + 1) * bs;
+                if (end > hi[CATERVA_MAX_DIM - 1]) {
+                    end = hi[CATERVA_MAX_DIM - 1];
+                }
+                int64_t nblock = 0;
+                int64_t block_pointer = 0;
+                int64_t buf_pointer = 0;
+                for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                    nblock = nblock * blocksgrid_[i] + kk[i] / blockshape_[i];
+                    block_pointer = block_pointer * blockshape_[i] + kk[i] % blockshape_[i];
+                    buf_pointer = buf_pointer * shape_[i] +
+                                  ii[i] * chunkshape_[i] + kk[i] - start_[i];
+                }
+                memcpy(&cache->data[(get_block_position(array, nblock) * array->blocknitems +
+                                     block_pointer) * array->itemsize],
+                       &bbuffer[buf_pointer * array->itemsize],
+                       (size_t) (end - kk[CATERVA_MAX_DIM - 1]) * array->itemsize);
+                kk[CATERVA_MAX_DIM - 1] = end;
+            }
+        }
+        cache->dirty = true;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Append the chunks held by the super-chunk of an array stored in an I/O backend to its stream
+// (but the special ones, which are only a header and a value), replacing them by header-only
+// chunks, and then the tail if it has changed
+static int io_flush(caterva_ctx_t *ctx, caterva_array_t *array) {
+    blosc2_schunk *sc = array->sc;
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(sc, &cparams) < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    int rc = CATERVA_SUCCEED;
+    for (int64_t index = 0; index < sc->nchunks && rc == CATERVA_SUCCEED; ++index) {
+        if (array->io_offsets[index] >= 0) {
+            continue;
+        }
+        uint8_t *cchunk;
+        bool needs_free;
+        int32_t cbytes = blosc2_schunk_get_chunk(sc, (int) index, &cchunk, &needs_free);
+        int32_t nbytes;
+        int32_t csize;
+        int32_t blocksize;
+        if (cbytes < 0 || blosc2_cbuffer_sizes(cchunk, &nbytes, &csize, &blocksize) < 0) {
+            rc = CATERVA_ERR_BLOSC_FAILED;
+            break;
+        }
+        bool special = ((cchunk[BLOSC2_CHUNK_BLOSC2_FLAGS] >> 4) & BLOSC2_SPECIAL_MASK) != 0;
+        if (!special) {
+            rc = caterva_io_write(array->io, array->io_stream, cchunk, cbytes, array->io_end);
+        }
+        if (needs_free) {
+            free(cchunk);
+        }
+        if (special || rc != CATERVA_SUCCEED) {
+            continue;
+        }
+        uint8_t header[BLOSC_EXTENDED_HEADER_LENGTH];
+        if (blosc2_chunk_uninit(*cparams, (size_t) nbytes, header, sizeof(header)) < 0 ||
+            blosc2_schunk_update_chunk(sc, (int) index, header, true) < 0) {
+            rc = CATERVA_ERR_BLOSC_FAILED;
+            break;
+        }
+        array->io_offsets[index] = array->io_end;
+        array->io_cbytes[index] = cbytes;
+        array->io_end += cbytes;
+    }
+    free(cparams);
+    CATERVA_ERROR(rc);
+
+    uint8_t *frame;
+    bool needs_free;
+    int64_t frame_len = blosc2_schunk_to_buffer(sc, &frame, &needs_free);
+    if (frame_len < 0) {
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    uint8_t *tail;
+    int64_t tail_len;
+    rc = caterva_io_encode_tail(ctx, frame, frame_len, array->io_offsets, array->io_cbytes,
+                                sc->nchunks, &tail, &tail_len);
+    if (needs_free) {
+        free(frame);
+    }
+    CATERVA_ERROR(rc);
+    if (array->io_tail != NULL && array->io_tail_len == tail_len &&
+        memcmp(array->io_tail, tail, (size_t) tail_len) == 0) {
+        ctx->cfg->free(tail);
+        return CATERVA_SUCCEED;
+    }
+    rc = caterva_io_write_tail(array->io, array->io_stream, tail, tail_len, array->io_end);
+    if (rc != CATERVA_SUCCEED) {
+        ctx->cfg->free(tail);
+        CATERVA_ERROR(rc);
+    }
+    array->io_end += tail_len;
+    if (array->io_tail != NULL) {
+        ctx->cfg->free(array->io_tail);
+    }
+    array->io_tail = tail;
+    array->io_tail_len = tail_len;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_flush(caterva_ctx_t *ctx, caterva_array_t *array) {
+    // Read-only arrays have no pending changes
+    if (array->readonly) {
+        return CATERVA_SUCCEED;
+    }
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        if (array->write_cache[i].dirty) {
+            CATERVA_ERROR(write_cache_store(ctx, array, &array->write_cache[i]));
+        }
+    }
+    if (array->pending_slabs > 0) {
+        CATERVA_ERROR(update_meta(array));
+        array->pending_slabs = 0;
+    }
+    if (array->sparse && array->chunk_presence_dirty) {
+        CATERVA_ERROR(update_sparse_meta(array));
+    }
+    if (array->io != NULL) {
+        CATERVA_ERROR(io_flush(ctx, array));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Remove the frame of an array. Sparse frames are directories holding a file per chunk and the
+// index, so their files are removed before the directory itself.
+void caterva_blosc_remove_urlpath(caterva_ctx_t *ctx, const char *urlpath) {
+    struct stat st;
+    if (stat(urlpath, &st) != 0) {
+        return;
+    }
+    if ((st.st_mode & S_IFMT) != S_IFDIR) {
+        remove(urlpath);
+        return;
+    }
+    size_t len = strlen(urlpath) + 260;
+    char *path = ctx->cfg->alloc(len);
+    if (path == NULL) {
+        return;
+    }
+#if defined(_WIN32)
+    snprintf(path, len, "%s/*", urlpath);
+    struct _finddata_t entry;
+    intptr_t handle = _findfirst(path, &entry);
+    if (handle != -1) {
+        do {
+            if (strcmp(entry.name, ".") != 0 && strcmp(entry.name, "..") != 0) {
+                snprintf(path, len, "%s/%s", urlpath, entry.name);
+                remove(path);
+            }
+        } while (_findnext(handle, &entry) == 0);
+        _findclose(handle);
+    }
+    _rmdir(urlpath);
+#else
+    DIR *dir = opendir(urlpath);
+    if (dir != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                snprintf(path, len, "%s/%s", urlpath, entry->d_name);
+                remove(path);
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(urlpath);
+#endif
+    ctx->cfg->free(path);
+}
+
+// Append a compressed chunk (of a row-major array that is neither sparse nor extendable)
+int caterva_blosc_array_append_cchunk(caterva_ctx_t *ctx, caterva_array_t *array,
+                                      uint8_t *cchunk) {
+    int32_t nbytes, cbytes, blocksize;
+    if (blosc2_cbuffer_sizes(cchunk, &nbytes, &cbytes, &blocksize) < 0 ||
+        nbytes != array->extchunknitems * array->itemsize) {
+        DEBUG_PRINT("The chunk does not have the size of the chunks of the array");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    CATERVA_ERROR(sc_insert_chunk(ctx, array, array->sc->nchunks, cchunk));
+    update_next_chunkshape(array, array->nchunks + 1);
+
+    return CATERVA_SUCCEED;
+}
+
+// Get a chunk of the grid as stored in the super-chunk (it must be released with free() if
+// needs_free is true). The special buffer (of BLOSC_EXTENDED_HEADER_LENGTH + itemsize bytes)
+// holds the chunks not stored in sparse arrays.
+int caterva_blosc_array_get_cchunk(caterva_array_t *array, int64_t nchunk, uint8_t *special,
+                                   uint8_t **cchunk, int32_t *cbytes, bool *needs_free) {
+    // The chunks not stored in sparse arrays are represented by a chunk repeating the fill value
+    if (!chunk_is_present(array, nchunk)) {
+        blosc2_cparams *cparams;
+        if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        *cbytes = blosc2_chunk_repeatval(*cparams,
+                                         (size_t) array->extchunknitems * array->itemsize,
+                                         special, BLOSC_EXTENDED_HEADER_LENGTH + array->itemsize,
+                                         array->fill_value);
+        free(cparams);
+        if (*cbytes < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        *cchunk = special;
+        *needs_free = false;
+        return CATERVA_SUCCEED;
+    }
+
+    CATERVA_ERROR(sc_get_chunk(array, get_chunk_index(array, nchunk), cchunk, cbytes,
+                               needs_free));
+
+    return CATERVA_SUCCEED;
+}
+
+// Copy the layers of metadata of a super-chunk into another one (the fixed-length ones have to
+// be added before any chunk)
+static int copy_metalayers(blosc2_schunk *src, blosc2_schunk *dest, bool vlmeta) {
+    int16_t nmetalayers = vlmeta ? src->nvlmetalayers : src->nmetalayers;
+    for (int i = 0; i < nmetalayers; ++i) {
+        char *name = vlmeta ? src->vlmetalayers[i]->name : src->metalayers[i]->name;
+        uint8_t *content;
+        uint32_t content_len;
+        int rc;
+        if (vlmeta) {
+            rc = blosc2_vlmeta_get(src, name, &content, &content_len);
+        } else {
+            rc = blosc2_meta_get(src, name, &content, &content_len);
+        }
+        if (rc < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        if (vlmeta) {
+            rc = blosc2_vlmeta_add(dest, name, content, content_len, NULL);
+        } else {
+            rc = blosc2_meta_add(dest, name, content, content_len);
+        }
+        free(content);
+        if (rc < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
         }
+    }
 
-        blosc2_set_maskout(array->sc->dctx, block_maskout, nblocks);
-        if (blosc2_schunk_decompress_chunk(array->sc, nchunk, chunk,
-                                       (size_t) array->extchunknitems * typesize) < 0) {
-            return CATERVA_ERR_BLOSC_FAILED;
-        }
+    return CATERVA_SUCCEED;
+}
 
-        num_blocks = 1;
-        for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-            num_blocks *= j_shape[i];
+// Append the chunks of a super-chunk to another one, one by one, recompressing the ones that
+// are not special if requested
+static int copy_chunks(caterva_ctx_t *ctx, caterva_array_t *array, blosc2_schunk *dest,
+                       bool recompress) {
+    blosc2_schunk *sc = array->sc;
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+    uint8_t *buffer = NULL;
+    if (recompress) {
+        buffer = ctx->cfg->alloc((size_t) nbytes);
+        CATERVA_ERROR_NULL(buffer);
+    }
+    uint8_t value[UINT8_MAX];
+
+    int rc = CATERVA_SUCCEED;
+    for (int nchunk = 0; nchunk < sc->nchunks && rc == CATERVA_SUCCEED; ++nchunk) {
+        uint8_t *chunk;
+        int32_t cbytes;
+        bool needs_free;
+        rc = sc_get_chunk(array, nchunk, &chunk, &cbytes, &needs_free);
+        if (rc != CATERVA_SUCCEED) {
+            break;
         }
-        for (int block_ind = 0; block_ind < num_blocks; ++block_ind) {
-            index_unidim_to_multidim(CATERVA_MAX_DIM, j_shape, block_ind, jj);
-            for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-                jj[i] += j_start[i];
-            }
-            /* Decompress block jj */
-            int s_start = 0;
-            int sinc = 1;
-            int nblock = 0;
-            for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
-                nblock += (int) (jj[i] * sinc);
-                sinc *= (int) (s_epshape[i] / s_spshape[i]);
+        int special;
+        get_special(array, chunk, &special, value);
+        if (recompress && special == 0) {
+            if (blosc2_decompress_ctx(sc->dctx, chunk, cbytes, buffer, nbytes) < 0 ||
+                blosc2_schunk_append_buffer(dest, buffer, nbytes) < 0) {
+                rc = CATERVA_ERR_BLOSC_FAILED;
             }
+        } else if (blosc2_schunk_append_chunk(dest, chunk, true) < 0) {
+            rc = CATERVA_ERR_BLOSC_FAILED;
+        }
+        if (needs_free) {
+            free(chunk);
+        }
+    }
+    if (buffer != NULL) {
+        ctx->cfg->free(buffer);
+    }
+    CATERVA_ERROR(rc);
 
-            s_start = nblock * array->blocknitems;
-            /* memcpy */
-            for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-                if (jj[i] == j_start[i] && ii[i] == i_start[i]) {
-                    sp_start[i] = (start_[i] % s_pshape[i]) % s_spshape[i];
-                } else {
-                    sp_start[i] = 0;
-                }
-                if (jj[i] == j_stop[i] && ii[i] == i_stop[i]) {
-                    sp_stop[i] = (((stop_[i] - 1) % s_pshape[i]) % s_spshape[i]) + 1;
-                } else {
-                    sp_stop[i] = s_spshape[i];
-                }
-                if ((jj[i] + 1) * s_spshape[i] > s_pshape[i]) {  // case padding
-                    int64_t lastn = s_pshape[i] % s_spshape[i];
-                    if (lastn < sp_stop[i]) {
-                        sp_stop[i] = lastn;
-                    }
-                }
-                sp_shape[i] = sp_stop[i] - sp_start[i];
-            }
-            int64_t kk[CATERVA_MAX_DIM];
-            kk[CATERVA_MAX_DIM - 1] = sp_start[CATERVA_MAX_DIM - 1];
-            int64_t ncopies = 1;
-            for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
-                ncopies *= sp_shape[i];
-            }
-            for (int ncopy = 0; ncopy < ncopies; ++ncopy) {
-                index_unidim_to_multidim(CATERVA_MAX_DIM - 1, sp_shape, ncopy, kk);
-                for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
-                    kk[i] += sp_start[i];
-                }
+    return CATERVA_SUCCEED;
+}
 
-                // Copy each line of data from block to bdest
-                int64_t sp_pointer = 0;
-                int64_t sp_pointer_inc = 1;
-                for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
-                    sp_pointer += kk[i] * sp_pointer_inc;
-                    sp_pointer_inc *= s_spshape[i];
-                }
-                int64_t buf_pointer = 0;
-                int64_t buf_pointer_inc = 1;
-                for (int i = CATERVA_MAX_DIM - 1; i >= 0; --i) {
-                    buf_pointer +=
-                        (kk[i] + s_spshape[i] * jj[i] + s_pshape[i] * ii[i] - start_[i]) *
-                        buf_pointer_inc;
-                    buf_pointer_inc *= d_pshape_[i];
-                }
+int caterva_blosc_array_compact(caterva_ctx_t *ctx, caterva_array_t *array, bool recompress) {
+    // The frame is rewritten with the local file API, so it can not be stored by a backend
+    if (array->io != NULL) {
+        DEBUG_PRINT("The arrays stored through an I/O backend can not be compacted");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+    blosc2_schunk *sc = array->sc;
+    if (sc->storage->urlpath == NULL || !sc->storage->contiguous) {
+        DEBUG_PRINT("Only the arrays stored in a sequential frame on disk can be compacted");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+    CATERVA_ERROR(caterva_blosc_array_flush(ctx, array));
+    ccache_clear(ctx, array);
+
+    // The frame is rewritten next to the current one and renamed over it at the end, so the
+    // arrays mapping the current frame keep reading it
+    char *urlpath = sc->storage->urlpath;
+    size_t urlpath_len = strlen(urlpath) + sizeof(CATERVA_COMPACT_SUFFIX);
+    char *compact_urlpath = ctx->cfg->alloc(urlpath_len);
+    CATERVA_ERROR_NULL(compact_urlpath);
+    snprintf(compact_urlpath, urlpath_len, "%s%s", urlpath, CATERVA_COMPACT_SUFFIX);
+    remove(compact_urlpath);
 
-                memcpy(&bbuffer[buf_pointer * typesize], &chunk[(s_start + sp_pointer) * typesize],
-                       (size_t)(sp_stop[7] - sp_start[7]) * typesize);
-            }
+    blosc2_cparams *cparams;
+    if (blosc2_schunk_get_cparams(sc, &cparams) < 0) {
+        ctx->cfg->free(compact_urlpath);
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+    }
+    cparams->schunk = NULL;
+    if (recompress) {
+        cparams->prefilter = ctx->cfg->prefilter;
+        cparams->pparams = ctx->cfg->pparams;
+        cparams->use_dict = ctx->cfg->usedict;
+        cparams->nthreads = (int16_t) ctx->cfg->nthreads;
+        cparams->clevel = (uint8_t) ctx->cfg->complevel;
+        cparams->compcode = (uint8_t) ctx->cfg->compcodec;
+        for (int i = 0; i < BLOSC2_MAX_FILTERS; ++i) {
+            cparams->filters[i] = ctx->cfg->filters[i];
+            cparams->filters_meta[i] = ctx->cfg->filtersmeta[i];
         }
     }
+    blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+    dparams.nthreads = ctx->cfg->nthreads;
 
-    ctx->cfg->free(block_maskout);
-    if (local_cache) {
-        ctx->cfg->free(chunk);
+    blosc2_storage b_storage = BLOSC2_STORAGE_DEFAULTS;
+    b_storage.cparams = cparams;
+    b_storage.dparams = &dparams;
+    b_storage.contiguous = true;
+    b_storage.urlpath = compact_urlpath;
+    blosc2_schunk *compact_sc = blosc2_schunk_new(&b_storage);
+    free(cparams);
+    if (compact_sc == NULL) {
+        ctx->cfg->free(compact_urlpath);
+        CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
     }
-    return CATERVA_SUCCEED;
-}
 
-int caterva_blosc_array_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer) {
-    int8_t *bbuffer = (int8_t *) buffer;
-    int8_t ndim = array->ndim;
-    int64_t start[CATERVA_MAX_DIM];
-    int64_t stop[CATERVA_MAX_DIM];
-    for (int i = 0; i < ndim; i++) {
-        start[i] = 0;
-        stop[i] = array->shape[i];
+    // The chunks are written in the order of their indexes, that follows the chunk order
+    int rc = copy_metalayers(sc, compact_sc, false);
+    if (rc == CATERVA_SUCCEED) {
+        rc = copy_chunks(ctx, array, compact_sc, recompress);
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = copy_metalayers(sc, compact_sc, true);
+    }
+    blosc2_schunk_free(compact_sc);
+    if (rc != CATERVA_SUCCEED) {
+        remove(compact_urlpath);
+        ctx->cfg->free(compact_urlpath);
+        CATERVA_ERROR(rc);
     }
 
-    CATERVA_ERROR(caterva_blosc_array_get_slice_buffer(ctx, array, start, stop, array->shape, bbuffer));
+#if defined(_WIN32)
+    // rename() does not replace existing files on Windows
+    rc = MoveFileExA(compact_urlpath, urlpath, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    rc = rename(compact_urlpath, urlpath);
+#endif
+    ctx->cfg->free(compact_urlpath);
+    if (rc != 0) {
+        DEBUG_PRINT("The compacted frame can not be renamed");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
+    char *array_urlpath = ctx->cfg->alloc(strlen(urlpath) + 1);
+    CATERVA_ERROR_NULL(array_urlpath);
+    strcpy(array_urlpath, urlpath);
+    blosc2_schunk_free(sc);
+    array->sc = blosc2_schunk_open(array_urlpath);
+    ctx->cfg->free(array_urlpath);
+    CATERVA_ERROR_NULL(array->sc);
+
     return CATERVA_SUCCEED;
 }
 
@@ -923,68 +3940,16 @@ int caterva_blosc_array_get_slice(caterva_ctx_t *ctx, caterva_array_t *src, int6
     return CATERVA_SUCCEED;
 }
 
+void caterva_blosc_update_geometry(caterva_array_t *array, int8_t ndim, int64_t *shape,
+                                   int32_t *chunkshape, int32_t *blockshape) {
+    update_geometry(array, ndim, shape, chunkshape, blockshape);
+}
+
 int caterva_blosc_update_shape(caterva_array_t *array, int8_t ndim, int64_t *shape,
                                int32_t *chunkshape, int32_t *blockshape) {
-    array->ndim = ndim;
-    array->nitems = 1;
-    array->extnitems = 1;
-    array->extchunknitems = 1;
-    array->chunknitems = 1;
-    array->blocknitems = 1;
-    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
-        if (i < ndim) {
-            array->shape[i] = shape[i];
-            array->chunkshape[i] = chunkshape[i];
-            array->blockshape[i] = blockshape[i];
-            if (shape[i] != 0) {
-                if (shape[i] % array->chunkshape[i] == 0) {
-                    array->extshape[i] = shape[i];
-                } else {
-                    array->extshape[i] = shape[i] + chunkshape[i] - shape[i] % chunkshape[i];
-                }
-                if (chunkshape[i] % blockshape[i] == 0) {
-                    array->extchunkshape[i] = chunkshape[i];
-                } else {
-                    array->extchunkshape[i] =
-                            chunkshape[i] + blockshape[i] - chunkshape[i] % blockshape[i];
-                }
-            } else {
-                array->extchunkshape[i] = 0;
-                array->extshape[i] = 0;
-            }
-        } else {
-            array->blockshape[i] = 1;
-            array->chunkshape[i] = 1;
-            array->extshape[i] = 1;
-            array->extchunkshape[i] = 1;
-            array->shape[i] = 1;
-        }
-        array->nitems *= array->shape[i];
-        array->extnitems *= array->extshape[i];
-        array->extchunknitems *= array->extchunkshape[i];
-        array->chunknitems *= array->chunkshape[i];
-        array->blocknitems *= array->blockshape[i];
-    }
-
-    uint8_t *smeta = NULL;
-    // Serialize the dimension info ...
-    int32_t smeta_len =
-        serialize_meta(array->ndim, array->shape, array->chunkshape, array->blockshape, &smeta);
-    if (smeta_len < 0) {
-        fprintf(stderr, "error during serializing dims info for Caterva");
-        return -1;
-    }
-    // ... and update it in its metalayer
-    if (blosc2_meta_exists(array->sc, "caterva") < 0) {
-        if (blosc2_meta_add(array->sc, "caterva", smeta, (uint32_t) smeta_len) < 0) {
-            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
-        }
-    } else {
-        if (blosc2_meta_update(array->sc, "caterva", smeta, (uint32_t) smeta_len) < 0) {
-            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
-        }
-    }
-    free(smeta);
+    update_geometry(array, ndim, shape, chunkshape, blockshape);
+    CATERVA_ERROR(update_meta(array));
+    array->pending_slabs = 0;
 
     return CATERVA_SUCCEED;
 }
@@ -992,6 +3957,12 @@ int caterva_blosc_update_shape(caterva_array_t *array, int8_t ndim, int64_t *sha
 
 int caterva_blosc_array_squeeze_index(caterva_ctx_t *ctx, caterva_array_t *array, bool *index) {
     CATERVA_UNUSED_PARAM(ctx);
+    // Removing dimensions does not move the chunks along a Z-order curve, but it does along
+    // a Hilbert one
+    if (array->chunk_order == CATERVA_CHUNK_ORDER_HILBERT) {
+        DEBUG_PRINT("Arrays whose chunks are in Hilbert order can not be squeezed");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
     uint8_t nones = 0;
     int64_t newshape[CATERVA_MAX_DIM];
     int32_t newchunkshape[CATERVA_MAX_DIM];
@@ -1042,13 +4013,198 @@ int caterva_blosc_array_squeeze(caterva_ctx_t *ctx, caterva_array_t *array) {
     return CATERVA_SUCCEED;
 }
 
+int caterva_blosc_array_resize_check(caterva_array_t *array, int64_t *new_shape) {
+    if (array->sparse) {
+        DEBUG_PRINT("Sparse arrays can not be resized");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (array->chunk_order != CATERVA_CHUNK_ORDER_ROW_MAJOR) {
+        DEBUG_PRINT("Arrays whose chunks are not in row-major order can not be resized");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    for (int i = 0; i < array->ndim; ++i) {
+        if (new_shape[i] != 0 && array->chunkshape[i] == 0) {
+            DEBUG_PRINT("A dimension with a null chunkshape can not be resized");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    }
+    if (array->extendable && new_shape[array->extendable_axis] %
+                             array->chunkshape[array->extendable_axis] != 0) {
+        DEBUG_PRINT("The extendable axis must be resized to a multiple of its chunkshape");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (!array->filled && array->nchunks != 0) {
+        DEBUG_PRINT("Only completely filled arrays can be resized");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (array->filled && array->sc->nchunks != get_grid_nchunks(array)) {
+        DEBUG_PRINT("The super-chunk does not match the array chunk grid");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_blosc_array_resize(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *new_shape) {
+    CATERVA_ERROR(caterva_blosc_array_resize_check(array, new_shape));
+    bool no_chunks = !array->filled && array->nchunks == 0;
+
+    int64_t old_grid[CATERVA_MAX_DIM];
+    int64_t new_grid[CATERVA_MAX_DIM];
+    int64_t mid_grid[CATERVA_MAX_DIM];
+    get_chunk_grid(array, array->shape, old_grid);
+    get_chunk_grid(array, new_shape, new_grid);
+    int64_t old_nchunks = 1;
+    int64_t new_nchunks = 1;
+    int64_t mid_nchunks = 1;
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        mid_grid[i] = old_grid[i] < new_grid[i] ? old_grid[i] : new_grid[i];
+        old_nchunks *= old_grid[i];
+        new_nchunks *= new_grid[i];
+        mid_nchunks *= mid_grid[i];
+    }
+
+    // The caches are only dropped once the new shape is known to be valid
+    ccache_clear(ctx, array);
+    if (array->chunk_cache.data != NULL) {
+        array->chunk_cache.nchunk = -1;
+    }
+    CATERVA_ERROR(write_cache_clear(ctx, array));
+
+    // An array without chunks only needs its geometry to be updated
+    if (no_chunks) {
+        CATERVA_ERROR(caterva_blosc_update_shape(array, array->ndim, new_shape, array->chunkshape,
+                                                 array->blockshape));
+        update_next_chunkshape(array, array->nchunks);
+        array->filled = (array->nitems == 0);
+        array->empty = !array->filled;
+        return CATERVA_SUCCEED;
+    }
+
+    int64_t coords[CATERVA_MAX_DIM];
+
+    // Drop the whole chunks that fall outside of the new shape (backwards, so that the
+    // indexes of the chunks still to be visited are not affected)
+    if (mid_nchunks != old_nchunks) {
+        for (int64_t nchunk = old_nchunks - 1; nchunk >= 0; --nchunk) {
+            index_unidim_to_multidim(CATERVA_MAX_DIM, old_grid, nchunk, coords);
+            for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                if (coords[i] >= new_grid[i]) {
+                    CATERVA_ERROR(sc_delete_chunk(array, nchunk));
+                    break;
+                }
+            }
+        }
+    }
+
+    // Re-pad the new edge chunks of the dimensions that have been shrunk, so that the stale
+    // data does not show up if these dimensions are grown again
+    bool repad = false;
+    for (int i = 0; i < array->ndim; ++i) {
+        if (new_shape[i] < array->shape[i] && new_shape[i] % array->chunkshape[i] != 0) {
+            repad = true;
+        }
+    }
+    if (repad && mid_nchunks != 0) {
+        int32_t nbytes = (int32_t) array->extchunknitems * array->itemsize;
+        uint8_t *rchunk = ctx->cfg->alloc((size_t) nbytes);
+        CATERVA_ERROR_NULL(rchunk);
+        uint8_t *cchunk = ctx->cfg->alloc((size_t) nbytes + BLOSC_MAX_OVERHEAD);
+        if (cchunk == NULL) {
+            ctx->cfg->free(rchunk);
+            CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+        }
+        int rc = CATERVA_SUCCEED;
+        for (int64_t nchunk = 0; nchunk < mid_nchunks && rc == CATERVA_SUCCEED; ++nchunk) {
+            index_unidim_to_multidim(CATERVA_MAX_DIM, mid_grid, nchunk, coords);
+            bool edge = false;
+            int64_t valid_shape[CATERVA_MAX_DIM];
+            for (int i = 0; i < array->ndim; ++i) {
+                valid_shape[i] = new_shape[i] - coords[i] * array->chunkshape[i];
+                if (valid_shape[i] >= array->chunkshape[i]) {
+                    valid_shape[i] = array->chunkshape[i];
+                }
+                if (new_shape[i] < array->shape[i] && valid_shape[i] < array->chunkshape[i]) {
+                    edge = true;
+                }
+            }
+            if (!edge) {
+                continue;
+            }
+            rc = sc_decompress_chunk(array, nchunk, rchunk, nbytes);
+            if (rc != CATERVA_SUCCEED) {
+                break;
+            }
+            chunk_zero_outside(array, rchunk, valid_shape);
+            int csize = blosc2_compress_ctx(array->sc->cctx, rchunk, nbytes, cchunk,
+                                            nbytes + BLOSC_MAX_OVERHEAD);
+            rc = csize < 0 ? CATERVA_ERR_BLOSC_FAILED : sc_update_chunk(array, nchunk, cchunk);
+        }
+        ctx->cfg->free(cchunk);
+        ctx->cfg->free(rchunk);
+        CATERVA_ERROR(rc);
+    }
+
+    // Add zero chunks for the new positions of the grid. The untouched chunks keep their
+    // relative (row-major) order, so walking forwards the new grid always leaves the chunks
+    // already visited in place.
+    if (new_nchunks != mid_nchunks) {
+        blosc2_cparams *cparams;
+        if (blosc2_schunk_get_cparams(array->sc, &cparams) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        uint8_t zchunk[BLOSC_EXTENDED_HEADER_LENGTH];
+        int csize = blosc2_chunk_zeros(*cparams, (size_t) array->extchunknitems * array->itemsize,
+                                       zchunk, BLOSC_EXTENDED_HEADER_LENGTH);
+        free(cparams);
+        if (csize < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        for (int64_t nchunk = 0; nchunk < new_nchunks; ++nchunk) {
+            index_unidim_to_multidim(CATERVA_MAX_DIM, new_grid, nchunk, coords);
+            bool added = false;
+            for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+                if (coords[i] >= mid_grid[i]) {
+                    added = true;
+                    break;
+                }
+            }
+            if (!added) {
+                continue;
+            }
+            CATERVA_ERROR(sc_insert_chunk(ctx, array, nchunk, zchunk));
+        }
+    }
+
+    CATERVA_ERROR(caterva_blosc_update_shape(array, array->ndim, new_shape, array->chunkshape,
+                                             array->blockshape));
+    array->nchunks = new_nchunks;
+    array->filled = true;
+    array->empty = false;
+
+    return CATERVA_SUCCEED;
+}
+
 int caterva_blosc_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
                              caterva_storage_t *storage, caterva_array_t *src,
                              caterva_array_t **dest) {
     CATERVA_UNUSED_PARAM(params);
 
     bool equals = true;
-    if (src->storage == CATERVA_STORAGE_PLAINBUFFER) {
+    if (src->storage != CATERVA_STORAGE_BLOSC) {
+        equals = false;
+    }
+    // The chunks of sparse arrays are not the ones in the chunk grid
+    if (src->sparse || storage->properties.blosc.sparse) {
+        equals = false;
+    }
+    // The chunks of the arrays stored in an I/O backend are not all held by their super-chunk
+    if (src->io != NULL || storage->io != NULL) {
+        equals = false;
+    }
+    // The chunks (and blocks) of the copied super-chunk are in the order of the source
+    if (src->chunk_order != storage->properties.blosc.chunk_order ||
+        src->block_order != storage->properties.blosc.block_order) {
         equals = false;
     }
     for (int i = 0; i < src->ndim; ++i) {
@@ -1063,6 +4219,7 @@ int caterva_blosc_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
     }
 
     if (equals) {
+        CATERVA_ERROR(caterva_blosc_array_flush(ctx, src));
         CATERVA_ERROR(caterva_empty(ctx, params, storage, dest));
         blosc2_schunk *new_sc = blosc2_schunk_copy(src->sc, (*dest)->sc->storage);
         blosc2_schunk_free((*dest)->sc);
@@ -1087,17 +4244,81 @@ int caterva_blosc_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
 
 int caterva_blosc_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
                               caterva_storage_t *storage, caterva_array_t **array) {
+    if (storage->io != NULL &&
+        (!storage->properties.blosc.sequencial || storage->properties.blosc.urlpath == NULL)) {
+        DEBUG_PRINT("Only sequential frames with an urlpath can be stored in an I/O backend");
+        CATERVA_ERROR(CATERVA_ERR_INVALID_STORAGE);
+    }
+
     /* Create a caterva_array_t buffer */
     (*array) = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
     CATERVA_ERROR_NULL(*array) ;
 
     (*array)->storage = storage->backend;
+    (*array)->readonly = false;
+    (*array)->lazy_urlpath = NULL;
+    (*array)->shards = NULL;
+    (*array)->nshards = 0;
+    (*array)->shard_urlpath = NULL;
     (*array)->ndim = params->ndim;
     (*array)->itemsize = params->itemsize;
 
     int64_t *shape = params->shape;
     int32_t *chunkshape = storage->properties.blosc.chunkshape;
     int32_t *blockshape = storage->properties.blosc.blockshape;
+
+    (*array)->extendable = storage->properties.blosc.extendable;
+    (*array)->extendable_axis = storage->properties.blosc.extendable_axis;
+    (*array)->pending_slabs = 0;
+    if ((*array)->extendable) {
+        int8_t axis = (*array)->extendable_axis;
+        if (axis < 0 || axis >= params->ndim) {
+            DEBUG_PRINT("The extendable axis is out of range");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        if (chunkshape[axis] == 0 || shape[axis] % chunkshape[axis] != 0) {
+            DEBUG_PRINT("The extendable axis shape must be a multiple of its chunkshape");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        for (int i = 0; i < params->ndim; ++i) {
+            if (i != axis && shape[i] == 0) {
+                DEBUG_PRINT("Only the extendable axis can have a zero shape");
+                return CATERVA_ERR_INVALID_ARGUMENT;
+            }
+        }
+    }
+    (*array)->sparse = storage->properties.blosc.sparse;
+    (*array)->fill_value = NULL;
+    (*array)->chunk_presence = NULL;
+    (*array)->chunk_ranks = NULL;
+    (*array)->chunk_presence_dirty = false;
+    if ((*array)->sparse && (*array)->extendable) {
+        DEBUG_PRINT("Sparse arrays can not be extendable");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    for (int i = 0; i < CATERVA_MAX_CODEC_CANDIDATES; ++i) {
+        (*array)->codec_cctx[i] = NULL;
+        (*array)->codec_nchunks[i] = 0;
+    }
+    (*array)->codec_ncandidates = 0;
+    (*array)->chunk_order = storage->properties.blosc.chunk_order;
+    (*array)->chunk_positions = NULL;
+    (*array)->block_order = storage->properties.blosc.block_order;
+    (*array)->block_positions = NULL;
+    if ((*array)->block_order < CATERVA_BLOCK_ORDER_ROW_MAJOR ||
+        (*array)->block_order > CATERVA_BLOCK_ORDER_MORTON) {
+        DEBUG_PRINT("Unknown block order");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if ((*array)->chunk_order < CATERVA_CHUNK_ORDER_ROW_MAJOR ||
+        (*array)->chunk_order > CATERVA_CHUNK_ORDER_HILBERT) {
+        DEBUG_PRINT("Unknown chunk order");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if ((*array)->chunk_order != CATERVA_CHUNK_ORDER_ROW_MAJOR && (*array)->extendable) {
+        DEBUG_PRINT("Arrays whose chunks are not in row-major order can not be extendable");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
     (*array)->nitems = 1;
     (*array)->chunknitems = 1;
     (*array)->extnitems = 1;
@@ -1115,6 +4336,10 @@ int caterva_blosc_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
             } else {
                 (*array)->extshape[i] = shape[i] + chunkshape[i] - shape[i] % chunkshape[i];
             }
+        } else {
+            (*array)->extshape[i] = 0;
+        }
+        if (chunkshape[i] != 0 && blockshape[i] != 0) {
             if (chunkshape[i] % blockshape[i] == 0) {
                 (*array)->extchunkshape[i] = chunkshape[i];
             } else {
@@ -1122,7 +4347,6 @@ int caterva_blosc_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
                         chunkshape[i] + blockshape[i] - chunkshape[i] % blockshape[i];
             }
         } else {
-            (*array)->extshape[i] = 0;
             (*array)->extchunkshape[i] = 0;
         }
         (*array)->nitems *= shape[i];
@@ -1147,7 +4371,41 @@ int caterva_blosc_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
     (*array)->chunk_cache.data = NULL;
     (*array)->chunk_cache.nchunk = -1;  // means no valid cache yet
 
+    // The write-back cache (empty initially)
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        (*array)->write_cache[i].data = NULL;
+        (*array)->write_cache[i].nchunk = -1;
+        (*array)->write_cache[i].dirty = false;
+        (*array)->write_cache[i].access = 0;
+    }
+    (*array)->write_cache_access = 0;
+    (*array)->access_stats = NULL;
+    (*array)->ccache = NULL;
+    (*array)->ccache_len = 0;
+    (*array)->ccache_free = -1;
+    (*array)->ccache_slots = NULL;
+    (*array)->ccache_nslots = 0;
+    (*array)->ccache_hand = 0;
+    (*array)->reader_scs = NULL;
+    (*array)->reader_nscs = 0;
+    memset(&(*array)->ccache_stats, 0, sizeof(caterva_ccache_stats_t));
+    (*array)->checksums_dropped = false;
+    (*array)->io = NULL;
+    (*array)->io_urlpath = NULL;
+    (*array)->io_stream = NULL;
+    (*array)->io_offsets = NULL;
+    (*array)->io_cbytes = NULL;
+    (*array)->io_nslots = 0;
+    (*array)->io_end = 0;
+    (*array)->io_tail = NULL;
+    (*array)->io_tail_len = 0;
+
     (*array)->buf = NULL;
+    (*array)->map = NULL;
+    (*array)->map_len = 0;
+    (*array)->map_urlpath = NULL;
+    (*array)->advice = CATERVA_ADVICE_NORMAL;
+    (*array)->ndirect_scans = 0;
 
     blosc2_cparams cparams = BLOSC2_CPARAMS_DEFAULTS;
     cparams.blocksize = (*array)->blocknitems * params->itemsize;
@@ -1175,7 +4433,23 @@ int caterva_blosc_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
     if (storage->properties.blosc.sequencial) {
         b_storage.contiguous = true;
     }
-    if (storage->properties.blosc.urlpath != NULL) {
+    // The chunks of the arrays stored in an I/O backend are written in its stream when they are
+    // flushed. Their super-chunk holds the chunks apart in memory, so that the ones written are
+    // released.
+    if (storage->io != NULL) {
+        b_storage.contiguous = false;
+        (*array)->io = storage->io;
+        (*array)->io_urlpath = ctx->cfg->alloc(strlen(storage->properties.blosc.urlpath) + 1);
+        CATERVA_ERROR_NULL((*array)->io_urlpath);
+        strcpy((*array)->io_urlpath, storage->properties.blosc.urlpath);
+        (*array)->io_stream = storage->io->open(storage->properties.blosc.urlpath, "w+b",
+                                                storage->io->params);
+        if ((*array)->io_stream == NULL) {
+            DEBUG_PRINT("Can not open the stream in the I/O backend");
+            return CATERVA_ERR_INVALID_STORAGE;
+        }
+        (*array)->io_end = CATERVA_IO_SUPERBLOCK_LEN;
+    } else if (storage->properties.blosc.urlpath != NULL) {
         b_storage.urlpath = storage->properties.blosc.urlpath;
     }
 
@@ -1192,7 +4466,8 @@ int caterva_blosc_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
         return CATERVA_ERR_BLOSC_FAILED;
     }
     uint8_t *smeta = NULL;
-    int32_t smeta_len = serialize_meta(params->ndim, shape, chunkshape, blockshape, &smeta);
+    int32_t smeta_len = serialize_meta(params->ndim, shape, chunkshape, blockshape,
+                                       (*array)->chunk_order, (*array)->block_order, &smeta);
     if (smeta_len < 0) {
         DEBUG_PRINT("error during serializing dims info for Caterva");
         return CATERVA_ERR_BLOSC_FAILED;
@@ -1213,7 +4488,45 @@ int caterva_blosc_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
             CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
         }
     }
+
+    // Store the extendable axis in a variable-length metalayer
+    if ((*array)->extendable) {
+        uint8_t saxis = (uint8_t) (*array)->extendable_axis;  // positive fixnum
+        if (blosc2_vlmeta_add(sc, CATERVA_EXTENDABLE_VLMETA, &saxis, 1, NULL) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+    }
     (*array)->sc = sc;
+    (*array)->nchunks = 0;
+    update_next_chunkshape(*array, 0);
+
+    // Compute the positions of the chunks along the chunk order (and of the blocks along the
+    // block order)
+    CATERVA_ERROR(create_chunk_positions(ctx, *array));
+    if ((*array)->chunk_positions != NULL && !(*array)->sparse) {
+        CATERVA_ERROR(create_chunk_presence(ctx, *array));
+    }
+    CATERVA_ERROR(create_block_positions(ctx, *array));
+
+    // Keep the fill value and the chunk presence bitmap in a variable-length metalayer
+    if ((*array)->sparse) {
+        (*array)->fill_value = ctx->cfg->alloc((size_t) params->itemsize);
+        CATERVA_ERROR_NULL((*array)->fill_value);
+        if (storage->properties.blosc.fill_value != NULL) {
+            memcpy((*array)->fill_value, storage->properties.blosc.fill_value, params->itemsize);
+        } else {
+            memset((*array)->fill_value, 0, params->itemsize);
+        }
+        int64_t bitmap_len = (get_grid_nchunks(*array) + 7) / 8;
+        if (bitmap_len == 0) {
+            bitmap_len = 1;
+        }
+        (*array)->chunk_presence = ctx->cfg->alloc((size_t) bitmap_len);
+        CATERVA_ERROR_NULL((*array)->chunk_presence);
+        memset((*array)->chunk_presence, 0, (size_t) bitmap_len);
+        CATERVA_ERROR(create_chunk_ranks(ctx, *array));
+        CATERVA_ERROR(update_sparse_meta(*array));
+    }
 
     return CATERVA_SUCCEED;
 }
@@ -23,21 +23,53 @@ caterva_blosc_from_schunk(caterva_ctx_t *ctx, blosc2_schunk *schunk, caterva_arr
 int caterva_blosc_from_serial_schunk(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64_t len,
                                      caterva_array_t **array);
 
+int caterva_blosc_from_serial_schunk_view(caterva_ctx_t *ctx, uint8_t *serial_schunk, int64_t len,
+                                          caterva_array_t **array);
+
 int caterva_blosc_open(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array);
 
+int caterva_blosc_open_io(caterva_ctx_t *ctx, const caterva_io_t *io, const char *urlpath,
+                          caterva_array_t **array);
+
+int caterva_blosc_open_lazy(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array);
+
+int caterva_blosc_array_load(caterva_ctx_t *ctx, caterva_array_t *array);
+
+int caterva_blosc_open_mmap(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array);
+
+void caterva_blosc_update_geometry(caterva_array_t *array, int8_t ndim, int64_t *shape,
+                                   int32_t *chunkshape, int32_t *blockshape);
+
 int caterva_blosc_array_repart_chunk(int8_t *rchunk, int64_t rchunksize, void *chunk,
                                      int64_t chunksize, caterva_array_t *array);
 
 int caterva_blosc_array_append(caterva_ctx_t *ctx, caterva_array_t *array, void *chunk,
-                               int64_t chunksize);
+                               int32_t chunksize);
 
 int caterva_blosc_array_from_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer,
                                     int64_t buffersize);
 
+int caterva_blosc_array_full(caterva_ctx_t *ctx, caterva_array_t *array, void *fill_value);
+
 int caterva_blosc_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
-                                         int64_t *start, int64_t *stop, int64_t *shape,
+                                         int64_t *start, int64_t *stop, const int64_t *shape,
                                          void *buffer);
 
+int caterva_blosc_array_set_slice_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersize,
+                                         int64_t *start, int64_t *stop, caterva_array_t *array);
+
+int caterva_blosc_array_flush(caterva_ctx_t *ctx, caterva_array_t *array);
+
+void caterva_blosc_remove_urlpath(caterva_ctx_t *ctx, const char *urlpath);
+
+int caterva_blosc_array_compact(caterva_ctx_t *ctx, caterva_array_t *array, bool recompress);
+
+int caterva_blosc_array_append_cchunk(caterva_ctx_t *ctx, caterva_array_t *array,
+                                      uint8_t *cchunk);
+
+int caterva_blosc_array_get_cchunk(caterva_array_t *array, int64_t nchunk, uint8_t *special,
+                                   uint8_t **cchunk, int32_t *cbytes, bool *needs_free);
+
 int caterva_blosc_array_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer);
 
 int caterva_blosc_array_get_slice(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *start,
@@ -47,6 +79,11 @@ int caterva_blosc_array_squeeze_index(caterva_ctx_t *ctx, caterva_array_t *src,
 
 int caterva_blosc_array_squeeze(caterva_ctx_t *ctx, caterva_array_t *src);
 
+// Check whether an array can be resized to a new shape (without modifying it)
+int caterva_blosc_array_resize_check(caterva_array_t *array, int64_t *new_shape);
+
+int caterva_blosc_array_resize(caterva_ctx_t *ctx, caterva_array_t *array, int64_t *new_shape);
+
 int caterva_blosc_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
                              caterva_storage_t *storage, caterva_array_t *src,
                              caterva_array_t **dest);
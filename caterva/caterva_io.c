@@ -0,0 +1,648 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+// O_DIRECT is only declared for GNU sources
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <caterva.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "caterva_io.h"
+
+// The number of bytes of the regions in which the frames are read and written
+#define CATERVA_IO_REGION_SIZE (1 << 20)
+
+// The alignment of the buffers, offsets and sizes of the direct reads
+#define CATERVA_IO_DIRECT_ALIGNMENT 4096
+
+#if !defined(_WIN32)
+static void *file_open(const char *urlpath, const char *mode, void *params) {
+    (void) params;
+    int flags = mode[0] == 'r' ? O_RDONLY : O_RDWR | O_CREAT | O_TRUNC;
+    if (mode[0] == 'r' && strchr(mode, '+') != NULL) {
+        flags = O_RDWR;
+    }
+    int fd = open(urlpath, flags, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    int *stream = malloc(sizeof(int));
+    if (stream == NULL) {
+        close(fd);
+        return NULL;
+    }
+    *stream = fd;
+    return stream;
+}
+
+static int file_close(void *stream) {
+    int rc = close(*(int *) stream);
+    free(stream);
+    return rc;
+}
+
+static int64_t file_pread(void *stream, void *data, int64_t size, int64_t offset) {
+    return pread(*(int *) stream, data, (size_t) size, (off_t) offset);
+}
+
+static int64_t file_pwrite(void *stream, const void *data, int64_t size, int64_t offset) {
+    return pwrite(*(int *) stream, data, (size_t) size, (off_t) offset);
+}
+
+static int64_t file_size(void *stream) {
+    struct stat st;
+    if (fstat(*(int *) stream, &st) != 0) {
+        return -1;
+    }
+    return st.st_size;
+}
+
+static int file_sync(void *stream) {
+    return fsync(*(int *) stream);
+}
+#else
+static void *file_open(const char *urlpath, const char *mode, void *params) {
+    (void) params;
+    return fopen(urlpath, mode);
+}
+
+static int file_close(void *stream) {
+    return fclose(stream);
+}
+
+static int64_t file_pread(void *stream, void *data, int64_t size, int64_t offset) {
+    if (_fseeki64(stream, offset, SEEK_SET) != 0) {
+        return -1;
+    }
+    return (int64_t) fread(data, 1, (size_t) size, stream);
+}
+
+static int64_t file_pwrite(void *stream, const void *data, int64_t size, int64_t offset) {
+    if (_fseeki64(stream, offset, SEEK_SET) != 0) {
+        return -1;
+    }
+    return (int64_t) fwrite(data, 1, (size_t) size, stream);
+}
+
+static int64_t file_size(void *stream) {
+    if (_fseeki64(stream, 0, SEEK_END) != 0) {
+        return -1;
+    }
+    return _ftelli64(stream);
+}
+
+static int file_sync(void *stream) {
+    return fflush(stream);
+}
+#endif
+
+static const caterva_io_t file_io = {file_open, file_close, file_pread, file_pwrite, file_size,
+                                     file_sync, NULL, NULL, NULL};
+
+const caterva_io_t *caterva_io_file(void) {
+    return &file_io;
+}
+
+// Read a region whole, retrying the partial reads
+static int read_region(const caterva_io_t *io, void *stream, caterva_io_vec_t *vec) {
+    int64_t nread = 0;
+    while (nread < vec->size) {
+        int64_t rbytes = io->pread(stream, (uint8_t *) vec->data + nread, vec->size - nread,
+                                   vec->offset + nread);
+        if (rbytes <= 0) {
+            DEBUG_PRINT("Error reading from the I/O backend");
+            return CATERVA_ERR_INVALID_STORAGE;
+        }
+        nread += rbytes;
+    }
+    return CATERVA_SUCCEED;
+}
+
+#if !defined(_WIN32)
+// The regions read asynchronously that are completed
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int ndone;
+    bool failed;
+    int64_t *nbytes;
+} io_reads_t;
+
+static void read_done(int64_t nbytes, void *userdata) {
+    io_reads_t *reads = userdata;
+    pthread_mutex_lock(&reads->mutex);
+    reads->ndone++;
+    if (nbytes < 0) {
+        reads->failed = true;
+    } else {
+        *reads->nbytes += nbytes;
+    }
+    pthread_cond_broadcast(&reads->cond);
+    pthread_mutex_unlock(&reads->mutex);
+}
+
+// Start reading all the regions at once and wait for them. The regions that can not be started
+// are read synchronously, once the ones started are completed (their callbacks use the mutex).
+static int read_regions_async(const caterva_io_t *io, void *stream, caterva_io_vec_t *vecs,
+                              int nvecs, int64_t *nbytes) {
+    io_reads_t reads;
+    pthread_mutex_init(&reads.mutex, NULL);
+    pthread_cond_init(&reads.cond, NULL);
+    reads.ndone = 0;
+    reads.failed = false;
+    reads.nbytes = nbytes;
+    *nbytes = 0;
+
+    int nstarted = io->pread_async(stream, vecs, nvecs, read_done, &reads);
+    nstarted = nstarted < 0 ? 0 : nstarted;
+    nstarted = nstarted < nvecs ? nstarted : nvecs;
+    pthread_mutex_lock(&reads.mutex);
+    while (reads.ndone < nstarted) {
+        pthread_cond_wait(&reads.cond, &reads.mutex);
+    }
+    pthread_mutex_unlock(&reads.mutex);
+    pthread_mutex_destroy(&reads.mutex);
+    pthread_cond_destroy(&reads.cond);
+
+    int rc = reads.failed ? CATERVA_ERR_INVALID_STORAGE : CATERVA_SUCCEED;
+    for (int i = nstarted; i < nvecs && rc == CATERVA_SUCCEED; ++i) {
+        rc = read_region(io, stream, &vecs[i]);
+        *nbytes += rc == CATERVA_SUCCEED ? vecs[i].size : 0;
+    }
+    return rc;
+}
+#endif
+
+int caterva_io_read_regions(const caterva_io_t *io, void *stream, caterva_io_vec_t *vecs,
+                            int nvecs) {
+    int64_t size = 0;
+    for (int i = 0; i < nvecs; ++i) {
+        size += vecs[i].size;
+    }
+    int64_t nbytes = -1;
+#if !defined(_WIN32)
+    if (io->pread_async != NULL) {
+        CATERVA_ERROR(read_regions_async(io, stream, vecs, nvecs, &nbytes));
+    }
+#endif
+    if (nbytes < 0 && io->preadv != NULL) {
+        nbytes = io->preadv(stream, vecs, nvecs);
+    }
+    if (nbytes < 0) {
+        for (int i = 0; i < nvecs; ++i) {
+            CATERVA_ERROR(read_region(io, stream, &vecs[i]));
+        }
+        nbytes = size;
+    }
+    if (nbytes != size) {
+        DEBUG_PRINT("Error reading from the I/O backend");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_io_write(const caterva_io_t *io, void *stream, const void *data, int64_t size,
+                     int64_t offset) {
+    // The bytes are written in regions, retrying the partial writes
+    int64_t nwritten = 0;
+    while (nwritten < size) {
+        int64_t wsize = size - nwritten < CATERVA_IO_REGION_SIZE ? size - nwritten
+                                                                 : CATERVA_IO_REGION_SIZE;
+        int64_t wbytes = io->pwrite(stream, (const uint8_t *) data + nwritten, wsize,
+                                    offset + nwritten);
+        if (wbytes <= 0) {
+            DEBUG_PRINT("Error writing to the I/O backend");
+            return CATERVA_ERR_INVALID_STORAGE;
+        }
+        nwritten += wbytes;
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_io_read_chunk(const caterva_io_t *io, void *stream, int64_t offset, int32_t cbytes,
+                          uint8_t **chunk) {
+    // The chunk is released with free(), like the ones got from Blosc
+    *chunk = malloc((size_t) cbytes);
+    CATERVA_ERROR_NULL(*chunk);
+    caterva_io_vec_t vec = {*chunk, cbytes, offset};
+    int rc = read_region(io, stream, &vec);
+    if (rc != CATERVA_SUCCEED) {
+        free(*chunk);
+        *chunk = NULL;
+        CATERVA_ERROR(rc);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+static void store_le(uint8_t *dest, int64_t value, int nbytes) {
+    for (int i = 0; i < nbytes; ++i) {
+        dest[i] = (uint8_t) ((uint64_t) value >> (8 * i));
+    }
+}
+
+static int64_t load_le(const uint8_t *src, int nbytes) {
+    uint64_t value = 0;
+    for (int i = nbytes - 1; i >= 0; --i) {
+        value = (value << 8) | src[i];
+    }
+    return (int64_t) value;
+}
+
+int caterva_io_read_tail(caterva_ctx_t *ctx, const caterva_io_t *io, void *stream,
+                         uint8_t **tail, int64_t *tail_len, int64_t *end) {
+    uint8_t superblock[CATERVA_IO_SUPERBLOCK_LEN];
+    caterva_io_vec_t vec = {superblock, CATERVA_IO_SUPERBLOCK_LEN, 0};
+    CATERVA_ERROR(read_region(io, stream, &vec));
+    if (memcmp(superblock, CATERVA_IO_MAGIC, sizeof(CATERVA_IO_MAGIC)) != 0) {
+        DEBUG_PRINT("The stream does not hold a caterva array");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    int64_t offset = load_le(&superblock[CATERVA_IO_TAIL_OFFSET], sizeof(int64_t));
+    *tail_len = load_le(&superblock[CATERVA_IO_TAIL_LEN], sizeof(int64_t));
+    int64_t size = io->size(stream);
+    if (offset < CATERVA_IO_SUPERBLOCK_LEN || *tail_len <= 0 || offset + *tail_len > size) {
+        DEBUG_PRINT("The superblock of the stream is corrupted");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    *end = offset + *tail_len;
+
+    // The tail is read in regions (at once if the backend supports it)
+    int nvecs = (int) ((*tail_len + CATERVA_IO_REGION_SIZE - 1) / CATERVA_IO_REGION_SIZE);
+    *tail = ctx->cfg->alloc((size_t) *tail_len);
+    CATERVA_ERROR_NULL(*tail);
+    caterva_io_vec_t *vecs = ctx->cfg->alloc(nvecs * sizeof(caterva_io_vec_t));
+    if (vecs == NULL) {
+        ctx->cfg->free(*tail);
+        *tail = NULL;
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    for (int i = 0; i < nvecs; ++i) {
+        int64_t start = (int64_t) i * CATERVA_IO_REGION_SIZE;
+        vecs[i].data = *tail + start;
+        vecs[i].size = *tail_len - start < CATERVA_IO_REGION_SIZE ? *tail_len - start
+                                                                 : CATERVA_IO_REGION_SIZE;
+        vecs[i].offset = offset + start;
+    }
+    int rc = caterva_io_read_regions(io, stream, vecs, nvecs);
+    ctx->cfg->free(vecs);
+    if (rc != CATERVA_SUCCEED) {
+        ctx->cfg->free(*tail);
+        *tail = NULL;
+        CATERVA_ERROR(rc);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_io_write_tail(const caterva_io_t *io, void *stream, const uint8_t *tail,
+                          int64_t tail_len, int64_t offset) {
+    // The superblock is replaced once the chunks and the tail are durable, so that a failed
+    // write keeps the previous tail (and the chunks it refers to)
+    uint8_t superblock[CATERVA_IO_SUPERBLOCK_LEN] = {0};
+    memcpy(superblock, CATERVA_IO_MAGIC, sizeof(CATERVA_IO_MAGIC));
+    store_le(&superblock[CATERVA_IO_TAIL_OFFSET], offset, sizeof(int64_t));
+    store_le(&superblock[CATERVA_IO_TAIL_LEN], tail_len, sizeof(int64_t));
+    CATERVA_ERROR(caterva_io_write(io, stream, tail, tail_len, offset));
+    if (io->sync(stream) != 0) {
+        DEBUG_PRINT("Error syncing the I/O backend");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    CATERVA_ERROR(caterva_io_write(io, stream, superblock, CATERVA_IO_SUPERBLOCK_LEN, 0));
+    if (io->sync(stream) != 0) {
+        DEBUG_PRINT("Error syncing the I/O backend");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_io_encode_tail(caterva_ctx_t *ctx, const uint8_t *frame, int64_t frame_len,
+                           const int64_t *offsets, const int32_t *cbytes, int64_t nchunks,
+                           uint8_t **tail, int64_t *tail_len) {
+    *tail_len = 2 * sizeof(int64_t) + frame_len + nchunks * CATERVA_IO_INDEX_ENTRY_LEN;
+    *tail = ctx->cfg->alloc((size_t) *tail_len);
+    CATERVA_ERROR_NULL(*tail);
+    uint8_t *p = *tail;
+    store_le(p, frame_len, sizeof(int64_t));
+    p += sizeof(int64_t);
+    memcpy(p, frame, (size_t) frame_len);
+    p += frame_len;
+    store_le(p, nchunks, sizeof(int64_t));
+    p += sizeof(int64_t);
+    for (int64_t i = 0; i < nchunks; ++i) {
+        store_le(p, offsets[i], sizeof(int64_t));
+        store_le(p + sizeof(int64_t), cbytes[i], sizeof(int32_t));
+        p += CATERVA_IO_INDEX_ENTRY_LEN;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_io_decode_tail(caterva_ctx_t *ctx, uint8_t *tail, int64_t tail_len, uint8_t **frame,
+                           int64_t *frame_len, int64_t **offsets, int32_t **cbytes,
+                           int64_t *nchunks) {
+    *offsets = NULL;
+    *cbytes = NULL;
+    *frame_len = tail_len >= (int64_t) sizeof(int64_t) ? load_le(tail, sizeof(int64_t)) : -1;
+    if (*frame_len <= 0 || *frame_len > tail_len - 2 * (int64_t) sizeof(int64_t)) {
+        DEBUG_PRINT("The tail of the stream is corrupted");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    *frame = tail + sizeof(int64_t);
+    uint8_t *p = *frame + *frame_len;
+    *nchunks = load_le(p, sizeof(int64_t));
+    p += sizeof(int64_t);
+    if (*nchunks < 0 || *nchunks * CATERVA_IO_INDEX_ENTRY_LEN != tail + tail_len - p) {
+        DEBUG_PRINT("The index of the stream is corrupted");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    int64_t nslots = *nchunks > 0 ? *nchunks : 1;
+    *offsets = ctx->cfg->alloc(nslots * sizeof(int64_t));
+    *cbytes = ctx->cfg->alloc(nslots * sizeof(int32_t));
+    if (*offsets == NULL || *cbytes == NULL) {
+        if (*offsets != NULL) {
+            ctx->cfg->free(*offsets);
+        }
+        if (*cbytes != NULL) {
+            ctx->cfg->free(*cbytes);
+        }
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    for (int64_t i = 0; i < *nchunks; ++i) {
+        (*offsets)[i] = load_le(p, sizeof(int64_t));
+        (*cbytes)[i] = (int32_t) load_le(p + sizeof(int64_t), sizeof(int32_t));
+        p += CATERVA_IO_INDEX_ENTRY_LEN;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// A file read with direct I/O through a window of aligned extents, which is moved forward (or
+// backward) when a read falls out of it
+struct caterva_io_direct_s {
+#if defined(_WIN32)
+    void *stream;
+#else
+    int fd;
+    bool direct;
+#endif
+    char *urlpath;
+    int depth;
+    int64_t len;       // the length of the file
+    uint8_t *buffer;   // the allocation holding the window
+    uint8_t *window;   // the window, aligned inside the buffer
+    int64_t capacity;  // the number of bytes of the window (a whole number of regions)
+    int64_t offset;    // the offset of the window in the file
+    int64_t size;      // the number of bytes read in the window
+};
+
+#if !defined(_WIN32)
+// The regions of an extent read with direct I/O by several threads (the next one is taken by
+// the first thread that is free, so that up to `depth` regions are read ahead)
+typedef struct {
+    int fd;
+    uint8_t *extent;
+    int64_t offset;
+    int64_t len;
+    int64_t nregions;
+    int64_t next;
+    bool failed;
+    pthread_mutex_t mutex;
+} direct_reader_t;
+
+static void *direct_reader_run(void *arg) {
+    direct_reader_t *reader = arg;
+    while (true) {
+        pthread_mutex_lock(&reader->mutex);
+        int64_t nregion = reader->failed ? reader->nregions : reader->next++;
+        pthread_mutex_unlock(&reader->mutex);
+        if (nregion >= reader->nregions) {
+            break;
+        }
+        // The whole region is requested (the extent buffer is padded up to a whole number of
+        // regions), but only the bytes up to the end of the extent are returned
+        int64_t start = nregion * CATERVA_IO_REGION_SIZE;
+        int64_t size = CATERVA_IO_REGION_SIZE;
+        int64_t valid = reader->len - start < size ? reader->len - start : size;
+        int64_t nread = 0;
+        while (nread < valid) {
+            ssize_t rbytes = pread(reader->fd, reader->extent + start + nread,
+                                   (size_t) (size - nread),
+                                   (off_t) (reader->offset + start + nread));
+            if (rbytes <= 0) {
+                pthread_mutex_lock(&reader->mutex);
+                reader->failed = true;
+                pthread_mutex_unlock(&reader->mutex);
+                break;
+            }
+            nread += rbytes;
+        }
+    }
+    return NULL;
+}
+
+// Read the regions of the extent of a file starting at an aligned offset, up to `depth` at once
+static bool read_regions_direct(caterva_ctx_t *ctx, int fd, uint8_t *extent, int64_t offset,
+                                int64_t len, int depth) {
+    direct_reader_t reader;
+    reader.fd = fd;
+    reader.extent = extent;
+    reader.offset = offset;
+    reader.len = len;
+    reader.nregions = (len + CATERVA_IO_REGION_SIZE - 1) / CATERVA_IO_REGION_SIZE;
+    reader.next = 0;
+    reader.failed = false;
+    pthread_mutex_init(&reader.mutex, NULL);
+    int nthreads = depth < 1 ? 1 : depth;
+    nthreads = nthreads < reader.nregions ? nthreads : (int) reader.nregions;
+    pthread_t *threads = nthreads > 1 ? ctx->cfg->alloc(nthreads * sizeof(pthread_t)) : NULL;
+    int nstarted = 0;
+    for (int i = 1; threads != NULL && i < nthreads; ++i) {
+        if (pthread_create(&threads[nstarted], NULL, direct_reader_run, &reader) != 0) {
+            break;
+        }
+        nstarted++;
+    }
+    // The calling thread reads regions too (all of them if no thread can be created)
+    direct_reader_run(&reader);
+    for (int i = 0; i < nstarted; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    if (threads != NULL) {
+        ctx->cfg->free(threads);
+    }
+    pthread_mutex_destroy(&reader.mutex);
+
+    return !reader.failed;
+}
+#endif
+
+// Read an extent of the file in the window
+static int direct_fill(caterva_ctx_t *ctx, caterva_io_direct_t *file, int64_t offset,
+                       int64_t len) {
+#if defined(_WIN32)
+    CATERVA_UNUSED_PARAM(ctx);
+    caterva_io_vec_t vec = {file->window, len, offset};
+    CATERVA_ERROR(read_region(caterva_io_file(), file->stream, &vec));
+#else
+    bool read = read_regions_direct(ctx, file->fd, file->window, offset, len, file->depth);
+#if defined(O_DIRECT)
+    // Some file systems accept O_DIRECT when the file is opened but not when it is read
+    if (!read && file->direct) {
+        close(file->fd);
+        file->fd = open(file->urlpath, O_RDONLY);
+        file->direct = false;
+        read = file->fd >= 0 &&
+               read_regions_direct(ctx, file->fd, file->window, offset, len, file->depth);
+    }
+#endif
+    if (!read) {
+        DEBUG_PRINT("Error reading the frame file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+#endif
+    file->offset = offset;
+    file->size = len;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_io_direct_open(caterva_ctx_t *ctx, const char *urlpath, int depth,
+                           caterva_io_direct_t **file) {
+    caterva_io_direct_t *f = ctx->cfg->alloc(sizeof(caterva_io_direct_t));
+    CATERVA_ERROR_NULL(f);
+    memset(f, 0, sizeof(caterva_io_direct_t));
+    f->depth = depth < 1 ? 1 : depth;
+    f->urlpath = ctx->cfg->alloc(strlen(urlpath) + 1);
+    if (f->urlpath == NULL) {
+        ctx->cfg->free(f);
+        CATERVA_ERROR(CATERVA_ERR_NULL_POINTER);
+    }
+    strcpy(f->urlpath, urlpath);
+#if defined(_WIN32)
+    // The file is read through the page cache
+    f->stream = caterva_io_file()->open(urlpath, "rb", NULL);
+    f->len = f->stream != NULL ? caterva_io_file()->size(f->stream) : -1;
+    bool opened = f->stream != NULL;
+#else
+    // The page cache is bypassed with O_DIRECT (or F_NOCACHE). If the file system does not
+    // support it, the file is read through the page cache and its pages are dropped when it is
+    // closed.
+    f->fd = -1;
+#if defined(O_DIRECT)
+    f->fd = open(urlpath, O_RDONLY | O_DIRECT);
+    f->direct = f->fd >= 0;
+#endif
+    if (f->fd < 0) {
+        f->fd = open(urlpath, O_RDONLY);
+#if defined(F_NOCACHE)
+        f->direct = f->fd >= 0 && fcntl(f->fd, F_NOCACHE, 1) == 0;
+#endif
+    }
+    struct stat st;
+    f->len = f->fd >= 0 && fstat(f->fd, &st) == 0 ? st.st_size : -1;
+    bool opened = f->fd >= 0;
+#endif
+    *file = f;
+    if (!opened) {
+        caterva_io_direct_close(ctx, file);
+        DEBUG_PRINT("Can not open the frame file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (f->len <= 0) {
+        caterva_io_direct_close(ctx, file);
+        DEBUG_PRINT("The frame file is empty");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_io_direct_read(caterva_ctx_t *ctx, caterva_io_direct_t *file, int64_t offset,
+                           int64_t size, uint8_t **data) {
+    if (offset < 0 || size < 0 || offset + size > file->len) {
+        DEBUG_PRINT("The read is out of the frame file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (file->window == NULL || offset < file->offset ||
+        offset + size > file->offset + file->size) {
+        // The window starts at the aligned offset before the read and spans `depth` regions at
+        // least, so that the next reads are served from it
+        int64_t start = offset - offset % CATERVA_IO_DIRECT_ALIGNMENT;
+        int64_t span = offset + size - start;
+        int64_t ahead = (int64_t) file->depth * CATERVA_IO_REGION_SIZE;
+        span = span > ahead ? span : ahead;
+        int64_t capacity = (span + CATERVA_IO_REGION_SIZE - 1) / CATERVA_IO_REGION_SIZE *
+                           CATERVA_IO_REGION_SIZE;
+        if (capacity > file->capacity) {
+            // The buffer is aligned by hand, since the allocation function of the context may
+            // not do it
+            if (file->buffer != NULL) {
+                ctx->cfg->free(file->buffer);
+            }
+            file->window = NULL;
+            file->capacity = 0;
+            file->buffer = ctx->cfg->alloc((size_t) (capacity + CATERVA_IO_DIRECT_ALIGNMENT));
+            CATERVA_ERROR_NULL(file->buffer);
+            uintptr_t misalignment = (uintptr_t) file->buffer % CATERVA_IO_DIRECT_ALIGNMENT;
+            file->window = file->buffer +
+                           (misalignment == 0 ? 0 : CATERVA_IO_DIRECT_ALIGNMENT - misalignment);
+            file->capacity = capacity;
+        }
+        int64_t len = file->len - start < file->capacity ? file->len - start : file->capacity;
+        int rc = direct_fill(ctx, file, start, len);
+        if (rc != CATERVA_SUCCEED) {
+            file->size = 0;
+            CATERVA_ERROR(rc);
+        }
+    }
+    *data = file->window + (offset - file->offset);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_io_direct_close(caterva_ctx_t *ctx, caterva_io_direct_t **file) {
+    caterva_io_direct_t *f = *file;
+    if (f == NULL) {
+        return CATERVA_SUCCEED;
+    }
+#if defined(_WIN32)
+    if (f->stream != NULL) {
+        caterva_io_file()->close(f->stream);
+    }
+#else
+#if defined(POSIX_FADV_DONTNEED)
+    if (!f->direct && f->fd >= 0) {
+        posix_fadvise(f->fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+#endif
+    if (f->fd >= 0) {
+        close(f->fd);
+    }
+#endif
+    if (f->buffer != NULL) {
+        ctx->cfg->free(f->buffer);
+    }
+    ctx->cfg->free(f->urlpath);
+    ctx->cfg->free(f);
+    *file = NULL;
+
+    return CATERVA_SUCCEED;
+}
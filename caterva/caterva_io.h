@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#ifndef CATERVA_CATERVA_IO_H_
+#define CATERVA_CATERVA_IO_H_
+
+// The streams of the arrays stored in an I/O backend start with a superblock holding a magic and
+// the offset and length of the last tail written. The chunks and the tails are appended after it
+// when the arrays are flushed. A tail holds the length of the frame of the super-chunk (whose
+// chunks written in the stream are replaced by header-only chunks), the frame, the number of
+// chunks and the offset and compressed size of each chunk in the stream (with a negative offset
+// for the ones kept in the frame), all of them in little endian.
+#define CATERVA_IO_MAGIC "caterva-io-1"
+#define CATERVA_IO_TAIL_OFFSET 16
+#define CATERVA_IO_TAIL_LEN 24
+#define CATERVA_IO_SUPERBLOCK_LEN 32
+#define CATERVA_IO_INDEX_ENTRY_LEN 12
+
+int caterva_io_read_regions(const caterva_io_t *io, void *stream, caterva_io_vec_t *vecs,
+                            int nvecs);
+
+int caterva_io_write(const caterva_io_t *io, void *stream, const void *data, int64_t size,
+                     int64_t offset);
+
+int caterva_io_read_chunk(const caterva_io_t *io, void *stream, int64_t offset, int32_t cbytes,
+                          uint8_t **chunk);
+
+int caterva_io_read_tail(caterva_ctx_t *ctx, const caterva_io_t *io, void *stream,
+                         uint8_t **tail, int64_t *tail_len, int64_t *end);
+
+int caterva_io_write_tail(const caterva_io_t *io, void *stream, const uint8_t *tail,
+                          int64_t tail_len, int64_t offset);
+
+int caterva_io_encode_tail(caterva_ctx_t *ctx, const uint8_t *frame, int64_t frame_len,
+                           const int64_t *offsets, const int32_t *cbytes, int64_t nchunks,
+                           uint8_t **tail, int64_t *tail_len);
+
+int caterva_io_decode_tail(caterva_ctx_t *ctx, uint8_t *tail, int64_t tail_len, uint8_t **frame,
+                           int64_t *frame_len, int64_t **offsets, int32_t **cbytes,
+                           int64_t *nchunks);
+
+typedef struct caterva_io_direct_s caterva_io_direct_t;
+
+int caterva_io_direct_open(caterva_ctx_t *ctx, const char *urlpath, int depth,
+                           caterva_io_direct_t **file);
+
+int caterva_io_direct_read(caterva_ctx_t *ctx, caterva_io_direct_t *file, int64_t offset,
+                           int64_t size, uint8_t **data);
+
+int caterva_io_direct_close(caterva_ctx_t *ctx, caterva_io_direct_t **file);
+
+#endif  // CATERVA_CATERVA_IO_H_
@@ -10,6 +10,24 @@
  */
 
 #include <caterva.h>
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "caterva_plainbuffer.h"
+
+// The files where plain buffers are stored start with a header holding a magic string, the
+// format version, the number of dimensions, the itemsize and the shape (as little-endian int64),
+// padded so that the data that follows is aligned
+#define CATERVA_PLAINBUFFER_MAGIC "CATPBUF"
+#define CATERVA_PLAINBUFFER_MAGIC_LEN 8
+#define CATERVA_PLAINBUFFER_VERSION 0
+#define CATERVA_PLAINBUFFER_SHAPE_OFFSET 16
+#define CATERVA_PLAINBUFFER_HEADER_LEN 128
 
 static void index_unidim_to_multidim(int8_t ndim, int64_t *shape, int64_t i, int64_t *index) {
     int64_t strides[CATERVA_MAX_DIM];
@@ -24,10 +42,170 @@ static void index_unidim_to_multidim(int8_t ndim, int64_t *shape, int64_t i, int
     }
 }
 
+static void store_int64_le(uint8_t *dest, int64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        dest[i] = (uint8_t) ((uint64_t) value >> (8 * i));
+    }
+}
+
+static int64_t load_int64_le(const uint8_t *src) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | src[i];
+    }
+    return (int64_t) value;
+}
+
+// Write the current geometry of a plain buffer in the header of its file
+static void write_header(caterva_array_t *array) {
+    uint8_t *header = array->map;
+    memset(header, 0, CATERVA_PLAINBUFFER_HEADER_LEN);
+    memcpy(header, CATERVA_PLAINBUFFER_MAGIC, CATERVA_PLAINBUFFER_MAGIC_LEN);
+    header[CATERVA_PLAINBUFFER_MAGIC_LEN] = CATERVA_PLAINBUFFER_VERSION;
+    header[CATERVA_PLAINBUFFER_MAGIC_LEN + 1] = (uint8_t) array->ndim;
+    header[CATERVA_PLAINBUFFER_MAGIC_LEN + 2] = (uint8_t) array->itemsize;
+    for (int i = 0; i < array->ndim; ++i) {
+        store_int64_le(&header[CATERVA_PLAINBUFFER_SHAPE_OFFSET + 8 * i], array->shape[i]);
+    }
+}
+
+static int apply_advice(caterva_array_t *array) {
+#if defined(_WIN32)
+    CATERVA_UNUSED_PARAM(array);
+#else
+    int advice;
+    switch (array->advice) {
+        case CATERVA_ADVICE_NORMAL:
+            advice = POSIX_MADV_NORMAL;
+            break;
+        case CATERVA_ADVICE_SEQUENTIAL:
+        case CATERVA_ADVICE_DIRECT:
+            advice = POSIX_MADV_SEQUENTIAL;
+            break;
+        case CATERVA_ADVICE_RANDOM:
+            advice = POSIX_MADV_RANDOM;
+            break;
+        case CATERVA_ADVICE_WILLNEED:
+            advice = POSIX_MADV_WILLNEED;
+            break;
+        default:
+            DEBUG_PRINT("Unknown advice");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (array->map != NULL && posix_madvise(array->map, (size_t) array->map_len, advice) != 0) {
+        DEBUG_PRINT("Can not advise the access pattern of the plain buffer");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+#endif
+
+    return CATERVA_SUCCEED;
+}
+
+// How the file of a plain buffer is mapped: an existing file is opened as it is, a new file is
+// created and a resized file keeps its items while its size is changed
+typedef enum {
+    MAPPING_OPEN,
+    MAPPING_CREATE,
+    MAPPING_RESIZE,
+} mapping_mode_t;
+
+// Map the file of a plain buffer into memory. When it is created or resized, the size of the
+// file is set to the size of the array once it is mapped (so a failed resize leaves the file as
+// it was) and its header is written; otherwise its size must match the array. Files that can not be written are mapped read-only and the array is marked readonly.
+static int map_file(caterva_array_t *array, mapping_mode_t mode) {
+#if defined(_WIN32)
+    CATERVA_UNUSED_PARAM(array);
+    CATERVA_UNUSED_PARAM(mode);
+    DEBUG_PRINT("Plain buffers stored on disk are not supported on Windows");
+    return CATERVA_ERR_INVALID_STORAGE;
+#else
+    int64_t len = CATERVA_PLAINBUFFER_HEADER_LEN + array->nitems * array->itemsize;
+    int flags = mode == MAPPING_CREATE ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR;
+    int fd = open(array->map_urlpath, flags, 0644);
+    if (fd < 0 && mode == MAPPING_OPEN && (errno == EACCES || errno == EROFS)) {
+        fd = open(array->map_urlpath, O_RDONLY);
+        array->readonly = true;
+    }
+    if (fd < 0) {
+        DEBUG_PRINT("Can not open the plain buffer file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (mode == MAPPING_OPEN) {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (int64_t) st.st_size != len) {
+            close(fd);
+            DEBUG_PRINT("The size of the plain buffer file does not match its header");
+            return CATERVA_ERR_INVALID_STORAGE;
+        }
+    }
+    // The mapping is kept after closing the file
+    int prot = array->readonly ? PROT_READ : PROT_READ | PROT_WRITE;
+    void *map = mmap(NULL, (size_t) len, prot, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        DEBUG_PRINT("Can not map the plain buffer file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (mode != MAPPING_OPEN && ftruncate(fd, (off_t) len) != 0) {
+        munmap(map, (size_t) len);
+        close(fd);
+        DEBUG_PRINT("Can not set the size of the plain buffer file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    close(fd);
+    array->map = map;
+    array->map_len = len;
+    array->buf = array->map + CATERVA_PLAINBUFFER_HEADER_LEN;
+    if (mode != MAPPING_OPEN) {
+        write_header(array);
+    }
+    CATERVA_ERROR(apply_advice(array));
+
+    return CATERVA_SUCCEED;
+#endif
+}
+
+static void unmap_file(caterva_array_t *array) {
+#if !defined(_WIN32)
+    munmap(array->map, (size_t) array->map_len);
+#endif
+    array->map = NULL;
+    array->map_len = 0;
+    array->buf = NULL;
+}
+
 int caterva_plainbuffer_array_free(caterva_ctx_t *ctx, caterva_array_t **array) {
-    if ((*array)->buf != NULL) {
+    if ((*array)->map != NULL) {
+        unmap_file(*array);
+    } else if ((*array)->buf != NULL) {
         ctx->cfg->free((*array)->buf);
     }
+    if ((*array)->map_urlpath != NULL) {
+        ctx->cfg->free((*array)->map_urlpath);
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_plainbuffer_array_flush(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_UNUSED_PARAM(ctx);
+#if !defined(_WIN32)
+    if (array->map != NULL && !array->readonly &&
+        msync(array->map, (size_t) array->map_len, MS_SYNC) != 0) {
+        DEBUG_PRINT("Can not synchronize the plain buffer file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+#else
+    CATERVA_UNUSED_PARAM(array);
+#endif
+    return CATERVA_SUCCEED;
+}
+
+int caterva_plainbuffer_array_advise(caterva_ctx_t *ctx, caterva_array_t *array,
+                                     caterva_advice_t advice) {
+    CATERVA_UNUSED_PARAM(ctx);
+    array->advice = advice;
+    CATERVA_ERROR(apply_advice(array));
+
     return CATERVA_SUCCEED;
 }
 
@@ -51,6 +229,24 @@ int caterva_plainbuffer_array_from_buffer(caterva_ctx_t *ctx, caterva_array_t *a
     return CATERVA_SUCCEED;
 }
 
+int caterva_plainbuffer_array_full(caterva_ctx_t *ctx, caterva_array_t *array,
+                                   void *fill_value) {
+    CATERVA_UNUSED_PARAM(ctx);
+
+    if (fill_value == NULL) {
+        memset(array->buf, 0, (size_t) array->nitems * array->itemsize);
+    } else {
+        for (int64_t i = 0; i < array->nitems; ++i) {
+            memcpy(&array->buf[i * array->itemsize], fill_value, array->itemsize);
+        }
+    }
+    array->nchunks = 1;
+    array->filled = true;
+    array->empty = false;
+
+    return CATERVA_SUCCEED;
+}
+
 int caterva_plainbuffer_array_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
                                         void *buffer) {
     CATERVA_UNUSED_PARAM(ctx);
@@ -82,6 +278,7 @@ int caterva_plainbuffer_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array
     int8_t s_ndim = array->ndim;
 
     int64_t s_shape[CATERVA_MAX_DIM];
+    int64_t slice_shape_[CATERVA_MAX_DIM];
     for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
         start_[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = start__[i];
         stop_[(CATERVA_MAX_DIM - s_ndim + i) % CATERVA_MAX_DIM] = stop__[i];
@@ -91,6 +288,9 @@ int caterva_plainbuffer_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array
     for (int j = 0; j < CATERVA_MAX_DIM - s_ndim; ++j) {
         start_[j] = 0;
     }
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        slice_shape_[i] = stop_[i] - start_[i];
+    }
     int64_t start_copy[CATERVA_MAX_DIM];
     start_copy[CATERVA_MAX_DIM - 1] = start_[CATERVA_MAX_DIM - 1];
     int64_t ncopies = 1;
@@ -98,7 +298,7 @@ int caterva_plainbuffer_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array
         ncopies *= stop_[i] - start_[i];
     }
     for (int ncopy = 0; ncopy < ncopies; ++ncopy) {
-        index_unidim_to_multidim(CATERVA_MAX_DIM - 1, d_pshape_, ncopy, start_copy);
+        index_unidim_to_multidim(CATERVA_MAX_DIM - 1, slice_shape_, ncopy, start_copy);
         for (int i = 0; i < CATERVA_MAX_DIM - 1; ++i) {
             start_copy[i] += start_[i];
         }
@@ -211,6 +411,9 @@ int caterva_plainbuffer_update_shape(caterva_array_t *array, int8_t ndim, int64_
         array->extnitems *= array->extshape[i];
         array->chunknitems *= array->chunkshape[i];
     }
+    if (array->map != NULL) {
+        write_header(array);
+    }
 
     return CATERVA_SUCCEED;
 }
@@ -257,6 +460,78 @@ int caterva_plainbuffer_array_squeeze(caterva_ctx_t *ctx, caterva_array_t *array
 }
 
 
+int caterva_plainbuffer_array_resize(caterva_ctx_t *ctx, caterva_array_t *array,
+                                     int64_t *new_shape) {
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t new_nitems = 1;
+    int64_t overlap_nitems = 1;
+    for (int i = 0; i < array->ndim; ++i) {
+        stop[i] = array->shape[i] < new_shape[i] ? array->shape[i] : new_shape[i];
+        new_nitems *= new_shape[i];
+        overlap_nitems *= stop[i];
+    }
+
+    size_t new_size = (size_t) new_nitems * array->itemsize;
+    uint8_t *buf = ctx->cfg->alloc(new_size);
+    if (buf == NULL && new_size != 0) {
+        DEBUG_PRINT("Pointer is null");
+        return CATERVA_ERR_NULL_POINTER;
+    }
+    if (new_size != 0) {
+        memset(buf, 0, new_size);
+    }
+
+    // Copy the region shared by the old and the new shapes
+    int rc = CATERVA_SUCCEED;
+    if (overlap_nitems != 0) {
+        rc = caterva_plainbuffer_array_get_slice_buffer(ctx, array, start, stop, new_shape, buf);
+    }
+    if (rc == CATERVA_SUCCEED && array->map != NULL) {
+        // The file is grown or shrunk in place (it is never truncated to zero), mapped again with
+        // the new size and the items are copied into it. The old mapping is kept until the new
+        // one succeeds, so the array is left as it was on failure.
+        uint8_t *old_map = array->map;
+        int64_t old_map_len = array->map_len;
+        int64_t old_shape[CATERVA_MAX_DIM];
+        for (int i = 0; i < array->ndim; ++i) {
+            old_shape[i] = array->shape[i];
+        }
+        rc = caterva_plainbuffer_update_shape(array, array->ndim, new_shape);
+        if (rc == CATERVA_SUCCEED) {
+            rc = map_file(array, MAPPING_RESIZE);
+        }
+        if (rc != CATERVA_SUCCEED) {
+            caterva_plainbuffer_update_shape(array, array->ndim, old_shape);
+            array->map = old_map;
+            array->map_len = old_map_len;
+            array->buf = old_map + CATERVA_PLAINBUFFER_HEADER_LEN;
+        } else {
+#if !defined(_WIN32)
+            munmap(old_map, (size_t) old_map_len);
+#endif
+            if (new_size != 0) {
+                memcpy(array->buf, buf, new_size);
+            }
+        }
+    }
+    if (rc != CATERVA_SUCCEED || array->map != NULL) {
+        if (buf != NULL) {
+            ctx->cfg->free(buf);
+        }
+        CATERVA_ERROR(rc);
+        return CATERVA_SUCCEED;
+    }
+    if (array->buf != NULL) {
+        ctx->cfg->free(array->buf);
+    }
+    array->buf = buf;
+
+    CATERVA_ERROR(caterva_plainbuffer_update_shape(array, array->ndim, new_shape));
+
+    return CATERVA_SUCCEED;
+}
+
 int caterva_plainbuffer_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
                                    caterva_storage_t *storage, caterva_array_t *src,
                                    caterva_array_t **dest) {
@@ -269,8 +544,8 @@ int caterva_plainbuffer_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
     return CATERVA_SUCCEED;
 }
 
-int caterva_plainbuffer_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
-                                    caterva_storage_t *storage, caterva_array_t **array) {
+static int create_array(caterva_ctx_t *ctx, caterva_params_t *params,
+                        caterva_storage_t *storage, caterva_array_t **array) {
     /* Create a caterva_array_t buffer */
     (*array) = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
     if ((*array) == NULL) {
@@ -279,6 +554,11 @@ int caterva_plainbuffer_array_empty(caterva_ctx_t *ctx, caterva_params_t *params
     }
 
     (*array)->storage = storage->backend;
+    (*array)->readonly = false;
+    (*array)->lazy_urlpath = NULL;
+    (*array)->shards = NULL;
+    (*array)->nshards = 0;
+    (*array)->shard_urlpath = NULL;
     (*array)->ndim = params->ndim;
     (*array)->itemsize = params->itemsize;
 
@@ -308,11 +588,144 @@ int caterva_plainbuffer_array_empty(caterva_ctx_t *ctx, caterva_params_t *params
     (*array)->chunk_cache.data = NULL;
     (*array)->chunk_cache.nchunk = -1;  // means no valid cache yet
 
+    // The write-back cache is not used by plain buffers
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        (*array)->write_cache[i].data = NULL;
+        (*array)->write_cache[i].nchunk = -1;
+        (*array)->write_cache[i].dirty = false;
+        (*array)->write_cache[i].access = 0;
+    }
+    (*array)->write_cache_access = 0;
+    (*array)->access_stats = NULL;
+    (*array)->ccache = NULL;
+    (*array)->ccache_len = 0;
+    (*array)->ccache_free = -1;
+    (*array)->ccache_slots = NULL;
+    (*array)->ccache_nslots = 0;
+    (*array)->ccache_hand = 0;
+    (*array)->reader_scs = NULL;
+    (*array)->reader_nscs = 0;
+    memset(&(*array)->ccache_stats, 0, sizeof(caterva_ccache_stats_t));
+    (*array)->checksums_dropped = false;
+    (*array)->io = NULL;
+    (*array)->io_urlpath = NULL;
+    (*array)->io_stream = NULL;
+    (*array)->io_offsets = NULL;
+    (*array)->io_cbytes = NULL;
+    (*array)->io_nslots = 0;
+    (*array)->io_end = 0;
+    (*array)->io_tail = NULL;
+    (*array)->io_tail_len = 0;
+
     (*array)->sc = NULL;
 
+    // Plain buffers can not grow while appending
+    (*array)->extendable = false;
+    (*array)->extendable_axis = 0;
+    (*array)->pending_slabs = 0;
+
+    // Plain buffers store all their items
+    (*array)->sparse = false;
+    (*array)->fill_value = NULL;
+    (*array)->chunk_presence = NULL;
+    (*array)->chunk_ranks = NULL;
+    (*array)->chunk_presence_dirty = false;
+    (*array)->chunk_order = CATERVA_CHUNK_ORDER_ROW_MAJOR;
+    (*array)->chunk_positions = NULL;
+    (*array)->block_order = CATERVA_BLOCK_ORDER_ROW_MAJOR;
+    (*array)->block_positions = NULL;
+    for (int i = 0; i < CATERVA_MAX_CODEC_CANDIDATES; ++i) {
+        (*array)->codec_cctx[i] = NULL;
+        (*array)->codec_nchunks[i] = 0;
+    }
+    (*array)->codec_ncandidates = 0;
+
+    (*array)->buf = NULL;
+    (*array)->map = NULL;
+    (*array)->map_len = 0;
+    (*array)->map_urlpath = NULL;
+    (*array)->advice = storage->properties.plainbuffer.advice;
+    (*array)->ndirect_scans = 0;
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_plainbuffer_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
+                                    caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR(create_array(ctx, params, storage, array));
+
+    char *urlpath = storage->properties.plainbuffer.urlpath;
+    if (urlpath != NULL) {
+        (*array)->map_urlpath = ctx->cfg->alloc(strlen(urlpath) + 1);
+        CATERVA_ERROR_NULL((*array)->map_urlpath);
+        strcpy((*array)->map_urlpath, urlpath);
+        CATERVA_ERROR(map_file(*array, MAPPING_CREATE));
+        return CATERVA_SUCCEED;
+    }
+
     uint8_t *buf = ctx->cfg->alloc((size_t)(*array)->extnitems * params->itemsize);
 
     (*array)->buf = buf;
 
     return CATERVA_SUCCEED;
 }
+
+// Read the header of a file, returning false if it does not store a plain buffer
+static bool read_header(const char *urlpath, uint8_t *header) {
+    FILE *fp = fopen(urlpath, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    size_t len = fread(header, 1, CATERVA_PLAINBUFFER_HEADER_LEN, fp);
+    fclose(fp);
+
+    return len == CATERVA_PLAINBUFFER_HEADER_LEN &&
+           memcmp(header, CATERVA_PLAINBUFFER_MAGIC, CATERVA_PLAINBUFFER_MAGIC_LEN) == 0;
+}
+
+bool caterva_plainbuffer_is_file(const char *urlpath) {
+    uint8_t header[CATERVA_PLAINBUFFER_HEADER_LEN];
+    return read_header(urlpath, header);
+}
+
+int caterva_plainbuffer_open(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array) {
+    uint8_t header[CATERVA_PLAINBUFFER_HEADER_LEN];
+    if (!read_header(urlpath, header)) {
+        DEBUG_PRINT("The file does not store a plain buffer");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (header[CATERVA_PLAINBUFFER_MAGIC_LEN] > CATERVA_PLAINBUFFER_VERSION) {
+        DEBUG_PRINT("Unsupported version of the plain buffer file");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    caterva_params_t params;
+    params.ndim = (int8_t) header[CATERVA_PLAINBUFFER_MAGIC_LEN + 1];
+    params.itemsize = header[CATERVA_PLAINBUFFER_MAGIC_LEN + 2];
+    if (params.ndim > CATERVA_MAX_DIM) {
+        DEBUG_PRINT("The number of dimensions of the plain buffer file is not valid");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = load_int64_le(&header[CATERVA_PLAINBUFFER_SHAPE_OFFSET + 8 * i]);
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_PLAINBUFFER;
+    CATERVA_ERROR(create_array(ctx, &params, &storage, array));
+    (*array)->map_urlpath = ctx->cfg->alloc(strlen(urlpath) + 1);
+    CATERVA_ERROR_NULL((*array)->map_urlpath);
+    strcpy((*array)->map_urlpath, urlpath);
+    int rc = map_file(*array, MAPPING_OPEN);
+    if (rc != CATERVA_SUCCEED) {
+        caterva_plainbuffer_array_free(ctx, array);
+        ctx->cfg->free(*array);
+        *array = NULL;
+        return rc;
+    }
+    (*array)->nchunks = 1;
+    (*array)->filled = true;
+    (*array)->empty = false;
+
+    return CATERVA_SUCCEED;
+}
@@ -11,12 +11,24 @@ int caterva_plainbuffer_array_empty(caterva_ctx_t *ctx, caterva_params_t *params
 
 int caterva_plainbuffer_array_free(caterva_ctx_t *ctx, caterva_array_t **array);
 
+bool caterva_plainbuffer_is_file(const char *urlpath);
+
+int caterva_plainbuffer_open(caterva_ctx_t *ctx, const char *urlpath, caterva_array_t **array);
+
+int caterva_plainbuffer_array_flush(caterva_ctx_t *ctx, caterva_array_t *array);
+
+int caterva_plainbuffer_array_advise(caterva_ctx_t *ctx, caterva_array_t *array,
+                                     caterva_advice_t advice);
+
 int caterva_plainbuffer_array_append(caterva_ctx_t *ctx, caterva_array_t *array, void *chunk,
                                      int64_t chunksize);
 
 int caterva_plainbuffer_array_from_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
                                           void *buffer, int64_t buffersize);
 
+int caterva_plainbuffer_array_full(caterva_ctx_t *ctx, caterva_array_t *array,
+                                   void *fill_value);
+
 int caterva_plainbuffer_array_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
                                         void *buffer);
 
@@ -36,6 +48,9 @@ int caterva_plainbuffer_array_squeeze_index(caterva_ctx_t *ctx, caterva_array_t
 
 int caterva_plainbuffer_array_squeeze(caterva_ctx_t *ctx, caterva_array_t *array);
 
+int caterva_plainbuffer_array_resize(caterva_ctx_t *ctx, caterva_array_t *array,
+                                     int64_t *new_shape);
+
 int caterva_plainbuffer_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
                                    caterva_storage_t *storage, caterva_array_t *src,
                                    caterva_array_t **dest);
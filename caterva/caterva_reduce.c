@@ -0,0 +1,590 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+#include <math.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#include "caterva_reduce.h"
+
+// The minimum number of items of a tile reduced by several threads
+#define CATERVA_REDUCE_MIN_PARALLEL_NITEMS (64 * 1024)
+#define CATERVA_REDUCE_MAX_THREADS 64
+
+// The type of the values accumulated while an array is reduced
+typedef enum {
+    ACC_INT64,
+    ACC_UINT64,
+    ACC_DOUBLE,
+} acc_kind_t;
+
+// A tile of the array (never larger than a chunk) reduced into the accumulators of an output
+// chunk. Its rows span the last dimension.
+typedef struct {
+    const uint8_t *data;
+    caterva_dtype_t dtype;
+    caterva_reduce_op_t op;
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    // The strides of the axes in the accumulators (0 for the reduced axes)
+    int64_t acc_strides[CATERVA_MAX_DIM];
+    int64_t acc_offset;
+    int64_t nrows;
+    int64_t rowlen;
+    bool last_kept;
+} tile_t;
+
+// The rows of a tile reduced by a thread into its own accumulators
+typedef struct {
+    const tile_t *tile;
+    int64_t start;
+    int64_t stop;
+    void *acc;
+} tile_part_t;
+
+static void index_unidim_to_multidim(int8_t ndim, int64_t *shape, int64_t i, int64_t *index) {
+    int64_t strides[CATERVA_MAX_DIM];
+    strides[ndim - 1] = 1;
+    for (int j = ndim - 2; j >= 0; --j) {
+        strides[j] = shape[j + 1] * strides[j + 1];
+    }
+
+    index[0] = i / strides[0];
+    for (int j = 1; j < ndim; ++j) {
+        index[j] = (i % strides[j - 1]) / strides[j];
+    }
+}
+
+static int8_t get_dtype_itemsize(caterva_dtype_t dtype) {
+    switch (dtype) {
+        case CATERVA_DTYPE_INT8:
+        case CATERVA_DTYPE_UINT8:
+            return 1;
+        case CATERVA_DTYPE_INT16:
+        case CATERVA_DTYPE_UINT16:
+            return 2;
+        case CATERVA_DTYPE_INT32:
+        case CATERVA_DTYPE_UINT32:
+        case CATERVA_DTYPE_FLOAT32:
+            return 4;
+        case CATERVA_DTYPE_INT64:
+        case CATERVA_DTYPE_UINT64:
+        case CATERVA_DTYPE_FLOAT64:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+static acc_kind_t get_acc_kind(caterva_dtype_t dtype, caterva_reduce_op_t op) {
+    switch (dtype) {
+        case CATERVA_DTYPE_FLOAT32:
+        case CATERVA_DTYPE_FLOAT64:
+            return ACC_DOUBLE;
+        case CATERVA_DTYPE_UINT8:
+        case CATERVA_DTYPE_UINT16:
+        case CATERVA_DTYPE_UINT32:
+        case CATERVA_DTYPE_UINT64:
+            return op == CATERVA_REDUCE_MEAN ? ACC_DOUBLE : ACC_UINT64;
+        default:
+            return op == CATERVA_REDUCE_MEAN ? ACC_DOUBLE : ACC_INT64;
+    }
+}
+
+// The type of the reduced array: the sums are widened to 64 bits and the means are doubles
+static caterva_dtype_t get_out_dtype(caterva_dtype_t dtype, caterva_reduce_op_t op) {
+    if (op == CATERVA_REDUCE_MEAN) {
+        return CATERVA_DTYPE_FLOAT64;
+    }
+    if (op != CATERVA_REDUCE_SUM) {
+        return dtype;
+    }
+    switch (get_acc_kind(dtype, op)) {
+        case ACC_INT64:
+            return CATERVA_DTYPE_INT64;
+        case ACC_UINT64:
+            return CATERVA_DTYPE_UINT64;
+        default:
+            return CATERVA_DTYPE_FLOAT64;
+    }
+}
+
+// Fill the accumulators with the identity of the operation
+static void init_acc(acc_kind_t kind, caterva_reduce_op_t op, void *acc, int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+        switch (kind) {
+            case ACC_INT64:
+                ((int64_t *) acc)[i] = op == CATERVA_REDUCE_MIN ? INT64_MAX :
+                                       op == CATERVA_REDUCE_MAX ? INT64_MIN : 0;
+                break;
+            case ACC_UINT64:
+                ((uint64_t *) acc)[i] = op == CATERVA_REDUCE_MIN ? UINT64_MAX : 0;
+                break;
+            default:
+                ((double *) acc)[i] = op == CATERVA_REDUCE_MIN ? INFINITY :
+                                      op == CATERVA_REDUCE_MAX ? -INFINITY : 0;
+        }
+    }
+}
+
+#define REDUCE_SUM(a, x) (a) += (x)
+#define REDUCE_MIN(a, x) (a) = (x) < (a) ? (x) : (a)
+#define REDUCE_MAX(a, x) (a) = (x) > (a) ? (x) : (a)
+// The NaNs are propagated, as in NumPy
+#define REDUCE_FMIN(a, x) (a) = ((x) < (a) || (x) != (x)) ? (x) : (a)
+#define REDUCE_FMAX(a, x) (a) = ((x) > (a) || (x) != (x)) ? (x) : (a)
+
+// Reduce the rows [start, stop) of a tile, elementwise if the last axis is kept (so the compiler
+// can vectorize the loop) or into a single accumulator otherwise
+#define REDUCE_ROWS(T, A, OP)                                                         \
+    for (int64_t row = start; row < stop; ++row) {                                    \
+        const T *x = (const T *) tile->data + row * tile->rowlen;                     \
+        A *a = (A *) acc + get_row_offset(tile, row);                                 \
+        if (tile->last_kept) {                                                        \
+            for (int64_t j = 0; j < tile->rowlen; ++j) {                              \
+                OP(a[j], (A) x[j]);                                                   \
+            }                                                                         \
+        } else {                                                                      \
+            A r = a[0];                                                               \
+            for (int64_t j = 0; j < tile->rowlen; ++j) {                              \
+                OP(r, (A) x[j]);                                                      \
+            }                                                                         \
+            a[0] = r;                                                                 \
+        }                                                                             \
+    }
+
+#define REDUCE_INT_ROWS(T, A)                                                         \
+    switch (tile->op) {                                                               \
+        case CATERVA_REDUCE_MIN:                                                      \
+            REDUCE_ROWS(T, A, REDUCE_MIN)                                             \
+            break;                                                                    \
+        case CATERVA_REDUCE_MAX:                                                      \
+            REDUCE_ROWS(T, A, REDUCE_MAX)                                             \
+            break;                                                                    \
+        case CATERVA_REDUCE_MEAN:                                                     \
+            REDUCE_ROWS(T, double, REDUCE_SUM)                                        \
+            break;                                                                    \
+        default:                                                                      \
+            REDUCE_ROWS(T, A, REDUCE_SUM)                                             \
+    }
+
+#define REDUCE_FLOAT_ROWS(T)                                                          \
+    switch (tile->op) {                                                               \
+        case CATERVA_REDUCE_MIN:                                                      \
+            REDUCE_ROWS(T, double, REDUCE_FMIN)                                       \
+            break;                                                                    \
+        case CATERVA_REDUCE_MAX:                                                      \
+            REDUCE_ROWS(T, double, REDUCE_FMAX)                                       \
+            break;                                                                    \
+        default:                                                                      \
+            REDUCE_ROWS(T, double, REDUCE_SUM)                                        \
+    }
+
+// The position in the accumulators of the first item of a row of a tile
+static int64_t get_row_offset(const tile_t *tile, int64_t row) {
+    int64_t offset = tile->acc_offset;
+    for (int i = tile->ndim - 2; i >= 0 && row > 0; --i) {
+        offset += (row % tile->shape[i]) * tile->acc_strides[i];
+        row /= tile->shape[i];
+    }
+    return offset;
+}
+
+static void reduce_rows(const tile_t *tile, int64_t start, int64_t stop, void *acc) {
+    switch (tile->dtype) {
+        case CATERVA_DTYPE_INT8:
+            REDUCE_INT_ROWS(int8_t, int64_t)
+            break;
+        case CATERVA_DTYPE_INT16:
+            REDUCE_INT_ROWS(int16_t, int64_t)
+            break;
+        case CATERVA_DTYPE_INT32:
+            REDUCE_INT_ROWS(int32_t, int64_t)
+            break;
+        case CATERVA_DTYPE_INT64:
+            REDUCE_INT_ROWS(int64_t, int64_t)
+            break;
+        case CATERVA_DTYPE_UINT8:
+            REDUCE_INT_ROWS(uint8_t, uint64_t)
+            break;
+        case CATERVA_DTYPE_UINT16:
+            REDUCE_INT_ROWS(uint16_t, uint64_t)
+            break;
+        case CATERVA_DTYPE_UINT32:
+            REDUCE_INT_ROWS(uint32_t, uint64_t)
+            break;
+        case CATERVA_DTYPE_UINT64:
+            REDUCE_INT_ROWS(uint64_t, uint64_t)
+            break;
+        case CATERVA_DTYPE_FLOAT32:
+            REDUCE_FLOAT_ROWS(float)
+            break;
+        case CATERVA_DTYPE_FLOAT64:
+            REDUCE_FLOAT_ROWS(double)
+            break;
+    }
+}
+
+// Combine the partial reductions of a thread with the ones of the calling thread
+static void combine_acc(acc_kind_t kind, caterva_reduce_op_t op, void *acc, const void *partial,
+                        int64_t n) {
+    for (int64_t i = 0; i < n; ++i) {
+        switch (kind) {
+            case ACC_INT64: {
+                int64_t *a = acc;
+                const int64_t *p = partial;
+                if (op == CATERVA_REDUCE_MIN) {
+                    REDUCE_MIN(a[i], p[i]);
+                } else if (op == CATERVA_REDUCE_MAX) {
+                    REDUCE_MAX(a[i], p[i]);
+                } else {
+                    REDUCE_SUM(a[i], p[i]);
+                }
+                break;
+            }
+            case ACC_UINT64: {
+                uint64_t *a = acc;
+                const uint64_t *p = partial;
+                if (op == CATERVA_REDUCE_MIN) {
+                    REDUCE_MIN(a[i], p[i]);
+                } else if (op == CATERVA_REDUCE_MAX) {
+                    REDUCE_MAX(a[i], p[i]);
+                } else {
+                    REDUCE_SUM(a[i], p[i]);
+                }
+                break;
+            }
+            default: {
+                double *a = acc;
+                const double *p = partial;
+                if (op == CATERVA_REDUCE_MIN) {
+                    REDUCE_FMIN(a[i], p[i]);
+                } else if (op == CATERVA_REDUCE_MAX) {
+                    REDUCE_FMAX(a[i], p[i]);
+                } else {
+                    REDUCE_SUM(a[i], p[i]);
+                }
+            }
+        }
+    }
+}
+
+// Convert the accumulators of an output chunk into its items
+static void store_acc(acc_kind_t kind, caterva_reduce_op_t op, caterva_dtype_t dtype,
+                      const void *acc, int64_t n, int64_t count, uint8_t *chunk) {
+    for (int64_t i = 0; i < n; ++i) {
+        double d = 0;
+        int64_t s = 0;
+        uint64_t u = 0;
+        switch (kind) {
+            case ACC_INT64:
+                s = ((const int64_t *) acc)[i];
+                d = (double) s;
+                u = (uint64_t) s;
+                break;
+            case ACC_UINT64:
+                u = ((const uint64_t *) acc)[i];
+                d = (double) u;
+                s = (int64_t) u;
+                break;
+            default:
+                d = ((const double *) acc)[i];
+                if (op == CATERVA_REDUCE_MEAN) {
+                    d = count > 0 ? d / (double) count : NAN;
+                }
+        }
+        switch (dtype) {
+            case CATERVA_DTYPE_INT8:
+                ((int8_t *) chunk)[i] = (int8_t) s;
+                break;
+            case CATERVA_DTYPE_INT16:
+                ((int16_t *) chunk)[i] = (int16_t) s;
+                break;
+            case CATERVA_DTYPE_INT32:
+                ((int32_t *) chunk)[i] = (int32_t) s;
+                break;
+            case CATERVA_DTYPE_INT64:
+                ((int64_t *) chunk)[i] = s;
+                break;
+            case CATERVA_DTYPE_UINT8:
+                ((uint8_t *) chunk)[i] = (uint8_t) u;
+                break;
+            case CATERVA_DTYPE_UINT16:
+                ((uint16_t *) chunk)[i] = (uint16_t) u;
+                break;
+            case CATERVA_DTYPE_UINT32:
+                ((uint32_t *) chunk)[i] = (uint32_t) u;
+                break;
+            case CATERVA_DTYPE_UINT64:
+                ((uint64_t *) chunk)[i] = u;
+                break;
+            case CATERVA_DTYPE_FLOAT32:
+                ((float *) chunk)[i] = (float) d;
+                break;
+            case CATERVA_DTYPE_FLOAT64:
+                ((double *) chunk)[i] = d;
+                break;
+        }
+    }
+}
+
+#if !defined(_WIN32)
+static void *tile_part_run(void *arg) {
+    tile_part_t *part = arg;
+    reduce_rows(part->tile, part->start, part->stop, part->acc);
+    return NULL;
+}
+#endif
+
+// Reduce a tile, splitting its rows between several threads when it is large enough. The thread
+// i (but the first one) reduces its rows into the partials i - 1.
+static void reduce_tile(const tile_t *tile, void *acc, uint8_t *partials, int64_t partial_nbytes,
+                        int nthreads) {
+#if !defined(_WIN32)
+    if (nthreads > tile->nrows) {
+        nthreads = (int) tile->nrows;
+    }
+    if (nthreads > 1 && tile->nrows * tile->rowlen >= CATERVA_REDUCE_MIN_PARALLEL_NITEMS) {
+        tile_part_t parts[CATERVA_REDUCE_MAX_THREADS];
+        pthread_t threads[CATERVA_REDUCE_MAX_THREADS];
+        bool started[CATERVA_REDUCE_MAX_THREADS] = {false};
+        int64_t nrows = tile->nrows / nthreads;
+        for (int i = 0; i < nthreads; ++i) {
+            parts[i].tile = tile;
+            parts[i].start = i * nrows;
+            parts[i].stop = i == nthreads - 1 ? tile->nrows : (i + 1) * nrows;
+            parts[i].acc = i == 0 ? acc : partials + (i - 1) * partial_nbytes;
+        }
+        for (int i = 1; i < nthreads; ++i) {
+            started[i] = pthread_create(&threads[i], NULL, tile_part_run, &parts[i]) == 0;
+        }
+        // The calling thread reduces its rows and the ones of the threads not created
+        for (int i = 0; i < nthreads; ++i) {
+            if (i == 0 || !started[i]) {
+                tile_part_run(&parts[i]);
+            }
+        }
+        for (int i = 1; i < nthreads; ++i) {
+            if (started[i]) {
+                pthread_join(threads[i], NULL);
+            }
+        }
+        return;
+    }
+#endif
+    CATERVA_UNUSED_PARAM(partials);
+    CATERVA_UNUSED_PARAM(partial_nbytes);
+    CATERVA_UNUSED_PARAM(nthreads);
+    reduce_rows(tile, 0, tile->nrows, acc);
+}
+
+int caterva_reduce_array(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                         caterva_reduce_op_t op, bool *axes, caterva_storage_t *storage,
+                         caterva_array_t **out) {
+    if (get_dtype_itemsize(dtype) != array->itemsize) {
+        DEBUG_PRINT("The itemsize of the array does not match the data type");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (op != CATERVA_REDUCE_SUM && op != CATERVA_REDUCE_MIN && op != CATERVA_REDUCE_MAX &&
+        op != CATERVA_REDUCE_MEAN) {
+        DEBUG_PRINT("Unknown reduction");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (!array->filled) {
+        DEBUG_PRINT("Only arrays completely filled can be reduced");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    // The 0-dim arrays are reduced as arrays with a single item in a single axis
+    int8_t ndim = array->ndim > 0 ? array->ndim : 1;
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t chunkshape[CATERVA_MAX_DIM];
+    bool reduced[CATERVA_MAX_DIM];
+    int8_t out_axis[CATERVA_MAX_DIM];
+    int64_t count = 1;
+    caterva_params_t params;
+    params.ndim = 0;
+    for (int i = 0; i < ndim; ++i) {
+        shape[i] = array->ndim > 0 ? array->shape[i] : 1;
+        chunkshape[i] = array->ndim > 0 ? array->chunkshape[i] : 1;
+        reduced[i] = array->ndim > 0 && (axes == NULL || axes[i]);
+        out_axis[i] = params.ndim;
+        if (reduced[i]) {
+            count *= shape[i];
+        } else if (array->ndim > 0) {
+            params.shape[params.ndim++] = shape[i];
+        }
+    }
+    if (count == 0 && op != CATERVA_REDUCE_SUM) {
+        DEBUG_PRINT("The minimum, maximum and mean of an empty axis are not defined");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    acc_kind_t kind = get_acc_kind(dtype, op);
+    caterva_dtype_t out_dtype = get_out_dtype(dtype, op);
+    params.itemsize = get_dtype_itemsize(out_dtype);
+
+    CATERVA_ERROR(caterva_empty(ctx, &params, storage, out));
+    caterva_array_t *dest = *out;
+    if (dest->nitems == 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    // The output chunks are reduced (and appended) in row-major order
+    int8_t out_ndim = dest->ndim > 0 ? dest->ndim : 1;
+    int64_t out_shape[CATERVA_MAX_DIM];
+    int64_t out_chunkshape[CATERVA_MAX_DIM];
+    int64_t out_grid[CATERVA_MAX_DIM];
+    int64_t out_nchunks = 1;
+    for (int i = 0; i < out_ndim; ++i) {
+        out_shape[i] = dest->ndim > 0 ? dest->shape[i] : 1;
+        out_chunkshape[i] = dest->ndim > 0 ? dest->chunkshape[i] : 1;
+        out_grid[i] = (out_shape[i] + out_chunkshape[i] - 1) / out_chunkshape[i];
+        out_nchunks *= out_grid[i];
+    }
+
+    int nthreads = ctx->cfg->nthreads;
+    if (nthreads > CATERVA_REDUCE_MAX_THREADS) {
+        nthreads = CATERVA_REDUCE_MAX_THREADS;
+    }
+    if (nthreads < 1) {
+        nthreads = 1;
+    }
+    int64_t acc_nitems = dest->chunknitems > 0 ? dest->chunknitems : 1;
+    int64_t acc_nbytes = acc_nitems * (int64_t) sizeof(double);
+    int64_t tile_nbytes = (array->chunknitems > 0 ? array->chunknitems : 1) * array->itemsize;
+    uint8_t *acc = ctx->cfg->alloc((size_t) acc_nbytes);
+    uint8_t *partials = NULL;
+    if (nthreads > 1) {
+        partials = ctx->cfg->alloc((size_t) ((nthreads - 1) * acc_nbytes));
+    }
+    uint8_t *chunk = ctx->cfg->alloc((size_t) (acc_nitems * dest->itemsize));
+    uint8_t *tile_data = ctx->cfg->alloc((size_t) tile_nbytes);
+    int rc = CATERVA_SUCCEED;
+    if (acc == NULL || chunk == NULL || tile_data == NULL || (nthreads > 1 && partials == NULL)) {
+        DEBUG_PRINT("Allocation fails");
+        rc = CATERVA_ERR_NULL_POINTER;
+    }
+
+    for (int64_t nchunk = 0; rc == CATERVA_SUCCEED && nchunk < out_nchunks; ++nchunk) {
+        int64_t out_coords[CATERVA_MAX_DIM];
+        int64_t out_start[CATERVA_MAX_DIM];
+        int64_t out_strides[CATERVA_MAX_DIM];
+        int64_t nitems = 1;
+        index_unidim_to_multidim(out_ndim, out_grid, nchunk, out_coords);
+        for (int i = out_ndim - 1; i >= 0; --i) {
+            out_start[i] = out_coords[i] * out_chunkshape[i];
+            int64_t extent = out_shape[i] - out_start[i];
+            extent = extent < out_chunkshape[i] ? extent : out_chunkshape[i];
+            out_strides[i] = nitems;
+            nitems *= extent;
+        }
+        init_acc(kind, op, acc, nitems);
+        for (int i = 1; i < nthreads; ++i) {
+            init_acc(kind, op, partials + (i - 1) * acc_nbytes, nitems);
+        }
+
+        // The region of the array reduced into the output chunk, read in tiles of a chunk at most
+        int64_t region_start[CATERVA_MAX_DIM];
+        int64_t region_stop[CATERVA_MAX_DIM];
+        int64_t tile_first[CATERVA_MAX_DIM];
+        int64_t tile_grid[CATERVA_MAX_DIM];
+        int64_t ntiles = 1;
+        for (int i = 0; i < ndim; ++i) {
+            if (reduced[i]) {
+                region_start[i] = 0;
+                region_stop[i] = shape[i];
+            } else {
+                int8_t k = array->ndim > 0 ? out_axis[i] : 0;
+                region_start[i] = out_start[k];
+                region_stop[i] = out_start[k] + out_chunkshape[k];
+                region_stop[i] = region_stop[i] < shape[i] ? region_stop[i] : shape[i];
+            }
+            if (region_stop[i] <= region_start[i]) {
+                ntiles = 0;
+                break;
+            }
+            tile_first[i] = region_start[i] / chunkshape[i];
+            tile_grid[i] = (region_stop[i] + chunkshape[i] - 1) / chunkshape[i] - tile_first[i];
+            ntiles *= tile_grid[i];
+        }
+
+        for (int64_t ntile = 0; ntile < ntiles; ++ntile) {
+            int64_t tile_coords[CATERVA_MAX_DIM];
+            int64_t start[CATERVA_MAX_DIM];
+            int64_t stop[CATERVA_MAX_DIM];
+            tile_t tile;
+            index_unidim_to_multidim(ndim, tile_grid, ntile, tile_coords);
+            tile.data = tile_data;
+            tile.dtype = dtype;
+            tile.op = op;
+            tile.ndim = ndim;
+            tile.acc_offset = 0;
+            tile.nrows = 1;
+            for (int i = 0; i < ndim; ++i) {
+                start[i] = (tile_first[i] + tile_coords[i]) * chunkshape[i];
+                stop[i] = start[i] + chunkshape[i];
+                start[i] = start[i] > region_start[i] ? start[i] : region_start[i];
+                stop[i] = stop[i] < region_stop[i] ? stop[i] : region_stop[i];
+                tile.shape[i] = stop[i] - start[i];
+                if (reduced[i]) {
+                    tile.acc_strides[i] = 0;
+                } else {
+                    int8_t k = array->ndim > 0 ? out_axis[i] : 0;
+                    tile.acc_strides[i] = out_strides[k];
+                    tile.acc_offset += (start[i] - out_start[k]) * out_strides[k];
+                }
+                if (i < ndim - 1) {
+                    tile.nrows *= tile.shape[i];
+                }
+            }
+            tile.rowlen = tile.shape[ndim - 1];
+            tile.last_kept = !reduced[ndim - 1];
+
+            rc = caterva_get_slice_buffer(ctx, array, start, stop, tile.shape, tile_data,
+                                          tile_nbytes);
+            if (rc != CATERVA_SUCCEED) {
+                break;
+            }
+            reduce_tile(&tile, acc, partials, acc_nbytes, nthreads);
+        }
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+
+        for (int i = 1; i < nthreads; ++i) {
+            combine_acc(kind, op, acc, partials + (i - 1) * acc_nbytes, nitems);
+        }
+        store_acc(kind, op, out_dtype, acc, nitems, count, chunk);
+        rc = caterva_append(ctx, dest, chunk, nitems * dest->itemsize);
+    }
+
+    if (acc != NULL) {
+        ctx->cfg->free(acc);
+    }
+    if (partials != NULL) {
+        ctx->cfg->free(partials);
+    }
+    if (chunk != NULL) {
+        ctx->cfg->free(chunk);
+    }
+    if (tile_data != NULL) {
+        ctx->cfg->free(tile_data);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        caterva_free(ctx, out);
+        CATERVA_ERROR(rc);
+    }
+
+    return CATERVA_SUCCEED;
+}
@@ -0,0 +1,19 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#ifndef CATERVA_CATERVA_REDUCE_H_
+#define CATERVA_CATERVA_REDUCE_H_
+
+int caterva_reduce_array(caterva_ctx_t *ctx, caterva_array_t *array, caterva_dtype_t dtype,
+                         caterva_reduce_op_t op, bool *axes, caterva_storage_t *storage,
+                         caterva_array_t **out);
+
+#endif  // CATERVA_CATERVA_REDUCE_H_
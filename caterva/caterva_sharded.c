@@ -0,0 +1,817 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#include "caterva_blosc.h"
+#include "caterva_sharded.h"
+#include "caterva_verify.h"
+
+// The manifest of a sharded array holds a magic string, the format version, the number of
+// dimensions, the itemsize, the kind of frame of the shards, the number of chunks along the
+// first dimension of each shard and the shape, the chunkshape and the blockshape (as
+// little-endian integers)
+#define CATERVA_SHARDED_MAGIC "CATSHRD"
+#define CATERVA_SHARDED_MAGIC_LEN 8
+#define CATERVA_SHARDED_VERSION 0
+#define CATERVA_SHARDED_NCHUNKS_OFFSET 12
+#define CATERVA_SHARDED_SHAPE_OFFSET 16
+#define CATERVA_SHARDED_CHUNKSHAPE_OFFSET 80
+#define CATERVA_SHARDED_BLOCKSHAPE_OFFSET 112
+#define CATERVA_SHARDED_MANIFEST_LEN 144
+
+static void store_le(uint8_t *dest, int64_t value, int nbytes) {
+    for (int i = 0; i < nbytes; ++i) {
+        dest[i] = (uint8_t) ((uint64_t) value >> (8 * i));
+    }
+}
+
+static int64_t load_le(const uint8_t *src, int nbytes) {
+    uint64_t value = 0;
+    for (int i = nbytes - 1; i >= 0; --i) {
+        value = (value << 8) | src[i];
+    }
+    return (int64_t) value;
+}
+
+// Number of items along the first dimension stored in each shard
+static int64_t get_shard_len(caterva_array_t *array) {
+    return (int64_t) array->shard_nchunks * array->chunkshape[0];
+}
+
+static int64_t get_nshards(caterva_array_t *array, const int64_t *shape) {
+    // Arrays without dimensions are stored in a single shard
+    if (array->ndim == 0) {
+        return 1;
+    }
+    int64_t len = get_shard_len(array);
+    if (len == 0) {
+        return 0;
+    }
+    return (shape[0] + len - 1) / len;
+}
+
+// Get the shape of a shard of an array with a shape and the index of its first item along the
+// first dimension
+static void get_shard_shape(caterva_array_t *array, const int64_t *shape, int64_t nshard,
+                            int64_t *shard_shape, int64_t *offset) {
+    for (int i = 0; i < array->ndim; ++i) {
+        shard_shape[i] = shape[i];
+    }
+    *offset = 0;
+    if (array->ndim > 0) {
+        int64_t len = get_shard_len(array);
+        *offset = nshard * len;
+        shard_shape[0] = shape[0] - *offset < len ? shape[0] - *offset : len;
+    }
+}
+
+// Number of items of a buffer with a shape in each index of its first dimension
+static int64_t get_row_nitems(caterva_array_t *array, const int64_t *shape) {
+    int64_t nitems = 1;
+    for (int i = 1; i < array->ndim; ++i) {
+        nitems *= shape[i];
+    }
+    return nitems;
+}
+
+static char *get_shard_urlpath(caterva_ctx_t *ctx, const char *urlpath, int64_t nshard) {
+    size_t len = strlen(urlpath) + 24;
+    char *shard_urlpath = ctx->cfg->alloc(len);
+    if (shard_urlpath != NULL) {
+        snprintf(shard_urlpath, len, "%s.%lld", urlpath, (long long) nshard);
+    }
+    return shard_urlpath;
+}
+
+// An operation on a shard of an array
+typedef int (*shard_op_t)(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nshard,
+                          void *arg);
+
+#if !defined(_WIN32)
+// A pool of threads running an operation on a range of shards, each one taking the next shard
+// not handled yet until they are all handled (or an operation fails)
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *array;
+    shard_op_t op;
+    void *arg;
+    int64_t next;
+    int64_t stop;
+    int rc;
+    pthread_mutex_t mutex;
+} shard_pool_t;
+
+static void *shard_pool_run(void *arg) {
+    shard_pool_t *pool = arg;
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->next < pool->stop && pool->rc == CATERVA_SUCCEED) {
+        int64_t nshard = pool->next++;
+        pthread_mutex_unlock(&pool->mutex);
+        int rc = pool->op(pool->ctx, pool->array, nshard, pool->arg);
+        pthread_mutex_lock(&pool->mutex);
+        if (rc != CATERVA_SUCCEED && pool->rc == CATERVA_SUCCEED) {
+            pool->rc = rc;
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+#endif
+
+// Run an operation on the shards from start to stop (excluded), spread over the threads of the
+// context. The shards are independent arrays, so each one is only handled by a thread.
+static int for_each_shard(caterva_ctx_t *ctx, caterva_array_t *array, int64_t start,
+                          int64_t stop, shard_op_t op, void *arg) {
+#if !defined(_WIN32)
+    int64_t nthreads = ctx->cfg->nthreads < stop - start ? ctx->cfg->nthreads : stop - start;
+    pthread_t *threads = NULL;
+    if (nthreads > 1) {
+        threads = ctx->cfg->alloc((size_t) (nthreads - 1) * sizeof(pthread_t));
+    }
+    if (threads != NULL) {
+        shard_pool_t pool;
+        pool.ctx = ctx;
+        pool.array = array;
+        pool.op = op;
+        pool.arg = arg;
+        pool.next = start;
+        pool.stop = stop;
+        pool.rc = CATERVA_SUCCEED;
+        pthread_mutex_init(&pool.mutex, NULL);
+        int64_t nstarted = 0;
+        while (nstarted < nthreads - 1 &&
+               pthread_create(&threads[nstarted], NULL, shard_pool_run, &pool) == 0) {
+            nstarted++;
+        }
+        // The calling thread takes shards too (all of them if no thread could be started)
+        shard_pool_run(&pool);
+        for (int64_t i = 0; i < nstarted; ++i) {
+            pthread_join(threads[i], NULL);
+        }
+        pthread_mutex_destroy(&pool.mutex);
+        ctx->cfg->free(threads);
+        CATERVA_ERROR(pool.rc);
+        return CATERVA_SUCCEED;
+    }
+#endif
+    for (int64_t i = start; i < stop; ++i) {
+        CATERVA_ERROR(op(ctx, array, i, arg));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Write the current geometry of a sharded array in its manifest
+static int write_manifest(caterva_array_t *array) {
+    if (array->shard_urlpath == NULL) {
+        return CATERVA_SUCCEED;
+    }
+    uint8_t manifest[CATERVA_SHARDED_MANIFEST_LEN] = {0};
+    memcpy(manifest, CATERVA_SHARDED_MAGIC, CATERVA_SHARDED_MAGIC_LEN);
+    manifest[CATERVA_SHARDED_MAGIC_LEN] = CATERVA_SHARDED_VERSION;
+    manifest[CATERVA_SHARDED_MAGIC_LEN + 1] = (uint8_t) array->ndim;
+    manifest[CATERVA_SHARDED_MAGIC_LEN + 2] = (uint8_t) array->itemsize;
+    manifest[CATERVA_SHARDED_MAGIC_LEN + 3] = array->shard_sequencial;
+    store_le(&manifest[CATERVA_SHARDED_NCHUNKS_OFFSET], array->shard_nchunks, 4);
+    for (int i = 0; i < array->ndim; ++i) {
+        store_le(&manifest[CATERVA_SHARDED_SHAPE_OFFSET + 8 * i], array->shape[i], 8);
+        store_le(&manifest[CATERVA_SHARDED_CHUNKSHAPE_OFFSET + 4 * i], array->chunkshape[i], 4);
+        store_le(&manifest[CATERVA_SHARDED_BLOCKSHAPE_OFFSET + 4 * i], array->blockshape[i], 4);
+    }
+
+    FILE *fp = fopen(array->shard_urlpath, "wb");
+    if (fp == NULL) {
+        DEBUG_PRINT("Can not open the manifest of the shards");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    size_t len = fwrite(manifest, 1, CATERVA_SHARDED_MANIFEST_LEN, fp);
+    if (fclose(fp) != 0 || len != CATERVA_SHARDED_MANIFEST_LEN) {
+        DEBUG_PRINT("Can not write the manifest of the shards");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Read the manifest of a file, returning false if it does not store a sharded array
+static bool read_manifest(const char *urlpath, uint8_t *manifest) {
+    FILE *fp = fopen(urlpath, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    size_t len = fread(manifest, 1, CATERVA_SHARDED_MANIFEST_LEN, fp);
+    fclose(fp);
+
+    return len == CATERVA_SHARDED_MANIFEST_LEN &&
+           memcmp(manifest, CATERVA_SHARDED_MAGIC, CATERVA_SHARDED_MAGIC_LEN) == 0;
+}
+
+// Create an empty shard with the shape it has in an array
+static int create_shard(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nshard,
+                        caterva_array_t **shard) {
+    caterva_params_t params;
+    params.itemsize = array->itemsize;
+    params.ndim = array->ndim;
+    int64_t offset;
+    get_shard_shape(array, array->shape, nshard, params.shape, &offset);
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.sequencial = array->shard_sequencial;
+    for (int i = 0; i < array->ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = array->chunkshape[i];
+        storage.properties.blosc.blockshape[i] = array->blockshape[i];
+    }
+    if (array->shard_urlpath != NULL) {
+        storage.properties.blosc.urlpath = get_shard_urlpath(ctx, array->shard_urlpath, nshard);
+        CATERVA_ERROR_NULL(storage.properties.blosc.urlpath);
+    }
+    int rc = caterva_empty(ctx, &params, &storage, shard);
+    if (storage.properties.blosc.urlpath != NULL) {
+        ctx->cfg->free(storage.properties.blosc.urlpath);
+    }
+    CATERVA_ERROR(rc);
+    (*shard)->advice = array->advice;
+
+    return CATERVA_SUCCEED;
+}
+
+// Number of chunks stored in each shard
+static int64_t get_shard_nchunks(caterva_array_t *array) {
+    if (array->ndim == 0) {
+        return 1;
+    }
+    int64_t nchunks = array->shard_nchunks;
+    for (int i = 1; i < array->ndim; ++i) {
+        nchunks *= array->extshape[i] / array->chunkshape[i];
+    }
+    return nchunks;
+}
+
+// Take the shape of the next chunk to be appended from the shard where it is stored
+static void update_next_chunkshape(caterva_array_t *array, int64_t nchunk) {
+    int64_t nshard = nchunk / get_shard_nchunks(array);
+    if (nshard >= array->nshards) {
+        return;
+    }
+    caterva_array_t *shard = array->shards[nshard];
+    for (int i = 0; i < CATERVA_MAX_DIM; ++i) {
+        array->next_chunkshape[i] = shard->next_chunkshape[i];
+    }
+    array->next_chunknitems = shard->next_chunknitems;
+}
+
+// Update the number of chunks and the state of a sharded array from its shards
+static void update_state(caterva_array_t *array) {
+    array->nchunks = 0;
+    array->filled = true;
+    for (int64_t i = 0; i < array->nshards; ++i) {
+        array->nchunks += array->shards[i]->nchunks;
+        if (!array->shards[i]->filled) {
+            array->filled = false;
+        }
+    }
+    array->empty = !array->filled && array->nchunks == 0;
+    if (!array->filled) {
+        update_next_chunkshape(array, array->nchunks);
+    }
+}
+
+static int create_array(caterva_ctx_t *ctx, caterva_params_t *params,
+                        caterva_storage_properties_sharded_t *properties,
+                        caterva_array_t **array) {
+    if (properties->shard_nchunks <= 0) {
+        DEBUG_PRINT("The number of chunks of each shard must be positive");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    (*array) = (caterva_array_t *) ctx->cfg->alloc(sizeof(caterva_array_t));
+    CATERVA_ERROR_NULL(*array);
+    memset(*array, 0, sizeof(caterva_array_t));
+    (*array)->storage = CATERVA_STORAGE_SHARDED;
+    (*array)->itemsize = params->itemsize;
+    caterva_blosc_update_geometry(*array, params->ndim, params->shape, properties->chunkshape,
+                                  properties->blockshape);
+
+    // The caches are kept by the shards
+    (*array)->chunk_cache.nchunk = -1;
+    for (int i = 0; i < CATERVA_WRITE_CACHE_NCHUNKS; ++i) {
+        (*array)->write_cache[i].nchunk = -1;
+    }
+
+    (*array)->shard_nchunks = properties->shard_nchunks;
+    (*array)->shard_sequencial = properties->sequencial;
+    if (properties->urlpath != NULL) {
+        (*array)->shard_urlpath = ctx->cfg->alloc(strlen(properties->urlpath) + 1);
+        CATERVA_ERROR_NULL((*array)->shard_urlpath);
+        strcpy((*array)->shard_urlpath, properties->urlpath);
+    }
+    (*array)->nshards = get_nshards(*array, (*array)->shape);
+    if ((*array)->nshards > 0) {
+        size_t size = (size_t) (*array)->nshards * sizeof(caterva_array_t *);
+        (*array)->shards = ctx->cfg->alloc(size);
+        CATERVA_ERROR_NULL((*array)->shards);
+        memset((*array)->shards, 0, size);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
+                                caterva_storage_t *storage, caterva_array_t **array) {
+    CATERVA_ERROR(create_array(ctx, params, &storage->properties.sharded, array));
+
+    for (int64_t i = 0; i < (*array)->nshards; ++i) {
+        CATERVA_ERROR(create_shard(ctx, *array, i, &(*array)->shards[i]));
+    }
+    if ((*array)->nitems != 0) {
+        update_next_chunkshape(*array, 0);
+    }
+    CATERVA_ERROR(write_manifest(*array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_free(caterva_ctx_t *ctx, caterva_array_t **array) {
+    if ((*array)->shards != NULL) {
+        for (int64_t i = 0; i < (*array)->nshards; ++i) {
+            if ((*array)->shards[i] != NULL) {
+                caterva_free(ctx, &(*array)->shards[i]);
+            }
+        }
+        ctx->cfg->free((*array)->shards);
+    }
+    if ((*array)->shard_urlpath != NULL) {
+        ctx->cfg->free((*array)->shard_urlpath);
+    }
+    return CATERVA_SUCCEED;
+}
+
+bool caterva_sharded_is_file(const char *urlpath) {
+    uint8_t manifest[CATERVA_SHARDED_MANIFEST_LEN];
+    return read_manifest(urlpath, manifest);
+}
+
+int caterva_sharded_open(caterva_ctx_t *ctx, const char *urlpath,
+                         int (*open_shard)(caterva_ctx_t *, const char *, caterva_array_t **),
+                         caterva_array_t **array) {
+    uint8_t manifest[CATERVA_SHARDED_MANIFEST_LEN];
+    if (!read_manifest(urlpath, manifest)) {
+        DEBUG_PRINT("The file is not the manifest of a sharded array");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (manifest[CATERVA_SHARDED_MAGIC_LEN] > CATERVA_SHARDED_VERSION) {
+        DEBUG_PRINT("Unsupported version of the manifest of the shards");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    caterva_params_t params;
+    params.ndim = (int8_t) manifest[CATERVA_SHARDED_MAGIC_LEN + 1];
+    params.itemsize = manifest[CATERVA_SHARDED_MAGIC_LEN + 2];
+    if (params.ndim > CATERVA_MAX_DIM) {
+        DEBUG_PRINT("The number of dimensions of the manifest of the shards is not valid");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    caterva_storage_properties_sharded_t properties = {0};
+    properties.sequencial = manifest[CATERVA_SHARDED_MAGIC_LEN + 3];
+    properties.shard_nchunks = (int32_t) load_le(&manifest[CATERVA_SHARDED_NCHUNKS_OFFSET], 4);
+    properties.urlpath = (char *) urlpath;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = load_le(&manifest[CATERVA_SHARDED_SHAPE_OFFSET + 8 * i], 8);
+        properties.chunkshape[i] =
+            (int32_t) load_le(&manifest[CATERVA_SHARDED_CHUNKSHAPE_OFFSET + 4 * i], 4);
+        properties.blockshape[i] =
+            (int32_t) load_le(&manifest[CATERVA_SHARDED_BLOCKSHAPE_OFFSET + 4 * i], 4);
+    }
+    CATERVA_ERROR(create_array(ctx, &params, &properties, array));
+
+    int rc = CATERVA_SUCCEED;
+    for (int64_t i = 0; i < (*array)->nshards && rc == CATERVA_SUCCEED; ++i) {
+        char *shard_urlpath = get_shard_urlpath(ctx, urlpath, i);
+        if (shard_urlpath == NULL) {
+            rc = CATERVA_ERR_NULL_POINTER;
+            break;
+        }
+        rc = open_shard(ctx, shard_urlpath, &(*array)->shards[i]);
+        ctx->cfg->free(shard_urlpath);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        // Every shard must have the shape it has in the array
+        caterva_array_t *shard = (*array)->shards[i];
+        int64_t shard_shape[CATERVA_MAX_DIM];
+        int64_t offset;
+        get_shard_shape(*array, (*array)->shape, i, shard_shape, &offset);
+        if (shard->storage != CATERVA_STORAGE_BLOSC || shard->ndim != params.ndim ||
+            shard->itemsize != params.itemsize) {
+            rc = CATERVA_ERR_INVALID_STORAGE;
+        }
+        for (int j = 0; j < params.ndim && rc == CATERVA_SUCCEED; ++j) {
+            if (shard->shape[j] != shard_shape[j]) {
+                rc = CATERVA_ERR_INVALID_STORAGE;
+            }
+        }
+        if (rc != CATERVA_SUCCEED) {
+            DEBUG_PRINT("The shape of a shard does not match the manifest");
+        }
+    }
+    if (rc != CATERVA_SUCCEED) {
+        caterva_sharded_array_free(ctx, array);
+        ctx->cfg->free(*array);
+        *array = NULL;
+        return rc;
+    }
+    update_state(*array);
+    for (int64_t i = 0; i < (*array)->nshards; ++i) {
+        if ((*array)->shards[i]->readonly) {
+            (*array)->readonly = true;
+        }
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+static int flush_shard(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nshard, void *arg) {
+    CATERVA_UNUSED_PARAM(arg);
+    CATERVA_ERROR(caterva_flush(ctx, array->shards[nshard]));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_flush(caterva_ctx_t *ctx, caterva_array_t *array) {
+    CATERVA_ERROR(for_each_shard(ctx, array, 0, array->nshards, flush_shard, NULL));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_compact(caterva_ctx_t *ctx, caterva_array_t *array, bool recompress) {
+    for (int64_t i = 0; i < array->nshards; ++i) {
+        CATERVA_ERROR(caterva_compact(ctx, array->shards[i], recompress));
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_append(caterva_ctx_t *ctx, caterva_array_t *array, void *chunk,
+                                 int64_t chunksize) {
+    // The chunks are appended in row-major order, so every shard is completed before the next
+    int64_t nshard = array->nchunks / get_shard_nchunks(array);
+    CATERVA_ERROR(caterva_append(ctx, array->shards[nshard], chunk, chunksize));
+    update_next_chunkshape(array, array->nchunks + 1);
+
+    return CATERVA_SUCCEED;
+}
+
+// Get the rows of a buffer with the shape of an array stored in a shard
+static uint8_t *get_shard_rows(caterva_array_t *array, int64_t nshard, uint8_t *buffer) {
+    int64_t shard_shape[CATERVA_MAX_DIM];
+    int64_t offset;
+    get_shard_shape(array, array->shape, nshard, shard_shape, &offset);
+    return &buffer[offset * get_row_nitems(array, array->shape) * array->itemsize];
+}
+
+static int from_buffer_shard(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nshard,
+                             void *arg) {
+    caterva_array_t *shard = array->shards[nshard];
+    CATERVA_ERROR(caterva_blosc_array_from_buffer(ctx, shard, get_shard_rows(array, nshard, arg),
+                                                  shard->nitems * shard->itemsize));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_from_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer,
+                                      int64_t buffersize) {
+    CATERVA_UNUSED_PARAM(buffersize);
+
+    // The items of each shard are contiguous in the buffer
+    CATERVA_ERROR(for_each_shard(ctx, array, 0, array->nshards, from_buffer_shard, buffer));
+    update_state(array);
+
+    return CATERVA_SUCCEED;
+}
+
+static int full_shard(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nshard, void *arg) {
+    CATERVA_ERROR(caterva_blosc_array_full(ctx, array->shards[nshard], arg));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_full(caterva_ctx_t *ctx, caterva_array_t *array, void *fill_value) {
+    CATERVA_ERROR(for_each_shard(ctx, array, 0, array->nshards, full_shard, fill_value));
+    update_state(array);
+
+    return CATERVA_SUCCEED;
+}
+
+static int to_buffer_shard(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nshard,
+                           void *arg) {
+    caterva_array_t *shard = array->shards[nshard];
+    CATERVA_ERROR(caterva_to_buffer(ctx, shard, get_shard_rows(array, nshard, arg),
+                                    shard->nitems * shard->itemsize));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer) {
+    CATERVA_ERROR(for_each_shard(ctx, array, 0, array->nshards, to_buffer_shard, buffer));
+
+    return CATERVA_SUCCEED;
+}
+
+// A slice of a sharded array read or written through a buffer
+typedef struct {
+    int64_t *start;
+    int64_t *stop;
+    int64_t *shape;
+    uint8_t *buffer;
+    int64_t row_nbytes;
+} shard_slice_t;
+
+// Get the part of a slice in the range of the first dimension stored in a shard, and the index
+// of its first row in the slice
+static int64_t get_shard_slice(caterva_array_t *array, shard_slice_t *slice, int64_t nshard,
+                               int64_t *shard_start, int64_t *shard_stop) {
+    int64_t len = get_shard_len(array);
+    int64_t offset = nshard * len;
+    for (int j = 0; j < array->ndim; ++j) {
+        shard_start[j] = slice->start[j];
+        shard_stop[j] = slice->stop[j];
+    }
+    int64_t first = slice->start[0] > offset ? slice->start[0] : offset;
+    int64_t last = slice->stop[0] < offset + len ? slice->stop[0] : offset + len;
+    shard_start[0] = first - offset;
+    shard_stop[0] = last - offset;
+    return first - slice->start[0];
+}
+
+// Get the range of shards holding the rows of a slice
+static void get_slice_shards(caterva_array_t *array, shard_slice_t *slice, int64_t *first,
+                             int64_t *last) {
+    int64_t len = get_shard_len(array);
+    *first = slice->start[0] / len;
+    *last = (slice->stop[0] + len - 1) / len;
+    if (*last > array->nshards) {
+        *last = array->nshards;
+    }
+}
+
+static int get_slice_buffer_shard(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nshard,
+                                  void *arg) {
+    shard_slice_t *slice = arg;
+    int64_t shard_start[CATERVA_MAX_DIM];
+    int64_t shard_stop[CATERVA_MAX_DIM];
+    int64_t shard_shape[CATERVA_MAX_DIM];
+    int64_t row = get_shard_slice(array, slice, nshard, shard_start, shard_stop);
+    for (int j = 0; j < array->ndim; ++j) {
+        shard_shape[j] = slice->shape[j];
+    }
+    shard_shape[0] = slice->shape[0] - row;
+    CATERVA_ERROR(caterva_get_slice_buffer(ctx, array->shards[nshard], shard_start, shard_stop,
+                                           shard_shape, &slice->buffer[row * slice->row_nbytes],
+                                           shard_shape[0] * slice->row_nbytes));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
+                                           int64_t *start, int64_t *stop, int64_t *shape,
+                                           void *buffer) {
+    if (array->ndim == 0) {
+        CATERVA_ERROR(caterva_get_slice_buffer(ctx, array->shards[0], start, stop, shape, buffer,
+                                               array->itemsize));
+        return CATERVA_SUCCEED;
+    }
+
+    // Every shard fills the rows of the buffer in its range of the first dimension
+    shard_slice_t slice = {start, stop, shape, buffer,
+                           get_row_nitems(array, shape) * array->itemsize};
+    int64_t first;
+    int64_t last;
+    get_slice_shards(array, &slice, &first, &last);
+    CATERVA_ERROR(for_each_shard(ctx, array, first, last, get_slice_buffer_shard, &slice));
+
+    return CATERVA_SUCCEED;
+}
+
+static int set_slice_buffer_shard(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nshard,
+                                  void *arg) {
+    shard_slice_t *slice = arg;
+    int64_t shard_start[CATERVA_MAX_DIM];
+    int64_t shard_stop[CATERVA_MAX_DIM];
+    int64_t row = get_shard_slice(array, slice, nshard, shard_start, shard_stop);
+    CATERVA_ERROR(caterva_set_slice_buffer(ctx, &slice->buffer[row * slice->row_nbytes],
+                                           (shard_stop[0] - shard_start[0]) * slice->row_nbytes,
+                                           shard_start, shard_stop, array->shards[nshard]));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_set_slice_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersize,
+                                           int64_t *start, int64_t *stop,
+                                           caterva_array_t *array) {
+    if (array->ndim == 0) {
+        CATERVA_ERROR(caterva_set_slice_buffer(ctx, buffer, buffersize, start, stop,
+                                               array->shards[0]));
+        return CATERVA_SUCCEED;
+    }
+
+    // Every shard is updated with the rows of the buffer in its range of the first dimension
+    shard_slice_t slice = {start, stop, NULL, buffer, array->itemsize};
+    for (int j = 1; j < array->ndim; ++j) {
+        slice.row_nbytes *= stop[j] - start[j];
+    }
+    int64_t first;
+    int64_t last;
+    get_slice_shards(array, &slice, &first, &last);
+    CATERVA_ERROR(for_each_shard(ctx, array, first, last, set_slice_buffer_shard, &slice));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_get_slice(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *start,
+                                    int64_t *stop, caterva_array_t *array) {
+    // The shards are filled one by one, so only a shard is kept decompressed at a time
+    for (int64_t i = 0; i < array->nshards; ++i) {
+        caterva_array_t *shard = array->shards[i];
+        int64_t shard_shape[CATERVA_MAX_DIM];
+        int64_t offset;
+        get_shard_shape(array, array->shape, i, shard_shape, &offset);
+        int64_t src_start[CATERVA_MAX_DIM];
+        int64_t src_stop[CATERVA_MAX_DIM];
+        for (int j = 0; j < array->ndim; ++j) {
+            src_start[j] = start[j];
+            src_stop[j] = stop[j];
+        }
+        if (array->ndim > 0) {
+            src_start[0] = start[0] + offset;
+            src_stop[0] = src_start[0] + shard_shape[0];
+        }
+
+        int64_t size = shard->nitems * shard->itemsize;
+        uint8_t *buffer = ctx->cfg->alloc((size_t) size);
+        CATERVA_ERROR_NULL(buffer);
+        int rc = caterva_get_slice_buffer(ctx, src, src_start, src_stop, shard_shape, buffer,
+                                          size);
+        if (rc == CATERVA_SUCCEED) {
+            rc = caterva_blosc_array_from_buffer(ctx, shard, buffer, size);
+        }
+        ctx->cfg->free(buffer);
+        CATERVA_ERROR(rc);
+    }
+    update_state(array);
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_squeeze_index(caterva_ctx_t *ctx, caterva_array_t *array,
+                                        bool *index) {
+    if (array->ndim > 0 && index[0]) {
+        DEBUG_PRINT("The first dimension of a sharded array can not be squeezed");
+        return CATERVA_ERR_INVALID_INDEX;
+    }
+
+    int8_t nones = 0;
+    int64_t newshape[CATERVA_MAX_DIM];
+    int32_t newchunkshape[CATERVA_MAX_DIM];
+    int32_t newblockshape[CATERVA_MAX_DIM];
+    for (int i = 0; i < array->ndim; ++i) {
+        if (index[i]) {
+            if (array->shape[i] != 1) {
+                CATERVA_ERROR(CATERVA_ERR_INVALID_INDEX);
+            }
+        } else {
+            newshape[nones] = array->shape[i];
+            newchunkshape[nones] = array->chunkshape[i];
+            newblockshape[nones] = array->blockshape[i];
+            nones += 1;
+        }
+    }
+
+    for (int64_t i = 0; i < array->nshards; ++i) {
+        CATERVA_ERROR(caterva_squeeze_index(ctx, array->shards[i], index));
+    }
+    caterva_blosc_update_geometry(array, nones, newshape, newchunkshape, newblockshape);
+    CATERVA_ERROR(write_manifest(array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_squeeze(caterva_ctx_t *ctx, caterva_array_t *array) {
+    // The first dimension is kept, as the shards are slabs along it
+    bool index[CATERVA_MAX_DIM];
+    for (int i = 0; i < array->ndim; ++i) {
+        index[i] = (i > 0 && array->shape[i] == 1);
+    }
+    CATERVA_ERROR(caterva_sharded_array_squeeze_index(ctx, array, index));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_resize(caterva_ctx_t *ctx, caterva_array_t *array,
+                                 int64_t *new_shape) {
+    if (array->ndim > 0 && new_shape[0] != 0 && get_shard_len(array) == 0) {
+        DEBUG_PRINT("A dimension with a null chunkshape can not be resized");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+    if (!array->filled && array->nchunks != 0) {
+        DEBUG_PRINT("Only completely filled arrays can be resized");
+        return CATERVA_ERR_INVALID_ARGUMENT;
+    }
+
+    // Every shard kept is checked before any of them is modified, so an array that can not be
+    // resized is left as it was
+    int64_t nshards = get_nshards(array, new_shape);
+    int64_t nkept = nshards < array->nshards ? nshards : array->nshards;
+    for (int64_t i = 0; i < nkept; ++i) {
+        caterva_array_t *shard = array->shards[i];
+        CATERVA_ERROR(caterva_blosc_array_load(ctx, shard));
+        if (shard->readonly) {
+            CATERVA_ERROR(CATERVA_ERR_READ_ONLY);
+        }
+        int64_t shard_shape[CATERVA_MAX_DIM];
+        int64_t offset;
+        get_shard_shape(array, new_shape, i, shard_shape, &offset);
+        CATERVA_ERROR(caterva_verify_drop_checksums(shard));
+        CATERVA_ERROR(caterva_blosc_array_resize_check(shard, shard_shape));
+    }
+
+    caterva_array_t **shards = NULL;
+    if (nshards > 0) {
+        size_t size = (size_t) nshards * sizeof(caterva_array_t *);
+        shards = ctx->cfg->alloc(size);
+        CATERVA_ERROR_NULL(shards);
+        memset(shards, 0, size);
+    }
+
+    // The shards past the new shape are removed
+    for (int64_t i = nshards; i < array->nshards; ++i) {
+        caterva_free(ctx, &array->shards[i]);
+        if (array->shard_urlpath != NULL) {
+            char *shard_urlpath = get_shard_urlpath(ctx, array->shard_urlpath, i);
+            if (shard_urlpath != NULL) {
+                caterva_blosc_remove_urlpath(ctx, shard_urlpath);
+                ctx->cfg->free(shard_urlpath);
+            }
+        }
+    }
+    // The shards kept are resized to their new shape
+    for (int64_t i = 0; i < nkept; ++i) {
+        shards[i] = array->shards[i];
+    }
+    if (array->shards != NULL) {
+        ctx->cfg->free(array->shards);
+    }
+    array->shards = shards;
+    array->nshards = nshards;
+    for (int64_t i = 0; i < nkept; ++i) {
+        int64_t shard_shape[CATERVA_MAX_DIM];
+        int64_t offset;
+        get_shard_shape(array, new_shape, i, shard_shape, &offset);
+        CATERVA_ERROR(caterva_resize(ctx, array->shards[i], shard_shape));
+    }
+
+    // The new shards are filled with zeros, unless the array has no chunks yet
+    bool filled = array->filled;
+    caterva_blosc_update_geometry(array, array->ndim, new_shape, array->chunkshape,
+                                  array->blockshape);
+    for (int64_t i = nkept; i < nshards; ++i) {
+        CATERVA_ERROR(create_shard(ctx, array, i, &array->shards[i]));
+        if (filled && array->shards[i]->nitems != 0) {
+            CATERVA_ERROR(caterva_blosc_array_full(ctx, array->shards[i], NULL));
+        }
+    }
+    update_state(array);
+    CATERVA_ERROR(write_manifest(array));
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_sharded_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
+                               caterva_storage_t *storage, caterva_array_t *src,
+                               caterva_array_t **dest) {
+    CATERVA_ERROR(caterva_empty(ctx, params, storage, dest));
+    if ((*dest)->nitems == 0) {
+        return CATERVA_SUCCEED;
+    }
+
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM];
+    for (int i = 0; i < src->ndim; ++i) {
+        stop[i] = src->shape[i];
+    }
+    CATERVA_ERROR(caterva_sharded_array_get_slice(ctx, src, start, stop, *dest));
+
+    return CATERVA_SUCCEED;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#ifndef CATERVA_CATERVA_SHARDED_H_
+#define CATERVA_CATERVA_SHARDED_H_
+
+int caterva_sharded_array_empty(caterva_ctx_t *ctx, caterva_params_t *params,
+                                caterva_storage_t *storage, caterva_array_t **array);
+
+int caterva_sharded_array_free(caterva_ctx_t *ctx, caterva_array_t **array);
+
+bool caterva_sharded_is_file(const char *urlpath);
+
+int caterva_sharded_open(caterva_ctx_t *ctx, const char *urlpath,
+                         int (*open_shard)(caterva_ctx_t *, const char *, caterva_array_t **),
+                         caterva_array_t **array);
+
+int caterva_sharded_array_flush(caterva_ctx_t *ctx, caterva_array_t *array);
+
+int caterva_sharded_array_compact(caterva_ctx_t *ctx, caterva_array_t *array, bool recompress);
+
+int caterva_sharded_array_append(caterva_ctx_t *ctx, caterva_array_t *array, void *chunk,
+                                 int64_t chunksize);
+
+int caterva_sharded_array_from_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer,
+                                      int64_t buffersize);
+
+int caterva_sharded_array_full(caterva_ctx_t *ctx, caterva_array_t *array, void *fill_value);
+
+int caterva_sharded_array_to_buffer(caterva_ctx_t *ctx, caterva_array_t *array, void *buffer);
+
+int caterva_sharded_array_get_slice_buffer(caterva_ctx_t *ctx, caterva_array_t *array,
+                                           int64_t *start, int64_t *stop, int64_t *shape,
+                                           void *buffer);
+
+int caterva_sharded_array_set_slice_buffer(caterva_ctx_t *ctx, void *buffer, int64_t buffersize,
+                                           int64_t *start, int64_t *stop,
+                                           caterva_array_t *array);
+
+int caterva_sharded_array_get_slice(caterva_ctx_t *ctx, caterva_array_t *src, int64_t *start,
+                                    int64_t *stop, caterva_array_t *array);
+
+int caterva_sharded_array_squeeze_index(caterva_ctx_t *ctx, caterva_array_t *array,
+                                        bool *index);
+
+int caterva_sharded_array_squeeze(caterva_ctx_t *ctx, caterva_array_t *array);
+
+int caterva_sharded_array_resize(caterva_ctx_t *ctx, caterva_array_t *array,
+                                 int64_t *new_shape);
+
+int caterva_sharded_array_copy(caterva_ctx_t *ctx, caterva_params_t *params,
+                               caterva_storage_t *storage, caterva_array_t *src,
+                               caterva_array_t **dest);
+
+#endif  // CATERVA_CATERVA_SHARDED_H_
@@ -0,0 +1,554 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <caterva.h>
+
+#include "caterva_blosc.h"
+#include "caterva_stream.h"
+
+// A serialized stream starts with a header holding a magic string, the format version, the
+// number of dimensions, the itemsize, the block order, the number of chunks and the shape, the
+// chunkshape and the blockshape (as little-endian integers). It is followed by the metalayers and
+// the variable-length metalayers set by the user (each group is a count and, for every layer,
+// the length of its name, the name, the length of its content and the content), the chunks of the
+// grid in row-major order (as stored by Blosc, so every chunk holds its size in its header), the
+// index with the offset of every chunk in the stream and a trailer with the offset of the index
+// and the magic string again.
+#define CATERVA_STREAM_MAGIC "CATSTRM"
+#define CATERVA_STREAM_MAGIC_LEN 8
+#define CATERVA_STREAM_VERSION 1
+#define CATERVA_STREAM_NCHUNKS_OFFSET 12
+#define CATERVA_STREAM_SHAPE_OFFSET 20
+#define CATERVA_STREAM_CHUNKSHAPE_OFFSET 84
+#define CATERVA_STREAM_BLOCKSHAPE_OFFSET 116
+#define CATERVA_STREAM_HEADER_LEN 148
+#define CATERVA_STREAM_TRAILER_LEN 16
+
+// The number of offsets of the index written at once
+#define CATERVA_STREAM_INDEX_BATCH 512
+
+// The number of bytes of the content of a layer read at once (the buffer grows as they arrive)
+#define CATERVA_STREAM_LAYER_BATCH (64 * 1024)
+
+static void store_le(uint8_t *dest, int64_t value, int nbytes) {
+    for (int i = 0; i < nbytes; ++i) {
+        dest[i] = (uint8_t) ((uint64_t) value >> (8 * i));
+    }
+}
+
+static int64_t load_le(const uint8_t *src, int nbytes) {
+    uint64_t value = 0;
+    for (int i = nbytes - 1; i >= 0; --i) {
+        value = (value << 8) | src[i];
+    }
+    return (int64_t) value;
+}
+
+// Number of chunks in the grid of an array backed by a super-chunk
+static int64_t get_nchunks(caterva_array_t *array) {
+    if (array->chunknitems == 0) {
+        return 0;
+    }
+    return array->extnitems / array->chunknitems;
+}
+
+static int write_bytes(caterva_write_cb_t write_cb, void *userdata, const void *data,
+                       int64_t size, int64_t *offset) {
+    if (size > 0 && write_cb(data, size, userdata) != size) {
+        DEBUG_PRINT("Error writing the serialized array");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    *offset += size;
+    return CATERVA_SUCCEED;
+}
+
+// Check whether a layer of metadata is set by caterva itself (these are not serialized, as they
+// are written again by the array created when the stream is read)
+static bool is_caterva_layer(const char *name) {
+    return strncmp(name, "caterva", strlen("caterva")) == 0;
+}
+
+// Write the layers of metadata of a super-chunk set by the user
+static int write_layers(blosc2_schunk *sc, bool vlmeta, caterva_write_cb_t write_cb,
+                        void *userdata, int64_t *offset) {
+    int16_t nlayers = sc == NULL ? 0 : vlmeta ? sc->nvlmetalayers : sc->nmetalayers;
+    int32_t nuser = 0;
+    for (int i = 0; i < nlayers; ++i) {
+        char *name = vlmeta ? sc->vlmetalayers[i]->name : sc->metalayers[i]->name;
+        nuser += is_caterva_layer(name) ? 0 : 1;
+    }
+    uint8_t count[sizeof(int32_t)];
+    store_le(count, nuser, sizeof(int32_t));
+    CATERVA_ERROR(write_bytes(write_cb, userdata, count, sizeof(count), offset));
+
+    for (int i = 0; i < nlayers; ++i) {
+        char *name = vlmeta ? sc->vlmetalayers[i]->name : sc->metalayers[i]->name;
+        if (is_caterva_layer(name)) {
+            continue;
+        }
+        uint8_t *content;
+        uint32_t content_len;
+        int rc;
+        if (vlmeta) {
+            rc = blosc2_vlmeta_get(sc, name, &content, &content_len);
+        } else {
+            rc = blosc2_meta_get(sc, name, &content, &content_len);
+        }
+        if (rc < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+        uint8_t name_len = (uint8_t) strlen(name);
+        uint8_t size[sizeof(int32_t)];
+        store_le(size, content_len, sizeof(int32_t));
+        rc = write_bytes(write_cb, userdata, &name_len, sizeof(name_len), offset);
+        if (rc == CATERVA_SUCCEED) {
+            rc = write_bytes(write_cb, userdata, name, name_len, offset);
+        }
+        if (rc == CATERVA_SUCCEED) {
+            rc = write_bytes(write_cb, userdata, size, sizeof(size), offset);
+        }
+        if (rc == CATERVA_SUCCEED) {
+            rc = write_bytes(write_cb, userdata, content, content_len, offset);
+        }
+        free(content);
+        CATERVA_ERROR(rc);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_stream_serialize(caterva_ctx_t *ctx, caterva_array_t *array,
+                             caterva_write_cb_t write_cb, void *userdata) {
+    // The chunks of sharded arrays are the ones of every shard (the shards split the grid along
+    // the first dimension, so they keep the row-major order)
+    caterva_array_t **parts;
+    int64_t nparts;
+    switch (array->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            parts = &array;
+            nparts = 1;
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            parts = array->shards;
+            nparts = array->nshards;
+            break;
+        default:
+            DEBUG_PRINT("Only arrays backed by Blosc super-chunks can be serialized");
+            return CATERVA_ERR_INVALID_STORAGE;
+    }
+    int64_t nchunks = 0;
+    for (int64_t i = 0; i < nparts; ++i) {
+        if (!parts[i]->filled) {
+            DEBUG_PRINT("Only filled arrays can be serialized");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+        CATERVA_ERROR(caterva_blosc_array_flush(ctx, parts[i]));
+        nchunks += get_nchunks(parts[i]);
+    }
+
+    uint8_t header[CATERVA_STREAM_HEADER_LEN] = {0};
+    memcpy(header, CATERVA_STREAM_MAGIC, CATERVA_STREAM_MAGIC_LEN);
+    header[CATERVA_STREAM_MAGIC_LEN] = CATERVA_STREAM_VERSION;
+    header[CATERVA_STREAM_MAGIC_LEN + 1] = (uint8_t) array->ndim;
+    header[CATERVA_STREAM_MAGIC_LEN + 2] = array->itemsize;
+    header[CATERVA_STREAM_MAGIC_LEN + 3] =
+        (uint8_t) (nparts > 0 ? parts[0]->block_order : array->block_order);
+    store_le(&header[CATERVA_STREAM_NCHUNKS_OFFSET], nchunks, sizeof(int64_t));
+    for (int i = 0; i < array->ndim; ++i) {
+        store_le(&header[CATERVA_STREAM_SHAPE_OFFSET + i * sizeof(int64_t)], array->shape[i],
+                 sizeof(int64_t));
+        store_le(&header[CATERVA_STREAM_CHUNKSHAPE_OFFSET + i * sizeof(int32_t)],
+                 array->chunkshape[i], sizeof(int32_t));
+        store_le(&header[CATERVA_STREAM_BLOCKSHAPE_OFFSET + i * sizeof(int32_t)],
+                 array->blockshape[i], sizeof(int32_t));
+    }
+    int64_t offset = 0;
+    CATERVA_ERROR(write_bytes(write_cb, userdata, header, sizeof(header), &offset));
+
+    // The metadata of sharded arrays is the one of their first shard
+    blosc2_schunk *sc = nparts > 0 ? parts[0]->sc : NULL;
+    CATERVA_ERROR(write_layers(sc, false, write_cb, userdata, &offset));
+    CATERVA_ERROR(write_layers(sc, true, write_cb, userdata, &offset));
+
+    // Only one chunk is kept in memory at a time (and the offsets of the chunks for the index)
+    int64_t *offsets = ctx->cfg->alloc((size_t) (nchunks > 0 ? nchunks : 1) * sizeof(int64_t));
+    CATERVA_ERROR_NULL(offsets);
+    uint8_t special[BLOSC_EXTENDED_HEADER_LENGTH + UINT8_MAX];
+    int rc = CATERVA_SUCCEED;
+    int64_t n = 0;
+    for (int64_t i = 0; i < nparts && rc == CATERVA_SUCCEED; ++i) {
+        int64_t part_nchunks = get_nchunks(parts[i]);
+        for (int64_t nchunk = 0; nchunk < part_nchunks; ++nchunk) {
+            uint8_t *cchunk;
+            int32_t cbytes;
+            bool needs_free;
+            rc = caterva_blosc_array_get_cchunk(parts[i], nchunk, special, &cchunk, &cbytes,
+                                                &needs_free);
+            if (rc != CATERVA_SUCCEED) {
+                break;
+            }
+            offsets[n++] = offset;
+            rc = write_bytes(write_cb, userdata, cchunk, cbytes, &offset);
+            if (needs_free) {
+                free(cchunk);
+            }
+            if (rc != CATERVA_SUCCEED) {
+                break;
+            }
+        }
+    }
+
+    // The index is written in batches
+    int64_t index_offset = offset;
+    uint8_t batch[CATERVA_STREAM_INDEX_BATCH * sizeof(int64_t)];
+    for (int64_t i = 0; i < nchunks && rc == CATERVA_SUCCEED; i += CATERVA_STREAM_INDEX_BATCH) {
+        int64_t nbatch = nchunks - i < CATERVA_STREAM_INDEX_BATCH ? nchunks - i
+                                                                 : CATERVA_STREAM_INDEX_BATCH;
+        for (int64_t j = 0; j < nbatch; ++j) {
+            store_le(&batch[j * sizeof(int64_t)], offsets[i + j], sizeof(int64_t));
+        }
+        rc = write_bytes(write_cb, userdata, batch, nbatch * (int64_t) sizeof(int64_t), &offset);
+    }
+    ctx->cfg->free(offsets);
+    CATERVA_ERROR(rc);
+
+    uint8_t trailer[CATERVA_STREAM_TRAILER_LEN];
+    store_le(trailer, index_offset, sizeof(int64_t));
+    memcpy(&trailer[sizeof(int64_t)], CATERVA_STREAM_MAGIC, CATERVA_STREAM_MAGIC_LEN);
+    CATERVA_ERROR(write_bytes(write_cb, userdata, trailer, sizeof(trailer), &offset));
+
+    return CATERVA_SUCCEED;
+}
+
+// Read the next bytes of a stream (sources like pipes can return less bytes than requested)
+static int read_bytes(caterva_read_cb_t read_cb, void *userdata, void *data, int64_t size,
+                      int64_t *offset) {
+    uint8_t *bdata = data;
+    int64_t nread = 0;
+    while (nread < size) {
+        int64_t rbytes = read_cb(bdata + nread, size - nread, userdata);
+        if (rbytes <= 0 || rbytes > size - nread) {
+            DEBUG_PRINT("Error reading the serialized array");
+            return CATERVA_ERR_INVALID_STORAGE;
+        }
+        nread += rbytes;
+    }
+    *offset += size;
+    return CATERVA_SUCCEED;
+}
+
+// Read the count of a group of layers of metadata
+static int read_nlayers(caterva_read_cb_t read_cb, void *userdata, int32_t max_nlayers,
+                        int32_t *nlayers, int64_t *offset) {
+    uint8_t count[sizeof(int32_t)];
+    CATERVA_ERROR(read_bytes(read_cb, userdata, count, sizeof(count), offset));
+    *nlayers = (int32_t) load_le(count, sizeof(int32_t));
+    if (*nlayers < 0 || *nlayers > max_nlayers) {
+        DEBUG_PRINT("The metadata of the serialized array is corrupted");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Read the content of a layer of metadata. The length comes from the stream, so the buffer only
+// grows as the bytes arrive (a corrupted length can not force a large allocation if the stream
+// is shorter).
+static int read_content(caterva_ctx_t *ctx, caterva_read_cb_t read_cb, void *userdata,
+                        int32_t content_len, uint8_t **content, int64_t *offset) {
+    int64_t capacity = content_len < CATERVA_STREAM_LAYER_BATCH ? content_len
+                                                                : CATERVA_STREAM_LAYER_BATCH;
+    *content = ctx->cfg->alloc((size_t) capacity + 1);
+    CATERVA_ERROR_NULL(*content);
+    int64_t nread = 0;
+    while (nread < content_len) {
+        if (nread == capacity) {
+            int64_t new_capacity = 2 * capacity < content_len ? 2 * capacity : content_len;
+            uint8_t *new_content = ctx->cfg->alloc((size_t) new_capacity + 1);
+            if (new_content == NULL) {
+                ctx->cfg->free(*content);
+                *content = NULL;
+                CATERVA_ERROR_NULL(new_content);
+            }
+            memcpy(new_content, *content, (size_t) nread);
+            ctx->cfg->free(*content);
+            *content = new_content;
+            capacity = new_capacity;
+        }
+        int rc = read_bytes(read_cb, userdata, *content + nread, capacity - nread, offset);
+        if (rc != CATERVA_SUCCEED) {
+            ctx->cfg->free(*content);
+            *content = NULL;
+            return rc;
+        }
+        nread = capacity;
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Read a layer of metadata (its name and its content are released with ctx->cfg->free())
+static int read_layer(caterva_ctx_t *ctx, caterva_read_cb_t read_cb, void *userdata,
+                      char **name, uint8_t **content, int32_t *content_len, int64_t *offset) {
+    uint8_t name_len;
+    CATERVA_ERROR(read_bytes(read_cb, userdata, &name_len, sizeof(name_len), offset));
+    *name = ctx->cfg->alloc((size_t) name_len + 1);
+    CATERVA_ERROR_NULL(*name);
+    int rc = read_bytes(read_cb, userdata, *name, name_len, offset);
+    (*name)[name_len] = '\0';
+    uint8_t size[sizeof(int32_t)];
+    if (rc == CATERVA_SUCCEED) {
+        rc = read_bytes(read_cb, userdata, size, sizeof(size), offset);
+    }
+    *content = NULL;
+    if (rc == CATERVA_SUCCEED) {
+        *content_len = (int32_t) load_le(size, sizeof(int32_t));
+        if (*content_len < 0) {
+            DEBUG_PRINT("The metadata of the serialized array is corrupted");
+            rc = CATERVA_ERR_INVALID_STORAGE;
+        }
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = read_content(ctx, read_cb, userdata, *content_len, content, offset);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        ctx->cfg->free(*name);
+        if (*content != NULL) {
+            ctx->cfg->free(*content);
+        }
+        return rc;
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Read the fixed-length metalayers of a stream into the storage of the array (the ones already
+// in the storage are kept)
+static int read_metalayers(caterva_ctx_t *ctx, caterva_read_cb_t read_cb, void *userdata,
+                           caterva_storage_properties_blosc_t *blosc, int64_t *offset) {
+    int32_t nlayers;
+    CATERVA_ERROR(read_nlayers(read_cb, userdata, CATERVA_MAX_METALAYERS, &nlayers, offset));
+    int nstorage = blosc->nmetalayers;
+    for (int32_t i = 0; i < nlayers; ++i) {
+        char *name;
+        uint8_t *content;
+        int32_t content_len;
+        CATERVA_ERROR(read_layer(ctx, read_cb, userdata, &name, &content, &content_len, offset));
+        bool found = false;
+        for (int j = 0; j < nstorage; ++j) {
+            found |= strcmp(blosc->metalayers[j].name, name) == 0;
+        }
+        if (found || blosc->nmetalayers == CATERVA_MAX_METALAYERS) {
+            ctx->cfg->free(name);
+            ctx->cfg->free(content);
+            continue;
+        }
+        blosc->metalayers[blosc->nmetalayers].name = name;
+        blosc->metalayers[blosc->nmetalayers].sdata = content;
+        blosc->metalayers[blosc->nmetalayers].size = content_len;
+        blosc->nmetalayers++;
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Read the variable-length metalayers of a stream, adding them to an array
+static int read_vlmetalayers(caterva_ctx_t *ctx, caterva_read_cb_t read_cb, void *userdata,
+                             caterva_array_t *array, int64_t *offset) {
+    int32_t nlayers;
+    CATERVA_ERROR(read_nlayers(read_cb, userdata, BLOSC2_MAX_VLMETALAYERS, &nlayers, offset));
+    for (int32_t i = 0; i < nlayers; ++i) {
+        char *name;
+        uint8_t *content;
+        int32_t content_len;
+        CATERVA_ERROR(read_layer(ctx, read_cb, userdata, &name, &content, &content_len, offset));
+        int rc = blosc2_vlmeta_add(array->sc, name, content, content_len, NULL);
+        ctx->cfg->free(name);
+        ctx->cfg->free(content);
+        if (rc < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+    }
+    return CATERVA_SUCCEED;
+}
+
+// Get the region of a chunk of the grid of an array
+static void get_chunk_region(caterva_array_t *array, int64_t nchunk, int64_t *start,
+                             int64_t *stop) {
+    for (int i = array->ndim - 1; i >= 0; --i) {
+        int64_t grid = array->extshape[i] / array->chunkshape[i];
+        start[i] = (nchunk % grid) * array->chunkshape[i];
+        stop[i] = start[i] + array->chunkshape[i] < array->shape[i]
+                      ? start[i] + array->chunkshape[i]
+                      : array->shape[i];
+        nchunk /= grid;
+    }
+}
+
+// Read the chunks and the index of a stream, appending the chunks to an array
+static int read_chunks(caterva_ctx_t *ctx, caterva_read_cb_t read_cb,
+                       caterva_chunk_cb_t chunk_cb, void *userdata, int64_t nchunks,
+                       caterva_array_t *array, int64_t *offset) {
+    // Only one chunk is kept in memory at a time (and the offsets of the chunks for the index)
+    int32_t nbytes = (int32_t) array->extchunknitems * array->itemsize;
+    uint8_t *cchunk = ctx->cfg->alloc((size_t) nbytes + BLOSC_MAX_OVERHEAD);
+    CATERVA_ERROR_NULL(cchunk);
+    int64_t *offsets = ctx->cfg->alloc((size_t) (nchunks > 0 ? nchunks : 1) * sizeof(int64_t));
+    CATERVA_ERROR_NULL(offsets);
+    int rc = CATERVA_SUCCEED;
+    for (int64_t nchunk = 0; nchunk < nchunks; ++nchunk) {
+        offsets[nchunk] = *offset;
+        // The size of the chunk is read from its header
+        int32_t chunk_nbytes, cbytes, blocksize;
+        rc = read_bytes(read_cb, userdata, cchunk, BLOSC_EXTENDED_HEADER_LENGTH, offset);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        if (blosc2_cbuffer_sizes(cchunk, &chunk_nbytes, &cbytes, &blocksize) < 0 ||
+            chunk_nbytes != nbytes || cbytes < BLOSC_EXTENDED_HEADER_LENGTH ||
+            cbytes > nbytes + BLOSC_MAX_OVERHEAD) {
+            DEBUG_PRINT("The chunk does not have the size of the chunks of the array");
+            rc = CATERVA_ERR_INVALID_STORAGE;
+            break;
+        }
+        rc = read_bytes(read_cb, userdata, cchunk + BLOSC_EXTENDED_HEADER_LENGTH,
+                        cbytes - BLOSC_EXTENDED_HEADER_LENGTH, offset);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        rc = caterva_blosc_array_append_cchunk(ctx, array, cchunk);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        array->nchunks++;
+        array->empty = false;
+        if (array->nchunks == get_nchunks(array)) {
+            array->filled = true;
+        }
+        if (chunk_cb != NULL) {
+            int64_t start[CATERVA_MAX_DIM];
+            int64_t stop[CATERVA_MAX_DIM];
+            get_chunk_region(array, nchunk, start, stop);
+            rc = chunk_cb(array, start, stop, userdata);
+            if (rc != CATERVA_SUCCEED) {
+                DEBUG_PRINT("The chunk callback stopped the deserialization");
+                break;
+            }
+        }
+    }
+    ctx->cfg->free(cchunk);
+
+    // The index is read in batches and checked against the offsets of the chunks read
+    uint8_t batch[CATERVA_STREAM_INDEX_BATCH * sizeof(int64_t)];
+    for (int64_t i = 0; i < nchunks && rc == CATERVA_SUCCEED; i += CATERVA_STREAM_INDEX_BATCH) {
+        int64_t nbatch = nchunks - i < CATERVA_STREAM_INDEX_BATCH ? nchunks - i
+                                                                 : CATERVA_STREAM_INDEX_BATCH;
+        rc = read_bytes(read_cb, userdata, batch, nbatch * (int64_t) sizeof(int64_t), offset);
+        for (int64_t j = 0; j < nbatch && rc == CATERVA_SUCCEED; ++j) {
+            if (load_le(&batch[j * sizeof(int64_t)], sizeof(int64_t)) != offsets[i + j]) {
+                DEBUG_PRINT("The index of the serialized array is corrupted");
+                rc = CATERVA_ERR_INVALID_STORAGE;
+            }
+        }
+    }
+    ctx->cfg->free(offsets);
+
+    return rc;
+}
+
+int caterva_stream_deserialize(caterva_ctx_t *ctx, caterva_read_cb_t read_cb,
+                               caterva_chunk_cb_t chunk_cb, void *userdata,
+                               caterva_storage_t *storage, caterva_array_t **array) {
+    if (storage->backend != CATERVA_STORAGE_BLOSC) {
+        DEBUG_PRINT("Serialized arrays can only be stored in a Blosc super-chunk");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    int64_t offset = 0;
+    uint8_t header[CATERVA_STREAM_HEADER_LEN];
+    CATERVA_ERROR(read_bytes(read_cb, userdata, header, sizeof(header), &offset));
+    if (memcmp(header, CATERVA_STREAM_MAGIC, CATERVA_STREAM_MAGIC_LEN) != 0 ||
+        header[CATERVA_STREAM_MAGIC_LEN] != CATERVA_STREAM_VERSION) {
+        DEBUG_PRINT("The stream does not hold a serialized array");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+
+    // The geometry and the block order of the array are the ones of the stream, and the
+    // chunks are appended to a row-major array
+    caterva_params_t params = {0};
+    params.ndim = header[CATERVA_STREAM_MAGIC_LEN + 1];
+    params.itemsize = header[CATERVA_STREAM_MAGIC_LEN + 2];
+    uint8_t block_order = header[CATERVA_STREAM_MAGIC_LEN + 3];
+    int64_t nchunks = load_le(&header[CATERVA_STREAM_NCHUNKS_OFFSET], sizeof(int64_t));
+    if (params.ndim > CATERVA_MAX_DIM || params.itemsize == 0 ||
+        block_order > CATERVA_BLOCK_ORDER_MORTON) {
+        DEBUG_PRINT("The header of the serialized array is corrupted");
+        return CATERVA_ERR_INVALID_STORAGE;
+    }
+    caterva_storage_t stream_storage = *storage;
+    caterva_storage_properties_blosc_t *blosc = &stream_storage.properties.blosc;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = load_le(&header[CATERVA_STREAM_SHAPE_OFFSET + i * sizeof(int64_t)],
+                                  sizeof(int64_t));
+        blosc->chunkshape[i] = (int32_t) load_le(
+            &header[CATERVA_STREAM_CHUNKSHAPE_OFFSET + i * sizeof(int32_t)], sizeof(int32_t));
+        blosc->blockshape[i] = (int32_t) load_le(
+            &header[CATERVA_STREAM_BLOCKSHAPE_OFFSET + i * sizeof(int32_t)], sizeof(int32_t));
+    }
+    blosc->block_order = (caterva_block_order_t) block_order;
+    blosc->chunk_order = CATERVA_CHUNK_ORDER_ROW_MAJOR;
+    blosc->extendable = false;
+    blosc->sparse = false;
+    blosc->fill_value = NULL;
+
+    // The fixed-length metalayers have to be added before any chunk, so the array is created
+    // with them
+    int nstorage = blosc->nmetalayers;
+    int rc = read_metalayers(ctx, read_cb, userdata, blosc, &offset);
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_empty(ctx, &params, &stream_storage, array);
+    }
+    for (int i = nstorage; i < blosc->nmetalayers; ++i) {
+        ctx->cfg->free(blosc->metalayers[i].name);
+        ctx->cfg->free(blosc->metalayers[i].sdata);
+    }
+    CATERVA_ERROR(rc);
+    if (get_nchunks(*array) != nchunks) {
+        DEBUG_PRINT("The header of the serialized array is corrupted");
+        rc = CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = read_vlmetalayers(ctx, read_cb, userdata, *array, &offset);
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = read_chunks(ctx, read_cb, chunk_cb, userdata, nchunks, *array, &offset);
+    }
+    int64_t index_offset = offset - nchunks * (int64_t) sizeof(int64_t);
+    uint8_t trailer[CATERVA_STREAM_TRAILER_LEN];
+    if (rc == CATERVA_SUCCEED) {
+        rc = read_bytes(read_cb, userdata, trailer, sizeof(trailer), &offset);
+    }
+    if (rc == CATERVA_SUCCEED &&
+        (load_le(trailer, sizeof(int64_t)) != index_offset ||
+         memcmp(&trailer[sizeof(int64_t)], CATERVA_STREAM_MAGIC, CATERVA_STREAM_MAGIC_LEN) != 0)) {
+        DEBUG_PRINT("The trailer of the serialized array is corrupted");
+        rc = CATERVA_ERR_INVALID_STORAGE;
+    }
+    if (rc == CATERVA_SUCCEED) {
+        rc = caterva_blosc_array_flush(ctx, *array);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        // The frame written so far is removed, so that no partial array is left on disk
+        caterva_free(ctx, array);
+        *array = NULL;
+        if (blosc->urlpath != NULL) {
+            caterva_blosc_remove_urlpath(ctx, blosc->urlpath);
+        }
+        return rc;
+    }
+
+    return CATERVA_SUCCEED;
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#ifndef CATERVA_CATERVA_STREAM_H_
+#define CATERVA_CATERVA_STREAM_H_
+
+int caterva_stream_serialize(caterva_ctx_t *ctx, caterva_array_t *array,
+                             caterva_write_cb_t write_cb, void *userdata);
+
+int caterva_stream_deserialize(caterva_ctx_t *ctx, caterva_read_cb_t read_cb,
+                               caterva_chunk_cb_t chunk_cb, void *userdata,
+                               caterva_storage_t *storage, caterva_array_t **array);
+
+#endif  // CATERVA_CATERVA_STREAM_H_
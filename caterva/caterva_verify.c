@@ -0,0 +1,436 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include <assert.h>
+#include <caterva.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#include "caterva_blosc.h"
+#include "caterva_verify.h"
+
+// The name of the variable-length metalayer storing the CRC-32 checksums of the decompressed
+// chunks of an array, as an array with 2 entries (the number of chunks and the checksums of the
+// chunks of the grid in row-major order). It holds a nil when the checksums are dropped.
+#define CATERVA_CHECKSUMS_VLMETA "caterva_checksums"
+#define CATERVA_CHECKSUMS_HEADER_LEN (1 + 1 + sizeof(int64_t) + 1 + sizeof(int32_t))
+
+// The state shared by the threads verifying the chunks of a Blosc array
+typedef struct {
+    caterva_ctx_t *ctx;
+    caterva_array_t *array;
+    int64_t nchunks;
+    int64_t next;
+    uint32_t crc_table[256];
+    uint8_t *checksums;
+    bool checked;
+    uint32_t *computed;
+    int64_t *bad_chunks;
+    int64_t nbad;
+    int64_t bad_capacity;
+    int rc;
+#if !defined(_WIN32)
+    pthread_mutex_t mutex;
+#endif
+} verifier_t;
+
+static void store_be(uint8_t *dest, int64_t value, int nbytes) {
+    for (int i = 0; i < nbytes; ++i) {
+        dest[nbytes - 1 - i] = (uint8_t) ((uint64_t) value >> (8 * i));
+    }
+}
+
+static int64_t load_be(const uint8_t *src, int nbytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < nbytes; ++i) {
+        value = (value << 8) | src[i];
+    }
+    return (int64_t) value;
+}
+
+// Number of chunks in the grid of an array backed by a super-chunk
+static int64_t get_nchunks(caterva_array_t *array) {
+    if (array->chunknitems == 0) {
+        return 0;
+    }
+    return array->extnitems / array->chunknitems;
+}
+
+// Fill the table of the CRC-32 (with the reflected polynomial used by zlib)
+static void init_crc_table(uint32_t *crc_table) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+}
+
+static uint32_t get_crc(const uint32_t *crc_table, const uint8_t *data, int64_t len) {
+    uint32_t crc = 0xffffffffu;
+    for (int64_t i = 0; i < len; ++i) {
+        crc = crc_table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
+
+static void verifier_lock(verifier_t *verifier) {
+#if !defined(_WIN32)
+    pthread_mutex_lock(&verifier->mutex);
+#else
+    (void) verifier;
+#endif
+}
+
+static void verifier_unlock(verifier_t *verifier) {
+#if !defined(_WIN32)
+    pthread_mutex_unlock(&verifier->mutex);
+#else
+    (void) verifier;
+#endif
+}
+
+// Record a bad chunk (with the mutex of the verifier locked)
+static int add_bad_chunk(verifier_t *verifier, int64_t nchunk) {
+    if (verifier->nbad == verifier->bad_capacity) {
+        int64_t capacity = verifier->bad_capacity > 0 ? 2 * verifier->bad_capacity : 16;
+        int64_t *bad_chunks = verifier->ctx->cfg->alloc((size_t) capacity * sizeof(int64_t));
+        CATERVA_ERROR_NULL(bad_chunks);
+        if (verifier->bad_chunks != NULL) {
+            memcpy(bad_chunks, verifier->bad_chunks, verifier->nbad * sizeof(int64_t));
+            verifier->ctx->cfg->free(verifier->bad_chunks);
+        }
+        verifier->bad_chunks = bad_chunks;
+        verifier->bad_capacity = capacity;
+    }
+    verifier->bad_chunks[verifier->nbad++] = nchunk;
+    return CATERVA_SUCCEED;
+}
+
+// Verify the chunks not taken by other threads yet, decompressing them into a scratch buffer
+static void *verifier_run(void *arg) {
+    verifier_t *verifier = arg;
+    caterva_ctx_t *ctx = verifier->ctx;
+    caterva_array_t *array = verifier->array;
+    int32_t nbytes = (int32_t) (array->extchunknitems * array->itemsize);
+    uint8_t special[BLOSC_EXTENDED_HEADER_LENGTH + UINT8_MAX];
+    uint8_t *buffer = ctx->cfg->alloc((size_t) (nbytes > 0 ? nbytes : 1));
+    blosc2_dparams dparams = BLOSC2_DPARAMS_DEFAULTS;
+    blosc2_context *dctx = blosc2_create_dctx(dparams);
+
+    verifier_lock(verifier);
+    if (buffer == NULL || dctx == NULL) {
+        verifier->rc = CATERVA_ERR_NULL_POINTER;
+    }
+    while (verifier->rc == CATERVA_SUCCEED && verifier->next < verifier->nchunks) {
+        int64_t nchunk = verifier->next++;
+        // The chunks are read one at a time (the super-chunk can not be shared by threads)
+        uint8_t *cchunk;
+        int32_t cbytes;
+        bool needs_free = false;
+        int rc = caterva_blosc_array_get_cchunk(array, nchunk, special, &cchunk, &cbytes,
+                                                &needs_free);
+        verifier_unlock(verifier);
+
+        bool ok = rc == CATERVA_SUCCEED &&
+                  blosc2_decompress_ctx(dctx, cchunk, cbytes, buffer, nbytes) == nbytes;
+        uint32_t checksum = 0;
+        if (ok) {
+            checksum = get_crc(verifier->crc_table, buffer, nbytes);
+        }
+        if (ok && verifier->checksums != NULL) {
+            uint8_t *pchecksum = &verifier->checksums[CATERVA_CHECKSUMS_HEADER_LEN +
+                                                      nchunk * sizeof(uint32_t)];
+            ok = load_be(pchecksum, sizeof(uint32_t)) == checksum;
+        }
+        if (rc == CATERVA_SUCCEED && needs_free) {
+            free(cchunk);
+        }
+
+        verifier_lock(verifier);
+        if (verifier->computed != NULL) {
+            verifier->computed[nchunk] = checksum;
+        }
+        if (!ok) {
+            rc = add_bad_chunk(verifier, nchunk);
+            if (rc != CATERVA_SUCCEED) {
+                verifier->rc = rc;
+            }
+        }
+    }
+    verifier_unlock(verifier);
+
+    if (dctx != NULL) {
+        blosc2_free_ctx(dctx);
+    }
+    if (buffer != NULL) {
+        ctx->cfg->free(buffer);
+    }
+    return NULL;
+}
+
+// Read the checksums stored for the chunks of an array (NULL if there are not valid ones)
+static uint8_t *get_checksums(caterva_array_t *array, int64_t nchunks) {
+    if (blosc2_vlmeta_exists(array->sc, CATERVA_CHECKSUMS_VLMETA) < 0) {
+        return NULL;
+    }
+    uint8_t *smeta;
+    uint32_t smeta_len;
+    if (blosc2_vlmeta_get(array->sc, CATERVA_CHECKSUMS_VLMETA, &smeta, &smeta_len) < 0) {
+        return NULL;
+    }
+    // The checksums dropped or stored before the chunks were truncated are ignored
+    if (smeta_len != CATERVA_CHECKSUMS_HEADER_LEN + nchunks * sizeof(uint32_t) ||
+        smeta[0] != 0x90 + 2 || smeta[1] != 0xd3 ||
+        load_be(&smeta[2], sizeof(int64_t)) != nchunks) {
+        free(smeta);
+        return NULL;
+    }
+    return smeta;
+}
+
+// Verify the chunks of an array backed by a super-chunk with several threads
+static int verify_part(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads,
+                       bool store, verifier_t *verifier) {
+    memset(verifier, 0, sizeof(verifier_t));
+    verifier->ctx = ctx;
+    verifier->array = array;
+    verifier->nchunks = get_nchunks(array);
+    init_crc_table(verifier->crc_table);
+    if (store) {
+        verifier->computed = ctx->cfg->alloc(
+            (size_t) (verifier->nchunks > 0 ? verifier->nchunks : 1) * sizeof(uint32_t));
+        CATERVA_ERROR_NULL(verifier->computed);
+    } else {
+        verifier->checksums = get_checksums(array, verifier->nchunks);
+    }
+    if (nthreads > verifier->nchunks) {
+        nthreads = (int) verifier->nchunks;
+    }
+
+#if !defined(_WIN32)
+    pthread_mutex_init(&verifier->mutex, NULL);
+    pthread_t *threads = NULL;
+    int nstarted = 0;
+    if (nthreads > 1) {
+        threads = ctx->cfg->alloc(nthreads * sizeof(pthread_t));
+    }
+    for (int i = 0; threads != NULL && i < nthreads; ++i) {
+        if (pthread_create(&threads[i], NULL, verifier_run, verifier) != 0) {
+            break;
+        }
+        nstarted++;
+    }
+    // The calling thread verifies the chunks left if no thread can be created
+    if (nstarted == 0) {
+        verifier_run(verifier);
+    }
+    for (int i = 0; i < nstarted; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    if (threads != NULL) {
+        ctx->cfg->free(threads);
+    }
+    pthread_mutex_destroy(&verifier->mutex);
+#else
+    (void) nthreads;
+    verifier_run(verifier);
+#endif
+
+    if (verifier->checksums != NULL) {
+        free(verifier->checksums);
+        verifier->checksums = NULL;
+        verifier->checked = true;
+    }
+    return verifier->rc;
+}
+
+static void free_verifier(caterva_ctx_t *ctx, verifier_t *verifier) {
+    if (verifier->computed != NULL) {
+        ctx->cfg->free(verifier->computed);
+    }
+    if (verifier->bad_chunks != NULL) {
+        ctx->cfg->free(verifier->bad_chunks);
+    }
+}
+
+static int compare_nchunks(const void *a, const void *b) {
+    int64_t nchunk_a = *(const int64_t *) a;
+    int64_t nchunk_b = *(const int64_t *) b;
+    return (nchunk_a > nchunk_b) - (nchunk_a < nchunk_b);
+}
+
+// Add the coordinates of the bad chunks of an array to a report (with the first one shifted)
+static int add_bad_coords(caterva_ctx_t *ctx, caterva_array_t *array, verifier_t *verifier,
+                          int64_t offset, caterva_verify_report_t *report) {
+    if (verifier->nbad == 0) {
+        return CATERVA_SUCCEED;
+    }
+    qsort(verifier->bad_chunks, (size_t) verifier->nbad, sizeof(int64_t), compare_nchunks);
+    int64_t ncoords = (report->nbad + verifier->nbad) * array->ndim;
+    int64_t *bad_coords = ctx->cfg->alloc((size_t) (ncoords > 0 ? ncoords : 1) *
+                                          sizeof(int64_t));
+    CATERVA_ERROR_NULL(bad_coords);
+    if (report->bad_coords != NULL) {
+        memcpy(bad_coords, report->bad_coords, report->nbad * array->ndim * sizeof(int64_t));
+        ctx->cfg->free(report->bad_coords);
+    }
+    report->bad_coords = bad_coords;
+
+    for (int64_t i = 0; i < verifier->nbad; ++i) {
+        int64_t *coords = &report->bad_coords[report->nbad * array->ndim];
+        int64_t rem = verifier->bad_chunks[i];
+        for (int j = array->ndim - 1; j >= 0; --j) {
+            int64_t nchunks = array->extshape[j] / array->chunkshape[j];
+            coords[j] = rem % nchunks;
+            rem /= nchunks;
+        }
+        if (array->ndim > 0) {
+            coords[0] += offset;
+        }
+        report->nbad++;
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+// Get the arrays backed by a super-chunk holding the chunks of an array (the shards of sharded
+// arrays split the grid along the first dimension)
+static int get_parts(caterva_array_t **array, caterva_array_t ***parts, int64_t *nparts) {
+    switch ((*array)->storage) {
+        case CATERVA_STORAGE_BLOSC:
+            *parts = array;
+            *nparts = 1;
+            break;
+        case CATERVA_STORAGE_SHARDED:
+            *parts = (*array)->shards;
+            *nparts = (*array)->nshards;
+            break;
+        default:
+            DEBUG_PRINT("Only arrays backed by Blosc super-chunks can be verified");
+            return CATERVA_ERR_INVALID_STORAGE;
+    }
+    for (int64_t i = 0; i < *nparts; ++i) {
+        if (!(*parts)[i]->filled) {
+            DEBUG_PRINT("Only filled arrays can be verified");
+            return CATERVA_ERR_INVALID_ARGUMENT;
+        }
+    }
+    return CATERVA_SUCCEED;
+}
+
+int caterva_verify_array(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads,
+                         caterva_verify_report_t *report) {
+    caterva_array_t **parts;
+    int64_t nparts;
+    CATERVA_ERROR(get_parts(&array, &parts, &nparts));
+    memset(report, 0, sizeof(caterva_verify_report_t));
+
+    int rc = CATERVA_SUCCEED;
+    for (int64_t i = 0; i < nparts && rc == CATERVA_SUCCEED; ++i) {
+        rc = caterva_blosc_array_flush(ctx, parts[i]);
+        if (rc != CATERVA_SUCCEED) {
+            break;
+        }
+        verifier_t verifier;
+        rc = verify_part(ctx, parts[i], nthreads, false, &verifier);
+        if (rc == CATERVA_SUCCEED) {
+            int64_t offset = i * array->shard_nchunks;
+            rc = add_bad_coords(ctx, parts[i], &verifier, offset, report);
+        }
+        report->nchunks += verifier.nchunks;
+        if (verifier.checked) {
+            report->nchecked += verifier.nchunks;
+        }
+        free_verifier(ctx, &verifier);
+    }
+    if (rc != CATERVA_SUCCEED) {
+        caterva_verify_report_free(ctx, report);
+        CATERVA_ERROR(rc);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_verify_store_checksums(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads) {
+    caterva_array_t **parts;
+    int64_t nparts;
+    CATERVA_ERROR(get_parts(&array, &parts, &nparts));
+
+    for (int64_t i = 0; i < nparts; ++i) {
+        CATERVA_ERROR(caterva_blosc_array_flush(ctx, parts[i]));
+        verifier_t verifier;
+        int rc = verify_part(ctx, parts[i], nthreads, true, &verifier);
+        if (rc == CATERVA_SUCCEED && verifier.nbad > 0) {
+            DEBUG_PRINT("The checksums of an array with bad chunks can not be stored");
+            rc = CATERVA_ERR_BLOSC_FAILED;
+        }
+        uint8_t *smeta = NULL;
+        uint32_t smeta_len = (uint32_t) (CATERVA_CHECKSUMS_HEADER_LEN +
+                                         verifier.nchunks * sizeof(uint32_t));
+        if (rc == CATERVA_SUCCEED) {
+            smeta = malloc(smeta_len);
+            rc = smeta == NULL ? CATERVA_ERR_NULL_POINTER : CATERVA_SUCCEED;
+        }
+        if (rc == CATERVA_SUCCEED) {
+            uint8_t *pmeta = smeta;
+            // Build an array with 2 entries (nchunks, checksums)
+            *pmeta++ = 0x90 + 2;
+            // nchunks entry as an int64
+            *pmeta++ = 0xd3;
+            store_be(pmeta, verifier.nchunks, sizeof(int64_t));
+            pmeta += sizeof(int64_t);
+            // checksums entry as a bin32
+            *pmeta++ = 0xc6;
+            store_be(pmeta, verifier.nchunks * (int64_t) sizeof(uint32_t), sizeof(int32_t));
+            pmeta += sizeof(int32_t);
+            for (int64_t nchunk = 0; nchunk < verifier.nchunks; ++nchunk) {
+                store_be(pmeta, verifier.computed[nchunk], sizeof(uint32_t));
+                pmeta += sizeof(uint32_t);
+            }
+            assert((uint32_t) (pmeta - smeta) == smeta_len);
+
+            if (blosc2_vlmeta_exists(parts[i]->sc, CATERVA_CHECKSUMS_VLMETA) < 0) {
+                rc = blosc2_vlmeta_add(parts[i]->sc, CATERVA_CHECKSUMS_VLMETA, smeta, smeta_len,
+                                       NULL);
+            } else {
+                rc = blosc2_vlmeta_update(parts[i]->sc, CATERVA_CHECKSUMS_VLMETA, smeta,
+                                          smeta_len, NULL);
+            }
+            rc = rc < 0 ? CATERVA_ERR_BLOSC_FAILED : CATERVA_SUCCEED;
+            free(smeta);
+            parts[i]->checksums_dropped = false;
+        }
+        free_verifier(ctx, &verifier);
+        CATERVA_ERROR(rc);
+    }
+
+    return CATERVA_SUCCEED;
+}
+
+int caterva_verify_drop_checksums(caterva_array_t *array) {
+    if (array->checksums_dropped) {
+        return CATERVA_SUCCEED;
+    }
+    if (blosc2_vlmeta_exists(array->sc, CATERVA_CHECKSUMS_VLMETA) >= 0) {
+        uint8_t nil = 0xc0;
+        if (blosc2_vlmeta_update(array->sc, CATERVA_CHECKSUMS_VLMETA, &nil, sizeof(nil),
+                                 NULL) < 0) {
+            CATERVA_ERROR(CATERVA_ERR_BLOSC_FAILED);
+        }
+    }
+    array->checksums_dropped = true;
+
+    return CATERVA_SUCCEED;
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2018-present Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#ifndef CATERVA_CATERVA_VERIFY_H_
+#define CATERVA_CATERVA_VERIFY_H_
+
+int caterva_verify_array(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads,
+                         caterva_verify_report_t *report);
+
+int caterva_verify_store_checksums(caterva_ctx_t *ctx, caterva_array_t *array, int nthreads);
+
+int caterva_verify_drop_checksums(caterva_array_t *array);
+
+#endif  // CATERVA_CATERVA_VERIFY_H_
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+// Benchmark the shapes suggested by caterva_suggest_shapes() against naive ones on sample data
+
+# include <caterva.h>
+
+#define NREADS 50
+
+// Time the reads matching an access pattern (in seconds per read)
+static double time_reads(caterva_ctx_t *ctx, caterva_array_t *arr,
+                         caterva_access_hint_t access_hint, int8_t *dest) {
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t destshape[CATERVA_MAX_DIM] = {0};
+    blosc_timestamp_t t0, t1;
+    blosc_set_timestamp(&t0);
+    for (int n = 0; n < NREADS; ++n) {
+        int64_t pos = (n * 7919) % arr->shape[0];
+        switch (access_hint) {
+            case CATERVA_ACCESS_WHOLE:
+                start[0] = 0, stop[0] = arr->shape[0];
+                start[1] = 0, stop[1] = arr->shape[1];
+                break;
+            case CATERVA_ACCESS_ROWS:
+                start[0] = pos, stop[0] = pos + 1;
+                start[1] = 0, stop[1] = arr->shape[1];
+                break;
+            case CATERVA_ACCESS_COLUMNS:
+                start[0] = 0, stop[0] = arr->shape[0];
+                start[1] = pos, stop[1] = pos + 1;
+                break;
+            default:
+                start[0] = pos / 2, stop[0] = pos / 2 + 10;
+                start[1] = pos / 3, stop[1] = pos / 3 + 10;
+        }
+        int64_t destsize = arr->itemsize;
+        for (int i = 0; i < arr->ndim; ++i) {
+            destshape[i] = stop[i] - start[i];
+            destsize *= destshape[i];
+        }
+        CATERVA_ERROR(caterva_get_slice_buffer(ctx, arr, start, stop, destshape, dest, destsize));
+    }
+    blosc_set_timestamp(&t1);
+
+    return blosc_elapsed_secs(t0, t1) / NREADS;
+}
+
+int main() {
+    int8_t ndim = 2;
+    int64_t shape[] = {2000, 2000};
+    int32_t naive_chunkshape[] = {100, 100};
+    int32_t naive_blockshape[] = {10, 10};
+    int8_t itemsize = 8;
+
+    int64_t nelem = 1;
+    for (int i = 0; i < ndim; ++i) {
+        nelem *= shape[i];
+    }
+    int64_t size = nelem * itemsize;
+    double *data = malloc(size);
+    for (int64_t i = 0; i < nelem; ++i) {
+        data[i] = (double) (i % 1000) / 10;
+    }
+    int8_t *dest = malloc(size);
+
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    caterva_ctx_t *ctx;
+    caterva_ctx_new(&cfg, &ctx);
+
+    caterva_params_t params = {0};
+    params.ndim = ndim;
+    params.itemsize = itemsize;
+    for (int i = 0; i < ndim; ++i) {
+        params.shape[i] = shape[i];
+    }
+
+    const char *names[] = {"whole", "rows", "columns", "random"};
+    caterva_access_hint_t hints[] = {CATERVA_ACCESS_WHOLE, CATERVA_ACCESS_ROWS,
+                                     CATERVA_ACCESS_COLUMNS, CATERVA_ACCESS_RANDOM};
+    for (int h = 0; h < 4; ++h) {
+        caterva_storage_t storage = {0};
+        storage.backend = CATERVA_STORAGE_BLOSC;
+        CATERVA_ERROR(caterva_suggest_shapes(ctx, &params, hints[h],
+                                             storage.properties.blosc.chunkshape,
+                                             storage.properties.blosc.blockshape));
+        caterva_array_t *arr;
+        CATERVA_ERROR(caterva_from_buffer(ctx, data, size, &params, &storage, &arr));
+        double suggested = time_reads(ctx, arr, hints[h], dest);
+        CATERVA_ERROR(caterva_free(ctx, &arr));
+
+        caterva_storage_t naive_storage = {0};
+        naive_storage.backend = CATERVA_STORAGE_BLOSC;
+        for (int i = 0; i < ndim; ++i) {
+            naive_storage.properties.blosc.chunkshape[i] = naive_chunkshape[i];
+            naive_storage.properties.blosc.blockshape[i] = naive_blockshape[i];
+        }
+        CATERVA_ERROR(caterva_from_buffer(ctx, data, size, &params, &naive_storage, &arr));
+        double naive = time_reads(ctx, arr, hints[h], dest);
+        CATERVA_ERROR(caterva_free(ctx, &arr));
+
+        printf("%-8s chunkshape (%d, %d) blockshape (%d, %d): %.3g ms per read "
+               "(naive: %.3g ms, speedup %.2fx)\n", names[h],
+               storage.properties.blosc.chunkshape[0], storage.properties.blosc.chunkshape[1],
+               storage.properties.blosc.blockshape[0], storage.properties.blosc.blockshape[1],
+               suggested * 1e3, naive * 1e3, naive / suggested);
+    }
+
+    free(dest);
+    free(data);
+    caterva_ctx_free(&ctx);
+
+    return 0;
+}
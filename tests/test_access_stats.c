@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t nchunks;
+    int64_t nblocks;
+} test_access_stats_shapes_t;
+
+
+CUTEST_TEST_DATA(access_stats) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(access_stats) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(shapes, test_access_stats_shapes_t, CUTEST_DATA(
+            {1, {100}, {30}, {7}, {25}, {65}, 3, 8}, // 1-dim
+            {2, {200, 200}, {200, 4}, {10, 2}, {7, 0}, {8, 200}, 50, 100}, // rows
+            {2, {200, 200}, {4, 200}, {2, 10}, {0, 7}, {200, 8}, 50, 100}, // columns
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, {3, 0, 3}, {6, 7, 10}, 4, 12}, // general
+    ));
+    CUTEST_PARAMETRIZE(nreads, int, CUTEST_DATA(1, 100));
+}
+
+
+CUTEST_TEST_TEST(access_stats) {
+    CUTEST_GET_PARAMETER(shapes, test_access_stats_shapes_t);
+    CUTEST_GET_PARAMETER(nreads, int);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(double);
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_zeros(data->ctx, &params, &storage, &src));
+    CATERVA_TEST_ASSERT(caterva_record_accesses(data->ctx, src, true));
+
+    int64_t destshape[CATERVA_MAX_DIM];
+    int64_t destnitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        destshape[i] = shapes.stop[i] - shapes.start[i];
+        destnitems *= destshape[i];
+    }
+    int64_t destsize = destnitems * params.itemsize;
+    double *dest = malloc(destsize);
+    for (int n = 0; n < nreads; ++n) {
+        CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, shapes.start, shapes.stop,
+                                                     destshape, dest, destsize));
+    }
+
+    /* The slices are recorded */
+    caterva_access_stats_t *stats = src->access_stats;
+    CUTEST_ASSERT("Slices are not counted", stats->naccesses == nreads);
+    CUTEST_ASSERT("Chunks are not counted", stats->nchunks == shapes.nchunks * nreads);
+    CUTEST_ASSERT("Blocks are not counted", stats->nblocks == shapes.nblocks * nreads);
+    CUTEST_ASSERT("Bytes used are not counted", stats->nbytes_used == destsize * nreads);
+    CUTEST_ASSERT("Bytes touched are not counted",
+                  stats->nbytes_touched ==
+                  shapes.nblocks * src->blocknitems * src->itemsize * nreads);
+    for (int i = 0; i < params.ndim; ++i) {
+        int64_t total = 0;
+        for (int bin = 0; bin < CATERVA_ACCESS_NBINS; ++bin) {
+            total += stats->extents[i][bin];
+            int64_t low = bin == 0 ? 0 : (int64_t) 1 << bin;
+            if (stats->extents[i][bin] != 0) {
+                CUTEST_ASSERT("Extent in the wrong bin",
+                              low <= destshape[i] && destshape[i] < (int64_t) 1 << (bin + 1));
+            }
+        }
+        CUTEST_ASSERT("Extents are not counted", total == nreads);
+    }
+
+    /* The recommended shapes are not more expensive than the current ones */
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    double speedup;
+    CATERVA_TEST_ASSERT(caterva_recommend_shapes(data->ctx, src, chunkshape, blockshape,
+                                                 &speedup));
+    CUTEST_ASSERT("Speedup is lower than 1", speedup >= 1);
+    for (int i = 0; i < params.ndim; ++i) {
+        CUTEST_ASSERT("Shapes are not nested",
+                      0 < blockshape[i] && blockshape[i] <= chunkshape[i] &&
+                      chunkshape[i] <= shapes.shape[i]);
+    }
+    if (params.ndim == 2) {
+        CUTEST_ASSERT("Chunks are not recommended for the slices", speedup > 1);
+    }
+
+    FILE *stream = tmpfile();
+    CUTEST_ASSERT("Can not create the report file", stream != NULL);
+    CATERVA_TEST_ASSERT(caterva_access_report(data->ctx, src, stream));
+    CUTEST_ASSERT("Report is empty", ftell(stream) > 0);
+    fclose(stream);
+
+    /* Stopping the recording discards the statistics */
+    CATERVA_TEST_ASSERT(caterva_record_accesses(data->ctx, src, false));
+    CUTEST_ASSERT("Slices are still recorded", src->access_stats == NULL);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, shapes.start, shapes.stop,
+                                                 destshape, dest, destsize));
+    CATERVA_TEST_ASSERT(caterva_record_accesses(data->ctx, src, true));
+    CUTEST_ASSERT("Statistics are not discarded", src->access_stats->naccesses == 0);
+
+    free(dest);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(access_stats) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(access_stats);
+}
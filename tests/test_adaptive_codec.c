@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+} test_adaptive_codec_shapes_t;
+
+typedef struct {
+    caterva_codec_target_t codec_target;
+    double target;
+} test_adaptive_codec_target_t;
+
+
+CUTEST_TEST_DATA(adaptive_codec) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(adaptive_codec) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(target, test_adaptive_codec_target_t, CUTEST_DATA(
+            {CATERVA_CODEC_TARGET_RATIO, 0}, // fastest candidate
+            {CATERVA_CODEC_TARGET_RATIO, 1000}, // best ratio (not reached)
+            {CATERVA_CODEC_TARGET_SPEED, 0}, // best ratio
+            {CATERVA_CODEC_TARGET_SPEED, 1e12}, // fastest candidate (not reached)
+    ));
+    CUTEST_PARAMETRIZE(shapes, test_adaptive_codec_shapes_t, CUTEST_DATA(
+            {1, {100}, {30}, {7}}, // 1-dim
+            {2, {40, 40}, {10, 20}, {4, 5}}, // general
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}}, // general
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+CUTEST_TEST_TEST(adaptive_codec) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_adaptive_codec_shapes_t);
+    CUTEST_GET_PARAMETER(target, test_adaptive_codec_target_t);
+
+    char *urlpath = "test_adaptive_codec.b2frame";
+    remove(urlpath);
+
+    caterva_ctx_t *ctx;
+    caterva_config_t cfg = *data->ctx->cfg;
+    cfg.ncandidates = 3;
+    cfg.candidates[0] = (caterva_codec_candidate_t) {BLOSC_BLOSCLZ, 5, BLOSC_SHUFFLE};
+    cfg.candidates[1] = (caterva_codec_candidate_t) {BLOSC_LZ4, 1, BLOSC_NOSHUFFLE};
+    cfg.candidates[2] = (caterva_codec_candidate_t) {BLOSC_ZSTD, 9, BLOSC_BITSHUFFLE};
+    cfg.codec_target = target.codec_target;
+    cfg.target_ratio = target.target;
+    cfg.target_speed = target.target;
+    CATERVA_TEST_ASSERT(caterva_ctx_new(&cfg, &ctx));
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int64_t);
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.persistent) {
+        storage.properties.blosc.urlpath = urlpath;
+    }
+    storage.properties.blosc.sequencial = backend.sequential;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+
+    /* Create original data mixing a constant region with a noisy one */
+    int64_t nitems = 1;
+    int64_t nchunks = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+        nchunks *= (shapes.shape[i] + shapes.chunkshape[i] - 1) / shapes.chunkshape[i];
+    }
+    int64_t buffersize = nitems * params.itemsize;
+    int64_t *buffer = malloc(buffersize);
+    uint64_t seed = 1234;
+    for (int64_t i = 0; i < nitems; ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        buffer[i] = i < nitems / 2 ? 3 : (int64_t) (seed >> 16);
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(ctx, buffer, buffersize, &params, &storage, &src));
+    int64_t ncompressed = 0;
+    for (int i = 0; i < CATERVA_MAX_CODEC_CANDIDATES; ++i) {
+        ncompressed += src->codec_nchunks[i];
+    }
+    CUTEST_ASSERT("The codec is not chosen for every chunk", ncompressed == nchunks);
+
+    /* Chunks compressed with different codecs are read back */
+    int64_t *dest = malloc(buffersize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, src, dest, buffersize));
+    for (int64_t i = 0; i < nitems; ++i) {
+        CUTEST_ASSERT("Elements are not equal", dest[i] == buffer[i]);
+    }
+
+    /* Modified chunks are compressed again with the codec chosen for them */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t slicesize = params.itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        stop[i] = shapes.chunkshape[i] / 2 + 1;
+        slicesize *= stop[i];
+    }
+    int64_t *slice = malloc(slicesize);
+    memset(slice, 0, slicesize);
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(ctx, slice, slicesize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(ctx, src));
+    CUTEST_ASSERT("The codec is not chosen for the modified chunk",
+                  src->codec_nchunks[0] + src->codec_nchunks[1] + src->codec_nchunks[2] ==
+                  nchunks + 1);
+
+    /* The codec contexts follow the candidates of the context used for each write */
+    caterva_ctx_t *narrow_ctx;
+    caterva_config_t narrow_cfg = cfg;
+    narrow_cfg.ncandidates = 1;
+    CATERVA_TEST_ASSERT(caterva_ctx_new(&narrow_cfg, &narrow_ctx));
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(narrow_ctx, slice, slicesize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(narrow_ctx, src));
+    CUTEST_ASSERT("The codec contexts do not follow the candidates",
+                  src->codec_ncandidates == 1 && src->codec_nchunks[0] == 1);
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(ctx, slice, slicesize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(ctx, src));
+    CUTEST_ASSERT("The codec contexts do not follow the candidates",
+                  src->codec_ncandidates == 3 &&
+                  src->codec_nchunks[0] + src->codec_nchunks[1] + src->codec_nchunks[2] == 1);
+    CATERVA_TEST_ASSERT(caterva_ctx_free(&narrow_ctx));
+    CATERVA_TEST_ASSERT(caterva_free(ctx, &src));
+
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_open(ctx, urlpath, &src));
+        CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, src, dest, buffersize));
+        CATERVA_TEST_ASSERT(caterva_free(ctx, &src));
+        for (int64_t i = 0; i < nitems; ++i) {
+            int64_t rem = i;
+            bool inside = true;
+            for (int j = params.ndim - 1; j >= 0; --j) {
+                if (rem % shapes.shape[j] >= stop[j]) {
+                    inside = false;
+                }
+                rem /= shapes.shape[j];
+            }
+            CUTEST_ASSERT("Elements are not equal", dest[i] == (inside ? 0 : buffer[i]));
+        }
+    }
+    free(slice);
+    free(dest);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_ctx_free(&ctx));
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(adaptive_codec) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(adaptive_codec);
+}
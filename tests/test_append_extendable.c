@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int8_t axis;
+    int64_t nslabs;
+} test_append_extendable_shapes_t;
+
+
+// Read a whole file (NULL if it can not be read)
+static uint8_t *read_file(const char *urlpath, int64_t *len) {
+    FILE *fp = fopen(urlpath, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    uint8_t *content = malloc(*len + 1);
+    if (fread(content, 1, (size_t) *len, fp) != (size_t) *len) {
+        free(content);
+        content = NULL;
+    }
+    fclose(fp);
+    return content;
+}
+
+
+CUTEST_TEST_DATA(append_extendable) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(append_extendable) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(shapes, test_append_extendable_shapes_t, CUTEST_DATA(
+            {1, {0}, {4}, {2}, 0, 6}, // 1-dim from 0-shape
+            {3, {0, 6, 5}, {2, 4, 5}, {1, 2, 2}, 0, 5}, // time series from 0-shape
+            {3, {4, 6, 5}, {2, 4, 5}, {2, 2, 2}, 0, 3}, // time series already filled
+            {2, {7, 4}, {3, 2}, {2, 2}, 1, 4}, // trailing axis
+            {3, {5, 0, 3}, {2, 3, 2}, {2, 2, 2}, 1, 19}, // inner axis (metalayer updated)
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+// Append chunks until the array is filled, plus nslabs slabs along the extendable axis.
+// Each item gets its position in an array with the final shape.
+static int append_chunks(caterva_ctx_t *ctx, caterva_array_t *array, int64_t nslabs,
+                         const int64_t *final_shape) {
+    int8_t axis = array->extendable_axis;
+    int64_t grid[CATERVA_MAX_DIM];
+    int64_t ngrid = 1;
+    int64_t nslab = 1;
+    for (int i = 0; i < array->ndim; ++i) {
+        grid[i] = (array->shape[i] + array->chunkshape[i] - 1) / array->chunkshape[i];
+        ngrid *= grid[i];
+        nslab *= (i == axis) ? 1 : grid[i];
+    }
+    int64_t nchunks = ngrid + nslabs * nslab;
+    int64_t *chunk = malloc(array->chunknitems * sizeof(int64_t));
+
+    for (int64_t n = array->nchunks; n < nchunks; ) {
+        // Compute the chunk coordinates
+        int64_t coords[CATERVA_MAX_DIM];
+        int64_t nchunk = n < ngrid ? n : (n - ngrid) % nslab;
+        for (int i = array->ndim - 1; i >= 0; --i) {
+            int64_t ncoords = (i == axis && n >= ngrid) ? 1 : grid[i];
+            coords[i] = nchunk % ncoords;
+            nchunk /= ncoords;
+        }
+        if (n >= ngrid) {
+            coords[axis] = grid[axis] + (n - ngrid) / nslab;
+        }
+
+        // Fill the chunk
+        for (int64_t j = 0; j < array->next_chunknitems; ++j) {
+            int64_t rem = j;
+            int64_t value = 0;
+            int64_t inc = 1;
+            for (int i = array->ndim - 1; i >= 0; --i) {
+                int64_t coord = coords[i] * array->chunkshape[i] + rem % array->next_chunkshape[i];
+                rem /= array->next_chunkshape[i];
+                value += coord * inc;
+                inc *= final_shape[i];
+            }
+            chunk[j] = value;
+        }
+        CATERVA_TEST_ASSERT(caterva_append(ctx, array, chunk,
+                                           array->next_chunknitems * sizeof(int64_t)));
+        n++;
+        CUTEST_ASSERT("Array is filled before a slab is completed",
+                      array->filled == (n >= ngrid && (n - ngrid) % nslab == 0));
+    }
+    free(chunk);
+
+    return 0;
+}
+
+
+static int check_array(caterva_ctx_t *ctx, caterva_array_t *array, const int64_t *shape) {
+    for (int i = 0; i < array->ndim; ++i) {
+        CUTEST_ASSERT("Shape is not updated", array->shape[i] == shape[i]);
+    }
+    int64_t buffersize = array->nitems * array->itemsize;
+    int64_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+    for (int64_t i = 0; i < array->nitems; ++i) {
+        CUTEST_ASSERT("Elements are not equal", buffer[i] == i);
+    }
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(append_extendable) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_append_extendable_shapes_t);
+
+    char *urlpath = "test_append_extendable.b2frame";
+    remove(urlpath);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int64_t);
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.persistent) {
+        storage.properties.blosc.urlpath = urlpath;
+    }
+    storage.properties.blosc.sequencial = backend.sequential;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+    storage.properties.blosc.extendable = true;
+    storage.properties.blosc.extendable_axis = shapes.axis;
+
+    // The array grows a chunkshape in the extendable axis per slab (and one more when reopened)
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t final_shape[CATERVA_MAX_DIM];
+    for (int i = 0; i < params.ndim; ++i) {
+        shape[i] = shapes.shape[i];
+        final_shape[i] = shapes.shape[i];
+    }
+    shape[shapes.axis] += shapes.nslabs * shapes.chunkshape[shapes.axis];
+    final_shape[shapes.axis] = shape[shapes.axis];
+    if (backend.persistent) {
+        final_shape[shapes.axis] += shapes.chunkshape[shapes.axis];
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_empty(data->ctx, &params, &storage, &src));
+    if (append_chunks(data->ctx, src, shapes.nslabs, final_shape) != 0) {
+        return CUNIT_FAIL;
+    }
+    if (!backend.persistent && check_array(data->ctx, src, shape) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* An array only opened is not rewritten when it is freed */
+    if (backend.persistent && backend.sequential) {
+        int64_t len;
+        int64_t len2;
+        uint8_t *frame = read_file(urlpath, &len);
+        CUTEST_ASSERT("Frame is not written", frame != NULL);
+        caterva_array_t *dest;
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &dest));
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+        uint8_t *frame2 = read_file(urlpath, &len2);
+        CUTEST_ASSERT("Frame is rewritten", frame2 != NULL && len == len2 &&
+                                            memcmp(frame, frame2, (size_t) len) == 0);
+        free(frame);
+        free(frame2);
+    }
+
+    /* A reopened array keeps growing along its extendable axis */
+    if (backend.persistent) {
+        caterva_array_t *dest;
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &dest));
+        CUTEST_ASSERT("Array is not extendable", dest->extendable);
+        CUTEST_ASSERT("Extendable axis is not persisted", dest->extendable_axis == shapes.axis);
+        for (int i = 0; i < params.ndim; ++i) {
+            CUTEST_ASSERT("Shape is not persisted", dest->shape[i] == shape[i]);
+        }
+        if (append_chunks(data->ctx, dest, 1, final_shape) != 0) {
+            return CUNIT_FAIL;
+        }
+        if (check_array(data->ctx, dest, final_shape) != 0) {
+            return CUNIT_FAIL;
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    }
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(append_extendable) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(append_extendable);
+}
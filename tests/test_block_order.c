@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_block_order_shapes_t;
+
+
+CUTEST_TEST_DATA(block_order) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(block_order) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(shapes, test_block_order_shapes_t, CUTEST_DATA(
+            {1, {100}, {30}, {7}, {5}, {77}}, // 1-dim
+            {2, {40, 40}, {16, 20}, {4, 5}, {3, 12}, {35, 33}}, // general
+            {3, {10, 10, 10}, {6, 8, 9}, {2, 2, 3}, {1, 2, 3}, {9, 10, 7}}, // general
+            {2, {20, 0}, {7, 0}, {3, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+static int check_array(caterva_ctx_t *ctx, caterva_array_t *array, const int64_t *result) {
+    int64_t buffersize = array->nitems * array->itemsize;
+    int64_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(block_order) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_block_order_shapes_t);
+
+    char *urlpath = "test_block_order.b2frame";
+    char *urlpath_copy = "test_block_order_copy.b2frame";
+    remove(urlpath);
+    remove(urlpath_copy);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int64_t);
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.persistent) {
+        storage.properties.blosc.urlpath = urlpath;
+    }
+    storage.properties.blosc.sequencial = backend.sequential;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+    storage.properties.blosc.block_order = CATERVA_BLOCK_ORDER_MORTON;
+
+    /* Create original data */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    int64_t buffersize = nitems * params.itemsize;
+    int64_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < nitems; ++i) {
+        result[i] = i;
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* The blocks of the first chunk are stored along the Z-order curve */
+    if (nitems > 0) {
+        int64_t grid[CATERVA_MAX_DIM];
+        int64_t nblocks = 1;
+        for (int i = 0; i < params.ndim; ++i) {
+            grid[i] = src->extchunkshape[i] / src->blockshape[i];
+            nblocks *= grid[i];
+        }
+        int64_t *chunk = malloc(src->extchunknitems * params.itemsize);
+        CUTEST_ASSERT("Can not decompress the chunk",
+                      blosc2_schunk_decompress_chunk(src->sc, 0, chunk,
+                                                     src->extchunknitems * params.itemsize) >= 0);
+        bool *used = calloc(nblocks, sizeof(bool));
+        for (int64_t nblock = 0; nblock < nblocks; ++nblock) {
+            // The first item of a block is its origin in the array
+            int64_t rem = nblock;
+            int64_t coords[CATERVA_MAX_DIM];
+            bool inside = true;
+            int64_t value = 0;
+            for (int i = params.ndim - 1; i >= 0; --i) {
+                coords[i] = rem % grid[i] * src->blockshape[i];
+                rem /= grid[i];
+                if (coords[i] >= shapes.chunkshape[i]) {
+                    inside = false;
+                }
+            }
+            for (int i = 0; i < params.ndim; ++i) {
+                value = value * shapes.shape[i] + coords[i];
+            }
+            int64_t position = src->block_positions[nblock];
+            CUTEST_ASSERT("Block position out of range", position >= 0 && position < nblocks);
+            CUTEST_ASSERT("Block position is repeated", !used[position]);
+            used[position] = true;
+            if (inside) {
+                CUTEST_ASSERT("Block is not in its position",
+                              chunk[position * src->blocknitems] == value);
+            }
+        }
+        CUTEST_ASSERT("The first block is not the curve origin", src->block_positions[0] == 0);
+        free(used);
+        free(chunk);
+    }
+
+    /* Setting a slice writes the blocks in their positions */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t slicesize = params.itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = shapes.start[i];
+        stop[i] = shapes.stop[i];
+        slicesize *= stop[i] - start[i];
+    }
+    int64_t *slice = malloc(slicesize + 1);
+    for (int64_t j = 0; j < slicesize / params.itemsize; ++j) {
+        int64_t rem = j;
+        int64_t ind = 0;
+        int64_t inc = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            int64_t shape = stop[i] - start[i];
+            ind += (start[i] + rem % shape) * inc;
+            rem /= shape;
+            inc *= shapes.shape[i];
+        }
+        slice[j] = -j;
+        result[ind] = -j;
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* Getting a slice reads the blocks from their positions */
+    int64_t slice_shape[CATERVA_MAX_DIM] = {0};
+    for (int i = 0; i < params.ndim; ++i) {
+        slice_shape[i] = stop[i] - start[i];
+    }
+    int64_t *dest_slice = malloc(slicesize + 1);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, slice_shape,
+                                                 dest_slice, slicesize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(dest_slice, slice, slicesize) == 0);
+    free(dest_slice);
+    free(slice);
+
+    /* Copying changes the block order */
+    caterva_storage_t storage_copy = storage;
+    storage_copy.properties.blosc.urlpath = NULL;
+    storage_copy.properties.blosc.block_order = CATERVA_BLOCK_ORDER_ROW_MAJOR;
+    caterva_array_t *rowmajor;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &storage_copy, &rowmajor));
+    CUTEST_ASSERT("Block order is not changed", rowmajor->block_positions == NULL);
+    if (check_array(data->ctx, rowmajor, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    storage_copy.properties.blosc.urlpath = backend.persistent ? urlpath_copy : NULL;
+    storage_copy.properties.blosc.block_order = CATERVA_BLOCK_ORDER_MORTON;
+    caterva_array_t *morton;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, rowmajor, &storage_copy, &morton));
+    if (check_array(data->ctx, morton, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &morton));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &rowmajor));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* The block order is persisted */
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+        CUTEST_ASSERT("Block order is not persisted",
+                      src->block_order == CATERVA_BLOCK_ORDER_MORTON);
+        if (check_array(data->ctx, src, result) != 0) {
+            return CUNIT_FAIL;
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    }
+
+    /* Arrays filled with a value have the same blocks in any order */
+    uint8_t value[8];
+    memset(value, 3, sizeof(value));
+    storage.properties.blosc.urlpath = NULL;
+    CATERVA_TEST_ASSERT(caterva_full(data->ctx, &params, &storage, value, &src));
+    int64_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer, buffersize));
+    for (int64_t i = 0; i < nitems; ++i) {
+        CUTEST_ASSERT("Elements are not equal", memcmp(&buffer[i], value, sizeof(int64_t)) == 0);
+    }
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    free(result);
+    remove(urlpath);
+    remove(urlpath_copy);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(block_order) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(block_order);
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int64_t ccache_size;
+    int io_depth;
+} test_ccache_t;
+
+
+CUTEST_TEST_DATA(ccache) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(ccache) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(cache, test_ccache_t, CUTEST_DATA(
+            {0, 1}, // no cache
+            {2000, 1}, // a few chunks
+            {1 << 24, 1}, // every chunk
+            {1 << 24, 4}, // every chunk (read ahead)
+    ));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {1, {10}, {7}, {2}}, // 1-idim
+            {1, {100}, {20}, {20}}, // aligned chunks
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+CUTEST_TEST_TEST(ccache) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(cache, test_ccache_t);
+
+    char *urlpath = "test_ccache.b2frame";
+    remove(urlpath);
+    data->ctx->cfg->ccache_size = cache.ccache_size;
+    data->ctx->cfg->io_depth = cache.io_depth;
+
+    uint8_t itemsize = 4;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    storage.properties.blosc.urlpath = urlpath;
+    storage.properties.blosc.sequencial = backend.sequential;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+
+    /* Create original data */
+    int64_t buffersize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        buffersize *= shapes.shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+    uint8_t *buffer_dest = malloc(buffersize);
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+
+    /* The chunks read twice are taken from the cache the second time */
+    caterva_ccache_stats_t stats;
+    for (int i = 0; i < 2; ++i) {
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+        CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+    }
+    CATERVA_TEST_ASSERT(caterva_ccache_stats(data->ctx, src, &stats));
+    CUTEST_ASSERT("Chunks are cached", cache.ccache_size > 0 || stats.nchunks == 0);
+    CUTEST_ASSERT("Budget is exceeded", stats.nbytes <= cache.ccache_size);
+    CUTEST_ASSERT("Chunks are not read", cache.ccache_size == 0 ||
+                                         stats.nhits + stats.nmisses == 2 * src->sc->nchunks);
+    if (cache.ccache_size >= src->sc->cbytes) {
+        CUTEST_ASSERT("Chunks are not cached", stats.nchunks == src->sc->nchunks);
+        CUTEST_ASSERT("Chunks are not taken from the cache", stats.nhits == src->sc->nchunks);
+        CUTEST_ASSERT("Chunks are evicted", stats.nevictions == 0);
+    }
+
+    /* Only the chunk updated in place is dropped from the cache */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM];
+    int64_t chunksize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        stop[i] = src->chunkshape[i];
+        chunksize *= src->chunkshape[i];
+    }
+    uint8_t *chunk = malloc(chunksize);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, stop, chunk,
+                                                 chunksize));
+    for (int64_t i = 0; i < chunksize; ++i) {
+        chunk[i] = (uint8_t) (chunk[i] + 1);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, chunk, chunksize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    free(chunk);
+    CATERVA_TEST_ASSERT(caterva_ccache_stats(data->ctx, src, &stats));
+    if (cache.ccache_size >= src->sc->cbytes) {
+        CUTEST_ASSERT("Chunks not updated are dropped", stats.nchunks == src->sc->nchunks - 1);
+    }
+
+    /* The chunks modified are not taken from the cache */
+    for (int64_t i = 0; i < buffersize; ++i) {
+        buffer[i] = (uint8_t) (buffer[i] + 1);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, buffer, buffersize, start,
+                                                 src->shape, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+
+    free(buffer);
+    free(buffer_dest);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(ccache) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(ccache);
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_chunk_order_shapes_t;
+
+
+CUTEST_TEST_DATA(chunk_order) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(chunk_order) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(chunk_order, caterva_chunk_order_t, CUTEST_DATA(
+            CATERVA_CHUNK_ORDER_MORTON,
+            CATERVA_CHUNK_ORDER_HILBERT,
+    ));
+    CUTEST_PARAMETRIZE(shapes, test_chunk_order_shapes_t, CUTEST_DATA(
+            {1, {100}, {7}, {7}, {20}, {61}}, // 1-dim
+            {2, {16, 16}, {4, 4}, {4, 4}, {3, 5}, {9, 13}}, // power of 2 grid
+            {2, {14, 10}, {3, 4}, {2, 2}, {5, 3}, {9, 10}}, // general
+            {3, {10, 10, 10}, {3, 5, 2}, {3, 5, 2}, {3, 0, 3}, {6, 7, 10}}, // general
+            {2, {20, 0}, {7, 0}, {3, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+static int check_array(caterva_ctx_t *ctx, caterva_array_t *array, const int64_t *result) {
+    int64_t buffersize = array->nitems * array->itemsize;
+    int64_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+    for (int64_t i = 0; i < array->nitems; ++i) {
+        CUTEST_ASSERT("Elements are not equal", buffer[i] == result[i]);
+    }
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(chunk_order) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_chunk_order_shapes_t);
+    CUTEST_GET_PARAMETER(chunk_order, caterva_chunk_order_t);
+
+    char *urlpath = "test_chunk_order.b2frame";
+    remove(urlpath);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int64_t);
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.persistent) {
+        storage.properties.blosc.urlpath = urlpath;
+    }
+    storage.properties.blosc.sequencial = backend.sequential;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+    storage.properties.blosc.chunk_order = chunk_order;
+
+    /* Create original data with each item holding its position */
+    int64_t nitems = 1;
+    int64_t grid[CATERVA_MAX_DIM];
+    int64_t nchunks = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+        grid[i] = shapes.shape[i] == 0 ? 0 : (shapes.shape[i] + shapes.chunkshape[i] - 1) /
+                                             shapes.chunkshape[i];
+        nchunks *= grid[i];
+    }
+    int64_t buffersize = nitems * params.itemsize;
+    int64_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < nitems; ++i) {
+        result[i] = i;
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* The chunks are stored along the curve */
+    bool *stored = calloc(nchunks + 1, sizeof(bool));
+    for (int64_t nchunk = 0; nchunk < nchunks; ++nchunk) {
+        int64_t position = src->chunk_positions[nchunk];
+        CUTEST_ASSERT("Positions are not a permutation",
+                      0 <= position && position < nchunks && !stored[position]);
+        stored[position] = true;
+
+        // The first item of the chunk stored in a position is the origin of the chunk
+        int64_t rem = nchunk;
+        int64_t origin = 0;
+        int64_t inc = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            origin += rem % grid[i] * shapes.chunkshape[i] * inc;
+            rem /= grid[i];
+            inc *= shapes.shape[i];
+        }
+        int64_t *chunk = malloc(src->extchunknitems * params.itemsize);
+        CUTEST_ASSERT("Can not decompress chunk",
+                      blosc2_schunk_decompress_chunk(src->sc, (int) position, chunk,
+                                                     src->extchunknitems * params.itemsize) >= 0);
+        CUTEST_ASSERT("Chunk is not in its position", chunk[0] == origin);
+        free(chunk);
+    }
+    free(stored);
+    if (params.ndim == 2 && shapes.shape[0] == 16) {
+        // Z-order goes to the right neighbour first, Hilbert order to the one below
+        int64_t right = src->chunk_positions[1];
+        int64_t below = src->chunk_positions[4];
+        CUTEST_ASSERT("Chunks are not in curve order",
+                      chunk_order == CATERVA_CHUNK_ORDER_MORTON ? right == 1 && below == 2
+                                                                : below == 1 && right == 3);
+    }
+
+    /* Slices are read and set through the chunk positions */
+    int64_t slicesize = params.itemsize;
+    int64_t sliceshape[CATERVA_MAX_DIM];
+    for (int i = 0; i < params.ndim; ++i) {
+        sliceshape[i] = shapes.stop[i] - shapes.start[i];
+        slicesize *= sliceshape[i];
+    }
+    int64_t *slice = malloc(slicesize + 1);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, shapes.start, shapes.stop,
+                                                 sliceshape, slice, slicesize));
+    for (int64_t j = 0; j < slicesize / params.itemsize; ++j) {
+        int64_t rem = j;
+        int64_t ind = 0;
+        int64_t inc = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            ind += (shapes.start[i] + rem % sliceshape[i]) * inc;
+            rem /= sliceshape[i];
+            inc *= shapes.shape[i];
+        }
+        CUTEST_ASSERT("Elements are not equal", slice[j] == result[ind]);
+        slice[j] = -ind;
+        result[ind] = -ind;
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, shapes.start,
+                                                 shapes.stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    free(slice);
+
+    /* Copying to another order appends the chunks in row-major order */
+    caterva_storage_t storage_copy = storage;
+    storage_copy.properties.blosc.urlpath = NULL;
+    storage_copy.properties.blosc.chunk_order = CATERVA_CHUNK_ORDER_ROW_MAJOR;
+    caterva_array_t *dest;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &storage_copy, &dest));
+    CUTEST_ASSERT("Chunk positions are not dropped", dest->chunk_positions == NULL);
+    if (check_array(data->ctx, dest, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    storage_copy.properties.blosc.chunk_order = chunk_order;
+    caterva_array_t *dest2;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, dest, &storage_copy, &dest2));
+    if (check_array(data->ctx, dest2, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest2));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+
+    /* Arrays with chunks in curve order can not be resized */
+    if (params.ndim > 0) {
+        CUTEST_ASSERT("Array is resized",
+                      caterva_resize(data->ctx, src, src->shape) == CATERVA_ERR_INVALID_ARGUMENT);
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* The chunk order is persisted in the caterva metalayer */
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+        CUTEST_ASSERT("Chunk order is not persisted", src->chunk_order == chunk_order);
+        if (check_array(data->ctx, src, result) != 0) {
+            return CUNIT_FAIL;
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    }
+
+    /* Constant arrays insert their special chunks along the curve */
+    remove(urlpath);
+    int64_t value = 3;
+    CATERVA_TEST_ASSERT(caterva_full(data->ctx, &params, &storage, &value, &src));
+    for (int64_t i = 0; i < nitems; ++i) {
+        result[i] = value;
+    }
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    free(result);
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(chunk_order) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(chunk_order);
+}
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+// Get the size of the frames of an array (and of its shards)
+static int64_t get_frames_size(const char *urlpath, int64_t nshards) {
+    int64_t size = 0;
+    for (int64_t i = -1; i < nshards; ++i) {
+        char frame_urlpath[64];
+        if (i < 0) {
+            snprintf(frame_urlpath, sizeof(frame_urlpath), "%s", urlpath);
+        } else {
+            snprintf(frame_urlpath, sizeof(frame_urlpath), "%s.%d", urlpath, (int) i);
+        }
+        FILE *fp = fopen(frame_urlpath, "rb");
+        if (fp != NULL) {
+            fseek(fp, 0, SEEK_END);
+            size += ftell(fp);
+            fclose(fp);
+        }
+    }
+    return size;
+}
+
+
+static void remove_frames(const char *urlpath, int64_t nshards) {
+    remove(urlpath);
+    for (int64_t i = 0; i < nshards; ++i) {
+        char shard_urlpath[64];
+        snprintf(shard_urlpath, sizeof(shard_urlpath), "%s.%d", urlpath, (int) i);
+        remove(shard_urlpath);
+    }
+}
+
+
+CUTEST_TEST_DATA(compact) {
+    caterva_ctx_t *ctx;
+    caterva_ctx_t *ctx_recompress;
+};
+
+
+CUTEST_TEST_SETUP(compact) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+    cfg.complevel = 9;
+    caterva_ctx_new(&cfg, &data->ctx_recompress);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(recompress, bool, CUTEST_DATA(false, true));
+    CUTEST_PARAMETRIZE(sparse, bool, CUTEST_DATA(false, true));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}}, // 1-idim
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+            {3, {100, 0, 12}, {31, 0, 12}, {10, 0, 12}},
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, true, true},
+            {CATERVA_STORAGE_SHARDED, true, true},
+    ));
+}
+
+
+CUTEST_TEST_TEST(compact) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(sparse, bool);
+    CUTEST_GET_PARAMETER(recompress, bool);
+
+    char *urlpath = "test_compact.b2frame";
+    int64_t nshards = 0;
+    remove_frames(urlpath, 128);
+
+    uint8_t itemsize = 4;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.backend == CATERVA_STORAGE_SHARDED) {
+        storage.properties.sharded.urlpath = urlpath;
+        storage.properties.sharded.sequencial = backend.sequential;
+        storage.properties.sharded.shard_nchunks = 2;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.sharded.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.sharded.blockshape[i] = shapes.blockshape[i];
+        }
+    } else {
+        storage.properties.blosc.urlpath = urlpath;
+        storage.properties.blosc.sequencial = backend.sequential;
+        storage.properties.blosc.sparse = sparse;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+        }
+    }
+
+    /* Create original data (with zeros in its second half) */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    int64_t buffersize = nitems * itemsize;
+    uint8_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < buffersize; ++i) {
+        result[i] = i < buffersize / 2 ? (uint8_t) (i % 255 + 1) : 0;
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    if (backend.backend == CATERVA_STORAGE_SHARDED) {
+        nshards = src->nshards;
+    }
+
+    /* Update every chunk, leaving its previous data unused in the frame */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    for (int64_t i = 0; i < buffersize; ++i) {
+        result[i] = (uint8_t) (i % 251);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, result, buffersize, start,
+                                                 src->shape, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    int64_t size = get_frames_size(urlpath, nshards);
+
+    /* The arrays mapped before keep reading the previous frame */
+    uint8_t *buffer = malloc(buffersize + 1);
+#if !defined(_WIN32)
+    caterva_array_t *mapped;
+    CATERVA_TEST_ASSERT(caterva_open_mmap(data->ctx, urlpath, &mapped));
+    CUTEST_ASSERT("Mapped arrays can be compacted",
+                  caterva_compact(data->ctx, mapped, false) == CATERVA_ERR_READ_ONLY);
+#endif
+
+    caterva_ctx_t *ctx = recompress ? data->ctx_recompress : data->ctx;
+    CATERVA_TEST_ASSERT(caterva_compact(ctx, src, recompress));
+    CUTEST_ASSERT("Frame is not compacted", get_frames_size(urlpath, nshards) <= size);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+
+#if !defined(_WIN32)
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, mapped, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &mapped));
+#endif
+
+    /* The compacted array can be updated and opened again */
+    if (buffersize > 0) {
+        result[0] ^= 0xff;
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, result, buffersize, start,
+                                                 src->shape, src));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+    caterva_array_t *part = backend.backend == CATERVA_STORAGE_SHARDED && src->nshards > 0 ?
+                            src->shards[0] : src;
+    if (part->sc != NULL) {
+        CUTEST_ASSERT("Chunks are not recompressed",
+                      part->sc->clevel == (recompress ? 9 : CATERVA_CONFIG_DEFAULTS.complevel));
+    }
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* Only sequential frames on disk can be compacted */
+    storage.properties.blosc.urlpath = NULL;
+    storage.properties.sharded.urlpath = NULL;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    if (backend.backend == CATERVA_STORAGE_BLOSC) {
+        CUTEST_ASSERT("In-memory arrays can be compacted",
+                      caterva_compact(data->ctx, src, false) == CATERVA_ERR_INVALID_STORAGE);
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    free(buffer);
+    free(result);
+    remove_frames(urlpath, nshards);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(compact) {
+    caterva_ctx_free(&data->ctx);
+    caterva_ctx_free(&data->ctx_recompress);
+}
+
+int main() {
+    CUTEST_TEST_RUN(compact);
+}
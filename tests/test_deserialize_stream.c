@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+#define STREAM_HEADER_LEN 148
+
+typedef struct {
+    uint8_t *data;
+    int64_t len;
+    int64_t pos;
+    int64_t max_read;
+    const uint8_t *result;
+    int64_t nchunks;
+    bool chunks_ok;
+} test_stream_t;
+
+
+static int64_t write_stream(const void *data, int64_t size, void *userdata) {
+    test_stream_t *stream = userdata;
+    stream->data = realloc(stream->data, (size_t) (stream->len + size));
+    memcpy(stream->data + stream->len, data, (size_t) size);
+    stream->len += size;
+    return size;
+}
+
+
+// Return the stream in pieces of up to max_read bytes (like a pipe)
+static int64_t read_stream(void *data, int64_t size, void *userdata) {
+    test_stream_t *stream = userdata;
+    int64_t rbytes = size < stream->max_read ? size : stream->max_read;
+    if (rbytes > stream->len - stream->pos) {
+        rbytes = stream->len - stream->pos;
+    }
+    memcpy(data, stream->data + stream->pos, (size_t) rbytes);
+    stream->pos += rbytes;
+    return rbytes;
+}
+
+
+// The largest allocation made while reading a stream
+static size_t max_alloc = 0;
+
+static void *track_alloc(size_t size) {
+    max_alloc = size > max_alloc ? size : max_alloc;
+    return malloc(size);
+}
+
+
+// Check that the items of every chunk can be read as soon as it is received
+static int check_chunk(caterva_array_t *array, int64_t *start, int64_t *stop, void *userdata) {
+    test_stream_t *stream = userdata;
+    stream->nchunks++;
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    caterva_ctx_t *ctx;
+    caterva_ctx_new(&cfg, &ctx);
+    int64_t shape[CATERVA_MAX_DIM] = {0};
+    int64_t size = array->itemsize;
+    for (int i = 0; i < array->ndim; ++i) {
+        shape[i] = stop[i] - start[i];
+        size *= shape[i];
+    }
+    uint8_t *chunk = malloc(size + 1);
+    if (caterva_get_slice_buffer(ctx, array, start, stop, shape, chunk, size) != CATERVA_SUCCEED) {
+        stream->chunks_ok = false;
+    }
+    for (int64_t j = 0; j < size / array->itemsize; ++j) {
+        int64_t rem = j;
+        int64_t ind = 0;
+        int64_t inc = 1;
+        for (int i = array->ndim - 1; i >= 0; --i) {
+            ind += (start[i] + rem % shape[i]) * inc;
+            rem /= shape[i];
+            inc *= array->shape[i];
+        }
+        if (memcmp(&chunk[j * array->itemsize], &stream->result[ind * array->itemsize],
+                   array->itemsize) != 0) {
+            stream->chunks_ok = false;
+        }
+    }
+    free(chunk);
+    caterva_ctx_free(&ctx);
+    return CATERVA_SUCCEED;
+}
+
+
+CUTEST_TEST_DATA(deserialize_stream) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(deserialize_stream) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(max_read, int64_t, CUTEST_DATA(7, 1 << 20));
+    CUTEST_PARAMETRIZE(sparse, bool, CUTEST_DATA(false, true));
+    CUTEST_PARAMETRIZE(block_order, caterva_block_order_t, CUTEST_DATA(
+            CATERVA_BLOCK_ORDER_ROW_MAJOR,
+            CATERVA_BLOCK_ORDER_MORTON,
+    ));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}}, // 1-idim
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+            {3, {100, 0, 12}, {31, 0, 12}, {10, 0, 12}},
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+CUTEST_TEST_TEST(deserialize_stream) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(block_order, caterva_block_order_t);
+    CUTEST_GET_PARAMETER(sparse, bool);
+    CUTEST_GET_PARAMETER(max_read, int64_t);
+
+    char *urlpath = "test_deserialize_stream.b2frame";
+    remove(urlpath);
+
+    uint8_t itemsize = 4;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.sequencial = true;
+    storage.properties.blosc.sparse = sparse;
+    storage.properties.blosc.block_order = block_order;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+    uint8_t meta[] = {1, 2, 3};
+    storage.properties.blosc.nmetalayers = 1;
+    storage.properties.blosc.metalayers[0].name = "user_meta";
+    storage.properties.blosc.metalayers[0].sdata = meta;
+    storage.properties.blosc.metalayers[0].size = sizeof(meta);
+
+    /* Create original data (with zeros in its second half) */
+    int64_t nitems = 1;
+    int64_t nchunks = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+        nchunks *= shapes.chunkshape[i] == 0 ? 0 : (shapes.shape[i] + shapes.chunkshape[i] - 1) /
+                                                   shapes.chunkshape[i];
+    }
+    int64_t buffersize = nitems * itemsize;
+    uint8_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < buffersize; ++i) {
+        result[i] = i < buffersize / 2 ? (uint8_t) (i % 255 + 1) : 0;
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    uint8_t vlmeta[] = {4, 5, 6, 7};
+    CUTEST_ASSERT("Can not add a variable-length metalayer",
+                  blosc2_vlmeta_add(src->sc, "user_vlmeta", vlmeta, sizeof(vlmeta), NULL) >= 0);
+    test_stream_t stream = {NULL, 0, 0, max_read, result, 0, true};
+    CATERVA_TEST_ASSERT(caterva_serialize_stream(data->ctx, src, write_stream, &stream));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* Every chunk is appended as soon as it is read */
+    caterva_storage_t dest_storage = {0};
+    dest_storage.backend = backend.backend;
+    dest_storage.properties.blosc.sequencial = backend.sequential;
+    if (backend.persistent) {
+        dest_storage.properties.blosc.urlpath = urlpath;
+    }
+    caterva_array_t *dest;
+    CATERVA_TEST_ASSERT(caterva_deserialize_stream(data->ctx, read_stream, check_chunk, &stream,
+                                                   &dest_storage, &dest));
+    CUTEST_ASSERT("Stream is not read", stream.pos == stream.len);
+    CUTEST_ASSERT("Chunks are not passed", stream.nchunks == nchunks);
+    CUTEST_ASSERT("Chunks are not readable", stream.chunks_ok);
+    CUTEST_ASSERT("Array is not filled", dest->filled);
+    CUTEST_ASSERT("Block order is not read", dest->block_order == block_order);
+    for (int i = 0; i < params.ndim; ++i) {
+        CUTEST_ASSERT("Shape is not read", dest->shape[i] == shapes.shape[i]);
+        CUTEST_ASSERT("Chunk shape is not read", dest->chunkshape[i] == shapes.chunkshape[i]);
+        CUTEST_ASSERT("Block shape is not read", dest->blockshape[i] == shapes.blockshape[i]);
+    }
+    /* The metalayers set by the user are carried in the stream */
+    uint8_t *content;
+    uint32_t content_len;
+    CUTEST_ASSERT("Metalayer is not read",
+                  blosc2_meta_get(dest->sc, "user_meta", &content, &content_len) >= 0 &&
+                  content_len == sizeof(meta) && memcmp(content, meta, sizeof(meta)) == 0);
+    free(content);
+    CUTEST_ASSERT("Variable-length metalayer is not read",
+                  blosc2_vlmeta_get(dest->sc, "user_vlmeta", &content, &content_len) >= 0 &&
+                  content_len == sizeof(vlmeta) && memcmp(content, vlmeta, sizeof(vlmeta)) == 0);
+    free(content);
+    uint8_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+
+    /* Truncated and corrupted streams are detected */
+    stream.pos = 0;
+    stream.len--;
+    CUTEST_ASSERT("Truncated stream is read",
+                  caterva_deserialize_stream(data->ctx, read_stream, NULL, &stream,
+                                             &dest_storage, &dest) != CATERVA_SUCCEED);
+    if (backend.persistent) {
+        FILE *fp = fopen(urlpath, "rb");
+        CUTEST_ASSERT("Partial frame is left on disk", fp == NULL);
+    }
+    stream.pos = 0;
+    stream.len++;
+    stream.data[stream.len - 1] ^= 0xff;
+    CUTEST_ASSERT("Corrupted stream is read",
+                  caterva_deserialize_stream(data->ctx, read_stream, NULL, &stream,
+                                             &dest_storage, &dest) != CATERVA_SUCCEED);
+    stream.data[stream.len - 1] ^= 0xff;
+
+    /* A corrupted length of a metalayer does not allocate more than the stream holds */
+    int64_t len_offset = STREAM_HEADER_LEN + 4 + 1 + (int64_t) strlen("user_meta");
+    uint8_t len_bytes[4];
+    memcpy(len_bytes, &stream.data[len_offset], sizeof(len_bytes));
+    memset(&stream.data[len_offset], 0xff, sizeof(len_bytes));
+    stream.data[len_offset + 3] = 0x7f;
+    stream.pos = 0;
+    max_alloc = 0;
+    void *(*alloc)(size_t) = data->ctx->cfg->alloc;
+    data->ctx->cfg->alloc = track_alloc;
+    CUTEST_ASSERT("Corrupted metalayer is read",
+                  caterva_deserialize_stream(data->ctx, read_stream, NULL, &stream,
+                                             &dest_storage, &dest) != CATERVA_SUCCEED);
+    data->ctx->cfg->alloc = alloc;
+    // The content is read in pieces of 64 KB at least
+    CUTEST_ASSERT("Corrupted metalayer is allocated",
+                  (int64_t) max_alloc <= 2 * stream.len + 64 * 1024 + 1);
+    memcpy(&stream.data[len_offset], len_bytes, sizeof(len_bytes));
+
+    free(stream.data);
+    free(result);
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(deserialize_stream) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(deserialize_stream);
+}
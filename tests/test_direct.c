@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static void remove_frames(const char *urlpath) {
+    remove(urlpath);
+    for (int i = 0; i < 128; ++i) {
+        char shard_urlpath[64];
+        snprintf(shard_urlpath, sizeof(shard_urlpath), "%s.%d", urlpath, i);
+        remove(shard_urlpath);
+    }
+}
+
+// The scans that read the frames with direct I/O (those of the shards are added up)
+static int64_t get_ndirect_scans(caterva_array_t *array) {
+    if (array->storage != CATERVA_STORAGE_SHARDED) {
+        return array->ndirect_scans;
+    }
+    int64_t nscans = 0;
+    for (int64_t i = 0; i < array->nshards; ++i) {
+        nscans += array->shards[i]->ndirect_scans;
+    }
+    return nscans;
+}
+
+
+CUTEST_TEST_DATA(direct) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(direct) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(io_depth, int, CUTEST_DATA(1, 4));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}}, // 1-idim
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+            {3, {100, 0, 12}, {31, 0, 12}, {10, 0, 12}},
+            {2, {1000, 700}, {250, 350}, {50, 50}}, // frames spanning several extents
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+            {CATERVA_STORAGE_SHARDED, true, true},
+    ));
+}
+
+
+CUTEST_TEST_TEST(direct) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(io_depth, int);
+
+    char *urlpath = "test_direct.b2frame";
+    remove_frames(urlpath);
+    data->ctx->cfg->io_depth = io_depth;
+
+    uint8_t itemsize = 4;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.backend == CATERVA_STORAGE_SHARDED) {
+        storage.properties.sharded.urlpath = backend.persistent ? urlpath : NULL;
+        storage.properties.sharded.sequencial = backend.sequential;
+        storage.properties.sharded.shard_nchunks = 2;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.sharded.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.sharded.blockshape[i] = shapes.blockshape[i];
+        }
+    } else {
+        storage.properties.blosc.urlpath = backend.persistent ? urlpath : NULL;
+        storage.properties.blosc.sequencial = backend.sequential;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+        }
+    }
+
+    /* Create original data */
+    int64_t buffersize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        buffersize *= shapes.shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize + 1);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+    uint8_t *buffer_dest = malloc(buffersize + 1);
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+
+    /* The frames on disk are read with direct I/O (the rest of arrays are read as usual) */
+    bool direct = backend.persistent && backend.sequential && buffersize > 0;
+    int64_t nframes = backend.backend == CATERVA_STORAGE_SHARDED ? src->nshards : 1;
+    CATERVA_TEST_ASSERT(caterva_advise(data->ctx, src, CATERVA_ADVICE_DIRECT));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+    CUTEST_ASSERT("Frames are not read with direct I/O",
+                  get_ndirect_scans(src) == (direct ? nframes : 0));
+
+    /* The chunks modified and not stored yet are read from the write-back cache */
+    for (int64_t i = 0; i < buffersize; ++i) {
+        buffer[i] = (uint8_t) (buffer[i] + 1);
+    }
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, buffer, buffersize, start,
+                                                 src->shape, src));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+    CUTEST_ASSERT("Frames with pending chunks are read with direct I/O",
+                  get_ndirect_scans(src) == (direct ? nframes : 0));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+    CUTEST_ASSERT("Frames are not read with direct I/O",
+                  get_ndirect_scans(src) == (direct ? 2 * nframes : 0));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* The advice is kept when an array opened lazily is loaded */
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_open_lazy(data->ctx, urlpath, &src));
+        CATERVA_TEST_ASSERT(caterva_advise(data->ctx, src, CATERVA_ADVICE_DIRECT));
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+        CUTEST_ASSERT("Advice is not kept", src->advice == CATERVA_ADVICE_DIRECT);
+        CUTEST_ASSERT("Frames are not read with direct I/O",
+                      get_ndirect_scans(src) == (direct ? nframes : 0));
+        CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    }
+
+    free(buffer);
+    free(buffer_dest);
+    remove_frames(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(direct) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(direct);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_full_shapes_t;
+
+
+CUTEST_TEST_DATA(full) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(full) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 4, 8));
+    CUTEST_PARAMETRIZE(fill_value, int8_t, CUTEST_DATA(0, 1, -3));
+    CUTEST_PARAMETRIZE(shapes, test_full_shapes_t, CUTEST_DATA(
+            {0, {0}, {0}, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}, {2}, {9}}, // 1-idim
+            {2, {14, 10}, {8, 5}, {2, 2}, {5, 3}, {9, 10}}, // general
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, {3, 0, 3}, {6, 7, 10}}, // general
+            {2, {20, 0}, {7, 0}, {3, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_PLAINBUFFER, false, false},
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+CUTEST_TEST_TEST(full) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_full_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+    CUTEST_GET_PARAMETER(fill_value, int8_t);
+
+    char *urlpath = "test_full.b2frame";
+    remove(urlpath);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.backend == CATERVA_STORAGE_BLOSC) {
+        if (backend.persistent) {
+            storage.properties.blosc.urlpath = urlpath;
+        }
+        storage.properties.blosc.sequencial = backend.sequential;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+        }
+    }
+
+    /* Use a value with all its bytes equal (to be valid for every itemsize) */
+    uint8_t value[8];
+    memset(value, (uint8_t) fill_value, sizeof(value));
+
+    caterva_array_t *src;
+    if (fill_value == 0) {
+        CATERVA_TEST_ASSERT(caterva_zeros(data->ctx, &params, &storage, &src));
+    } else {
+        CATERVA_TEST_ASSERT(caterva_full(data->ctx, &params, &storage, value, &src));
+    }
+    CUTEST_ASSERT("Array is not filled", src->filled);
+
+    /* Check a slice of the array */
+    int64_t destshape[CATERVA_MAX_DIM] = {0};
+    int64_t destbuffersize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        destshape[i] = shapes.stop[i] - shapes.start[i];
+        destbuffersize *= destshape[i];
+    }
+    uint8_t *destbuffer = malloc(destbuffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, shapes.start, shapes.stop,
+                                                 destshape, destbuffer, destbuffersize));
+    for (int64_t i = 0; i < destbuffersize; ++i) {
+        CUTEST_ASSERT("Elements are not equal", destbuffer[i] == (uint8_t) fill_value);
+    }
+    free(destbuffer);
+
+    /* The positions added when growing the array are zeros */
+    if (backend.backend == CATERVA_STORAGE_BLOSC && src->nitems != 0) {
+        int64_t new_shape[CATERVA_MAX_DIM];
+        for (int i = 0; i < params.ndim; ++i) {
+            new_shape[i] = shapes.shape[i] + 1;
+        }
+        CATERVA_TEST_ASSERT(caterva_resize(data->ctx, src, new_shape));
+        int64_t buffersize = src->nitems * itemsize;
+        uint8_t *buffer = malloc(buffersize);
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer, buffersize));
+        for (int64_t i = 0; i < src->nitems; ++i) {
+            int64_t rem = i;
+            bool inside = true;
+            for (int j = params.ndim - 1; j >= 0; --j) {
+                if (rem % new_shape[j] >= shapes.shape[j]) {
+                    inside = false;
+                }
+                rem /= new_shape[j];
+            }
+            uint8_t expected = inside ? (uint8_t) fill_value : 0;
+            for (int j = 0; j < itemsize; ++j) {
+                CUTEST_ASSERT("Elements are not equal", buffer[i * itemsize + j] == expected);
+            }
+        }
+        free(buffer);
+    }
+
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(full) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(full);
+}
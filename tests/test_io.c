@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#define TEST_IO_NFILES 4
+
+typedef enum {
+    TEST_IO_PREAD,
+    TEST_IO_PREADV,
+    TEST_IO_ASYNC,
+} test_io_mode_t;
+
+// An I/O backend keeping the files in memory
+typedef struct {
+    char urlpath[64];
+    uint8_t *data;
+    int64_t len;
+} test_io_file_t;
+
+typedef struct {
+    test_io_file_t files[TEST_IO_NFILES];
+    int nfiles;
+    bool readonly;
+} test_io_store_t;
+
+
+static void *mem_open(const char *urlpath, const char *mode, void *params) {
+    test_io_store_t *store = params;
+    for (int i = 0; i < store->nfiles; ++i) {
+        if (strcmp(store->files[i].urlpath, urlpath) == 0) {
+            if (store->readonly && (mode[0] == 'w' || mode[1] == '+')) {
+                return NULL;
+            }
+            if (mode[0] == 'w') {
+                store->files[i].len = 0;
+            }
+            return &store->files[i];
+        }
+    }
+    if (mode[0] == 'r' || store->nfiles == TEST_IO_NFILES) {
+        return NULL;
+    }
+    test_io_file_t *file = &store->files[store->nfiles++];
+    snprintf(file->urlpath, sizeof(file->urlpath), "%s", urlpath);
+    file->data = NULL;
+    file->len = 0;
+    return file;
+}
+
+static int mem_close(void *stream) {
+    (void) stream;
+    return 0;
+}
+
+static int64_t mem_pread(void *stream, void *data, int64_t size, int64_t offset) {
+    test_io_file_t *file = stream;
+    if (offset >= file->len) {
+        return 0;
+    }
+    // Read in small pieces, like a slow device
+    int64_t rbytes = size < file->len - offset ? size : file->len - offset;
+    rbytes = rbytes < 1000 ? rbytes : 1000;
+    memcpy(data, file->data + offset, (size_t) rbytes);
+    return rbytes;
+}
+
+static int64_t mem_pwrite(void *stream, const void *data, int64_t size, int64_t offset) {
+    test_io_file_t *file = stream;
+    if (offset + size > file->len) {
+        file->data = realloc(file->data, (size_t) (offset + size));
+        file->len = offset + size;
+    }
+    memcpy(file->data + offset, data, (size_t) size);
+    return size;
+}
+
+static int64_t mem_size(void *stream) {
+    test_io_file_t *file = stream;
+    return file->len;
+}
+
+static int mem_sync(void *stream) {
+    (void) stream;
+    return 0;
+}
+
+static int64_t mem_preadv(void *stream, caterva_io_vec_t *vecs, int nvecs) {
+    test_io_file_t *file = stream;
+    int64_t nbytes = 0;
+    for (int i = 0; i < nvecs; ++i) {
+        if (vecs[i].offset + vecs[i].size > file->len) {
+            return -1;
+        }
+        memcpy(vecs[i].data, file->data + vecs[i].offset, (size_t) vecs[i].size);
+        nbytes += vecs[i].size;
+    }
+    return nbytes;
+}
+
+#if !defined(_WIN32)
+typedef struct {
+    test_io_file_t *file;
+    caterva_io_vec_t *vecs;
+    int nvecs;
+    caterva_io_done_cb_t done_cb;
+    void *userdata;
+} test_io_reads_t;
+
+// Complete the reads from another thread, in reverse order
+static void *mem_read_async(void *arg) {
+    test_io_reads_t *reads = arg;
+    for (int i = reads->nvecs - 1; i >= 0; --i) {
+        caterva_io_vec_t *vec = &reads->vecs[i];
+        memcpy(vec->data, reads->file->data + vec->offset, (size_t) vec->size);
+        reads->done_cb(vec->size, reads->userdata);
+    }
+    free(reads->vecs);
+    free(reads);
+    return NULL;
+}
+
+static int mem_pread_async(void *stream, caterva_io_vec_t *vecs, int nvecs,
+                           caterva_io_done_cb_t done_cb, void *userdata) {
+    test_io_reads_t *reads = malloc(sizeof(test_io_reads_t));
+    reads->file = stream;
+    reads->vecs = malloc(nvecs * sizeof(caterva_io_vec_t));
+    memcpy(reads->vecs, vecs, nvecs * sizeof(caterva_io_vec_t));
+    reads->nvecs = nvecs;
+    reads->done_cb = done_cb;
+    reads->userdata = userdata;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, mem_read_async, reads) != 0) {
+        free(reads->vecs);
+        free(reads);
+        return -1;
+    }
+    pthread_detach(thread);
+    return nvecs;
+}
+#endif
+
+
+CUTEST_TEST_DATA(io) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(io) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(mode, test_io_mode_t, CUTEST_DATA(
+            TEST_IO_PREAD,
+            TEST_IO_PREADV,
+            TEST_IO_ASYNC,
+    ));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}}, // 1-idim
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+            {3, {100, 0, 12}, {31, 0, 12}, {10, 0, 12}},
+    ));
+}
+
+
+CUTEST_TEST_TEST(io) {
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(mode, test_io_mode_t);
+
+    char *urlpath = "test_io.b2frame";
+    remove(urlpath);
+
+    test_io_store_t store = {0};
+    caterva_io_t mem_io = {mem_open, mem_close, mem_pread, mem_pwrite, mem_size, mem_sync,
+                           NULL, NULL, &store};
+    if (mode == TEST_IO_PREADV) {
+        mem_io.preadv = mem_preadv;
+    }
+#if !defined(_WIN32)
+    if (mode == TEST_IO_ASYNC) {
+        mem_io.pread_async = mem_pread_async;
+    }
+#endif
+
+    uint8_t itemsize = 4;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.io = &mem_io;
+    storage.properties.blosc.urlpath = urlpath;
+    storage.properties.blosc.sequencial = true;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+
+    /* Create original data */
+    int64_t buffersize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        buffersize *= shapes.shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize + 1);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+    uint8_t *buffer_dest = malloc(buffersize + 1);
+
+    /* The frame is written in the backend (not in a local file) */
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    CUTEST_ASSERT("Frame is not written", store.nfiles == 1 && store.files[0].len > 0);
+    FILE *fp = fopen(urlpath, "rb");
+    CUTEST_ASSERT("Frame is written in a local file", fp == NULL);
+
+    /* The array is read-only if the stream can not be opened for writing */
+    store.readonly = true;
+    CATERVA_TEST_ASSERT(caterva_open_io(data->ctx, &mem_io, urlpath, &src));
+    CUTEST_ASSERT("Array is not read-only", src->readonly);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    store.readonly = false;
+
+    /* The chunks are updated through the backend */
+    CATERVA_TEST_ASSERT(caterva_open_io(data->ctx, &mem_io, urlpath, &src));
+    CUTEST_ASSERT("Array is read-only", !src->readonly);
+    if (params.ndim > 0 && buffersize > 0) {
+        int64_t start[CATERVA_MAX_DIM] = {0};
+        int64_t stop[CATERVA_MAX_DIM];
+        int64_t slicesize = itemsize;
+        for (int i = 0; i < params.ndim; ++i) {
+            stop[i] = shapes.shape[i] / 2 + 1;
+            slicesize *= stop[i];
+        }
+        uint8_t *slice = malloc(slicesize);
+        memset(slice, 0xAB, slicesize);
+        CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop,
+                                                     src));
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer, buffersize));
+        free(slice);
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    CATERVA_TEST_ASSERT(caterva_open_io(data->ctx, &mem_io, urlpath, &src));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer_dest, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+
+    /* It can be copied to a local file with the file backend */
+    caterva_storage_t storage_copy = storage;
+    storage_copy.io = caterva_io_file();
+    caterva_array_t *dest;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &storage_copy, &dest));
+    CUTEST_ASSERT("Array stored in a backend is compacted",
+                  caterva_compact(data->ctx, dest, false) == CATERVA_ERR_INVALID_STORAGE);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    CATERVA_TEST_ASSERT(caterva_open_io(data->ctx, caterva_io_file(), urlpath, &dest));
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, buffer_dest, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, buffer_dest, buffersize) == 0);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+
+    /* Only sequential frames with an urlpath are stored in a backend */
+    storage.properties.blosc.sequencial = false;
+    CUTEST_ASSERT("Sparse frames are stored in a backend",
+                  caterva_empty(data->ctx, &params, &storage, &dest) ==
+                  CATERVA_ERR_INVALID_STORAGE);
+    CUTEST_ASSERT("Missing frames are read",
+                  caterva_open_io(data->ctx, &mem_io, "missing.b2frame", &dest) !=
+                  CATERVA_SUCCEED);
+
+    for (int i = 0; i < store.nfiles; ++i) {
+        free(store.files[i].data);
+    }
+    free(buffer_dest);
+    free(buffer);
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(io) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(io);
+}
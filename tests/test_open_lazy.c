@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_open_lazy_shapes_t;
+
+
+CUTEST_TEST_DATA(open_lazy) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(open_lazy) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 4, 8));
+    CUTEST_PARAMETRIZE(block_order, caterva_block_order_t, CUTEST_DATA(
+            CATERVA_BLOCK_ORDER_ROW_MAJOR,
+            CATERVA_BLOCK_ORDER_MORTON,
+    ));
+    CUTEST_PARAMETRIZE(shapes, test_open_lazy_shapes_t, CUTEST_DATA(
+            {0, {0}, {0}, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}, {2}, {9}}, // 1-idim
+            {2, {14, 10}, {8, 5}, {2, 2}, {5, 3}, {9, 10}}, // general
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, {3, 0, 3}, {6, 7, 10}}, // general
+            {2, {20, 0}, {7, 0}, {3, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+// Open lazily an extendable array while slabs are appended to it (its metalayer is only updated
+// every few slabs)
+static int open_lazy_extendable(caterva_ctx_t *ctx, _test_backend backend, uint8_t itemsize,
+                                int32_t chunkshape, int32_t blockshape, char *urlpath) {
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = 1;
+    params.shape[0] = 0;
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    storage.properties.blosc.urlpath = urlpath;
+    storage.properties.blosc.sequencial = backend.sequential;
+    storage.properties.blosc.chunkshape[0] = chunkshape;
+    storage.properties.blosc.blockshape[0] = blockshape;
+    storage.properties.blosc.extendable = true;
+    storage.properties.blosc.extendable_axis = 0;
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_empty(ctx, &params, &storage, &src));
+    int64_t nslabs = 3;
+    int64_t buffersize = nslabs * chunkshape * itemsize;
+    uint8_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < buffersize; ++i) {
+        result[i] = (uint8_t) i;
+    }
+    uint8_t *buffer = malloc(buffersize + 1);
+    for (int64_t n = 0; n < nslabs; ++n) {
+        int64_t chunksize = chunkshape * itemsize;
+        CATERVA_TEST_ASSERT(caterva_append(ctx, src, &result[n * chunksize], chunksize));
+
+        /* The slabs appended since the metalayer was updated are in the shape */
+        caterva_array_t *dest;
+        CATERVA_TEST_ASSERT(caterva_open_lazy(ctx, urlpath, &dest));
+        CUTEST_ASSERT("Shape is stale", dest->shape[0] == (n + 1) * chunkshape);
+        CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, dest, buffer, (n + 1) * chunksize));
+        CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, (n + 1) * chunksize) == 0);
+        CUTEST_ASSERT("Shape changes when the array is loaded",
+                      dest->shape[0] == (n + 1) * chunkshape);
+        CATERVA_TEST_ASSERT(caterva_free(ctx, &dest));
+    }
+    free(buffer);
+    free(result);
+    CATERVA_TEST_ASSERT(caterva_free(ctx, &src));
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(open_lazy) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_open_lazy_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+    CUTEST_GET_PARAMETER(block_order, caterva_block_order_t);
+
+    char *urlpath = "test_open_lazy.b2frame";
+    remove(urlpath);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    storage.properties.blosc.urlpath = urlpath;
+    storage.properties.blosc.sequencial = backend.sequential;
+    storage.properties.blosc.block_order = block_order;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+
+    /* Create original data */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    int64_t buffersize = nitems * itemsize;
+    uint8_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < buffersize; ++i) {
+        result[i] = (uint8_t) i;
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* The geometry is read from the header of sequential frames only */
+    CATERVA_TEST_ASSERT(caterva_open_lazy(data->ctx, urlpath, &src));
+    if (backend.sequential) {
+        CUTEST_ASSERT("Super-chunk is loaded", src->sc == NULL && src->lazy_urlpath != NULL);
+    }
+    CUTEST_ASSERT("Dimensions are not read", src->ndim == shapes.ndim);
+    CUTEST_ASSERT("Itemsize is not read", src->itemsize == itemsize);
+    CUTEST_ASSERT("Block order is not read", src->block_order == block_order);
+    CUTEST_ASSERT("Number of items is not read", src->nitems == nitems);
+    for (int i = 0; i < params.ndim; ++i) {
+        CUTEST_ASSERT("Shape is not read", src->shape[i] == shapes.shape[i]);
+        CUTEST_ASSERT("Chunk shape is not read", src->chunkshape[i] == shapes.chunkshape[i]);
+        CUTEST_ASSERT("Block shape is not read", src->blockshape[i] == shapes.blockshape[i]);
+    }
+
+    /* Arrays that have not been loaded can be freed */
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* The super-chunk is loaded on the first access to the data */
+    CATERVA_TEST_ASSERT(caterva_open_lazy(data->ctx, urlpath, &src));
+    CATERVA_TEST_ASSERT(caterva_record_accesses(data->ctx, src, true));
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t slice_shape[CATERVA_MAX_DIM] = {0};
+    int64_t slicesize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = shapes.start[i];
+        stop[i] = shapes.stop[i];
+        slice_shape[i] = stop[i] - start[i];
+        slicesize *= slice_shape[i];
+    }
+    uint8_t *slice = malloc(slicesize + 1);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, slice_shape, slice,
+                                                 slicesize));
+    CUTEST_ASSERT("Super-chunk is not loaded", src->sc != NULL && src->lazy_urlpath == NULL);
+    CUTEST_ASSERT("Array is not filled", src->filled);
+    CUTEST_ASSERT("Recorded accesses are lost", src->access_stats != NULL &&
+                  src->access_stats->naccesses == (nitems > 0 ? 1 : 0));
+    for (int64_t j = 0; j < slicesize / itemsize; ++j) {
+        int64_t rem = j;
+        int64_t ind = 0;
+        int64_t inc = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            ind += (start[i] + rem % slice_shape[i]) * inc;
+            rem /= slice_shape[i];
+            inc *= shapes.shape[i];
+        }
+        CUTEST_ASSERT("Elements are not equal",
+                      memcmp(&slice[j * itemsize], &result[ind * itemsize], itemsize) == 0);
+    }
+    free(slice);
+
+    uint8_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* Frames with another format version are read eagerly */
+    if (backend.sequential) {
+        FILE *fp = fopen(urlpath, "r+b");
+        uint8_t flags;
+        fseek(fp, 25, SEEK_SET);
+        CUTEST_ASSERT("Can not read the frame", fread(&flags, 1, 1, fp) == 1);
+        flags = (uint8_t) ((flags & 0xf0) | 1);
+        fseek(fp, 25, SEEK_SET);
+        fwrite(&flags, 1, 1, fp);
+        fclose(fp);
+        CATERVA_TEST_ASSERT(caterva_open_lazy(data->ctx, urlpath, &src));
+        CUTEST_ASSERT("Super-chunk is not loaded", src->sc != NULL && src->lazy_urlpath == NULL);
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    }
+
+    free(result);
+    remove(urlpath);
+
+    if (shapes.ndim == 1 && open_lazy_extendable(data->ctx, backend, itemsize,
+                                                 shapes.chunkshape[0], shapes.blockshape[0],
+                                                 urlpath) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(open_lazy) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(open_lazy);
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_open_mmap_shapes_t;
+
+
+CUTEST_TEST_DATA(open_mmap) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(open_mmap) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 4, 8));
+    CUTEST_PARAMETRIZE(shapes, test_open_mmap_shapes_t, CUTEST_DATA(
+            {0, {0}, {0}, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}, {2}, {9}}, // 1-idim
+            {2, {14, 10}, {8, 5}, {2, 2}, {5, 3}, {9, 10}}, // general
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, {3, 0, 3}, {6, 7, 10}}, // general
+            {2, {20, 0}, {7, 0}, {3, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+static int check_array(caterva_ctx_t *ctx, caterva_array_t *array, const uint8_t *result) {
+    int64_t buffersize = array->nitems * array->itemsize;
+    uint8_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(open_mmap) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_open_mmap_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    char *urlpath = "test_open_mmap.b2frame";
+    remove(urlpath);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    storage.properties.blosc.urlpath = urlpath;
+    storage.properties.blosc.sequencial = backend.sequential;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+
+    /* Create original data */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    int64_t buffersize = nitems * itemsize;
+    uint8_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < buffersize; ++i) {
+        result[i] = (uint8_t) i;
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* Several arrays share the mapped frame */
+    caterva_array_t *other;
+    CATERVA_TEST_ASSERT(caterva_open_mmap(data->ctx, urlpath, &src));
+    CATERVA_TEST_ASSERT(caterva_open_mmap(data->ctx, urlpath, &other));
+    CUTEST_ASSERT("Array is not read-only", src->readonly && other->readonly);
+    CUTEST_ASSERT("Frame is not mapped", src->map != NULL);
+    CUTEST_ASSERT("Array is not filled", src->filled);
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    if (check_array(data->ctx, other, result) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* Slices are read from the mapping */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t slice_shape[CATERVA_MAX_DIM] = {0};
+    int64_t slicesize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = shapes.start[i];
+        stop[i] = shapes.stop[i];
+        slice_shape[i] = stop[i] - start[i];
+        slicesize *= slice_shape[i];
+    }
+    uint8_t *slice = malloc(slicesize + 1);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, slice_shape, slice,
+                                                 slicesize));
+    for (int64_t j = 0; j < slicesize / itemsize; ++j) {
+        int64_t rem = j;
+        int64_t ind = 0;
+        int64_t inc = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            ind += (start[i] + rem % slice_shape[i]) * inc;
+            rem /= slice_shape[i];
+            inc *= shapes.shape[i];
+        }
+        CUTEST_ASSERT("Elements are not equal",
+                      memcmp(&slice[j * itemsize], &result[ind * itemsize], itemsize) == 0);
+    }
+
+    /* The mapped array can not be modified */
+    if (nitems > 0) {
+        CUTEST_ASSERT("A read-only array is modified",
+                      caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop, src) ==
+                      CATERVA_ERR_READ_ONLY);
+    }
+    if (params.ndim > 0) {
+        CUTEST_ASSERT("A read-only array is resized",
+                      caterva_resize(data->ctx, src, shapes.shape) == CATERVA_ERR_READ_ONLY);
+    }
+    free(slice);
+
+    /* Copies of the mapped array can be modified */
+    caterva_storage_t storage_copy = storage;
+    storage_copy.properties.blosc.urlpath = NULL;
+    caterva_array_t *dest;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &storage_copy, &dest));
+    CUTEST_ASSERT("Copy is read-only", !dest->readonly);
+    if (check_array(data->ctx, dest, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &other));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    free(result);
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(open_mmap) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(open_mmap);
+}
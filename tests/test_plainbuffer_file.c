@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_plainbuffer_file_shapes_t;
+
+
+CUTEST_TEST_DATA(plainbuffer_file) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(plainbuffer_file) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 4, 8));
+    CUTEST_PARAMETRIZE(advice, caterva_advice_t, CUTEST_DATA(
+            CATERVA_ADVICE_NORMAL,
+            CATERVA_ADVICE_SEQUENTIAL,
+            CATERVA_ADVICE_RANDOM,
+            CATERVA_ADVICE_WILLNEED,
+    ));
+    CUTEST_PARAMETRIZE(shapes, test_plainbuffer_file_shapes_t, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {2}, {9}}, // 1-idim
+            {2, {14, 10}, {5, 3}, {9, 10}}, // general
+            {3, {10, 10, 10}, {3, 0, 3}, {6, 7, 10}}, // general
+            {2, {20, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+}
+
+
+static int check_array(caterva_ctx_t *ctx, caterva_array_t *array, const uint8_t *result) {
+    int64_t buffersize = array->nitems * array->itemsize;
+    uint8_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(plainbuffer_file) {
+    CUTEST_GET_PARAMETER(shapes, test_plainbuffer_file_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+    CUTEST_GET_PARAMETER(advice, caterva_advice_t);
+
+    char *urlpath = "test_plainbuffer_file.cat";
+    char *urlpath_copy = "test_plainbuffer_file_copy.cat";
+    remove(urlpath);
+    remove(urlpath_copy);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_PLAINBUFFER;
+    storage.properties.plainbuffer.urlpath = urlpath;
+    storage.properties.plainbuffer.advice = advice;
+
+    /* Create original data */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    int64_t buffersize = nitems * itemsize;
+    uint8_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < buffersize; ++i) {
+        result[i] = (uint8_t) i;
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    CUTEST_ASSERT("Plain buffer is not mapped", src->map != NULL);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* Opening the file maps it without reading the data */
+    CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+    CUTEST_ASSERT("Array is not a plain buffer", src->storage == CATERVA_STORAGE_PLAINBUFFER);
+    CUTEST_ASSERT("Array is not filled", src->filled);
+    CUTEST_ASSERT("Dimensions are not persisted", src->ndim == shapes.ndim);
+    CUTEST_ASSERT("Itemsize is not persisted", src->itemsize == itemsize);
+    for (int i = 0; i < params.ndim; ++i) {
+        CUTEST_ASSERT("Shape is not persisted", src->shape[i] == shapes.shape[i]);
+    }
+    CATERVA_TEST_ASSERT(caterva_advise(data->ctx, src, advice));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* Setting a slice writes it to the file */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t slice_shape[CATERVA_MAX_DIM] = {0};
+    int64_t slicesize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = shapes.start[i];
+        stop[i] = shapes.stop[i];
+        slice_shape[i] = stop[i] - start[i];
+        slicesize *= slice_shape[i];
+    }
+    uint8_t *slice = malloc(slicesize + 1);
+    for (int64_t j = 0; j < slicesize / itemsize; ++j) {
+        int64_t rem = j;
+        int64_t ind = 0;
+        int64_t inc = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            ind += (start[i] + rem % slice_shape[i]) * inc;
+            rem /= slice_shape[i];
+            inc *= shapes.shape[i];
+        }
+        memset(&slice[j * itemsize], 0xFF - (uint8_t) j, itemsize);
+        memset(&result[ind * itemsize], 0xFF - (uint8_t) j, itemsize);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    uint8_t *dest_slice = malloc(slicesize + 1);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, slice_shape,
+                                                 dest_slice, slicesize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(dest_slice, slice, slicesize) == 0);
+    free(dest_slice);
+    free(slice);
+
+    /* Copies into another file */
+    caterva_storage_t storage_copy = storage;
+    storage_copy.properties.plainbuffer.urlpath = urlpath_copy;
+    caterva_array_t *dest;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &storage_copy, &dest));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath_copy, &dest));
+    if (check_array(data->ctx, dest, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+
+    /* Resizing maps the file again with the new shape */
+    if (params.ndim > 0) {
+        int64_t new_shape[CATERVA_MAX_DIM];
+        for (int i = 0; i < params.ndim; ++i) {
+            new_shape[i] = shapes.shape[i] + 1;
+        }
+        CATERVA_TEST_ASSERT(caterva_resize(data->ctx, src, new_shape));
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+        for (int i = 0; i < params.ndim; ++i) {
+            CUTEST_ASSERT("Shape is not persisted", src->shape[i] == new_shape[i]);
+        }
+        int64_t new_buffersize = src->nitems * itemsize;
+        uint8_t *buffer = malloc(new_buffersize + 1);
+        CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, (int64_t[]) {0, 0, 0},
+                                                     shapes.shape, shapes.shape, buffer,
+                                                     buffersize));
+        CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+        free(buffer);
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    free(result);
+    remove(urlpath);
+    remove(urlpath_copy);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(plainbuffer_file) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(plainbuffer_file);
+}
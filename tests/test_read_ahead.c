@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_read_ahead_shapes_t;
+
+
+CUTEST_TEST_DATA(read_ahead) {
+    caterva_ctx_t *ctx;
+    caterva_ctx_t *ctx_ref;
+};
+
+
+CUTEST_TEST_SETUP(read_ahead) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx_ref);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(io_depth, int, CUTEST_DATA(2, 3, 16));
+    CUTEST_PARAMETRIZE(sparse, bool, CUTEST_DATA(false, true));
+    CUTEST_PARAMETRIZE(shapes, test_read_ahead_shapes_t, CUTEST_DATA(
+            {1, {100}, {7}, {2}, {2}, {95}}, // 1-idim
+            {2, {14, 10}, {4, 5}, {2, 2}, {5, 3}, {14, 10}}, // general
+            {3, {10, 10, 10}, {3, 5, 4}, {3, 4, 4}, {3, 0, 3}, {9, 7, 10}}, // general
+            {2, {20, 0}, {7, 0}, {3, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, true, true},
+            {CATERVA_STORAGE_BLOSC, false, true},
+    ));
+}
+
+
+CUTEST_TEST_TEST(read_ahead) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_read_ahead_shapes_t);
+    CUTEST_GET_PARAMETER(io_depth, int);
+    CUTEST_GET_PARAMETER(sparse, bool);
+
+    caterva_config_t cfg = *data->ctx_ref->cfg;
+    cfg.io_depth = io_depth;
+    CATERVA_TEST_ASSERT(caterva_ctx_new(&cfg, &data->ctx));
+
+    char *urlpath = "test_read_ahead.b2frame";
+    remove(urlpath);
+
+    uint8_t itemsize = 4;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    uint8_t fill_value[8] = {0};
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    storage.properties.blosc.urlpath = urlpath;
+    storage.properties.blosc.sequencial = backend.sequential;
+    storage.properties.blosc.sparse = sparse;
+    storage.properties.blosc.fill_value = fill_value;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+
+    /* Create original data (with the fill value in its second half) */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    int64_t buffersize = nitems * itemsize;
+    uint8_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < buffersize; ++i) {
+        result[i] = i < buffersize / 2 ? (uint8_t) (i % 255 + 1) : 0;
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+
+    /* The chunks read ahead are the same than the ones read one by one */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t slice_shape[CATERVA_MAX_DIM] = {0};
+    int64_t slicesize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = shapes.start[i];
+        stop[i] = shapes.stop[i];
+        slice_shape[i] = stop[i] - start[i];
+        slicesize *= slice_shape[i];
+    }
+    uint8_t *slice = malloc(slicesize + 1);
+    uint8_t *slice_ref = malloc(slicesize + 1);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, slice_shape, slice,
+                                                 slicesize));
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx_ref, src, start, stop, slice_shape,
+                                                 slice_ref, slicesize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(slice, slice_ref, slicesize) == 0);
+
+    /* The handles of the frame are kept for the next slices */
+    blosc2_schunk *reader_sc = src->reader_nscs > 0 ? src->reader_scs[0] : NULL;
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, slice_shape, slice,
+                                                 slicesize));
+    CUTEST_ASSERT("Handles are not kept", reader_sc == NULL || src->reader_scs[0] == reader_sc);
+
+    /* The chunks written since the handles were opened are read */
+    for (int64_t i = 0; i < slicesize; ++i) {
+        slice[i] = (uint8_t) (slice[i] + 1);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, slice_shape,
+                                                 slice_ref, slicesize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(slice, slice_ref, slicesize) == 0);
+    for (int64_t i = 0; i < slicesize; ++i) {
+        slice[i] = (uint8_t) (slice[i] - 1);
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    free(slice_ref);
+    free(slice);
+
+    uint8_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    caterva_ctx_free(&data->ctx);
+
+    free(result);
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(read_ahead) {
+    caterva_ctx_free(&data->ctx_ref);
+}
+
+int main() {
+    CUTEST_TEST_RUN(read_ahead);
+}
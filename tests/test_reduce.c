@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+#include <math.h>
+
+// Reduce the items of a buffer along some axes, one item at a time
+static void reduce_buf(const double *items, int8_t ndim, const int64_t *shape, const bool *axes,
+                       caterva_reduce_op_t op, double *result, int64_t *count) {
+    int64_t nitems = 1;
+    int64_t out_nitems = 1;
+    *count = 1;
+    for (int i = 0; i < ndim; ++i) {
+        nitems *= shape[i];
+        if (axes[i]) {
+            *count *= shape[i];
+        } else {
+            out_nitems *= shape[i];
+        }
+    }
+    for (int64_t i = 0; i < out_nitems; ++i) {
+        result[i] = op == CATERVA_REDUCE_MIN ? INFINITY : op == CATERVA_REDUCE_MAX ? -INFINITY : 0;
+    }
+    for (int64_t i = 0; i < nitems; ++i) {
+        int64_t rem = i;
+        int64_t out_index = 0;
+        int64_t out_stride = 1;
+        for (int j = ndim - 1; j >= 0; --j) {
+            int64_t coord = rem % shape[j];
+            rem /= shape[j];
+            if (!axes[j]) {
+                out_index += coord * out_stride;
+                out_stride *= shape[j];
+            }
+        }
+        double x = items[i];
+        if (op == CATERVA_REDUCE_MIN) {
+            result[out_index] = x < result[out_index] ? x : result[out_index];
+        } else if (op == CATERVA_REDUCE_MAX) {
+            result[out_index] = x > result[out_index] ? x : result[out_index];
+        } else {
+            result[out_index] += x;
+        }
+    }
+    if (op == CATERVA_REDUCE_MEAN) {
+        for (int64_t i = 0; i < out_nitems; ++i) {
+            result[i] /= (double) *count;
+        }
+    }
+}
+
+
+CUTEST_TEST_DATA(reduce) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(reduce) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(op, caterva_reduce_op_t, CUTEST_DATA(
+            CATERVA_REDUCE_SUM,
+            CATERVA_REDUCE_MIN,
+            CATERVA_REDUCE_MAX,
+            CATERVA_REDUCE_MEAN,
+    ));
+    CUTEST_PARAMETRIZE(dtype, caterva_dtype_t, CUTEST_DATA(
+            CATERVA_DTYPE_INT32,
+            CATERVA_DTYPE_FLOAT64,
+    ));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}}, // 1-idim
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {2, {1000, 300}, {500, 300}, {100, 100}}, // chunks reduced in parallel
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+            {3, {100, 0, 12}, {31, 0, 12}, {10, 0, 12}},
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_PLAINBUFFER, false, false},
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_SHARDED, false, false},
+    ));
+}
+
+
+CUTEST_TEST_TEST(reduce) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(dtype, caterva_dtype_t);
+    CUTEST_GET_PARAMETER(op, caterva_reduce_op_t);
+
+    uint8_t itemsize = dtype == CATERVA_DTYPE_INT32 ? 4 : 8;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.backend == CATERVA_STORAGE_SHARDED) {
+        storage.properties.sharded.shard_nchunks = 2;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.sharded.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.sharded.blockshape[i] = shapes.blockshape[i];
+        }
+    } else if (backend.backend == CATERVA_STORAGE_BLOSC) {
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+        }
+    }
+
+    /* Create original data (with repeated, negative and unordered items) */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    uint8_t *buffer = malloc(nitems * itemsize + 1);
+    double *items = malloc((nitems + 1) * sizeof(double));
+    for (int64_t i = 0; i < nitems; ++i) {
+        int32_t value = (int32_t) ((i * 7919) % 1009) - 500;
+        if (dtype == CATERVA_DTYPE_INT32) {
+            ((int32_t *) buffer)[i] = value;
+            items[i] = value;
+        } else {
+            ((double *) buffer)[i] = value / 8.;
+            items[i] = value / 8.;
+        }
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, nitems * itemsize, &params,
+                                            &storage, &src));
+
+    /* Every combination of axes is reduced (into chunks with the shape of the kept axes) */
+    int64_t max_nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        max_nitems *= shapes.shape[i] > 0 ? shapes.shape[i] : 1;
+    }
+    double *result = malloc(max_nitems * sizeof(double));
+    uint8_t *buffer_dest = malloc(max_nitems * sizeof(double));
+    for (int mask = 0; mask < (1 << params.ndim); ++mask) {
+        bool axes[CATERVA_MAX_DIM];
+        bool empty_axis = false;
+        caterva_storage_t out_storage = {0};
+        out_storage.backend = backend.backend == CATERVA_STORAGE_PLAINBUFFER ?
+                              CATERVA_STORAGE_PLAINBUFFER : CATERVA_STORAGE_BLOSC;
+        int8_t out_ndim = 0;
+        for (int i = 0; i < params.ndim; ++i) {
+            axes[i] = (mask >> i) & 1;
+            if (axes[i]) {
+                empty_axis |= shapes.shape[i] == 0;
+            } else {
+                if (out_storage.backend == CATERVA_STORAGE_BLOSC) {
+                    out_storage.properties.blosc.chunkshape[out_ndim] = shapes.chunkshape[i];
+                    out_storage.properties.blosc.blockshape[out_ndim] = shapes.blockshape[i];
+                }
+                out_ndim++;
+            }
+        }
+
+        caterva_array_t *dest;
+        int rc = caterva_reduce(data->ctx, src, dtype, op, axes, &out_storage, &dest);
+        if (empty_axis && op != CATERVA_REDUCE_SUM) {
+            CUTEST_ASSERT("Empty axes are reduced", rc == CATERVA_ERR_INVALID_ARGUMENT);
+            continue;
+        }
+        CATERVA_TEST_ASSERT(rc);
+        CUTEST_ASSERT("Dimensions are not removed", dest->ndim == out_ndim);
+        CUTEST_ASSERT("Array is not filled", dest->filled);
+
+        int64_t count;
+        reduce_buf(items, params.ndim, shapes.shape, axes, op, result, &count);
+        CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, buffer_dest,
+                                              dest->nitems * dest->itemsize));
+        for (int64_t i = 0; i < dest->nitems; ++i) {
+            double value;
+            if (op == CATERVA_REDUCE_MEAN || dtype == CATERVA_DTYPE_FLOAT64) {
+                CUTEST_ASSERT("Itemsize is not correct", dest->itemsize == 8);
+                value = ((double *) buffer_dest)[i];
+            } else if (op == CATERVA_REDUCE_SUM) {
+                CUTEST_ASSERT("Itemsize is not correct", dest->itemsize == 8);
+                value = (double) ((int64_t *) buffer_dest)[i];
+            } else {
+                CUTEST_ASSERT("Itemsize is not correct", dest->itemsize == 4);
+                value = ((int32_t *) buffer_dest)[i];
+            }
+            CUTEST_ASSERT("Elements are not equal",
+                          fabs(value - result[i]) <= 1e-9 * (1 + fabs(result[i])));
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    }
+
+    /* The data type must match the itemsize of the array */
+    caterva_storage_t out_storage = {0};
+    out_storage.backend = CATERVA_STORAGE_PLAINBUFFER;
+    caterva_array_t *dest;
+    CUTEST_ASSERT("Data type is not checked",
+                  caterva_reduce(data->ctx, src, CATERVA_DTYPE_INT16, op, NULL, &out_storage,
+                                 &dest) == CATERVA_ERR_INVALID_ARGUMENT);
+
+    free(result);
+    free(buffer_dest);
+    free(items);
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(reduce) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(reduce);
+}
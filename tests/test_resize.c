@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t newshape[CATERVA_MAX_DIM];
+} test_resize_shapes_t;
+
+
+CUTEST_TEST_DATA(resize) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(resize) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 4, 8));
+    CUTEST_PARAMETRIZE(shapes, test_resize_shapes_t, CUTEST_DATA(
+            {1, {10}, {7}, {2}, {25}}, // grow 1-dim
+            {1, {10}, {7}, {2}, {3}}, // shrink 1-dim
+            {2, {14, 10}, {8, 5}, {2, 2}, {30, 10}}, // grow leading axis
+            {2, {14, 10}, {8, 5}, {2, 2}, {14, 23}}, // grow trailing axis
+            {2, {14, 10}, {8, 5}, {2, 2}, {5, 7}}, // shrink both axes
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, {12, 4, 21}}, // grow and shrink
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, {10, 0, 10}}, // 0-shape
+            {2, {20, 0}, {7, 5}, {3, 5}, {20, 12}}, // from 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_PLAINBUFFER, false, false},
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+static int check_resized(caterva_ctx_t *ctx, caterva_array_t *array, const uint8_t *orig,
+                         const int64_t *orig_shape, const int64_t *valid_shape) {
+    int64_t buffersize = array->nitems * array->itemsize;
+    uint8_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+
+    for (int64_t i = 0; i < array->nitems; ++i) {
+        // Compute the coordinates of the item and its position in the original buffer
+        int64_t rem = i;
+        int64_t orig_ind = 0;
+        int64_t orig_inc = 1;
+        bool inside = true;
+        for (int j = array->ndim - 1; j >= 0; --j) {
+            int64_t coord = rem % array->shape[j];
+            rem /= array->shape[j];
+            if (coord >= valid_shape[j]) {
+                inside = false;
+            }
+            orig_ind += coord * orig_inc;
+            orig_inc *= orig_shape[j];
+        }
+        for (int k = 0; k < array->itemsize; ++k) {
+            uint8_t expected = inside ? orig[orig_ind * array->itemsize + k] : 0;
+            CUTEST_ASSERT("Elements are not equals!",
+                          buffer[i * array->itemsize + k] == expected);
+        }
+    }
+    free(buffer);
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(resize) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_resize_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    char *urlpath = "test_resize.b2frame";
+    remove(urlpath);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.backend == CATERVA_STORAGE_BLOSC) {
+        if (backend.persistent) {
+            storage.properties.blosc.urlpath = urlpath;
+        }
+        storage.properties.blosc.sequencial = backend.sequential;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+        }
+    }
+
+    /* Create original data */
+    int64_t buffersize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        buffersize *= shapes.shape[i];
+    }
+    uint8_t *buffer = malloc(buffersize + 1);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+
+    /* Resize to the new shape */
+    int64_t valid_shape[CATERVA_MAX_DIM];
+    for (int i = 0; i < params.ndim; ++i) {
+        valid_shape[i] = shapes.shape[i] < shapes.newshape[i] ? shapes.shape[i]
+                                                               : shapes.newshape[i];
+    }
+    CATERVA_TEST_ASSERT(caterva_resize(data->ctx, src, shapes.newshape));
+    for (int i = 0; i < params.ndim; ++i) {
+        CUTEST_ASSERT("Shape is not updated", src->shape[i] == shapes.newshape[i]);
+    }
+    if (check_resized(data->ctx, src, buffer, shapes.shape, valid_shape) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* Go back to the original shape; shrunk regions must come back as zeros */
+    CATERVA_TEST_ASSERT(caterva_resize(data->ctx, src, shapes.shape));
+    if (check_resized(data->ctx, src, buffer, shapes.shape, valid_shape) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* The persistent array must keep the new shape */
+    if (backend.backend == CATERVA_STORAGE_BLOSC && backend.persistent) {
+        caterva_array_t *dest;
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &dest));
+        for (int i = 0; i < params.ndim; ++i) {
+            CUTEST_ASSERT("Shape is not persisted", dest->shape[i] == shapes.shape[i]);
+        }
+        if (check_resized(data->ctx, dest, buffer, shapes.shape, valid_shape) != 0) {
+            return CUNIT_FAIL;
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    }
+
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(resize) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(resize);
+}
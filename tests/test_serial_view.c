@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+
+CUTEST_TEST_DATA(serial_view) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(serial_view) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 4, 8));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}}, // 1-idim
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+            {3, {100, 0, 12}, {31, 0, 12}, {10, 0, 12}},
+    ));
+}
+
+
+CUTEST_TEST_TEST(serial_view) {
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    storage.properties.blosc.urlpath = NULL;
+    storage.properties.blosc.sequencial = true;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+
+    /* Create original data */
+    size_t buffersize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        buffersize *= (size_t) params.shape[i];
+    }
+
+    uint8_t *buffer = malloc(buffersize);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    /* Create caterva_array_t with original data */
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+
+    uint8_t *sframe;
+    bool needs_free;
+    blosc2_schunk_to_buffer(src->sc, &sframe, &needs_free);
+
+    int64_t slen = blosc2_schunk_frame_len(src->sc);
+
+    /* The view references the serialized super-chunk without copying it */
+    caterva_array_t *dest;
+    CATERVA_TEST_ASSERT(caterva_from_serial_schunk_view(data->ctx, sframe, slen, &dest));
+    CUTEST_ASSERT("Array is not read-only", dest->readonly);
+
+    uint8_t *buffer_dest = malloc(buffersize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, dest, buffer_dest, buffersize));
+    CATERVA_TEST_ASSERT_BUFFER(buffer, buffer_dest, (int) buffersize);
+
+    /* Views can not be modified, but their copies can */
+    if (buffersize > 0) {
+        int64_t start[CATERVA_MAX_DIM] = {0};
+        CUTEST_ASSERT("Read-only array is modified",
+                      caterva_set_slice_buffer(data->ctx, buffer, (int64_t) buffersize, start,
+                                               params.shape, dest) != CATERVA_SUCCEED);
+        caterva_array_t *copy;
+        CATERVA_TEST_ASSERT(caterva_copy(data->ctx, dest, &storage, &copy));
+        CUTEST_ASSERT("Copy is read-only", !copy->readonly);
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &copy));
+    }
+
+    /* Free mallocs (the serialized super-chunk is released once the view is freed) */
+    free(buffer);
+    free(buffer_dest);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    if (needs_free) {
+        free(sframe);
+    }
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(serial_view) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(serial_view);
+}
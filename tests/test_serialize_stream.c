@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+#define STREAM_HEADER_LEN 148
+#define STREAM_TRAILER_LEN 16
+
+typedef struct {
+    uint8_t *data;
+    int64_t len;
+    int64_t max_write;
+    int64_t fail_after;
+} test_stream_sink_t;
+
+
+static int64_t write_sink(const void *data, int64_t size, void *userdata) {
+    test_stream_sink_t *sink = userdata;
+    if (sink->fail_after >= 0 && sink->len + size > sink->fail_after) {
+        return -1;
+    }
+    sink->data = realloc(sink->data, (size_t) (sink->len + size));
+    memcpy(sink->data + sink->len, data, (size_t) size);
+    sink->len += size;
+    if (size > sink->max_write) {
+        sink->max_write = size;
+    }
+    return size;
+}
+
+
+static int64_t load_le(const uint8_t *src, int nbytes) {
+    uint64_t value = 0;
+    for (int i = nbytes - 1; i >= 0; --i) {
+        value = (value << 8) | src[i];
+    }
+    return (int64_t) value;
+}
+
+
+CUTEST_TEST_DATA(serialize_stream) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(serialize_stream) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 8));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}}, // 1-idim
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+            {3, {100, 0, 12}, {31, 0, 12}, {10, 0, 12}},
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+            {CATERVA_STORAGE_BLOSC, false, true},
+            {CATERVA_STORAGE_SHARDED, true, false},
+    ));
+}
+
+
+CUTEST_TEST_TEST(serialize_stream) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    char *urlpath = "test_serialize_stream.b2frame";
+    remove(urlpath);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.backend == CATERVA_STORAGE_SHARDED) {
+        storage.properties.sharded.shard_nchunks = 2;
+        storage.properties.sharded.sequencial = backend.sequential;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.sharded.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.sharded.blockshape[i] = shapes.blockshape[i];
+        }
+    } else {
+        if (backend.persistent) {
+            storage.properties.blosc.urlpath = urlpath;
+        }
+        storage.properties.blosc.sequencial = backend.sequential;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+        }
+    }
+
+    /* Create original data */
+    int64_t buffersize = itemsize;
+    int64_t nchunks = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        buffersize *= params.shape[i];
+        nchunks *= shapes.chunkshape[i] == 0 ? 0 : (shapes.shape[i] + shapes.chunkshape[i] - 1) /
+                                                   shapes.chunkshape[i];
+    }
+    uint8_t *buffer = malloc(buffersize + 1);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+
+    test_stream_sink_t sink = {NULL, 0, 0, -1};
+    CATERVA_TEST_ASSERT(caterva_serialize_stream(data->ctx, src, write_sink, &sink));
+
+    /* Check the header and the trailer */
+    CUTEST_ASSERT("Stream is too short", sink.len >= STREAM_HEADER_LEN + STREAM_TRAILER_LEN);
+    CUTEST_ASSERT("Magic is not written", memcmp(sink.data, "CATSTRM", 8) == 0);
+    CUTEST_ASSERT("Dimensions are not written", (int8_t) sink.data[9] == shapes.ndim);
+    CUTEST_ASSERT("Itemsize is not written", sink.data[10] == itemsize);
+    CUTEST_ASSERT("Number of chunks is not written", load_le(&sink.data[12], 8) == nchunks);
+    uint8_t *trailer = &sink.data[sink.len - STREAM_TRAILER_LEN];
+    CUTEST_ASSERT("Magic is not written", memcmp(&trailer[8], "CATSTRM", 8) == 0);
+    int64_t index_offset = load_le(trailer, 8);
+    CUTEST_ASSERT("Index is not written",
+                  index_offset + nchunks * 8 + STREAM_TRAILER_LEN == sink.len);
+
+    /* The chunks follow the header (and the empty groups of metalayers) in row-major order */
+    caterva_array_t **parts = backend.backend == CATERVA_STORAGE_SHARDED ? src->shards : &src;
+    int64_t nparts = backend.backend == CATERVA_STORAGE_SHARDED ? src->nshards : 1;
+    int64_t chunksize = src->extchunknitems * itemsize;
+    uint8_t *chunk = malloc(chunksize + 1);
+    uint8_t *chunk_ref = malloc(chunksize + 1);
+    CUTEST_ASSERT("Metalayers of caterva are written",
+                  load_le(&sink.data[STREAM_HEADER_LEN], 8) == 0);
+    int64_t offset = STREAM_HEADER_LEN + 8;
+    int64_t n = 0;
+    int64_t max_cbytes = 0;
+    for (int64_t i = 0; i < nparts; ++i) {
+        for (int64_t nchunk = 0; nchunk < parts[i]->sc->nchunks; ++nchunk) {
+            CUTEST_ASSERT("Offset is not indexed",
+                          load_le(&sink.data[index_offset + n * 8], 8) == offset);
+            int32_t nbytes, cbytes, blocksize;
+            blosc2_cbuffer_sizes(&sink.data[offset], &nbytes, &cbytes, &blocksize);
+            CUTEST_ASSERT("Chunk size is not correct", nbytes == chunksize);
+            CUTEST_ASSERT("Chunk can not be decompressed",
+                          blosc2_decompress(&sink.data[offset], cbytes, chunk, nbytes) == nbytes);
+            blosc2_schunk_decompress_chunk(parts[i]->sc, (int) nchunk, chunk_ref, nbytes);
+            CUTEST_ASSERT("Chunks are not equal", memcmp(chunk, chunk_ref, nbytes) == 0);
+            max_cbytes = cbytes > max_cbytes ? cbytes : max_cbytes;
+            offset += cbytes;
+            n++;
+        }
+    }
+    CUTEST_ASSERT("Chunks are not written", n == nchunks && offset == index_offset);
+    /* Every write holds the header, a count of metalayers, a chunk or a batch of the index (of up
+     * to 512 offsets) */
+    int64_t max_write = max_cbytes > 512 * 8 ? max_cbytes : 512 * 8;
+    CUTEST_ASSERT("Stream is buffered", sink.max_write <= max_write);
+    free(chunk_ref);
+    free(chunk);
+
+    /* The errors of the sink stop the serialization */
+    int64_t len = sink.len;
+    free(sink.data);
+    test_stream_sink_t failing = {NULL, 0, 0, len - 1};
+    CUTEST_ASSERT("Errors writing are not reported",
+                  caterva_serialize_stream(data->ctx, src, write_sink, &failing) !=
+                  CATERVA_SUCCEED);
+    free(failing.data);
+
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(serialize_stream) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(serialize_stream);
+}
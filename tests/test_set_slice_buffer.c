@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t maxslice;
+    int nslices;
+} test_set_slice_buffer_shapes_t;
+
+
+CUTEST_TEST_DATA(set_slice_buffer) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(set_slice_buffer) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 4, 8));
+    CUTEST_PARAMETRIZE(shapes, test_set_slice_buffer_shapes_t, CUTEST_DATA(
+            {1, {10}, {7}, {2}, 4, 20}, // 1-dim
+            {2, {40, 40}, {10, 10}, {4, 3}, 3, 200}, // pixel edits (with evictions)
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, 5, 50}, // general
+            {2, {20, 10}, {7, 5}, {3, 5}, 20, 5}, // big slices
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_PLAINBUFFER, false, false},
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+static int check_array(caterva_ctx_t *ctx, caterva_array_t *array, const uint8_t *result) {
+    int64_t buffersize = array->nitems * array->itemsize;
+    uint8_t *buffer = malloc(buffersize);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(set_slice_buffer) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_set_slice_buffer_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+
+    char *urlpath = "test_set_slice_buffer.b2frame";
+    remove(urlpath);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.backend == CATERVA_STORAGE_BLOSC) {
+        if (backend.persistent) {
+            storage.properties.blosc.urlpath = urlpath;
+        }
+        storage.properties.blosc.sequencial = backend.sequential;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+        }
+    }
+
+    /* Create original data */
+    int64_t buffersize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        buffersize *= shapes.shape[i];
+    }
+    uint8_t *result = malloc(buffersize);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(result, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+
+    /* Set small slices in pseudo-random positions, mirroring them in the result */
+    uint8_t *slice = malloc(buffersize);
+    uint32_t seed = 1234;
+    for (int n = 0; n < shapes.nslices; ++n) {
+        int64_t start[CATERVA_MAX_DIM];
+        int64_t stop[CATERVA_MAX_DIM];
+        int64_t slicesize = itemsize;
+        for (int i = 0; i < params.ndim; ++i) {
+            seed = seed * 1103515245 + 12345;
+            start[i] = (seed >> 8) % shapes.shape[i];
+            seed = seed * 1103515245 + 12345;
+            stop[i] = start[i] + 1 + (seed >> 8) % shapes.maxslice;
+            if (stop[i] > shapes.shape[i]) {
+                stop[i] = shapes.shape[i];
+            }
+            slicesize *= stop[i] - start[i];
+        }
+        memset(slice, n + 1, slicesize);
+        CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop,
+                                                     src));
+
+        int64_t nitems = slicesize / itemsize;
+        for (int64_t j = 0; j < nitems; ++j) {
+            int64_t rem = j;
+            int64_t ind = 0;
+            int64_t inc = 1;
+            for (int i = params.ndim - 1; i >= 0; --i) {
+                int64_t shape = stop[i] - start[i];
+                ind += (start[i] + rem % shape) * inc;
+                rem /= shape;
+                inc *= shapes.shape[i];
+            }
+            memset(&result[ind * itemsize], n + 1, itemsize);
+        }
+
+        /* Pending changes must be visible before flushing them */
+        if (n % 10 == 0 && check_array(data->ctx, src, result) != 0) {
+            return CUNIT_FAIL;
+        }
+    }
+    free(slice);
+
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* The changes must be stored when the array is freed */
+    if (backend.backend == CATERVA_STORAGE_BLOSC && backend.persistent) {
+        caterva_array_t *dest;
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &dest));
+        if (check_array(data->ctx, dest, result) != 0) {
+            return CUNIT_FAIL;
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    }
+    free(result);
+    remove(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(set_slice_buffer) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(set_slice_buffer);
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+#include <sys/stat.h>
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_sharded_shapes_t;
+
+
+CUTEST_TEST_DATA(sharded) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(sharded) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(shard_nchunks, int32_t, CUTEST_DATA(1, 2));
+    CUTEST_PARAMETRIZE(shapes, test_sharded_shapes_t, CUTEST_DATA(
+            {0, {0}, {0}, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {3}, {2}, {2}, {9}}, // 1-idim
+            {2, {14, 10}, {4, 5}, {2, 2}, {3, 3}, {13, 10}}, // general
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, {2, 0, 3}, {9, 7, 10}}, // general
+            {2, {20, 0}, {7, 0}, {3, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_SHARDED, false, false},
+            {CATERVA_STORAGE_SHARDED, true, false},
+            {CATERVA_STORAGE_SHARDED, true, true},
+    ));
+}
+
+
+static void remove_shards(const char *urlpath) {
+    remove(urlpath);
+    for (int i = 0; i < 16; ++i) {
+        char shard_urlpath[64];
+        snprintf(shard_urlpath, sizeof(shard_urlpath), "%s.%d", urlpath, i);
+        remove(shard_urlpath);
+    }
+}
+
+
+static int check_array(caterva_ctx_t *ctx, caterva_array_t *array, const int64_t *result) {
+    int64_t buffersize = array->nitems * array->itemsize;
+    int64_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(sharded) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_sharded_shapes_t);
+    CUTEST_GET_PARAMETER(shard_nchunks, int32_t);
+
+    char *urlpath = "test_sharded.cat";
+    char *urlpath_copy = "test_sharded_copy.b2frame";
+    remove_shards(urlpath);
+    remove(urlpath_copy);
+
+    caterva_params_t params;
+    params.itemsize = sizeof(int64_t);
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.persistent) {
+        storage.properties.sharded.urlpath = urlpath;
+    }
+    storage.properties.sharded.sequencial = backend.sequential;
+    storage.properties.sharded.shard_nchunks = shard_nchunks;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.sharded.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.sharded.blockshape[i] = shapes.blockshape[i];
+    }
+
+    /* Create original data */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    int64_t buffersize = nitems * params.itemsize;
+    int64_t *result = malloc(buffersize + 1);
+    for (int64_t i = 0; i < nitems; ++i) {
+        result[i] = i;
+    }
+
+    /* Every shard holds a slab of chunks along the first dimension */
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    int64_t nshards = 1;
+    if (params.ndim > 0) {
+        int64_t len = (int64_t) shard_nchunks * shapes.chunkshape[0];
+        nshards = len == 0 ? 0 : (shapes.shape[0] + len - 1) / len;
+    }
+    CUTEST_ASSERT("Number of shards is not correct", src->nshards == nshards);
+    CUTEST_ASSERT("Array is not filled", src->filled);
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* Slices spanning several shards are read and written */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t slice_shape[CATERVA_MAX_DIM] = {0};
+    int64_t slicesize = params.itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = shapes.start[i];
+        stop[i] = shapes.stop[i];
+        slice_shape[i] = stop[i] - start[i];
+        slicesize *= slice_shape[i];
+    }
+    int64_t *slice = malloc(slicesize + 1);
+    for (int64_t j = 0; j < slicesize / params.itemsize; ++j) {
+        int64_t rem = j;
+        int64_t ind = 0;
+        int64_t inc = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            ind += (start[i] + rem % slice_shape[i]) * inc;
+            rem /= slice_shape[i];
+            inc *= shapes.shape[i];
+        }
+        slice[j] = -j;
+        result[ind] = -j;
+    }
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop, src));
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    int64_t *dest_slice = malloc(slicesize + 1);
+    CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, start, stop, slice_shape,
+                                                 dest_slice, slicesize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(dest_slice, slice, slicesize) == 0);
+    free(dest_slice);
+    free(slice);
+
+    /* The shards are opened from the manifest */
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+        CUTEST_ASSERT("Array is not sharded", src->storage == CATERVA_STORAGE_SHARDED);
+        CUTEST_ASSERT("Number of shards is not persisted", src->nshards == nshards);
+        CUTEST_ASSERT("Array is not filled", src->filled);
+        for (int i = 0; i < params.ndim; ++i) {
+            CUTEST_ASSERT("Shape is not persisted", src->shape[i] == shapes.shape[i]);
+            CUTEST_ASSERT("Chunk shape is not persisted",
+                          src->chunkshape[i] == shapes.chunkshape[i]);
+        }
+        if (check_array(data->ctx, src, result) != 0) {
+            return CUNIT_FAIL;
+        }
+    }
+
+    /* Copies from and to a single super-chunk */
+    caterva_storage_t storage_copy = {0};
+    storage_copy.backend = CATERVA_STORAGE_BLOSC;
+    storage_copy.properties.blosc.urlpath = backend.persistent ? urlpath_copy : NULL;
+    storage_copy.properties.blosc.sequencial = true;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage_copy.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage_copy.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+    caterva_array_t *single;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &storage_copy, &single));
+    if (check_array(data->ctx, single, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    caterva_storage_t storage_sharded = storage;
+    storage_sharded.properties.sharded.urlpath = NULL;
+    storage_sharded.properties.sharded.shard_nchunks = 3 - shard_nchunks;
+    caterva_array_t *sharded;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, single, &storage_sharded, &sharded));
+    if (check_array(data->ctx, sharded, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &single));
+
+    /* Chunks are appended to the shard where they are stored */
+    caterva_array_t *appended;
+    CATERVA_TEST_ASSERT(caterva_empty(data->ctx, &params, &storage_sharded, &appended));
+    while (!appended->filled) {
+        int64_t chunk_start[CATERVA_MAX_DIM] = {0};
+        int64_t chunk_stop[CATERVA_MAX_DIM] = {0};
+        int64_t chunk_shape[CATERVA_MAX_DIM] = {0};
+        int64_t grid[CATERVA_MAX_DIM];
+        for (int i = 0; i < params.ndim; ++i) {
+            grid[i] = appended->extshape[i] / appended->chunkshape[i];
+        }
+        int64_t rem = appended->nchunks;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            chunk_start[i] = rem % grid[i] * appended->chunkshape[i];
+            rem /= grid[i];
+        }
+        for (int i = 0; i < params.ndim; ++i) {
+            chunk_stop[i] = chunk_start[i] + appended->next_chunkshape[i];
+            chunk_shape[i] = appended->next_chunkshape[i];
+        }
+        int64_t chunksize = appended->next_chunknitems * params.itemsize;
+        int64_t *chunk = malloc(chunksize + 1);
+        CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, sharded, chunk_start, chunk_stop,
+                                                     chunk_shape, chunk, chunksize));
+        CATERVA_TEST_ASSERT(caterva_append(data->ctx, appended, chunk, chunksize));
+        free(chunk);
+    }
+    if (check_array(data->ctx, appended, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &appended));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &sharded));
+
+    /* Resizing adds and removes shards */
+    if (params.ndim > 0 && nitems > 0) {
+        int64_t new_shape[CATERVA_MAX_DIM];
+        for (int i = 0; i < params.ndim; ++i) {
+            new_shape[i] = shapes.shape[i] + 1;
+        }
+        new_shape[0] = shapes.shape[0] + 2 * shard_nchunks * shapes.chunkshape[0];
+        CATERVA_TEST_ASSERT(caterva_resize(data->ctx, src, new_shape));
+        CUTEST_ASSERT("Shards are not added", src->nshards > nshards);
+        int64_t *buffer = malloc(buffersize + 1);
+        CATERVA_TEST_ASSERT(caterva_get_slice_buffer(data->ctx, src, (int64_t[]) {0, 0, 0},
+                                                     shapes.shape, shapes.shape, buffer,
+                                                     buffersize));
+        CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+        free(buffer);
+
+        new_shape[0] = 1;
+        CATERVA_TEST_ASSERT(caterva_resize(data->ctx, src, new_shape));
+        CUTEST_ASSERT("Shards are not removed", src->nshards == 1);
+        if (backend.persistent) {
+            struct stat st;
+            char shard_urlpath[64];
+            snprintf(shard_urlpath, sizeof(shard_urlpath), "%s.%d", urlpath, 1);
+            CUTEST_ASSERT("Frames of the shards are not removed", stat(shard_urlpath, &st) != 0);
+            CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+            CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+            CUTEST_ASSERT("Shape is not persisted", src->shape[0] == 1);
+        }
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    free(result);
+    remove_shards(urlpath);
+    remove(urlpath_copy);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(sharded) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(sharded);
+}
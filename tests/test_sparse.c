@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+    int32_t chunkshape[CATERVA_MAX_DIM];
+    int32_t blockshape[CATERVA_MAX_DIM];
+    int64_t start[CATERVA_MAX_DIM];
+    int64_t stop[CATERVA_MAX_DIM];
+} test_sparse_shapes_t;
+
+
+CUTEST_TEST_DATA(sparse) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(sparse) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 2, 4, 8));
+    CUTEST_PARAMETRIZE(fill_value, uint8_t, CUTEST_DATA(0, 7));
+    CUTEST_PARAMETRIZE(shapes, test_sparse_shapes_t, CUTEST_DATA(
+            {0, {0}, {0}, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}, {8}, {10}}, // 1-idim
+            {2, {14, 10}, {8, 5}, {2, 2}, {5, 3}, {9, 10}}, // general
+            {3, {10, 10, 10}, {3, 5, 9}, {3, 4, 4}, {3, 0, 3}, {6, 7, 10}}, // general
+            {2, {20, 0}, {7, 0}, {3, 0}, {2, 0}, {8, 0}}, // 0-shape
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+    ));
+}
+
+
+static int check_array(caterva_ctx_t *ctx, caterva_array_t *array, const uint8_t *result) {
+    int64_t buffersize = array->nitems * array->itemsize;
+    uint8_t *buffer = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(ctx, array, buffer, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, result, buffersize) == 0);
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEST(sparse) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, test_sparse_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+    CUTEST_GET_PARAMETER(fill_value, uint8_t);
+
+    char *urlpath = "test_sparse.b2frame";
+    char *urlpath_copy = "test_sparse_copy.b2frame";
+    remove(urlpath);
+    remove(urlpath_copy);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    /* Use a value with all its bytes equal (to be valid for every itemsize) */
+    uint8_t value[8];
+    memset(value, fill_value, sizeof(value));
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.persistent) {
+        storage.properties.blosc.urlpath = urlpath;
+    }
+    storage.properties.blosc.sequencial = backend.sequential;
+    for (int i = 0; i < params.ndim; ++i) {
+        storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+        storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+    }
+    storage.properties.blosc.sparse = true;
+    storage.properties.blosc.fill_value = value;
+
+    /* Create original data with the fill value except for the first item */
+    int64_t nitems = 1;
+    int64_t nchunks = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+        nchunks *= shapes.chunkshape[i] == 0 ? 0 : (shapes.shape[i] + shapes.chunkshape[i] - 1) /
+                                                   shapes.chunkshape[i];
+    }
+    int64_t buffersize = nitems * itemsize;
+    uint8_t *result = malloc(buffersize + 1);
+    memset(result, fill_value, buffersize);
+    if (nitems > 0) {
+        memset(result, fill_value + 1, itemsize);
+    }
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, result, buffersize, &params, &storage,
+                                            &src));
+    CUTEST_ASSERT("Array is not filled", src->filled);
+    CUTEST_ASSERT("Chunks filled with the fill value are stored",
+                  src->sc->nchunks == (nchunks > 0 && nitems > 0 ? 1 : 0));
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* Setting a slice materializes the chunks that it touches */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    int64_t stop[CATERVA_MAX_DIM] = {0};
+    int64_t slicesize = itemsize;
+    for (int i = 0; i < params.ndim; ++i) {
+        start[i] = shapes.start[i];
+        stop[i] = shapes.stop[i];
+        slicesize *= stop[i] - start[i];
+    }
+    uint8_t *slice = malloc(slicesize + 1);
+    memset(slice, fill_value + 2, slicesize);
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, slice, slicesize, start, stop, src));
+    for (int64_t j = 0; j < slicesize / itemsize; ++j) {
+        int64_t rem = j;
+        int64_t ind = 0;
+        int64_t inc = 1;
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            int64_t shape = stop[i] - start[i];
+            ind += (start[i] + rem % shape) * inc;
+            rem /= shape;
+            inc *= shapes.shape[i];
+        }
+        memset(&result[ind * itemsize], fill_value + 2, itemsize);
+    }
+    free(slice);
+    CATERVA_TEST_ASSERT(caterva_flush(data->ctx, src));
+    CUTEST_ASSERT("Too many chunks stored", src->sc->nchunks <= nchunks);
+    if (check_array(data->ctx, src, result) != 0) {
+        return CUNIT_FAIL;
+    }
+
+    /* Copying into a sparse array goes through appending chunks */
+    caterva_storage_t storage_copy = storage;
+    storage_copy.properties.blosc.urlpath = backend.persistent ? urlpath_copy : NULL;
+    caterva_array_t *dest;
+    CATERVA_TEST_ASSERT(caterva_copy(data->ctx, src, &storage_copy, &dest));
+    CUTEST_ASSERT("Chunks are not copied", dest->sc->nchunks == src->sc->nchunks);
+    if (check_array(data->ctx, dest, result) != 0) {
+        return CUNIT_FAIL;
+    }
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &dest));
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+
+    /* The fill value and the stored chunks are persisted */
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+        CUTEST_ASSERT("Array is not sparse", src->sparse);
+        CUTEST_ASSERT("Fill value is not persisted", memcmp(src->fill_value, value, itemsize) == 0);
+        CUTEST_ASSERT("Array is not filled", src->filled);
+        if (check_array(data->ctx, src, result) != 0) {
+            return CUNIT_FAIL;
+        }
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    }
+    free(result);
+    remove(urlpath);
+    remove(urlpath_copy);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(sparse) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(sparse);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+typedef struct {
+    int8_t ndim;
+    int64_t shape[CATERVA_MAX_DIM];
+} test_suggest_shapes_shapes_t;
+
+
+CUTEST_TEST_DATA(suggest_shapes) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(suggest_shapes) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(itemsize, uint8_t, CUTEST_DATA(1, 8));
+    CUTEST_PARAMETRIZE(access_hint, caterva_access_hint_t, CUTEST_DATA(
+            CATERVA_ACCESS_WHOLE,
+            CATERVA_ACCESS_ROWS,
+            CATERVA_ACCESS_COLUMNS,
+            CATERVA_ACCESS_RANDOM,
+    ));
+    CUTEST_PARAMETRIZE(shapes, test_suggest_shapes_shapes_t, CUTEST_DATA(
+            {0, {0}}, // 0-dim
+            {1, {3000000}}, // 1-dim
+            {2, {1000, 1000}}, // general
+            {3, {50, 60, 70}}, // general
+            {2, {100, 0}}, // 0-shape
+    ));
+}
+
+
+CUTEST_TEST_TEST(suggest_shapes) {
+    CUTEST_GET_PARAMETER(shapes, test_suggest_shapes_shapes_t);
+    CUTEST_GET_PARAMETER(itemsize, uint8_t);
+    CUTEST_GET_PARAMETER(access_hint, caterva_access_hint_t);
+
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = CATERVA_STORAGE_BLOSC;
+    CATERVA_TEST_ASSERT(caterva_suggest_shapes(data->ctx, &params, access_hint,
+                                               storage.properties.blosc.chunkshape,
+                                               storage.properties.blosc.blockshape));
+
+    int32_t *chunkshape = storage.properties.blosc.chunkshape;
+    int32_t *blockshape = storage.properties.blosc.blockshape;
+    for (int i = 0; i < params.ndim; ++i) {
+        CUTEST_ASSERT("Shapes are not nested",
+                      0 <= blockshape[i] && blockshape[i] <= chunkshape[i] &&
+                      chunkshape[i] <= shapes.shape[i]);
+        CUTEST_ASSERT("Shapes are empty", (chunkshape[i] == 0) == (shapes.shape[i] == 0));
+        if (chunkshape[i] < shapes.shape[i]) {
+            CUTEST_ASSERT("Blocks are padded", chunkshape[i] % blockshape[i] == 0);
+        }
+    }
+
+    /* The accesses span whole rows or columns whenever they fit in a chunk */
+    if (params.ndim == 2 && shapes.shape[1] != 0 && access_hint == CATERVA_ACCESS_ROWS) {
+        CUTEST_ASSERT("Chunks do not span rows", chunkshape[1] == shapes.shape[1]);
+    }
+    if (params.ndim == 2 && shapes.shape[1] != 0 && access_hint == CATERVA_ACCESS_COLUMNS) {
+        CUTEST_ASSERT("Chunks do not span columns", chunkshape[0] == shapes.shape[0]);
+    }
+
+    /* The shapes suggested can be used to create an array */
+    int64_t nitems = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        nitems *= shapes.shape[i];
+    }
+    int64_t buffersize = nitems * itemsize;
+    uint8_t *buffer = malloc(buffersize + 1);
+    for (int64_t i = 0; i < buffersize; ++i) {
+        buffer[i] = (uint8_t) i;
+    }
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+    uint8_t *dest = malloc(buffersize + 1);
+    CATERVA_TEST_ASSERT(caterva_to_buffer(data->ctx, src, dest, buffersize));
+    CUTEST_ASSERT("Elements are not equal", memcmp(buffer, dest, buffersize) == 0);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    free(dest);
+    free(buffer);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(suggest_shapes) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(suggest_shapes);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2018 Francesc Alted, Aleix Alcacer.
+ * Copyright (C) 2019-present Blosc Development team <blosc@blosc.org>
+ * All rights reserved.
+ *
+ * This source code is licensed under both the BSD-style license (found in the
+ * LICENSE file in the root directory of this source tree) and the GPLv2 (found
+ * in the COPYING file in the root directory of this source tree).
+ * You may select, at your option, one of the above-listed licenses.
+ */
+
+#include "test_common.h"
+
+static void remove_frames(const char *urlpath) {
+    remove(urlpath);
+    for (int i = 0; i < 128; ++i) {
+        char shard_urlpath[64];
+        snprintf(shard_urlpath, sizeof(shard_urlpath), "%s.%d", urlpath, i);
+        remove(shard_urlpath);
+    }
+}
+
+
+CUTEST_TEST_DATA(verify) {
+    caterva_ctx_t *ctx;
+};
+
+
+CUTEST_TEST_SETUP(verify) {
+    caterva_config_t cfg = CATERVA_CONFIG_DEFAULTS;
+    cfg.nthreads = 2;
+    cfg.compcodec = BLOSC_BLOSCLZ;
+    caterva_ctx_new(&cfg, &data->ctx);
+
+    // Add parametrizations
+    CUTEST_PARAMETRIZE(nthreads, int, CUTEST_DATA(1, 4));
+    CUTEST_PARAMETRIZE(shapes, _test_shapes, CUTEST_DATA(
+            {0, {0}, {0}, {0}}, // 0-dim
+            {1, {10}, {7}, {2}}, // 1-idim
+            {2, {100, 100}, {20, 20}, {10, 10}},
+            {3, {100, 55, 123}, {31, 5, 22}, {4, 4, 4}},
+            {3, {100, 0, 12}, {31, 0, 12}, {10, 0, 12}},
+    ));
+    CUTEST_PARAMETRIZE(backend, _test_backend, CUTEST_DATA(
+            {CATERVA_STORAGE_BLOSC, false, false},
+            {CATERVA_STORAGE_BLOSC, true, true},
+            {CATERVA_STORAGE_SHARDED, true, true},
+    ));
+}
+
+
+CUTEST_TEST_TEST(verify) {
+    CUTEST_GET_PARAMETER(backend, _test_backend);
+    CUTEST_GET_PARAMETER(shapes, _test_shapes);
+    CUTEST_GET_PARAMETER(nthreads, int);
+
+    char *urlpath = "test_verify.b2frame";
+    remove_frames(urlpath);
+
+    uint8_t itemsize = 4;
+    caterva_params_t params;
+    params.itemsize = itemsize;
+    params.ndim = shapes.ndim;
+    for (int i = 0; i < params.ndim; ++i) {
+        params.shape[i] = shapes.shape[i];
+    }
+
+    caterva_storage_t storage = {0};
+    storage.backend = backend.backend;
+    if (backend.backend == CATERVA_STORAGE_SHARDED) {
+        storage.properties.sharded.urlpath = backend.persistent ? urlpath : NULL;
+        storage.properties.sharded.sequencial = backend.sequential;
+        storage.properties.sharded.shard_nchunks = 2;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.sharded.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.sharded.blockshape[i] = shapes.blockshape[i];
+        }
+    } else {
+        storage.properties.blosc.urlpath = backend.persistent ? urlpath : NULL;
+        storage.properties.blosc.sequencial = backend.sequential;
+        for (int i = 0; i < params.ndim; ++i) {
+            storage.properties.blosc.chunkshape[i] = shapes.chunkshape[i];
+            storage.properties.blosc.blockshape[i] = shapes.blockshape[i];
+        }
+    }
+
+    /* Create original data */
+    int64_t buffersize = itemsize;
+    int64_t nchunks = 1;
+    for (int i = 0; i < params.ndim; ++i) {
+        buffersize *= shapes.shape[i];
+        nchunks *= shapes.chunkshape[i] == 0 ? 0 : (shapes.shape[i] + shapes.chunkshape[i] - 1) /
+                                                   shapes.chunkshape[i];
+    }
+    uint8_t *buffer = malloc(buffersize + 1);
+    CUTEST_ASSERT("Buffer filled incorrectly", fill_buf(buffer, itemsize, buffersize / itemsize));
+
+    caterva_array_t *src;
+    CATERVA_TEST_ASSERT(caterva_from_buffer(data->ctx, buffer, buffersize, &params, &storage,
+                                            &src));
+
+    /* Every chunk is decompressed */
+    caterva_verify_report_t report;
+    CATERVA_TEST_ASSERT(caterva_verify(data->ctx, src, nthreads, &report));
+    CUTEST_ASSERT("Chunks are not verified", report.nchunks == nchunks);
+    CUTEST_ASSERT("Checksums are checked", report.nchecked == 0);
+    CUTEST_ASSERT("Chunks are bad", report.nbad == 0);
+    CATERVA_TEST_ASSERT(caterva_verify_report_free(data->ctx, &report));
+
+    /* The stored checksums are checked (also after opening the array again) */
+    CATERVA_TEST_ASSERT(caterva_store_checksums(data->ctx, src, nthreads));
+    if (backend.persistent) {
+        CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+        CATERVA_TEST_ASSERT(caterva_open(data->ctx, urlpath, &src));
+    }
+    CATERVA_TEST_ASSERT(caterva_verify(data->ctx, src, nthreads, &report));
+    CUTEST_ASSERT("Checksums are not checked", report.nchecked == nchunks);
+    CUTEST_ASSERT("Chunks are bad", report.nbad == 0);
+    CATERVA_TEST_ASSERT(caterva_verify_report_free(data->ctx, &report));
+
+    /* A chunk replaced behind the back of the array does not match its checksum */
+    caterva_array_t **parts = backend.backend == CATERVA_STORAGE_SHARDED ? src->shards : &src;
+    int64_t nparts = backend.backend == CATERVA_STORAGE_SHARDED ? src->nshards : 1;
+    caterva_array_t *part = nparts > 0 ? parts[nparts - 1] : NULL;
+    if (part != NULL && part->sc->nchunks > 1) {
+        uint8_t *chunk;
+        bool needs_free;
+        CUTEST_ASSERT("Chunk can not be read",
+                      blosc2_schunk_get_chunk(part->sc, 0, &chunk, &needs_free) >= 0);
+        int64_t nchunk = part->sc->nchunks - 1;
+        CUTEST_ASSERT("Chunk can not be replaced",
+                      blosc2_schunk_update_chunk(part->sc, (int) nchunk, chunk, true) >= 0);
+        if (needs_free) {
+            free(chunk);
+        }
+        CATERVA_TEST_ASSERT(caterva_verify(data->ctx, src, nthreads, &report));
+        CUTEST_ASSERT("Bad chunk is not found", report.nbad == 1);
+        for (int i = params.ndim - 1; i >= 0; --i) {
+            int64_t part_nchunks = part->extshape[i] / part->chunkshape[i];
+            int64_t coord = nchunk % part_nchunks;
+            if (i == 0 && backend.backend == CATERVA_STORAGE_SHARDED) {
+                coord += (nparts - 1) * src->shard_nchunks;
+            }
+            CUTEST_ASSERT("Coordinates are not correct", report.bad_coords[i] == coord);
+            nchunk /= part_nchunks;
+        }
+        CATERVA_TEST_ASSERT(caterva_verify_report_free(data->ctx, &report));
+    }
+
+    /* The checksums are dropped when the array is modified */
+    int64_t start[CATERVA_MAX_DIM] = {0};
+    CATERVA_TEST_ASSERT(caterva_set_slice_buffer(data->ctx, buffer, buffersize, start,
+                                                 src->shape, src));
+    CATERVA_TEST_ASSERT(caterva_verify(data->ctx, src, nthreads, &report));
+    CUTEST_ASSERT("Checksums are checked", report.nchecked == 0 || buffersize == 0);
+    CUTEST_ASSERT("Chunks are bad", report.nbad == 0);
+    CATERVA_TEST_ASSERT(caterva_verify_report_free(data->ctx, &report));
+
+    free(buffer);
+    CATERVA_TEST_ASSERT(caterva_free(data->ctx, &src));
+    remove_frames(urlpath);
+
+    return 0;
+}
+
+
+CUTEST_TEST_TEARDOWN(verify) {
+    caterva_ctx_free(&data->ctx);
+}
+
+int main() {
+    CUTEST_TEST_RUN(verify);
+}